@@ -1,5 +1,7 @@
 #include "PKAsset.h"
 #include <string>
+#include <stdlib.h>
+#include <string.h>
 
 namespace PK::Assets
 {
@@ -420,4 +422,269 @@ namespace PK::Assets
 
         return 0;
     }
-}
+
+    constexpr static const uint32_t PK_LZ_MIN_MATCH = 4u;
+    constexpr static const uint32_t PK_LZ_MAX_OFFSET = 0xFFFFu;
+    constexpr static const uint32_t PK_LZ_HASH_BITS = 14u;
+    // The tail of a block is always emitted as literals so that match extension never reads past the end.
+    constexpr static const uint32_t PK_LZ_LAST_LITERALS = 8u;
+
+    static uint32_t LZRead32(const uint8_t* ptr)
+    {
+        uint32_t value;
+        memcpy(&value, ptr, sizeof(uint32_t));
+        return value;
+    }
+
+    static uint8_t* LZWriteLength(uint8_t* op, size_t length)
+    {
+        for (; length >= 255u; length -= 255u)
+        {
+            *op++ = 255u;
+        }
+
+        *op++ = (uint8_t)length;
+        return op;
+    }
+
+    static uint8_t* LZWriteSequence(uint8_t* op, const uint8_t* oend, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+    {
+        auto required = 1ull + literalCount / 255u + 1ull + literalCount + 2ull + matchLength / 255u + 1ull;
+
+        if ((size_t)(oend - op) < required)
+        {
+            return nullptr;
+        }
+
+        auto token = op++;
+        *token = (uint8_t)((literalCount < 15u ? literalCount : 15u) << 4u);
+
+        if (literalCount >= 15u)
+        {
+            op = LZWriteLength(op, literalCount - 15u);
+        }
+
+        memcpy(op, literals, literalCount);
+        op += literalCount;
+
+        if (matchLength == 0u)
+        {
+            return op;
+        }
+
+        *op++ = (uint8_t)(offset & 0xFFu);
+        *op++ = (uint8_t)(offset >> 8u);
+
+        matchLength -= PK_LZ_MIN_MATCH;
+        *token |= (uint8_t)(matchLength < 15u ? matchLength : 15u);
+
+        if (matchLength >= 15u)
+        {
+            op = LZWriteLength(op, matchLength - 15u);
+        }
+
+        return op;
+    }
+
+    size_t GetLZBlockBound(size_t size)
+    {
+        return size + size / 255u + 16u;
+    }
+
+    size_t CompressLZBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity)
+    {
+        auto base = reinterpret_cast<const uint8_t*>(src);
+        auto ip = base;
+        auto anchor = base;
+        auto iend = base + srcSize;
+        auto op = reinterpret_cast<uint8_t*>(dst);
+        auto oend = op + dstCapacity;
+
+        if (srcSize > PK_LZ_LAST_LITERALS + PK_LZ_MIN_MATCH)
+        {
+            auto table = reinterpret_cast<uint32_t*>(calloc(1ull << PK_LZ_HASH_BITS, sizeof(uint32_t)));
+
+            if (table == nullptr)
+            {
+                return 0ull;
+            }
+
+            auto matchLimit = iend - PK_LZ_LAST_LITERALS;
+
+            while (ip + PK_LZ_MIN_MATCH <= matchLimit)
+            {
+                auto sequence = LZRead32(ip);
+                auto hash = (sequence * 2654435761u) >> (32u - PK_LZ_HASH_BITS);
+                auto match = base + table[hash];
+                table[hash] = (uint32_t)(ip - base);
+
+                if (match >= ip || (size_t)(ip - match) > PK_LZ_MAX_OFFSET || LZRead32(match) != sequence)
+                {
+                    ++ip;
+                    continue;
+                }
+
+                auto matchEnd = ip + PK_LZ_MIN_MATCH;
+
+                for (match += PK_LZ_MIN_MATCH; matchEnd < matchLimit && *matchEnd == *match; ++matchEnd, ++match);
+
+                op = LZWriteSequence(op, oend, anchor, (size_t)(ip - anchor), (size_t)(matchEnd - match), (size_t)(matchEnd - ip));
+
+                if (op == nullptr)
+                {
+                    free(table);
+                    return 0ull;
+                }
+
+                ip = matchEnd;
+                anchor = ip;
+            }
+
+            free(table);
+        }
+
+        op = LZWriteSequence(op, oend, anchor, (size_t)(iend - anchor), 0ull, 0ull);
+        return op != nullptr ? (size_t)(op - reinterpret_cast<uint8_t*>(dst)) : 0ull;
+    }
+
+    size_t DecompressLZBlock(const char* src, size_t srcSize, char* dst, size_t dstSize)
+    {
+        auto ip = reinterpret_cast<const uint8_t*>(src);
+        auto iend = ip + srcSize;
+        auto op = reinterpret_cast<uint8_t*>(dst);
+        auto obase = op;
+        auto oend = op + dstSize;
+
+        while (ip < iend)
+        {
+            auto token = *ip++;
+            size_t literalCount = token >> 4u;
+
+            if (literalCount == 15u)
+            {
+                uint8_t value = 255u;
+
+                while (value == 255u && ip < iend)
+                {
+                    value = *ip++;
+                    literalCount += value;
+                }
+            }
+
+            if ((size_t)(iend - ip) < literalCount || (size_t)(oend - op) < literalCount)
+            {
+                return 0ull;
+            }
+
+            memcpy(op, ip, literalCount);
+            op += literalCount;
+            ip += literalCount;
+
+            // Last sequence has no match.
+            if (ip == iend)
+            {
+                break;
+            }
+
+            if (iend - ip < 2)
+            {
+                return 0ull;
+            }
+
+            size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8u);
+            ip += 2;
+
+            size_t matchLength = (token & 0xFu);
+
+            if (matchLength == 15u)
+            {
+                uint8_t value = 255u;
+
+                while (value == 255u && ip < iend)
+                {
+                    value = *ip++;
+                    matchLength += value;
+                }
+            }
+
+            matchLength += PK_LZ_MIN_MATCH;
+
+            if (offset == 0u || offset > (size_t)(op - obase) || (size_t)(oend - op) < matchLength)
+            {
+                return 0ull;
+            }
+
+            auto match = op - offset;
+
+            // Copies of 8 bytes only read data that has already been written when the offset is at least 8.
+            if (offset >= 8u)
+            {
+                for (; matchLength >= 8u; matchLength -= 8u, op += 8u, match += 8u)
+                {
+                    memcpy(op, match, 8u);
+                }
+            }
+
+            for (; matchLength > 0u; --matchLength)
+            {
+                *op++ = *match++;
+            }
+        }
+
+        return (size_t)(op - obase);
+    }
+
+    void* CompressAsset(const void* asset, size_t size, size_t* outSize)
+    {
+        auto header = reinterpret_cast<const PKAssetHeader*>(asset);
+
+        if (size < sizeof(PKAssetHeader) || header->compression != PKAssetCompression::None)
+        {
+            return nullptr;
+        }
+
+        auto source = reinterpret_cast<const char*>(asset) + sizeof(PKAssetHeader);
+        auto sourceSize = size - sizeof(PKAssetHeader);
+        auto chunkCount = (uint32_t)((sourceSize + PK_ASSET_COMPRESSION_CHUNK_SIZE - 1u) / PK_ASSET_COMPRESSION_CHUNK_SIZE);
+        auto dataOffset = sizeof(PKAssetHeader) + sizeof(PKChunkedPayload) + sizeof(PKCompressedChunk) * chunkCount;
+        auto capacity = dataOffset + GetLZBlockBound(PK_ASSET_COMPRESSION_CHUNK_SIZE) * chunkCount;
+        auto buffer = reinterpret_cast<char*>(calloc(capacity, sizeof(char)));
+
+        if (buffer == nullptr)
+        {
+            return nullptr;
+        }
+
+        memcpy(buffer, asset, sizeof(PKAssetHeader));
+        reinterpret_cast<PKAssetHeader*>(buffer)->compression = PKAssetCompression::LZChunked;
+
+        auto payload = reinterpret_cast<PKChunkedPayload*>(buffer + sizeof(PKAssetHeader));
+        payload->uncompressedSize = size;
+        payload->chunkSize = PK_ASSET_COMPRESSION_CHUNK_SIZE;
+        payload->chunkCount = chunkCount;
+        payload->chunks.Set(buffer, reinterpret_cast<PKCompressedChunk*>(payload + 1));
+
+        auto chunks = payload->chunks.Get(buffer);
+        auto head = dataOffset;
+
+        for (auto i = 0u; i < chunkCount; ++i)
+        {
+            auto chunkOffset = (size_t)i * PK_ASSET_COMPRESSION_CHUNK_SIZE;
+            auto chunkSize = sourceSize - chunkOffset < PK_ASSET_COMPRESSION_CHUNK_SIZE ? sourceSize - chunkOffset : PK_ASSET_COMPRESSION_CHUNK_SIZE;
+            auto written = CompressLZBlock(source + chunkOffset, chunkSize, buffer + head, capacity - head);
+
+            if (written == 0ull || written >= chunkSize)
+            {
+                memcpy(buffer + head, source + chunkOffset, chunkSize);
+                written = chunkSize;
+            }
+
+            chunks[i].offset = (relativePtr)head;
+            chunks[i].size = (uint32_t)written;
+            head += written;
+        }
+
+        *outSize = head;
+        return buffer;
+    }
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
 
 namespace PK::Assets
 {
@@ -8,10 +9,14 @@ namespace PK::Assets
     constexpr static const uint64_t PK_ASSET_MAGIC_NUMBER = 16056123332373007180ull;
     constexpr static const uint32_t PK_ASSET_NAME_MAX_LENGTH = 64;
     constexpr static const uint32_t PK_ASSET_MAX_VERTEX_ATTRIBUTES = 8;
+    constexpr static const uint32_t PK_ASSET_MAX_MESH_LODS = 4;
+    constexpr static const uint32_t PK_ASSET_MESHLET_MAX_VERTICES = 64;
+    constexpr static const uint32_t PK_ASSET_MESHLET_MAX_TRIANGLES = 124;
     constexpr static const uint32_t PK_ASSET_MAX_DESCRIPTOR_SETS = 4;
     constexpr static const uint32_t PK_ASSET_MAX_DESCRIPTORS_PER_SET = 16;
     constexpr static const uint32_t PK_ASSET_MAX_SHADER_KEYWORDS = 256;
     constexpr static const uint32_t PK_ASSET_MAX_UNBOUNDED_SIZE = 2048;
+    constexpr static const uint32_t PK_ASSET_COMPRESSION_CHUNK_SIZE = 256u * 1024u;
 
     constexpr static const char* PK_ASSET_EXTENSION_SHADER = ".pkshader";
     constexpr static const char* PK_ASSET_EXTENSION_MESH = ".pkmesh";
@@ -108,6 +113,15 @@ namespace PK::Assets
         TextureCubeHandle,
     };
 
+    enum class PKAssetCompression : unsigned char
+    {
+        None,
+        // Bit serial huffman coding. Stored as 'true' by assets written before compression modes were added.
+        Huffman,
+        // Independently decodable LZ blocks. Payload is described by PKChunkedPayload.
+        LZChunked
+    };
+
     enum class PKShaderStage : unsigned char
     {
         Vertex,
@@ -220,9 +234,33 @@ namespace PK::Assets
         uint64_t magicNumber = PK_ASSET_MAGIC_NUMBER;
         char name[PK_ASSET_NAME_MAX_LENGTH]{};
         PKAssetType type = PKAssetType::Invalid;
-        bool isCompressed = false;
+        PKAssetCompression compression = PKAssetCompression::None;
+    };
+
+    // Chunks that did not compress are stored as is & have a size equal to their decoded size.
+    struct PKCompressedChunk
+    {
+        relativePtr offset;
+        uint32_t size;
+    };
+
+    // Follows the header of LZChunked assets. Chunk i decodes to offset sizeof(PKAssetHeader) + i * chunkSize of the uncompressed asset.
+    struct PKChunkedPayload
+    {
+        uint64_t uncompressedSize;
+        uint32_t chunkSize;
+        uint32_t chunkCount;
+        RelativePtr<PKCompressedChunk> chunks;
     };
 
+    size_t GetLZBlockBound(size_t size);
+    // Returns the number of bytes written or 0 if dst is too small.
+    size_t CompressLZBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity);
+    // Returns the number of bytes decoded or 0 for malformed input.
+    size_t DecompressLZBlock(const char* src, size_t srcSize, char* dst, size_t dstSize);
+    // Compresses an uncompressed asset into a heap allocated LZChunked asset. Returns nullptr on failure.
+    void* CompressAsset(const void* asset, size_t size, size_t* outSize);
+
     namespace Shader
     {
         constexpr const static char* PK_SHADER_ATTRIB_ZWRITE = "#ZWrite ";
@@ -363,9 +401,38 @@ namespace PK::Assets
             float bbmax[3]{};
         };
 
+        enum class PKMeshFlags : unsigned short
+        {
+            None = 0,
+            // Index & vertex streams have been reordered for vertex cache, overdraw & fetch locality.
+            Optimized = 1 << 0,
+            // Mesh contains simplified index ranges & the lodCount field.
+            HasLods = 1 << 1,
+            // Mesh contains the meshlet fields. Requires HasLods for the preceding lodCount field.
+            HasMeshlets = 1 << 2,
+        };
+
+        // Cluster of consecutive triangles within a submesh.
+        // At most PK_ASSET_MESHLET_MAX_VERTICES unique vertices & PK_ASSET_MESHLET_MAX_TRIANGLES triangles.
+        struct PKMeshlet
+        {
+            // Relative to the first index of the submesh.
+            uint32_t firstIndex;
+            uint16_t indexCount;
+            // Index into the lod major submesh array. Meshlets are sorted by submesh.
+            uint16_t submesh;
+            float center[3];
+            float radius;
+            float coneAxis[3];
+            // Sine of the normal cone angle. 1 if the meshlet cannot be backface culled.
+            float coneCutoff;
+        };
+
         struct PKMesh
         {
             PKElementType indexType;
+            // Occupies the former padding after indexType. Zero for assets written before flags were introduced.
+            PKMeshFlags flags;
             uint32_t indexCount;
             uint32_t vertexCount;
             uint32_t submeshCount;
@@ -374,6 +441,12 @@ namespace PK::Assets
             RelativePtr<PKSubmesh> submeshes;
             RelativePtr<void> vertexBuffer;
             RelativePtr<void> indexBuffer;
+            // Only present when flags contain HasLods. Older assets end at the previous field.
+            // Submeshes are stored lod major. Lod l of submesh s is at submeshes[l * submeshCount + s].
+            uint32_t lodCount;
+            // Only present when flags contain HasMeshlets.
+            uint32_t meshletCount;
+            RelativePtr<PKMeshlet> meshlets;
         };
     }
 
@@ -381,5 +454,8 @@ namespace PK::Assets
     {
         PKAssetHeader* header = nullptr;
         void* rawData = nullptr;
+        uint64_t size = 0ull;
+        // Platform file mapping when rawData points to a memory mapped view. Null for heap allocated data.
+        void* mapping = nullptr;
     };
 }
\ No newline at end of file
@@ -3,10 +3,154 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+
+#if _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace PK::Assets
 {
-    void Decompress(PKAsset* asset)
+    static PKDispatchFunction s_dispatchFunction = nullptr;
+    static void* s_dispatchContext = nullptr;
+
+    struct ChunkDecodeArgs
+    {
+        const char* base;
+        char* output;
+        const PKChunkedPayload* payload;
+        const PKCompressedChunk* chunks;
+        std::atomic<uint32_t> failures;
+    };
+
+    void SetDecompressDispatch(PKDispatchFunction function, void* context)
+    {
+        s_dispatchFunction = function;
+        s_dispatchContext = context;
+    }
+
+    void* MapFile(const char* filepath, size_t* size, void** mapping)
+    {
+#if _WIN32
+        auto file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize{};
+
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        // Copy on write so that in place modifications never reach the file.
+        auto handle = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        CloseHandle(file);
+
+        if (handle == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto view = MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, 0);
+
+        if (view == nullptr)
+        {
+            CloseHandle(handle);
+            return nullptr;
+        }
+
+        *size = (size_t)fileSize.QuadPart;
+        *mapping = handle;
+        return view;
+#else
+        auto file = open(filepath, O_RDONLY);
+
+        if (file == -1)
+        {
+            return nullptr;
+        }
+
+        struct stat info{};
+
+        if (fstat(file, &info) != 0 || info.st_size == 0)
+        {
+            close(file);
+            return nullptr;
+        }
+
+        auto view = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        close(file);
+
+        if (view == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        *size = (size_t)info.st_size;
+        *mapping = view;
+        return view;
+#endif
+    }
+
+    void UnmapFile(void* view, size_t size, void* mapping)
+    {
+#if _WIN32
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+#else
+        munmap(view, size);
+#endif
+    }
+
+    void PrefetchMappedFile(const void* view, size_t size)
+    {
+#if _WIN32
+        WIN32_MEMORY_RANGE_ENTRY range{ const_cast<void*>(view), size };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+        madvise(const_cast<void*>(view), size, MADV_WILLNEED);
+#endif
+
+        // The hints above are asynchronous. Reading a byte per page blocks until the page is resident without copying it.
+        const size_t pageSize = 4096ull;
+        auto bytes = reinterpret_cast<const volatile char*>(view);
+        char sum = 0;
+
+        for (auto offset = 0ull; offset < size; offset += pageSize)
+        {
+            sum += bytes[offset];
+        }
+
+        (void)sum;
+    }
+
+    void ReleaseRawData(PKAsset* asset)
+    {
+        if (asset->mapping != nullptr)
+        {
+            UnmapFile(asset->rawData, asset->size, asset->mapping);
+        }
+        else
+        {
+            free(asset->rawData);
+        }
+
+        asset->rawData = nullptr;
+        asset->mapping = nullptr;
+        asset->size = 0ull;
+    }
+
+    void DecompressHuffman(PKAsset* asset)
     {
         auto base = reinterpret_cast<char*>(asset->rawData);
         auto head = base + sizeof(PKAssetHeader);
@@ -52,10 +196,109 @@ namespace PK::Assets
             }
         }
 
-        free(asset->rawData);
+        ReleaseRawData(asset);
         asset->rawData = decomp;
+        asset->size = osize;
         asset->header = reinterpret_cast<PKAssetHeader*>(decomp);
-        asset->header->isCompressed = false;
+        asset->header->compression = PKAssetCompression::None;
+    }
+
+    void DecompressChunk(void* context, uint32_t index)
+    {
+        auto args = reinterpret_cast<ChunkDecodeArgs*>(context);
+        auto& chunk = args->chunks[index];
+        auto offset = (size_t)index * args->payload->chunkSize;
+        auto remaining = args->payload->uncompressedSize - sizeof(PKAssetHeader) - offset;
+        auto size = remaining < args->payload->chunkSize ? (size_t)remaining : (size_t)args->payload->chunkSize;
+        auto src = args->base + chunk.offset;
+        auto dst = args->output + sizeof(PKAssetHeader) + offset;
+
+        if (chunk.size == size)
+        {
+            memcpy(dst, src, size);
+        }
+        else if (DecompressLZBlock(src, chunk.size, dst, size) != size)
+        {
+            args->failures.fetch_add(1u, std::memory_order_relaxed);
+        }
+    }
+
+    int DecompressChunked(PKAsset* asset)
+    {
+        auto base = reinterpret_cast<char*>(asset->rawData);
+
+        if (asset->size < sizeof(PKAssetHeader) + sizeof(PKChunkedPayload))
+        {
+            return -1;
+        }
+
+        auto payload = reinterpret_cast<PKChunkedPayload*>(base + sizeof(PKAssetHeader));
+        auto chunks = payload->chunks.Get(base);
+        auto payloadSize = payload->uncompressedSize - sizeof(PKAssetHeader);
+
+        if (payload->uncompressedSize < sizeof(PKAssetHeader) ||
+            payload->chunkSize == 0u ||
+            (payloadSize + payload->chunkSize - 1u) / payload->chunkSize != payload->chunkCount ||
+            payload->chunks.offset + sizeof(PKCompressedChunk) * payload->chunkCount > asset->size)
+        {
+            return -1;
+        }
+
+        for (auto i = 0u; i < payload->chunkCount; ++i)
+        {
+            if ((uint64_t)chunks[i].offset + chunks[i].size > asset->size)
+            {
+                return -1;
+            }
+        }
+
+        auto decomp = reinterpret_cast<char*>(malloc(payload->uncompressedSize));
+
+        if (decomp == nullptr)
+        {
+            return -1;
+        }
+
+        memcpy(decomp, base, sizeof(PKAssetHeader));
+
+        ChunkDecodeArgs args{ base, decomp, payload, chunks, 0u };
+
+        if (s_dispatchFunction != nullptr && payload->chunkCount > 1u)
+        {
+            s_dispatchFunction(s_dispatchContext, DecompressChunk, &args, payload->chunkCount);
+        }
+        else
+        {
+            for (auto i = 0u; i < payload->chunkCount; ++i)
+            {
+                DecompressChunk(&args, i);
+            }
+        }
+
+        if (args.failures.load() != 0u)
+        {
+            free(decomp);
+            return -1;
+        }
+
+        auto size = payload->uncompressedSize;
+        ReleaseRawData(asset);
+        asset->rawData = decomp;
+        asset->size = size;
+        asset->header = reinterpret_cast<PKAssetHeader*>(decomp);
+        asset->header->compression = PKAssetCompression::None;
+        return 0;
+    }
+
+    int Decompress(PKAsset* asset)
+    {
+        switch (asset->header->compression)
+        {
+            case PKAssetCompression::None: return 0;
+            case PKAssetCompression::Huffman: DecompressHuffman(asset); return 0;
+            case PKAssetCompression::LZChunked: return DecompressChunked(asset);
+            default: return -1;
+        }
     }
 
     FILE* OpenFile(const char* filepath, const char* option, size_t* size)
@@ -92,9 +335,40 @@ namespace PK::Assets
     }
 
 
-    int OpenAsset(const char* filepath, PKAsset* asset)
+    int OpenAsset(const char* filepath, PKAsset* asset, bool memoryMapped)
     {
         size_t size = 0ull;
+
+        if (memoryMapped)
+        {
+            void* mapping = nullptr;
+            auto view = MapFile(filepath, &size, &mapping);
+
+            if (view == nullptr)
+            {
+                return -1;
+            }
+
+            if (size < sizeof(PKAssetHeader) || *reinterpret_cast<uint64_t*>(view) != PK_ASSET_MAGIC_NUMBER)
+            {
+                UnmapFile(view, size, mapping);
+                return -1;
+            }
+
+            asset->rawData = view;
+            asset->size = size;
+            asset->mapping = mapping;
+            asset->header = reinterpret_cast<PKAssetHeader*>(asset->rawData);
+
+            if (Decompress(asset) != 0)
+            {
+                CloseAsset(asset);
+                return -1;
+            }
+
+            return 0;
+        }
+
         FILE* file = OpenFile(filepath, "rb", &size);
 
         if (file == nullptr)
@@ -122,14 +396,16 @@ namespace PK::Assets
         }
 
         asset->rawData = buffer;
+        asset->size = size;
         fread(buffer, sizeof(char), size, file);
         fclose(file);
 
         asset->header = reinterpret_cast<PKAssetHeader*>(asset->rawData);
 
-        if (asset->header->isCompressed)
+        if (Decompress(asset) != 0)
         {
-            Decompress(asset);
+            CloseAsset(asset);
+            return -1;
         }
 
         return 0;
@@ -143,7 +419,15 @@ namespace PK::Assets
         }
 
         asset->header = nullptr;
-        free(asset->rawData);
+        ReleaseRawData(asset);
+    }
+
+    void PrefetchAsset(const PKAsset* asset)
+    {
+        if (asset->rawData != nullptr && asset->mapping != nullptr)
+        {
+            PrefetchMappedFile(asset->rawData, asset->size);
+        }
     }
 
     Shader::PKShader* ReadAsShader(PKAsset* asset)
@@ -245,7 +529,7 @@ namespace PK::Assets
                 break;
             }
 #else
-            strncpy(meta->optionNames + PK_ASSET_NAME_MAX_LENGTH * lineIndex, head, (size_t)(comma - head));
+            strncpy(meta.optionNames + PK_ASSET_NAME_MAX_LENGTH * lineIndex, head, (size_t)(comma - head));
 #endif
 
             meta.optionValues[lineIndex++] = (uint32_t)strtoull(comma + 1, &head, 10);
@@ -3,8 +3,19 @@
 
 namespace PK::Assets
 {
-    int OpenAsset(const char* filepath, PKAsset* asset);
+    typedef void (*PKChunkFunction)(void* args, uint32_t index);
+    typedef void (*PKDispatchFunction)(void* context, PKChunkFunction function, void* args, uint32_t count);
+
+    // Optional parallel dispatch for decoding chunked payloads. Must invoke the function for every index in [0, count) before returning.
+    // Chunks are decoded serially on the calling thread when not set.
+    void SetDecompressDispatch(PKDispatchFunction function, void* context);
+
+    // Memory mapped assets resolve relative pointers directly against a copy on write view of the file.
+    // Compressed assets are always decoded into heap memory.
+    int OpenAsset(const char* filepath, PKAsset* asset, bool memoryMapped = false);
     void CloseAsset(PKAsset* asset);
+    // Faults in the pages of a memory mapped asset so that later reads do not block on disk. No-op for assets in heap memory.
+    void PrefetchAsset(const PKAsset* asset);
 
     Shader::PKShader* ReadAsShader(PKAsset* asset);
     Mesh::PKMesh* ReadAsMesh(PKAsset* asset);
@@ -36,12 +36,12 @@ float3 SampleRadiance(const int2 coord, const float3 origin, const float3 direct
         }
     }
 
-    const float level = roughness * roughness * log2(max(1.0f, dist) / PK_GI_VOXEL_SIZE);
+    const float level = min(roughness * roughness * log2(max(1.0f, dist) / PK_GI_VOXEL_SIZE), PK_GI_VOXEL_MAX_LOD);
     const float4 voxel = SampleGI_WS(worldpos, level);
 
     const float3 env = SampleEnvironment(OctaUV(direction), roughness);
     const float envclip = saturate(PK_GI_RAY_MAX_DISTANCE * (1.0f - (dist / PK_GI_RAY_MAX_DISTANCE)));
-    const float alpha = max(voxel.a, 1.0f / (PK_GI_VOXEL_MAX_MIP * PK_GI_VOXEL_MAX_MIP));
+    const float alpha = max(voxel.a, 1.0f / (PK_GI_VOXEL_MAX_LOD * PK_GI_VOXEL_MAX_LOD));
 
     return lerp(env, voxel.rgb / alpha, envclip);
 }
@@ -1,25 +1,54 @@
 #version 460
+
+#multi_compile PASS_PRUNE PASS_SCROLL
+
 #pragma PROGRAM_COMPUTE
 #include includes/Common.glsl
 #include includes/SharedSceneGI.glsl
 
 layout(rgba16, set = PK_SET_DRAW) uniform image3D _DestinationTex;
 
+PK_DECLARE_LOCAL_CBUFFER(pk_SceneGI_ScrollLevel)
+{
+    uint ScrollLevel;
+};
+
 layout(local_size_x = 8, local_size_y = 8, local_size_z = 8) in;
 void main()
 {
-    float3 worldpos = VoxelToWorldSpace(int3(gl_GlobalInvocationID));
+#if defined(PASS_PRUNE)
+    // Dispatched over the level that is voxelized this frame.
+    const uint level = pk_SceneGI_VoxelizeLevel;
+    const int3 texel = int3(gl_GlobalInvocationID);
+    const int3 masktexel = TexelToMaskSpace(texel, level);
+    const int3 coord = TexelToVoxelSpace(texel, pk_SceneGI_ClipmapOrigins[level].xyz);
 
-    if (!WorldToClipSpaceCull(worldpos))
+    if (!WorldToClipSpaceCull(VoxelToWorldSpace(coord, level)))
     {
         return;
     }
 
-    uint writeCount = imageLoad(pk_SceneGI_VolumeMaskWrite, int3(gl_GlobalInvocationID)).x;
-    imageStore(pk_SceneGI_VolumeMaskWrite, int3(gl_GlobalInvocationID), uint4(0u));
+    uint writeCount = imageLoad(pk_SceneGI_VolumeMaskWrite, masktexel).x;
+    imageStore(pk_SceneGI_VolumeMaskWrite, masktexel, uint4(0u));
 
     if (writeCount == 0u)
     {
-        imageStore(_DestinationTex, int3(gl_GlobalInvocationID), 0.0f.xxxx);
+        imageStore(_DestinationTex, texel, 0.0f.xxxx);
     }
+#else
+    // Texels whose voxel was outside of the level before it scrolled hold values from the opposite side of the level.
+    // Dispatched once per scrolled level with the level's volume bound as the destination.
+    const uint level = ScrollLevel;
+    const int3 texel = int3(gl_GlobalInvocationID);
+    const int3 scroll = pk_SceneGI_ClipmapScroll[level].xyz;
+    const int3 origin = pk_SceneGI_ClipmapOrigins[level].xyz;
+
+    if (all(equal(TexelToVoxelSpace(texel, origin), TexelToVoxelSpace(texel, origin - scroll))))
+    {
+        return;
+    }
+
+    imageStore(pk_SceneGI_VolumeMaskWrite, TexelToMaskSpace(texel, level), uint4(0u));
+    imageStore(_DestinationTex, texel, 0.0f.xxxx);
+#endif
 }
\ No newline at end of file
@@ -15,7 +15,8 @@ out flat uint vs_LAYER;
 void main()
 {
     gl_Position = PK_BLIT_VERTEX_POSITION;
-    gl_Layer = gl_InstanceIndex;
+    // Source layers are batch local. Destination layers are relative to the first instance.
+    gl_Layer = gl_InstanceIndex - gl_BaseInstance;
     vs_LAYER = gl_InstanceIndex;
     vs_TEXCOORD0 = PK_BLIT_VERTEX_TEXCOORD;
 }
@@ -38,6 +38,15 @@ float3 OctaDecode(float2 f)
     return normalize(n);
 }
 
+// Compact vertex attributes. Encoded by PK::Math::Functions::PackOctaUnorm16 & PackOctaTangent.
+float3 DecodeOctaUnorm16(uint v) { return OctaDecode(unpackUnorm2x16(v)); }
+
+float4 DecodeOctaTangent(uint v)
+{
+    float2 f = float2(v & 0xFFFFu, (v >> 16u) & 0x7FFFu) / float2(65535.0f, 32767.0f);
+    return float4(OctaDecode(f), (v >> 31u) != 0u ? -1.0f : 1.0f);
+}
+
 float2 OctaUV(float3 offset, float3 direction) { return offset.xy + OctaEncode(direction) * offset.z; }
 
 float2 OctaUV(float3 direction) { return OctaEncode(direction); }
@@ -38,9 +38,17 @@ float3 SampleEnvironment(float2 uv, float roughness)
     return HDRDecode(tex2DLod(pk_SceneOEM_HDR, uv, roughness * 4)) * pk_SceneOEM_Exposure; 
 }
 
+// Shadowmap indices pack the atlas layer, tile level & tile coordinates into 8, 2, 3 & 3 bits.
 float SampleLightShadowmap(uint shadowmapIndex, float2 uv, float lightDistance)
 {
-    float2 moments = tex2D(pk_ShadowmapAtlas, float3(uv, shadowmapIndex)).xy;
+    uint layer = bitfieldExtract(shadowmapIndex, 0, 8);
+    float tileScale = exp2(-float(bitfieldExtract(shadowmapIndex, 8, 2)));
+    float2 tile = float2(bitfieldExtract(shadowmapIndex, 10, 3), bitfieldExtract(shadowmapIndex, 13, 3));
+    // Keep bilinear taps inside the tile.
+    float2 border = 0.5f / (textureSize(pk_ShadowmapAtlas, 0).xy * tileScale);
+    uv = (tile + clamp(uv, border, 1.0f - border)) * tileScale;
+
+    float2 moments = tex2D(pk_ShadowmapAtlas, float3(uv, layer)).xy;
     float variance = moments.y - moments.x * moments.x;
     float difference = lightDistance - moments.x;
     return min(LBR(variance / (variance + difference * difference)) + step(difference, 0.1f), 1.0f);
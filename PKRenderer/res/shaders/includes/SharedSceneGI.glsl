@@ -4,14 +4,21 @@
 #include BlueNoise.glsl
 #include SHL1.glsl
 
+#define PK_GI_CLIPMAP_LEVELS 4
+#define PK_GI_CLIPMAP_RESOLUTION 128
+#define PK_GI_CLIPMAP_MIP_LEVELS 4
+
 PK_DECLARE_CBUFFER(pk_SceneGI_Params, PK_SET_SHADER)
 {
-    float4 pk_SceneGI_ST;
+    // Level origins & their change since the previous frame in voxels of each level.
+    int4 pk_SceneGI_ClipmapOrigins[PK_GI_CLIPMAP_LEVELS];
+    int4 pk_SceneGI_ClipmapScroll[PK_GI_CLIPMAP_LEVELS];
     uint4 pk_SceneGI_Swizzle;
     int4 pk_SceneGI_Checkerboard_Offset;
     float pk_SceneGI_VoxelSize; 
     float pk_SceneGI_LuminanceGain; 
     float pk_SceneGI_ChrominanceGain; 
+    uint pk_SceneGI_VoxelizeLevel;
 };
 
 layout(r32ui, set = PK_SET_SHADER) uniform uimage2D pk_ScreenGI_Meta_Read;
@@ -23,7 +30,7 @@ layout(rg16f, set = PK_SET_SHADER) uniform image2DArray pk_ScreenGI_CoCg_Write;
 layout(r8ui, set = PK_SET_SHADER) uniform uimage3D pk_SceneGI_VolumeMaskWrite;
 layout(rgba16, set = PK_SET_SHADER) uniform image3D pk_SceneGI_VolumeWrite;
 
-PK_DECLARE_SET_SHADER uniform sampler3D pk_SceneGI_VolumeRead;
+PK_DECLARE_SET_SHADER uniform sampler3D pk_SceneGI_VolumeRead[PK_GI_CLIPMAP_LEVELS];
 PK_DECLARE_SET_SHADER uniform sampler2DArray pk_ScreenGI_SHY_Read;
 PK_DECLARE_SET_SHADER uniform sampler2DArray pk_ScreenGI_CoCg_Read;
 
@@ -37,7 +44,9 @@ struct SceneGIMeta
 
 #define PK_GI_DIFF_LVL 0
 #define PK_GI_SPEC_LVL 1
-#define PK_GI_VOXEL_MAX_MIP 7
+#define PK_GI_VOXEL_MAX_MIP (PK_GI_CLIPMAP_MIP_LEVELS - 1)
+// Last mip of the last level. Lods are relative to the voxel size of the first level.
+#define PK_GI_VOXEL_MAX_LOD (PK_GI_CLIPMAP_LEVELS - 1 + PK_GI_VOXEL_MAX_MIP)
 #define PK_GI_VOXEL_SIZE pk_SceneGI_VoxelSize
 #define PK_GI_VOXEL_LENGTH pk_SceneGI_VoxelSize * PK_SQRT2
 #define PK_GI_CHECKERBOARD_OFFSET pk_SceneGI_Checkerboard_Offset.xy
@@ -63,24 +72,82 @@ float2 GetSampleOffset(uint2 coord, uint offset)
     return saturate(v.xy + ((v.z - 0.5f) / 256.0f));
 }
 
-float3 VoxelToWorldSpace(int3 coord) { return (float3(coord) * PK_GI_VOXEL_SIZE) + pk_SceneGI_ST.xyz + PK_GI_VOXEL_SIZE * 0.5f; }
-int3 WorldToVoxelSpace(float3 worldposition) { return int3((worldposition - pk_SceneGI_ST.xyz) * pk_SceneGI_ST.www); }
-float3 QuantizeWorldToVoxelSpace(float3 worldposition) { return VoxelToWorldSpace(WorldToVoxelSpace(worldposition)); }
-float3 WorldToSampleSpace(float3 worldposition) { return ((worldposition - pk_SceneGI_ST.xyz) * pk_SceneGI_ST.www) / textureSize(pk_SceneGI_VolumeRead, 0).xyz;  }
-float3 WorldToSampleSpaceDiscrete(float3 worldposition) { return (WorldToVoxelSpace(worldposition) + 0.5f.xxx) / textureSize(pk_SceneGI_VolumeRead, 0).xyz;  }
-float3 WorldToVoxelClipSpace(float3 worldposition) { return WorldToSampleSpace(worldposition) * 2.0f - 1.0f; }
+/*
+ * Each clipmap level has a volume of its own. Level i has a voxel size of PK_GI_VOXEL_SIZE * 2^i.
+ * Voxel coordinates are absolute & addressed toroidally within their level so that scrolling a level keeps the voxels that remain in it.
+ * The occupancy mask is only accessed as an image & has its levels stacked along the y axis.
+ */
+float SceneGI_GetVoxelSize(uint level) { return PK_GI_VOXEL_SIZE * exp2(float(level)); }
+float3 WorldToVoxelSpaceFloat(float3 worldposition, uint level) { return worldposition / SceneGI_GetVoxelSize(level); }
+int3 WorldToVoxelSpace(float3 worldposition, uint level) { return int3(floor(WorldToVoxelSpaceFloat(worldposition, level))); }
+float3 VoxelToWorldSpace(int3 coord, uint level) { return (float3(coord) + 0.5f) * SceneGI_GetVoxelSize(level); }
+int3 VoxelToTexelSpace(int3 coord) { return coord & (PK_GI_CLIPMAP_RESOLUTION - 1); }
+int3 TexelToMaskSpace(int3 texel, uint level) { return texel + int3(0, level * PK_GI_CLIPMAP_RESOLUTION, 0); }
+int3 TexelToVoxelSpace(int3 texel, int3 origin) { return origin + ((texel - origin) & (PK_GI_CLIPMAP_RESOLUTION - 1)); }
+
+bool SceneGI_IsInLevel(float3 coord, uint level, float margin)
+{
+    float3 localcoord = coord - float3(pk_SceneGI_ClipmapOrigins[level].xyz);
+    return all(greaterThanEqual(localcoord, margin.xxx)) && all(lessThanEqual(localcoord, (PK_GI_CLIPMAP_RESOLUTION - margin).xxx));
+}
+
+// The finest level that is at least as coarse as the requested lod & fully contains the filter footprint of the remaining mip.
+uint SceneGI_GetClipmapLevel(float3 worldposition, float lod)
+{
+    uint level = uint(clamp(lod, 0.0f, float(PK_GI_CLIPMAP_LEVELS - 1)));
+
+    for (; level < PK_GI_CLIPMAP_LEVELS - 1; ++level)
+    {
+        if (SceneGI_IsInLevel(WorldToVoxelSpaceFloat(worldposition, level), level, exp2(max(0.0f, lod - level))))
+        {
+            break;
+        }
+    }
+
+    return level;
+}
+
+// Toroidal coordinates wrap with the sampler on all axes.
+float3 WorldToSampleSpace(float3 worldposition, uint level) { return WorldToVoxelSpaceFloat(worldposition, level) / PK_GI_CLIPMAP_RESOLUTION; }
+
+// Levels are selected with constant indices as the level can vary within a wave.
+float4 SceneGI_SampleLevel(uint level, float3 uvw, float mip)
+{
+    switch (level)
+    {
+        case 0u: return tex2DLod(pk_SceneGI_VolumeRead[0], uvw, mip);
+        case 1u: return tex2DLod(pk_SceneGI_VolumeRead[1], uvw, mip);
+        case 2u: return tex2DLod(pk_SceneGI_VolumeRead[2], uvw, mip);
+        default: return tex2DLod(pk_SceneGI_VolumeRead[3], uvw, mip);
+    }
+}
+
+float4 SceneGI_LoadLevel(uint level, int3 texel)
+{
+    switch (level)
+    {
+        case 0u: return texelFetch(pk_SceneGI_VolumeRead[0], texel, 0);
+        case 1u: return texelFetch(pk_SceneGI_VolumeRead[1], texel, 0);
+        case 2u: return texelFetch(pk_SceneGI_VolumeRead[2], texel, 0);
+        default: return texelFetch(pk_SceneGI_VolumeRead[3], texel, 0);
+    }
+}
+
+// Voxelization & pruning operate on a single level per frame.
+float3 QuantizeWorldToVoxelSpace(float3 worldposition) { return VoxelToWorldSpace(WorldToVoxelSpace(worldposition, pk_SceneGI_VoxelizeLevel), pk_SceneGI_VoxelizeLevel); }
 
 float4 WorldToVoxelNDCSpace(float3 worldposition) 
 { 
-    float3 clippos = WorldToVoxelClipSpace(worldposition);
+    float3 localcoord = WorldToVoxelSpaceFloat(worldposition, pk_SceneGI_VoxelizeLevel) - float3(pk_SceneGI_ClipmapOrigins[pk_SceneGI_VoxelizeLevel].xyz);
+    float3 clippos = (localcoord / PK_GI_CLIPMAP_RESOLUTION) * 2.0f - 1.0f;
     return float4(clippos[pk_SceneGI_Swizzle.x], clippos[pk_SceneGI_Swizzle.y], clippos[pk_SceneGI_Swizzle.z] * 0.5f + 0.5f, 1);
 }
 
 //----------PREDICATES----------//
 bool SceneGI_VoxelHasValue(float3 worldposition)
 {
-    int3 coord = WorldToVoxelSpace(worldposition);
-    return imageLoad(pk_SceneGI_VolumeMaskWrite, coord).x != 0;
+    int3 coord = WorldToVoxelSpace(worldposition, pk_SceneGI_VoxelizeLevel);
+    return imageLoad(pk_SceneGI_VolumeMaskWrite, TexelToMaskSpace(VoxelToTexelSpace(coord), pk_SceneGI_VoxelizeLevel)).x != 0;
 }
 
 bool SceneGI_NormalReject(float3 normal)
@@ -116,21 +183,36 @@ SceneGIMeta SampleGI_Meta(int2 coord) { return SceneGI_DecodeMeta(imageLoad(pk_S
 void StoreGI_Meta(int2 coord, const SceneGIMeta meta) { imageStore(pk_ScreenGI_Meta_Write, coord, uint4(SceneGI_EncodeMeta(meta))); }
 
 //----------VOXEL SAMPLE / STORE FUNCTIONS----------//
-float4 SampleGI_WS(float3 worldposition, float level)
+// Lod is relative to the voxel size of the first level. Positions outside of the last level have no value.
+float4 SampleGI_WS(float3 worldposition, float lod)
 {
-    return tex2DLod(pk_SceneGI_VolumeRead, WorldToSampleSpace(worldposition), level);
+    const uint level = SceneGI_GetClipmapLevel(worldposition, lod);
+    const float mip = max(0.0f, lod - level);
+
+    if (!SceneGI_IsInLevel(WorldToVoxelSpaceFloat(worldposition, level), level, 0.0f))
+    {
+        return 0.0f.xxxx;
+    }
+
+    return SceneGI_SampleLevel(level, WorldToSampleSpace(worldposition, level), mip);
 }
 
-float4 SampleGI_WS_Discrete(float3 worldposition, float level)
+float4 SampleGI_WS_Discrete(float3 worldposition, uint level)
 {
-    return tex2DLod(pk_SceneGI_VolumeRead, WorldToSampleSpaceDiscrete(worldposition), level);
+    const int3 coord = WorldToVoxelSpace(worldposition, level);
+    return SceneGI_IsInLevel(float3(coord) + 0.5f, level, 0.0f) ? SceneGI_LoadLevel(level, VoxelToTexelSpace(coord)) : 0.0f.xxxx;
 }
 
 void StoreGI_WS(float3 worldposition, float4 color) 
 { 
-    int3 coord = WorldToVoxelSpace(worldposition);
-    imageStore(pk_SceneGI_VolumeMaskWrite, coord, uint4(1u));
-    imageStore(pk_SceneGI_VolumeWrite, coord, color); 
+    int3 coord = WorldToVoxelSpace(worldposition, pk_SceneGI_VoxelizeLevel);
+
+    if (SceneGI_IsInLevel(float3(coord) + 0.5f, pk_SceneGI_VoxelizeLevel, 0.0f))
+    {
+        int3 texel = VoxelToTexelSpace(coord);
+        imageStore(pk_SceneGI_VolumeMaskWrite, TexelToMaskSpace(texel, pk_SceneGI_VoxelizeLevel), uint4(1u));
+        imageStore(pk_SceneGI_VolumeWrite, texel, color); 
+    }
 }
 
 //----------SH SAMPLE / STORE FUNCTIONS----------//
@@ -9,6 +9,7 @@
 #ZWrite False
 #Cull Back
 #multi_compile _ PK_META_PASS_GBUFFER PK_META_PASS_GIVOXELIZE
+#multi_compile _ PK_VERTEX_COMPACT
 
 #if defined(PK_META_PASS_GIVOXELIZE) 
     #undef PK_NORMALMAPS
@@ -109,11 +110,23 @@ Indirect GetStaticSceneIndirect(float3 normal, float3 viewdir, float roughness)
     // Use these to modify surface values in fragment or vertex stage
     void PK_SURFACE_FUNC_VERT(inout SurfaceFragmentVaryings surf);
 
+    // Compact meshes store half positions & uvs which are converted by the input assembler.
+    // Normals & tangents are octahedral encoded & need to be decoded explicitly.
     in float3 in_POSITION;
-    in float3 in_NORMAL;
-    in float4 in_TANGENT;
     in float2 in_TEXCOORD0;
     out SurfaceFragmentVaryings baseVaryings;
+
+    #if defined(PK_VERTEX_COMPACT)
+        in uint in_NORMAL;
+        in uint in_TANGENT;
+        #define PK_VERTEX_NORMAL DecodeOctaUnorm16(in_NORMAL)
+        #define PK_VERTEX_TANGENT DecodeOctaTangent(in_TANGENT)
+    #else
+        in float3 in_NORMAL;
+        in float4 in_TANGENT;
+        #define PK_VERTEX_NORMAL in_NORMAL
+        #define PK_VERTEX_TANGENT in_TANGENT
+    #endif
     
     void main()
     {
@@ -121,7 +134,7 @@ Indirect GetStaticSceneIndirect(float3 normal, float3 viewdir, float roughness)
         baseVaryings.vs_TEXCOORD0 = in_TEXCOORD0;
     
         #if defined(PK_NORMALMAPS) || defined(PK_HEIGHTMAPS)
-            float3x3 TBN = ComposeMikkTangentSpaceMatrix(in_NORMAL, in_TANGENT);
+            float3x3 TBN = ComposeMikkTangentSpaceMatrix(PK_VERTEX_NORMAL, PK_VERTEX_TANGENT);
     
             #if defined(PK_NORMALMAPS)
                 baseVaryings.vs_TSROTATION = TBN;
@@ -133,7 +146,7 @@ Indirect GetStaticSceneIndirect(float3 normal, float3 viewdir, float roughness)
         #endif
     
         #if !defined(PK_NORMALMAPS)
-            baseVaryings.vs_NORMAL = ObjectToWorldDir(in_NORMAL.xyz);
+            baseVaryings.vs_NORMAL = ObjectToWorldDir(PK_VERTEX_NORMAL.xyz);
         #endif
 
         PK_SURFACE_FUNC_VERT(baseVaryings);
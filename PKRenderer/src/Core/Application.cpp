@@ -6,10 +6,15 @@
 #include "Core/Services/Time.h"
 #include "Core/Services/AssetDatabase.h"
 #include "Core/Services/Sequencer.h"
+#include "Core/Services/JobSystem.h"
+#include "Core/Services/Profiler.h"
 #include "Core/ApplicationConfig.h"
 #include "Core/CommandConfig.h"
 #include "Core/UpdateStep.h"
 #include "ECS/EntityDatabase.h"
+#include "ECS/Contextual/Services/CullingCache.h"
+#include "ECS/Contextual/Services/TransformChangeList.h"
+#include "ECS/Contextual/Services/RenderableChangeList.h"
 #include "ECS/Contextual/Engines/EngineCommandInput.h"
 #include "ECS/Contextual/Engines/EngineEditorCamera.h"
 #include "ECS/Contextual/Engines/EngineBuildAccelerationStructure.h"
@@ -21,6 +26,7 @@
 #include "ECS/Contextual/Tokens/TimeToken.h"
 #include "Rendering/RenderPipeline.h"
 #include "Rendering/HashCache.h"
+#include <PKAssets/PKAssetLoader.h>
 
 namespace PK::Core
 {
@@ -46,11 +52,30 @@ namespace PK::Core
         m_services = CreateScope<ServiceRegister>();
         m_services->Create<Debug::Logger>(logfilter);
         m_services->Create<StringHashID>();
+#if defined(PK_PROFILER_ENABLED)
+        m_services->Create<Profiler>();
+#endif
         m_services->Create<HashCache>();
 
         auto entityDb = m_services->Create<PK::ECS::EntityDatabase>();
+        auto cullingCache = m_services->Create<PK::ECS::Services::CullingCache>();
+        auto transformChangeList = m_services->Create<PK::ECS::Services::TransformChangeList>();
+        auto renderableChangeList = m_services->Create<PK::ECS::Services::RenderableChangeList>();
+        auto jobSystem = m_services->Create<JobSystem>(0u);
+
+        PK::Assets::SetDecompressDispatch([](void* context, PK::Assets::PKChunkFunction function, void* args, uint32_t count)
+        {
+            reinterpret_cast<JobSystem*>(context)->ParallelFor(count, 1u, [function, args](uint32_t begin, uint32_t end)
+            {
+                for (auto i = begin; i < end; ++i)
+                {
+                    function(args, i);
+                }
+            });
+        }, jobSystem);
+
         auto sequencer = m_services->Create<Sequencer>();
-        auto assetDatabase = m_services->Create<AssetDatabase>(sequencer);
+        auto assetDatabase = m_services->Create<AssetDatabase>(sequencer, jobSystem);
 
         assetDatabase->LoadDirectory<ApplicationConfig>("res/configs/");
         assetDatabase->LoadDirectory<CommandConfig>("res/configs/");
@@ -60,6 +85,9 @@ namespace PK::Core
         auto time = m_services->Create<Time>(sequencer, config->TimeScale);
         auto input = m_services->Create<Input>(sequencer);
 
+        // Shader sources are read & decoded on workers while the graphics driver & window are created.
+        assetDatabase->LoadDirectoryAsync<Shader>("res/shaders/", 0);
+
         auto workingDirectory = std::filesystem::path(arguments.args[0]).remove_filename().string();
         m_graphicsDriver = GraphicsDriver::Create(workingDirectory, APIType::Vulkan);
 
@@ -76,24 +104,27 @@ namespace PK::Core
         m_window->OnMouseButtonInput = PK_BIND_FUNCTION(input, OnMouseButtonInput);
         m_window->OnClose = PK_BIND_FUNCTION(this, Application::Close);
 
-        assetDatabase->LoadDirectory<Shader>("res/shaders/");
+        assetDatabase->WaitAsyncLoads();
+
+        // Pipelines seen by previous sessions are created up front instead of stalling their first draw.
+        m_graphicsDriver->PrecompilePipelines(assetDatabase, jobSystem);
 
         auto engineEditorCamera = m_services->Create<ECS::Engines::EngineEditorCamera>(sequencer, time, config);
-        auto engineUpdateTransforms = m_services->Create<ECS::Engines::EngineUpdateTransforms>(entityDb);
-        auto renderPipeline = m_services->Create<RenderPipeline>(assetDatabase, entityDb, sequencer, config);
+        auto engineUpdateTransforms = m_services->Create<ECS::Engines::EngineUpdateTransforms>(entityDb, jobSystem, cullingCache, transformChangeList, renderableChangeList);
+        auto renderPipeline = m_services->Create<RenderPipeline>(assetDatabase, entityDb, sequencer, jobSystem, config);
         auto engineCommands = m_services->Create<ECS::Engines::EngineCommandInput>(assetDatabase, sequencer, time, entityDb, commandConfig);
-        auto engineCull = m_services->Create<ECS::Engines::EngineCull>(entityDb);
-        auto engineBuildAccelerationStructure = m_services->Create<ECS::Engines::EngineBuildAccelerationStructure>(entityDb);
+        auto engineCull = m_services->Create<ECS::Engines::EngineCull>(entityDb, cullingCache);
+        auto engineBuildAccelerationStructure = m_services->Create<ECS::Engines::EngineBuildAccelerationStructure>(entityDb, cullingCache, transformChangeList);
         auto engineDebug = m_services->Create<ECS::Engines::EngineDebug>(assetDatabase, entityDb, config);
         auto enginePKAssetBuilder = m_services->Create<ECS::Engines::EnginePKAssetBuilder>(arguments);
-        auto engineScreenshot = m_services->Create<ECS::Engines::EngineScreenshot>();
+        auto engineScreenshot = m_services->Create<ECS::Engines::EngineScreenshot>(renderPipeline);
 
         sequencer->SetSteps(
             {
                 {
                     sequencer->GetRoot(),
                     {
-                        { (int)UpdateStep::OpenFrame,		{ Step::Simple(time) }},
+                        { (int)UpdateStep::OpenFrame,		{ Step::Simple(time), Step::Simple(assetDatabase) }},
                         { (int)UpdateStep::UpdateInput,		{ Step::Conditional<Window>(input) } },
                         { (int)UpdateStep::UpdateEngines,   { Step::Simple(engineUpdateTransforms) } },
                         { (int)UpdateStep::Render,			{ Step::Conditional<Window>(renderPipeline), Step::Token<Window>(engineScreenshot) } },
@@ -119,6 +150,7 @@ namespace PK::Core
                         Step::Token<TokenConsoleCommand>(engineEditorCamera),
                         Step::Token<TokenConsoleCommand>(enginePKAssetBuilder),
                         Step::Token<TokenConsoleCommand>(engineScreenshot),
+                        Step::Token<TokenConsoleCommand>(renderPipeline),
                         //PK_STEP_T(gizmoRenderer, ConsoleCommandToken),
                     }
                 },
@@ -152,6 +184,7 @@ namespace PK::Core
     {
         GetService<Services::Sequencer>()->Release();
         GetService<AssetDatabase>()->Unload();
+        PK::Assets::SetDecompressDispatch(nullptr, nullptr);
         m_services->Clear();
         m_window = nullptr;
         m_graphicsDriver = nullptr;
@@ -15,6 +15,7 @@ namespace PK::Core
             &EnableLightingDebug,
             &EnableCursor,
             &EnableFrameRateLog,
+            &EnableCompactVertices,
             &InitialWidth,
             &InitialHeight,
             &CameraStartPosition,
@@ -31,6 +32,8 @@ namespace PK::Core
             &RandomSeed,
             &LightCount,
             &ShadowmapTileSize,
+            &ShadowmapAtlasBudgetMB,
+            &EnableCPULightAssignment,
             &CameraFocalLength,
             &CameraFNumber,
             &CameraFilmHeight,
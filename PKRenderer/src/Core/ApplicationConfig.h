@@ -12,6 +12,7 @@ namespace PK::Core
         YAML::BoxedValue<bool> EnableLightingDebug = YAML::BoxedValue<bool>("EnableLightingDebug", false);
         YAML::BoxedValue<bool> EnableCursor = YAML::BoxedValue<bool>("EnableCursor", true);
         YAML::BoxedValue<bool> EnableFrameRateLog = YAML::BoxedValue<bool>("EnableFrameRateLog", true);
+        YAML::BoxedValue<bool> EnableCompactVertices = YAML::BoxedValue<bool>("EnableCompactVertices", false);
         YAML::BoxedValue<int> InitialWidth = YAML::BoxedValue<int>("InitialWidth", 1024);
         YAML::BoxedValue<int> InitialHeight = YAML::BoxedValue<int>("InitialHeight", 512);
         YAML::BoxedValue<std::string> FileWindowIcon = YAML::BoxedValue<std::string>("FileWindowIcon", "res/T_AppIcon.bmp");
@@ -33,6 +34,8 @@ namespace PK::Core
 
         YAML::BoxedValue<Math::uint> LightCount = YAML::BoxedValue<Math::uint>("LightCount", 0u);
         YAML::BoxedValue<Math::uint> ShadowmapTileSize = YAML::BoxedValue<Math::uint>("ShadowmapTileSize", 512);
+        YAML::BoxedValue<bool> EnableCPULightAssignment = YAML::BoxedValue<bool>("EnableCPULightAssignment", false);
+        YAML::BoxedValue<Math::uint> ShadowmapAtlasBudgetMB = YAML::BoxedValue<Math::uint>("ShadowmapAtlasBudgetMB", 256);
 
         YAML::BoxedValue<float> CameraFocalLength = YAML::BoxedValue<float>("CameraFocalLength", 0.05f);
         YAML::BoxedValue<float> CameraFNumber = YAML::BoxedValue<float>("CameraFNumber", 1.40f);
@@ -0,0 +1,77 @@
+#include "PrecompiledHeader.h"
+#include "AssetDatabase.h"
+#include "Core/UpdateStep.h"
+
+namespace PK::Core::Services
+{
+    AssetDatabase::~AssetDatabase()
+    {
+        m_jobSystem->Wait(&m_prepareCounter);
+    }
+
+    void AssetDatabase::Step(int condition)
+    {
+        if (condition == (int)UpdateStep::OpenFrame)
+        {
+            ProcessAsyncLoads(PK_ASSET_ASYNC_IMPORTS_PER_FRAME);
+        }
+    }
+
+    void AssetDatabase::ProcessAsyncLoads(uint32_t maxImports)
+    {
+        m_readyLoads.clear();
+
+        for (auto& kv : m_pendingLoads)
+        {
+            if (kv.second->state.load(std::memory_order_acquire) == AssetLoadState::Prepared)
+            {
+                m_readyLoads.push_back(kv.second.get());
+            }
+        }
+
+        std::sort(m_readyLoads.begin(), m_readyLoads.end(), [](const AssetLoadRequest* a, const AssetLoadRequest* b)
+        {
+            return a->priority != b->priority ? a->priority > b->priority : a->sequence < b->sequence;
+        });
+
+        auto count = m_readyLoads.size() < maxImports ? m_readyLoads.size() : (size_t)maxImports;
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            CompleteLoad(m_readyLoads.at(i));
+        }
+    }
+
+    void AssetDatabase::WaitAsyncLoads()
+    {
+        m_jobSystem->Wait(&m_prepareCounter);
+        ProcessAsyncLoads(0xFFFFFFFFu);
+    }
+
+    void AssetDatabase::CompleteLoad(AssetLoadRequest* request)
+    {
+        if (request->state.load(std::memory_order_acquire) == AssetLoadState::Queued)
+        {
+            m_jobSystem->Wait(&m_prepareCounter);
+        }
+
+        // Keep the request alive while it is removed from the pending loads.
+        auto reference = m_pendingLoads.at(request->assetId);
+        m_pendingLoads.erase(request->assetId);
+        request->import();
+        request->import = nullptr;
+        request->state.store(AssetLoadState::Imported, std::memory_order_release);
+    }
+
+    void AssetDatabase::PrepareJob(void* context, uint32_t begin, uint32_t end)
+    {
+        auto request = reinterpret_cast<AssetLoadRequest*>(context);
+
+        if (request->prepare != nullptr)
+        {
+            request->prepare->Prepare(request->filepath.c_str());
+        }
+
+        request->state.store(AssetLoadState::Prepared, std::memory_order_release);
+    }
+}
\ No newline at end of file
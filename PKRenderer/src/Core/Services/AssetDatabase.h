@@ -5,12 +5,15 @@
 #include "Core/Services/Log.h"
 #include "Core/Services/StringHashID.h"
 #include "Core/Services/Sequencer.h"
+#include "Core/Services/JobSystem.h"
 #include <filesystem>
 
 namespace PK::Core::Services
 {
     typedef uint32_t AssetID;
 
+    class AssetDatabase;
+
     class Asset : public Utilities::NoCopy
     {
         friend class AssetDatabase;
@@ -38,6 +41,46 @@ namespace PK::Core::Services
 
     typedef IAssetImport<> IAssetImportSimple;
 
+    // Optional stage for assets loaded through LoadAsync. Invoked on a job system worker before Import.
+    // Should only read & decode source data. Gpu resources are created by Import on the thread that owns the asset database.
+    class IAssetPrepare
+    {
+        friend class AssetDatabase;
+        virtual void Prepare(const char* filepath) = 0;
+    };
+
+    constexpr static const uint32_t PK_ASSET_ASYNC_IMPORTS_PER_FRAME = 8u;
+
+    enum class AssetLoadState : uint32_t
+    {
+        Queued,
+        Prepared,
+        Imported
+    };
+
+    struct AssetLoadRequest : public Utilities::NoCopy
+    {
+        std::string filepath;
+        AssetID assetId = 0u;
+        int32_t priority = 0;
+        uint64_t sequence = 0ull;
+        Utilities::Ref<Asset> asset = nullptr;
+        IAssetPrepare* prepare = nullptr;
+        std::function<void()> import;
+        std::atomic<AssetLoadState> state = AssetLoadState::Queued;
+    };
+
+    template<typename T>
+    struct AssetLoadHandle
+    {
+        Utilities::Ref<AssetLoadRequest> request = nullptr;
+
+        inline bool IsComplete() const { return request->state.load(std::memory_order_acquire) == AssetLoadState::Imported; }
+
+        // Null until the import has completed.
+        inline T* Get() const { return IsComplete() ? static_cast<T*>(request->asset.get()) : nullptr; }
+    };
+
     enum class AssetImportType
     {
         IMPORT,
@@ -60,9 +103,20 @@ namespace PK::Core::Services
         [[nodiscard]] Utilities::Ref<T> Create();
     };
 
-    class AssetDatabase : public IService
+    class AssetDatabase : public IService, public ISimpleStep
     {
     private:
+        template<typename T, typename ... Args>
+        void ImportInternal(const Utilities::Ref<T>& asset, const std::string& filepath, AssetImportType importType, Args&& ... args)
+        {
+            std::static_pointer_cast<Asset>(asset)->m_version++;
+
+            static_cast<IAssetImport<Args...>*>(asset.get())->Import(filepath.c_str(), std::forward<Args>(args)...);
+
+            AssetImportToken<T> importToken = { this, asset.get() };
+            m_sequencer->Next(this, &importToken, (int)importType);
+        }
+
         template<typename T, typename ... Args>
         [[nodiscard]] T* LoadInternal(const std::string& filepath, AssetID assetId, bool reload, Args&& ... args)
         {
@@ -70,6 +124,20 @@ namespace PK::Core::Services
             static_assert(std::is_base_of<IAssetImport<Args...>, T>::value, "Template argument type does not derive from IAssetImport!");
             PK_THROW_ASSERT(std::filesystem::exists(filepath), "Asset not found at path: %s", filepath.c_str());
 
+            // Finish a pending asynchronous load first so that the asset is not imported twice.
+            auto pending = m_pendingLoads.find(assetId);
+
+            if (pending != m_pendingLoads.end())
+            {
+                auto request = pending->second;
+                CompleteLoad(request.get());
+
+                if (!reload)
+                {
+                    return static_cast<T*>(request->asset.get());
+                }
+            }
+
             auto importType = reload ? AssetImportType::RELOAD : AssetImportType::IMPORT;
             auto& collection = m_assets[std::type_index(typeid(T))];
             auto iter = collection.find(assetId);
@@ -92,18 +160,82 @@ namespace PK::Core::Services
                 std::static_pointer_cast<Asset>(asset)->m_assetId = assetId;
             }
 
-            std::static_pointer_cast<Asset>(asset)->m_version++;
-
-            static_cast<IAssetImport<Args...>*>(asset.get())->Import(filepath.c_str(), std::forward<Args>(args)...);
-
-            AssetImportToken<T> importToken = { this, asset.get() };
-            m_sequencer->Next(this, &importToken, (int)importType);
-
+            ImportInternal<T>(asset, filepath, importType, std::forward<Args>(args)...);
             return asset.get();
         }
 
+        void CompleteLoad(AssetLoadRequest* request);
+
     public:
-        AssetDatabase(Sequencer* sequencer) : m_sequencer(sequencer) {}
+        AssetDatabase(Sequencer* sequencer, JobSystem* jobSystem) : m_sequencer(sequencer), m_jobSystem(jobSystem) {}
+        ~AssetDatabase();
+
+        // Imports prepared asynchronous loads at the start of a frame.
+        void Step(int condition) override final;
+
+        // Imports up to maxImports prepared asynchronous loads in priority order.
+        void ProcessAsyncLoads(uint32_t maxImports);
+
+        // Blocks until all asynchronous loads have been imported.
+        void WaitAsyncLoads();
+
+        /*
+         * Source data is read & decoded on job system workers for assets implementing IAssetPrepare.
+         * Imports are applied on the calling thread by ProcessAsyncLoads in descending priority order.
+         * Completion is signaled through the asset import token & the returned handle.
+         * The asset is not visible to Find until imported.
+         */
+        template<typename T, typename ... Args>
+        AssetLoadHandle<T> LoadAsync(const std::string& filepath, int32_t priority, Args&& ... args)
+        {
+            static_assert(std::is_base_of<Asset, T>::value, "Template argument type does not derive from Asset!");
+            static_assert(std::is_base_of<IAssetImport<Args...>, T>::value, "Template argument type does not derive from IAssetImport!");
+            PK_THROW_ASSERT(std::filesystem::exists(filepath), "Asset not found at path: %s", filepath.c_str());
+
+            auto assetId = StringHashID::StringToID(filepath);
+            auto pending = m_pendingLoads.find(assetId);
+
+            if (pending != m_pendingLoads.end())
+            {
+                pending->second->priority = priority > pending->second->priority ? priority : pending->second->priority;
+                return { pending->second };
+            }
+
+            auto request = Utilities::CreateRef<AssetLoadRequest>();
+            request->filepath = filepath;
+            request->assetId = assetId;
+            request->priority = priority;
+            request->sequence = m_loadSequence++;
+
+            auto& collection = m_assets[std::type_index(typeid(T))];
+            auto iter = collection.find(assetId);
+
+            if (iter != collection.end())
+            {
+                request->asset = iter->second;
+                request->state = AssetLoadState::Imported;
+                return { request };
+            }
+
+            auto asset = AssetImporters::Create<T>();
+            std::static_pointer_cast<Asset>(asset)->m_assetId = assetId;
+            request->asset = asset;
+
+            if constexpr (std::is_base_of<IAssetPrepare, T>::value)
+            {
+                request->prepare = static_cast<IAssetPrepare*>(asset.get());
+            }
+
+            request->import = [this, asset, filepath, args...]() mutable
+            {
+                m_assets[std::type_index(typeid(T))][asset->GetAssetID()] = asset;
+                ImportInternal<T>(asset, filepath, AssetImportType::IMPORT, std::forward<Args>(args)...);
+            };
+
+            m_pendingLoads[assetId] = request;
+            m_jobSystem->Schedule(PrepareJob, request.get(), &m_prepareCounter);
+            return { request };
+        }
 
         template<typename T, typename ... Args>
         [[nodiscard]] T* CreateProcedural(std::string name, Args&& ... args)
@@ -210,6 +342,27 @@ namespace PK::Core::Services
             }
         }
 
+        template<typename T, typename ... Args>
+        void LoadDirectoryAsync(const std::string& directory, int32_t priority, Args&& ... args)
+        {
+            static_assert(std::is_base_of<Asset, T>::value, "Template argument type does not derive from Asset!");
+
+            if (!std::filesystem::exists(directory))
+            {
+                return;
+            }
+
+            for (const auto& entry : std::filesystem::directory_iterator(directory))
+            {
+                auto& path = entry.path();
+
+                if (path.has_extension() && AssetImporters::IsValidExtension<T>(path.extension()))
+                {
+                    LoadAsync<T>(entry.path().string(), priority, std::forward<Args>(args)...);
+                }
+            }
+        }
+
         template<typename T, typename ... Args>
         void ReloadDirectory(const std::string& directory, Args&& ... args)
         {
@@ -274,7 +427,12 @@ namespace PK::Core::Services
             m_assets.erase(std::type_index(typeid(T)));
         }
 
-        inline void Unload() { m_assets.clear(); };
+        inline void Unload()
+        {
+            m_jobSystem->Wait(&m_prepareCounter);
+            m_pendingLoads.clear();
+            m_assets.clear();
+        };
 
         template<typename T>
         void ListAssetsOfType()
@@ -306,7 +464,14 @@ namespace PK::Core::Services
         }
 
     private:
+        static void PrepareJob(void* context, uint32_t begin, uint32_t end);
+
         std::unordered_map<std::type_index, std::unordered_map<AssetID, Utilities::Ref<Asset>>> m_assets;
+        std::unordered_map<AssetID, Utilities::Ref<AssetLoadRequest>> m_pendingLoads;
+        std::vector<AssetLoadRequest*> m_readyLoads;
+        JobCounter m_prepareCounter;
+        uint64_t m_loadSequence = 0ull;
         Sequencer* m_sequencer;
+        JobSystem* m_jobSystem;
     };
 }
\ No newline at end of file
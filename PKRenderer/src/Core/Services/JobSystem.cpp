@@ -0,0 +1,272 @@
+#include "PrecompiledHeader.h"
+#include "JobSystem.h"
+#include "Core/Services/Log.h"
+
+namespace PK::Core::Services
+{
+    constexpr static const uint32_t PK_JOB_FOREIGN_THREAD = ~0u;
+    static thread_local uint32_t t_workerIndex = PK_JOB_FOREIGN_THREAD;
+
+    JobSystem::JobSystem(uint32_t workerCount)
+    {
+        if (workerCount == 0u)
+        {
+            auto concurrency = std::thread::hardware_concurrency();
+            workerCount = concurrency > 1u ? concurrency - 1u : 0u;
+        }
+
+        t_workerIndex = 0u;
+        m_workers.reserve(workerCount + 1u);
+
+        for (auto i = 0u; i <= workerCount; ++i)
+        {
+            m_workers.push_back(Utilities::CreateScope<Worker>());
+        }
+
+        // Index 0 is reserved for the thread that owns the job system.
+        for (auto i = 1u; i <= workerCount; ++i)
+        {
+            m_workers.at(i)->thread = std::thread([this, i]() { WorkerMain(i); });
+        }
+
+        PK_LOG_VERBOSE("JobSystem: Started %i worker threads.", workerCount);
+    }
+
+    uint32_t JobSystem::GetWorkerIndex()
+    {
+        return t_workerIndex != PK_JOB_FOREIGN_THREAD ? t_workerIndex : 0u;
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isRunning = false;
+        }
+
+        m_condition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+
+        for (auto job : m_injectedJobs)
+        {
+            delete job;
+        }
+    }
+
+    void JobSystem::Schedule(JobFunction function, void* context, uint32_t begin, uint32_t end, JobCounter* signal, JobCounter* dependency)
+    {
+        Enqueue(function, context, begin, end, signal, dependency);
+        WakeWorkers();
+    }
+
+    void JobSystem::Wait(JobCounter* counter)
+    {
+        while (!counter->IsComplete())
+        {
+            auto job = GetJob();
+
+            if (job != nullptr)
+            {
+                Execute(job);
+                continue;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    void JobSystem::Enqueue(JobFunction function, void* context, uint32_t begin, uint32_t end, JobCounter* signal, JobCounter* dependency)
+    {
+        auto isForeign = t_workerIndex == PK_JOB_FOREIGN_THREAD;
+        auto job = (Job*)nullptr;
+        Job inlineJob;
+
+        if (m_workers.size() > 1)
+        {
+            job = isForeign ? new Job() : AcquireJob(m_workers.at(t_workerIndex).get());
+        }
+
+        if (job == nullptr)
+        {
+            job = &inlineJob;
+        }
+
+        job->function = function;
+        job->context = context;
+        job->begin = begin;
+        job->end = end;
+        job->signal = signal;
+        job->dependency = dependency;
+        job->isPending.store(true, std::memory_order_relaxed);
+        job->isInjected = isForeign && job != &inlineJob;
+
+        if (signal != nullptr)
+        {
+            signal->value.fetch_add(1u, std::memory_order_relaxed);
+        }
+
+        if (job != &inlineJob)
+        {
+            m_pendingJobs.fetch_add(1u, std::memory_order_release);
+
+            if (PushJob(job))
+            {
+                return;
+            }
+
+            m_pendingJobs.fetch_sub(1u, std::memory_order_relaxed);
+        }
+
+        // No workers, no free job slots or queue is saturated. Execute inline.
+        if (dependency != nullptr)
+        {
+            Wait(dependency);
+        }
+
+        Execute(job);
+    }
+
+    Job* JobSystem::AcquireJob(Worker* worker)
+    {
+        // Slots are released by the thread that executes the job. Deferred & stolen jobs may hold theirs past a full cycle of the ring.
+        for (auto i = 0u; i < PK_JOB_QUEUE_CAPACITY; ++i)
+        {
+            auto job = worker->jobs + (worker->jobIndex++ & (PK_JOB_QUEUE_CAPACITY - 1u));
+
+            if (!job->isPending.load(std::memory_order_acquire))
+            {
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool JobSystem::PushJob(Job* job)
+    {
+        if (t_workerIndex != PK_JOB_FOREIGN_THREAD)
+        {
+            return m_workers.at(t_workerIndex)->queue.Push(job);
+        }
+
+        std::lock_guard<std::mutex> lock(m_injectionLock);
+        m_injectedJobs.push_back(job);
+        m_injectedCount.fetch_add(1u, std::memory_order_release);
+        return true;
+    }
+
+    void JobSystem::WakeWorkers()
+    {
+        if (m_workers.size() < 2 || m_pendingJobs.load(std::memory_order_acquire) == 0u)
+        {
+            return;
+        }
+
+        // Acquire the lock to avoid a lost wake up between predicate evaluation & wait.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+
+        m_condition.notify_all();
+    }
+
+    Job* JobSystem::GetJob()
+    {
+        auto workerCount = (uint32_t)m_workers.size();
+        auto isForeign = t_workerIndex == PK_JOB_FOREIGN_THREAD;
+        auto index = isForeign ? 0u : t_workerIndex;
+        auto job = isForeign ? nullptr : m_workers.at(index)->queue.Pop();
+
+        if (job == nullptr && m_injectedCount.load(std::memory_order_acquire) > 0u)
+        {
+            std::lock_guard<std::mutex> lock(m_injectionLock);
+
+            if (!m_injectedJobs.empty())
+            {
+                job = m_injectedJobs.front();
+                m_injectedJobs.pop_front();
+                m_injectedCount.fetch_sub(1u, std::memory_order_relaxed);
+            }
+        }
+
+        // Only the owner may pop from a worker queue. Foreign threads steal from all of them.
+        for (auto i = isForeign ? 0u : 1u; job == nullptr && i < workerCount; ++i)
+        {
+            job = m_workers.at((index + i) % workerCount)->queue.Steal();
+        }
+
+        if (job != nullptr)
+        {
+            m_pendingJobs.fetch_sub(1u, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    void JobSystem::Execute(Job* job)
+    {
+        if (job->dependency != nullptr && !job->dependency->IsComplete())
+        {
+            // Dependencies are still in flight. Defer to the local queue.
+            m_pendingJobs.fetch_add(1u, std::memory_order_release);
+
+            if (PushJob(job))
+            {
+                std::this_thread::yield();
+                return;
+            }
+
+            m_pendingJobs.fetch_sub(1u, std::memory_order_relaxed);
+            Wait(job->dependency);
+        }
+
+        // Release the slot before running so that long running jobs do not hold it.
+        auto function = job->function;
+        auto context = job->context;
+        auto begin = job->begin;
+        auto end = job->end;
+        auto signal = job->signal;
+
+        if (job->isInjected)
+        {
+            delete job;
+        }
+        else
+        {
+            job->isPending.store(false, std::memory_order_release);
+        }
+
+        function(context, begin, end);
+
+        if (signal != nullptr)
+        {
+            signal->value.fetch_sub(1u, std::memory_order_release);
+        }
+    }
+
+    void JobSystem::WorkerMain(uint32_t index)
+    {
+        t_workerIndex = index;
+
+        while (m_isRunning.load(std::memory_order_relaxed))
+        {
+            auto job = GetJob();
+
+            if (job != nullptr)
+            {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_pendingJobs.load(std::memory_order_acquire) > 0u || !m_isRunning.load(std::memory_order_relaxed); });
+        }
+    }
+}
\ No newline at end of file
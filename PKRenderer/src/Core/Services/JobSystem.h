@@ -0,0 +1,120 @@
+#pragma once
+#include "Core/Services/IService.h"
+#include "Utilities/WorkStealingQueue.h"
+#include "Utilities/Ref.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace PK::Core::Services
+{
+    constexpr static const uint32_t PK_JOB_QUEUE_CAPACITY = 4096u;
+
+    // Counts outstanding jobs. Jobs signal the counter on completion & dependent jobs are deferred until it reaches zero.
+    struct JobCounter
+    {
+        std::atomic<uint32_t> value = 0u;
+        inline bool IsComplete() const { return value.load(std::memory_order_acquire) == 0u; }
+    };
+
+    typedef void (*JobFunction)(void* context, uint32_t begin, uint32_t end);
+
+    struct Job
+    {
+        JobFunction function = nullptr;
+        void* context = nullptr;
+        uint32_t begin = 0u;
+        uint32_t end = 0u;
+        JobCounter* signal = nullptr;
+        JobCounter* dependency = nullptr;
+        // Set while the job is queued or deferred. Released by the executing thread.
+        std::atomic<bool> isPending = false;
+        // Scheduled from a thread outside of the job system. Heap allocated & deleted by the executing thread.
+        bool isInjected = false;
+    };
+
+    class JobSystem : public IService
+    {
+        struct Worker
+        {
+            Utilities::WorkStealingQueue<Job, PK_JOB_QUEUE_CAPACITY> queue;
+            Job jobs[PK_JOB_QUEUE_CAPACITY];
+            uint32_t jobIndex = 0u;
+            std::thread thread;
+        };
+
+        public:
+            JobSystem(uint32_t workerCount);
+            ~JobSystem();
+
+            // Includes the main thread
+            inline uint32_t GetWorkerCount() const { return (uint32_t)m_workers.size(); }
+
+            // Index of the calling worker in [0, GetWorkerCount()). Threads outside of the job system report 0.
+            static uint32_t GetWorkerIndex();
+
+            void Schedule(JobFunction function, void* context, uint32_t begin, uint32_t end, JobCounter* signal, JobCounter* dependency = nullptr);
+            inline void Schedule(JobFunction function, void* context, JobCounter* signal, JobCounter* dependency = nullptr) { Schedule(function, context, 0u, 1u, signal, dependency); }
+
+            // Executes pending jobs on the calling thread until the counter reaches zero.
+            void Wait(JobCounter* counter);
+
+            // Splits [0, count) into ranges of at least batchSize elements & blocks until all of them have been processed.
+            template<typename TFunction>
+            void ParallelFor(uint32_t count, uint32_t batchSize, const TFunction& function)
+            {
+                if (count == 0u)
+                {
+                    return;
+                }
+
+                batchSize = batchSize < 1u ? 1u : batchSize;
+
+                if (count <= batchSize || m_workers.size() < 2)
+                {
+                    function(0u, count);
+                    return;
+                }
+
+                auto invoke = [](void* context, uint32_t begin, uint32_t end) { (*reinterpret_cast<const TFunction*>(context))(begin, end); };
+
+                JobCounter counter;
+                auto maxBatchCount = (uint32_t)m_workers.size() * 4u;
+                auto batchCount = (count + batchSize - 1u) / batchSize;
+                batchCount = batchCount > maxBatchCount ? maxBatchCount : batchCount;
+                auto stride = (count + batchCount - 1u) / batchCount;
+
+                for (auto begin = stride; begin < count; begin += stride)
+                {
+                    auto end = begin + stride > count ? count : begin + stride;
+                    Enqueue(invoke, (void*)&function, begin, end, &counter, nullptr);
+                }
+
+                WakeWorkers();
+                function(0u, stride);
+                Wait(&counter);
+            }
+
+        private:
+            void Enqueue(JobFunction function, void* context, uint32_t begin, uint32_t end, JobCounter* signal, JobCounter* dependency);
+            Job* AcquireJob(Worker* worker);
+            // Queues a job from the calling thread. Threads outside of the job system cannot use the worker queues.
+            bool PushJob(Job* job);
+            void WakeWorkers();
+            Job* GetJob();
+            void Execute(Job* job);
+            void WorkerMain(uint32_t index);
+
+            std::vector<Utilities::Scope<Worker>> m_workers;
+            // Jobs scheduled by threads outside of the job system. Checked by workers before stealing.
+            std::deque<Job*> m_injectedJobs;
+            std::mutex m_injectionLock;
+            std::atomic<uint32_t> m_injectedCount = 0u;
+            std::atomic<uint32_t> m_pendingJobs = 0u;
+            std::atomic<bool> m_isRunning = true;
+            std::mutex m_mutex;
+            std::condition_variable m_condition;
+    };
+}
\ No newline at end of file
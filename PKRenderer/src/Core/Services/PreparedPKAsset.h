@@ -0,0 +1,50 @@
+#pragma once
+#include "Utilities/NoCopy.h"
+#include <PKAssets/PKAssetLoader.h>
+
+namespace PK::Core::Services
+{
+    // PKAsset opened ahead of import from IAssetPrepare::Prepare. Open falls back to reading the file if nothing was prepared for the path.
+    // Mapped pages are faulted in by Prepare so that the disk reads happen on the preparing worker instead of during import.
+    class PreparedPKAsset : public Utilities::NoCopy
+    {
+        public:
+            ~PreparedPKAsset() { Release(); }
+
+            void Prepare(const char* filepath)
+            {
+                Release();
+
+                if (PK::Assets::OpenAsset(filepath, &m_asset, true) == 0)
+                {
+                    PK::Assets::PrefetchAsset(&m_asset);
+                    m_filepath = filepath;
+                }
+            }
+
+            int Open(const char* filepath, PK::Assets::PKAsset* outAsset)
+            {
+                if (m_asset.rawData != nullptr && m_filepath == filepath)
+                {
+                    *outAsset = m_asset;
+                    m_asset = {};
+                    m_filepath.clear();
+                    return 0;
+                }
+
+                Release();
+                return PK::Assets::OpenAsset(filepath, outAsset, true);
+            }
+
+            void Release()
+            {
+                PK::Assets::CloseAsset(&m_asset);
+                m_asset = {};
+                m_filepath.clear();
+            }
+
+        private:
+            PK::Assets::PKAsset m_asset{};
+            std::string m_filepath;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "PrecompiledHeader.h"
+#include "Profiler.h"
+#include "Core/Services/Log.h"
+#include <chrono>
+#include <iomanip>
+
+namespace PK::Core::Services
+{
+    struct ThreadBufferBinding
+    {
+        const Profiler* owner = nullptr;
+        void* buffer = nullptr;
+    };
+
+    static thread_local ThreadBufferBinding t_threadBuffer;
+
+    static void WriteEscapedString(std::ofstream& stream, const char* value)
+    {
+        for (auto c = value; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                stream << '\\';
+            }
+
+            stream << *c;
+        }
+    }
+
+    Profiler::Profiler()
+    {
+        m_startTimestamp = GetTimestampNanoseconds();
+    }
+
+    uint64_t Profiler::GetTimestampNanoseconds()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+    {
+        if (t_threadBuffer.owner == this)
+        {
+            return reinterpret_cast<ThreadBuffer*>(t_threadBuffer.buffer);
+        }
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        auto buffer = new ThreadBuffer();
+        buffer->threadIndex = (uint32_t)m_buffers.size();
+        m_buffers.emplace_back(buffer);
+        t_threadBuffer = { this, buffer };
+        return buffer;
+    }
+
+    void Profiler::BeginScope(const char* name)
+    {
+        auto buffer = GetThreadBuffer();
+
+        // Scopes deeper than the stack are not recorded but are still counted so that ends remain balanced.
+        if (buffer->depth < PK_PROFILER_MAX_DEPTH)
+        {
+            buffer->stackNames[buffer->depth] = name;
+            buffer->stackTimestamps[buffer->depth] = GetTimestampNanoseconds();
+        }
+
+        buffer->depth++;
+    }
+
+    void Profiler::EndScope()
+    {
+        auto buffer = GetThreadBuffer();
+
+        if (buffer->depth == 0u)
+        {
+            return;
+        }
+
+        auto depth = --buffer->depth;
+
+        if (depth >= PK_PROFILER_MAX_DEPTH)
+        {
+            return;
+        }
+
+        auto head = buffer->head.load(std::memory_order_relaxed);
+        auto& event = buffer->events[head % PK_PROFILER_MAX_EVENTS_PER_THREAD];
+        event = { buffer->stackNames[depth], buffer->stackTimestamps[depth], GetTimestampNanoseconds(), depth };
+        buffer->head.store(head + 1ull, std::memory_order_release);
+    }
+
+    void Profiler::Clear()
+    {
+        m_clearTimestamp.store(GetTimestampNanoseconds(), std::memory_order_relaxed);
+    }
+
+    void Profiler::WriteChromeTrace(const char* filepath)
+    {
+        std::ofstream stream(filepath);
+
+        if (!stream.is_open())
+        {
+            PK_LOG_WARNING("Failed to open profiler trace file: %s", filepath);
+            return;
+        }
+
+        std::vector<ProfilerEvent> events;
+        std::vector<std::pair<uint32_t, size_t>> threadRanges;
+        auto clearTimestamp = m_clearTimestamp.load(std::memory_order_relaxed);
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            for (auto& buffer : m_buffers)
+            {
+                auto first = events.size();
+                auto head = buffer->head.load(std::memory_order_acquire);
+                auto tail = head > PK_PROFILER_MAX_EVENTS_PER_THREAD ? head - PK_PROFILER_MAX_EVENTS_PER_THREAD : 0ull;
+
+                for (auto i = tail; i < head; ++i)
+                {
+                    events.push_back(buffer->events[i % PK_PROFILER_MAX_EVENTS_PER_THREAD]);
+                }
+
+                // The owning thread may have advanced past the copied range. Discard events that might have been overwritten meanwhile.
+                // The slot at the current head can be partially written.
+                auto headAfter = buffer->head.load(std::memory_order_acquire) + 1ull;
+                auto overwritten = headAfter > PK_PROFILER_MAX_EVENTS_PER_THREAD ? headAfter - PK_PROFILER_MAX_EVENTS_PER_THREAD : 0ull;
+                overwritten = overwritten > tail ? std::min(overwritten - tail, head - tail) : 0ull;
+                events.erase(events.begin() + first, events.begin() + first + overwritten);
+                threadRanges.emplace_back(buffer->threadIndex, events.size() - first);
+            }
+        }
+
+        stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        auto isFirst = true;
+        auto index = 0ull;
+        auto count = 0u;
+
+        for (auto& range : threadRanges)
+        {
+            for (auto i = 0ull; i < range.second; ++i)
+            {
+                auto& event = events[index++];
+
+                if (event.end < clearTimestamp)
+                {
+                    continue;
+                }
+
+                // Timestamps are in microseconds. Fractions retain the nanosecond precision.
+                stream << (isFirst ? "\n" : ",\n") << "{\"name\":\"";
+                WriteEscapedString(stream, event.name);
+                stream << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << range.first;
+                stream << ",\"ts\":" << (event.begin - m_startTimestamp) / 1000ull << '.' << std::setw(3) << std::setfill('0') << (event.begin - m_startTimestamp) % 1000ull;
+                stream << ",\"dur\":" << (event.end - event.begin) / 1000ull << '.' << std::setw(3) << std::setfill('0') << (event.end - event.begin) % 1000ull;
+                stream << ",\"args\":{\"depth\":" << event.depth << "}}";
+                isFirst = false;
+                count++;
+            }
+        }
+
+        stream << "\n]}\n";
+        stream.close();
+        PK_LOG_INFO("Wrote profiler trace with %i events to: %s", count, filepath);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include "Utilities/ISingleton.h"
+#include "Core/Services/IService.h"
+#include <atomic>
+#include <mutex>
+
+namespace PK::Core::Services
+{
+    constexpr static const uint32_t PK_PROFILER_MAX_EVENTS_PER_THREAD = 1u << 16u;
+    constexpr static const uint32_t PK_PROFILER_MAX_DEPTH = 64u;
+
+    struct ProfilerEvent
+    {
+        // Expected to point to static storage. Only the pointer is recorded.
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+        uint32_t depth;
+    };
+
+    /*
+     * Hierarchical cpu timings recorded into per thread ring buffers.
+     * Each buffer has a single writer & is never locked. Threads register their buffer on first use.
+     * Oldest events are overwritten once a buffer wraps around.
+     * Recorded events can be dumped as a chrome trace (chrome://tracing, perfetto) with the console command "profiler dump <filepath>".
+     */
+    class Profiler : public IService, public Utilities::ISingleton<Profiler>
+    {
+        struct ThreadBuffer
+        {
+            ProfilerEvent events[PK_PROFILER_MAX_EVENTS_PER_THREAD];
+            // Written by the owning thread only. Read when dumping to discard events that were overwritten during the copy.
+            std::atomic<uint64_t> head = 0ull;
+            const char* stackNames[PK_PROFILER_MAX_DEPTH];
+            uint64_t stackTimestamps[PK_PROFILER_MAX_DEPTH];
+            uint32_t depth = 0u;
+            uint32_t threadIndex = 0u;
+        };
+
+        public:
+            Profiler();
+
+            void BeginScope(const char* name);
+            void EndScope();
+
+            // Drops recorded events. Scopes that are currently open are still recorded once they end.
+            void Clear();
+            void WriteChromeTrace(const char* filepath);
+
+            static uint64_t GetTimestampNanoseconds();
+
+        private:
+            ThreadBuffer* GetThreadBuffer();
+
+            std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+            std::mutex m_lock;
+            // Events with an end timestamp below this are omitted from dumps.
+            std::atomic<uint64_t> m_clearTimestamp = 0ull;
+            uint64_t m_startTimestamp = 0ull;
+    };
+
+    struct ProfilerScope : public Utilities::NoCopy
+    {
+        ProfilerScope(const char* name)
+        {
+            m_profiler = Profiler::Get();
+
+            if (m_profiler != nullptr)
+            {
+                m_profiler->BeginScope(name);
+            }
+        }
+
+        ~ProfilerScope()
+        {
+            if (m_profiler != nullptr)
+            {
+                m_profiler->EndScope();
+            }
+        }
+
+        private: Profiler* m_profiler;
+    };
+}
+
+// Markers are compiled out of release builds.
+#if defined(PK_DEBUG)
+#define PK_PROFILER_ENABLED
+#endif
+
+#if defined(PK_PROFILER_ENABLED)
+#define PK_PROFILE_CONCAT_INTERNAL(a, b) a##b
+#define PK_PROFILE_CONCAT(a, b) PK_PROFILE_CONCAT_INTERNAL(a, b)
+#define PK_PROFILE_SCOPE(name) PK::Core::Services::ProfilerScope PK_PROFILE_CONCAT(pk_profile_scope_, __LINE__)(name)
+#define PK_PROFILE_FUNCTION() PK_PROFILE_SCOPE(__FUNCTION__)
+// Non scoped markers for sequential sections within a function. Every begin must be matched by an end on the same thread.
+#define PK_PROFILE_BEGIN(name) { auto pk_profiler = PK::Core::Services::Profiler::Get(); if (pk_profiler != nullptr) { pk_profiler->BeginScope(name); } }
+#define PK_PROFILE_END() { auto pk_profiler = PK::Core::Services::Profiler::Get(); if (pk_profiler != nullptr) { pk_profiler->EndScope(); } }
+#else
+#define PK_PROFILE_SCOPE(name)
+#define PK_PROFILE_FUNCTION()
+#define PK_PROFILE_BEGIN(name)
+#define PK_PROFILE_END()
+#endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "Core/Services/IService.h"
+#include "Core/Services/Profiler.h"
 #include "Utilities/Ref.h"
 
 namespace PK::Core::Services
@@ -103,6 +104,7 @@ namespace PK::Core::Services
             template<typename T>
             void InvokeSteps(const std::vector<Step>* branchSteps, T* token, int condition)
             {
+                PK_PROFILE_SCOPE(typeid(T).name());
                 using TToken = IStep<T>*;
                 using TConditional = IConditionalStep<T>*;
                 auto typeToken = std::type_index(typeid(TToken));
@@ -10,9 +10,23 @@ namespace PK::ECS::Components
         Math::float3 scale = Math::PK_FLOAT3_ONE;
         Math::float4x4 localToWorld = Math::PK_FLOAT4X4_IDENTITY;
         Math::float4x4 worldToLocal = Math::PK_FLOAT4X4_IDENTITY;
+        // Position, rotation & scale are relative to the parent when one is assigned.
+        Transform* parent = nullptr;
+        // Set by writers of the local values & cleared once the world matrices have been recomputed.
+        bool isDirty = true;
+        // Update index of the last world matrix change. Used to propagate changes to children.
+        uint32_t updateIndex = 0u;
+
+        inline void SetPosition(const Math::float3& value) { position = value; isDirty = true; }
+        inline void SetRotation(const Math::quaternion& value) { rotation = value; isDirty = true; }
+        inline void SetScale(const Math::float3& value) { scale = value; isDirty = true; }
+        inline void SetParent(Transform* value) { parent = value; isDirty = true; }
+        inline void MarkDirty() { isDirty = true; }
 
         inline Math::float4x4 GetLocalToWorld() const { return Math::Functions::GetMatrixTRS(position, rotation, scale); }
         inline Math::float4x4 GetWorldToLocal() const { return Math::Functions::GetMatrixInvTRS(position, rotation, scale); }
+        inline Math::float3 GetWorldPosition() const { return Math::float3(localToWorld[3]); }
+        inline Math::float3 GetWorldForward() const { return glm::normalize(Math::float3(localToWorld[2])); }
 
         virtual ~Transform() = default;
     };
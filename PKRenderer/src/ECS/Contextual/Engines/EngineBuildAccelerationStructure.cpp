@@ -1,6 +1,5 @@
 #include "PrecompiledHeader.h"
 #include "EngineBuildAccelerationStructure.h"
-#include "ECS/Contextual/EntityViews/BaseRenderableView.h"
 #include "ECS/Contextual/EntityViews/MeshRenderableView.h"
 #include "Math/FunctionsIntersect.h"
 
@@ -10,7 +9,57 @@ namespace PK::ECS::Engines
     using namespace PK::ECS::EntityViews;
     using namespace PK::Math;
 
-    EngineBuildAccelerationStructure::EngineBuildAccelerationStructure(EntityDatabase* entityDb) : m_entityDb(entityDb)
+    struct AccelerationStructureVisitor
+    {
+        const Services::CullingCache* cache;
+        const BoundingBox* bounds;
+        uint32_t requiredFlags;
+        std::vector<EGID>* egids;
+
+        inline bool Classify(const BoundingBox& nodeBounds, uint32_t* partial, uint32_t* inside) const
+        {
+            if (!Functions::IntersectAABB(*bounds, nodeBounds))
+            {
+                return false;
+            }
+
+            if (Functions::BoundsContains(*bounds, nodeBounds))
+            {
+                *partial = 0u;
+                *inside = 1u;
+            }
+
+            return true;
+        }
+
+        void Visit(uint32_t first, uint32_t count, uint32_t partial, uint32_t inside)
+        {
+            for (auto i = first; i < first + count; ++i)
+            {
+                if ((cache->flags[i] & requiredFlags) != requiredFlags)
+                {
+                    continue;
+                }
+
+                if (partial != 0u)
+                {
+                    auto slotBounds = BoundingBox({ cache->minX[i], cache->minY[i], cache->minZ[i] }, { cache->maxX[i], cache->maxY[i], cache->maxZ[i] });
+
+                    if (!Functions::IntersectAABB(*bounds, slotBounds))
+                    {
+                        continue;
+                    }
+                }
+
+                egids->push_back(EGID(cache->entityIds[i], (uint32_t)ECS::ENTITY_GROUPS::ACTIVE));
+            }
+        }
+    };
+
+    EngineBuildAccelerationStructure::EngineBuildAccelerationStructure(EntityDatabase* entityDb, Services::CullingCache* cullingCache, Services::TransformChangeList* changeList) : 
+        m_entityDb(entityDb),
+        m_cullingCache(cullingCache),
+        m_changeList(changeList)
     {
     }
 
@@ -18,47 +67,132 @@ namespace PK::ECS::Engines
     {
         PK_THROW_ASSERT(token != nullptr && token->structure, "Invalid token supplied!");
 
-        m_renderableEgids.clear();
+        // Changes of frames without a build are not recorded anywhere. Rewrite everything after a gap.
+        m_isWriteRequired |= token->structure != m_structure || m_changeList->updateIndex - m_updateIndex > 1u;
+        m_structure = token->structure;
+        m_updateIndex = m_changeList->updateIndex;
 
-        auto renderables = m_entityDb->Query<BaseRenderableView>((uint32_t)ECS::ENTITY_GROUPS::ACTIVE);
-        auto mask = token->mask;
-        auto aabb = token->bounds;
-        auto structure = token->structure;
-        auto requiredFlags = (RenderableFlags::Mesh | RenderableFlags::RayTraceable);
+        if (UpdateEntitySet(token) || m_isWriteRequired)
+        {
+            WriteInstances(token);
+            return;
+        }
+
+        UpdateInstances(token);
+    }
 
-        for (auto i = 0u; i < renderables.count; ++i)
+    EngineBuildAccelerationStructure::EntityRecord* EngineBuildAccelerationStructure::GetRecord(uint32_t entityId)
+    {
+        if (entityId >= m_records.size())
         {
-            auto renderable = &renderables[i];
-            auto flags = renderable->renderable->flags;
+            m_records.resize(entityId + 1u);
+        }
 
-            if ((flags & requiredFlags) != requiredFlags ||
-                (flags & mask) != mask)
-            {
-                continue;
-            }
+        return &m_records[entityId];
+    }
+
+    bool EngineBuildAccelerationStructure::UpdateEntitySet(Tokens::AccelerationStructureBuildToken* token)
+    {
+        auto buildIndex = ++m_buildIndex;
+        m_visitedEgids.clear();
+        m_addedEgids.clear();
+
+        for (const auto& egid : m_renderableEgids)
+        {
+            GetRecord(egid.entityID())->listIndex = buildIndex;
+        }
+
+        auto requiredFlags = (uint32_t)(RenderableFlags::Mesh | RenderableFlags::RayTraceable | token->mask);
+        AccelerationStructureVisitor visitor = { m_cullingCache, &token->bounds, requiredFlags, &m_visitedEgids };
+        m_cullingCache->Traverse(visitor, requiredFlags, token->useBounds ? 1u : 0u);
 
-            auto bounds = renderable->bounds->worldAABB;
+        for (const auto& egid : m_visitedEgids)
+        {
+            auto record = GetRecord(egid.entityID());
+            record->visitIndex = buildIndex;
 
-            if (token->useBounds && !Functions::IntersectAABB(aabb, bounds))
+            if (record->listIndex != buildIndex)
             {
-                continue;
+                m_addedEgids.push_back(egid);
             }
+        }
 
-            m_renderableEgids.push_back(renderable->GID);
+        // Without additions the sets can only differ by removals.
+        if (m_addedEgids.empty() && m_visitedEgids.size() == m_renderableEgids.size())
+        {
+            return false;
         }
 
-        structure->BeginWrite(token->queue, (uint32_t)m_renderableEgids.size());
+        // Traversal order follows the culling hierarchy which changes as entities move.
+        // Remaining entities keep their order & new ones are appended so that unchanged instances keep their slots.
+        auto removed = std::remove_if(m_renderableEgids.begin(), m_renderableEgids.end(), [this, buildIndex](const EGID& egid)
+        {
+            return m_records[egid.entityID()].visitIndex != buildIndex;
+        });
+
+        m_renderableEgids.erase(removed, m_renderableEgids.end());
+        m_renderableEgids.insert(m_renderableEgids.end(), m_addedEgids.begin(), m_addedEgids.end());
+        return true;
+    }
+
+    void EngineBuildAccelerationStructure::WriteInstances(Tokens::AccelerationStructureBuildToken* token)
+    {
+        auto structure = token->structure;
+        auto instanceLimit = 0u;
+
+        for (const auto& egid : m_renderableEgids)
+        {
+            instanceLimit += (uint32_t)m_entityDb->Query<MeshRenderableView>(egid)->materials->materials.size();
+        }
+
+        structure->BeginWrite(token->queue, instanceLimit);
+        m_isWriteRequired = false;
 
         for (const auto& egid : m_renderableEgids)
         {
             auto renderable = m_entityDb->Query<MeshRenderableView>(egid);
+            auto record = GetRecord(egid.entityID());
+            record->firstInstance = structure->GetInstanceCount();
 
+            // Instances skipped due to pending mesh uploads are added by the next write.
             for (const auto& material : renderable->materials->materials)
             {
-                structure->AddInstance(renderable->mesh->sharedMesh, material.submesh, 0u, renderable->transform->localToWorld);
+                m_isWriteRequired |= !structure->AddInstance(renderable->mesh->sharedMesh, material.submesh, 0u, renderable->transform->localToWorld);
+            }
+
+            record->instanceCount = structure->GetInstanceCount() - record->firstInstance;
+        }
+
+        structure->EndWrite();
+    }
+
+    void EngineBuildAccelerationStructure::UpdateInstances(Tokens::AccelerationStructureBuildToken* token)
+    {
+        auto structure = token->structure;
+        structure->BeginUpdate(token->queue);
+
+        for (auto entityId : m_changeList->entityIds)
+        {
+            if (entityId >= m_records.size())
+            {
+                continue;
+            }
+
+            const auto& record = m_records[entityId];
+
+            if (record.listIndex != m_buildIndex || record.instanceCount == 0u)
+            {
+                continue;
+            }
+
+            auto renderable = m_entityDb->Query<MeshRenderableView>(EGID(entityId, (uint32_t)ECS::ENTITY_GROUPS::ACTIVE));
+
+            for (auto i = 0u; i < record.instanceCount; ++i)
+            {
+                structure->SetInstanceTransform(record.firstInstance + i, renderable->transform->localToWorld);
             }
         }
 
         structure->EndWrite();
     }
-}
+}
\ No newline at end of file
@@ -3,18 +3,48 @@
 #include "Core/Services/Sequencer.h"
 #include "ECS/EntityDatabase.h"
 #include "ECS/Contextual/Tokens/AccelerationStructureBuildToken.h"
+#include "ECS/Contextual/Services/CullingCache.h"
+#include "ECS/Contextual/Services/TransformChangeList.h"
 
 namespace PK::ECS::Engines
 {
+    /*
+     * Instances are kept in the order their entities were first added so that the structure can be refit instead of rebuilt.
+     * The instance set is rewritten when entities enter or leave it. Otherwise only the transforms of changed entities are updated.
+     * Mesh & material changes of entities already in the set are not tracked.
+     */
     class EngineBuildAccelerationStructure : public Core::Services::IService,
         public Core::Services::IStep<Tokens::AccelerationStructureBuildToken>
     {
     public:
-        EngineBuildAccelerationStructure(EntityDatabase* entityDb);
+        EngineBuildAccelerationStructure(EntityDatabase* entityDb, Services::CullingCache* cullingCache, Services::TransformChangeList* changeList);
         void Step(Tokens::AccelerationStructureBuildToken* token) override final;
 
     private:
+        struct EntityRecord
+        {
+            uint32_t listIndex = 0u;
+            uint32_t visitIndex = 0u;
+            uint32_t firstInstance = 0u;
+            uint32_t instanceCount = 0u;
+        };
+
+        EntityRecord* GetRecord(uint32_t entityId);
+        bool UpdateEntitySet(Tokens::AccelerationStructureBuildToken* token);
+        void WriteInstances(Tokens::AccelerationStructureBuildToken* token);
+        void UpdateInstances(Tokens::AccelerationStructureBuildToken* token);
+
         EntityDatabase* m_entityDb = nullptr;
+        Services::CullingCache* m_cullingCache = nullptr;
+        Services::TransformChangeList* m_changeList = nullptr;
+        Rendering::Objects::AccelerationStructure* m_structure = nullptr;
+        // Entities of the previous write in instance order.
         std::vector<EGID> m_renderableEgids;
+        std::vector<EGID> m_visitedEgids;
+        std::vector<EGID> m_addedEgids;
+        std::vector<EntityRecord> m_records;
+        uint32_t m_buildIndex = 0u;
+        uint32_t m_updateIndex = 0u;
+        bool m_isWriteRequired = true;
     };
-}
\ No newline at end of file
+}
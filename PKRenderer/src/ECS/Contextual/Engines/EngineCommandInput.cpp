@@ -2,6 +2,7 @@
 #include "EngineCommandInput.h"
 #include "Core/Application.h"
 #include "Core/ApplicationConfig.h"
+#include "Core/Services/Profiler.h"
 #include "Rendering/GraphicsAPI.h"
 #include "Rendering/Objects/Texture.h"
 #include "Rendering/Objects/Material.h"
@@ -26,6 +27,11 @@ namespace PK::ECS::Engines
         {std::string("assets"),     CommandArgument::Assets},
         {std::string("assetmeta"),  CommandArgument::AssetMeta},
         {std::string("gpu_memory"), CommandArgument::GPUMemory},
+        {std::string("pipelines"),  CommandArgument::Pipelines},
+        {std::string("staging"),    CommandArgument::Staging},
+        {std::string("profiler"),   CommandArgument::Profiler},
+        {std::string("dump"),       CommandArgument::Dump},
+        {std::string("clear"),      CommandArgument::Clear},
         {std::string("shader"),     CommandArgument::TypeShader},
         {std::string("mesh"),       CommandArgument::TypeMesh},
         {std::string("texture"),    CommandArgument::TypeTexture},
@@ -75,6 +81,65 @@ namespace PK::ECS::Engines
         PK_LOG_NEWLINE();
     }
 
+    void EngineCommandInput::QueryPipelines(const ConsoleCommand& arguments)
+    {
+        PK_LOG_HEADER("----------PIPELINE CACHE INFO----------");
+        auto info = Rendering::GraphicsAPI::GetPipelineInfo();
+        PK_LOG_NEWLINE();
+        PK_LOG_INFO("Pipeline count: %i", info.pipelineCount);
+        PK_LOG_INFO("Manifest entry count: %i", info.manifestCount);
+        PK_LOG_INFO("Precompiled: %i (%.2fms)", info.precompiledCount, info.precompileMilliseconds);
+        PK_LOG_INFO("Misses: %i (%.2fms)", info.missCount, info.missMilliseconds);
+        PK_LOG_INFO("Max misses per frame: %i", info.maxFrameMissCount);
+        PK_LOG_INFO("Max miss duration: %.2fms", info.maxMissMilliseconds);
+        PK_LOG_INFO("Misses in the last %i frames:", Rendering::PK_PIPELINE_MISS_HISTORY_SIZE);
+
+        for (auto i = 0u; i < Rendering::PK_PIPELINE_MISS_HISTORY_SIZE; ++i)
+        {
+            if (info.frameMissCounts[i] > 0u)
+            {
+                PK_LOG_INFO("   Frame -%i: %i (%.2fms)", i + 1, info.frameMissCounts[i], info.frameMissMilliseconds[i]);
+            }
+        }
+
+        PK_LOG_NEWLINE();
+    }
+
+    void EngineCommandInput::QueryStaging(const ConsoleCommand& arguments)
+    {
+        PK_LOG_HEADER("----------STAGING MEMORY INFO----------");
+        auto info = Rendering::GraphicsAPI::GetStagingInfo();
+        PK_LOG_NEWLINE();
+        PK_LOG_INFO("Ring capacity: %s", Functions::BytesToString(info.ringCapacity).c_str());
+        PK_LOG_INFO("Ring in flight: %s", Functions::BytesToString(info.ringUsedBytes).c_str());
+        PK_LOG_INFO("Ring peak in flight: %s", Functions::BytesToString(info.ringPeakUsedBytes).c_str());
+        PK_LOG_INFO("Ring exhausted: %i, Grown: %i", info.ringExhaustedCount, info.ringGrowCount);
+        PK_LOG_INFO("Allocations: %i", info.allocationCount);
+        PK_LOG_INFO("Last frame: %i (%s)", info.frameAllocationCount, Functions::BytesToString(info.frameBytes).c_str());
+        PK_LOG_INFO("Peak frame: %s", Functions::BytesToString(info.peakFrameBytes).c_str());
+        PK_LOG_INFO("Dedicated: %i (%s), Active: %i", info.dedicatedCount, Functions::BytesToString(info.dedicatedBytes).c_str(), info.dedicatedActiveCount);
+        PK_LOG_NEWLINE();
+    }
+
+    void EngineCommandInput::ProfilerDump(const ConsoleCommand& arguments)
+    {
+        #if defined(PK_PROFILER_ENABLED)
+            Profiler::Get()->WriteChromeTrace(arguments[2].c_str());
+        #else
+            PK_LOG_WARNING("Profiler markers are not enabled in this build.");
+        #endif
+    }
+
+    void EngineCommandInput::ProfilerClear(const ConsoleCommand& arguments)
+    {
+        #if defined(PK_PROFILER_ENABLED)
+            Profiler::Get()->Clear();
+            PK_LOG_INFO("Profiler events cleared.");
+        #else
+            PK_LOG_WARNING("Profiler markers are not enabled in this build.");
+        #endif
+    }
+
     void EngineCommandInput::ReloadTime(const ConsoleCommand& arguments)
     {
         Application::GetService<Time>()->Reset();
@@ -172,6 +237,10 @@ namespace PK::ECS::Engines
         m_commands[{CommandArgument::Query, CommandArgument::TypeTexture, CommandArgument::StringParameter, CommandArgument::AssetMeta}] = PK_BIND_FUNCTION(this, QueryAssetMeta<Texture>);
         m_commands[{CommandArgument::Query, CommandArgument::TypeMesh, CommandArgument::StringParameter, CommandArgument::AssetMeta}] = PK_BIND_FUNCTION(this, QueryAssetMeta<Mesh>);
         m_commands[{CommandArgument::Query, CommandArgument::GPUMemory}] = PK_BIND_FUNCTION(this, QueryGPUMemory);
+        m_commands[{CommandArgument::Query, CommandArgument::Pipelines}] = PK_BIND_FUNCTION(this, QueryPipelines);
+        m_commands[{CommandArgument::Query, CommandArgument::Staging}] = PK_BIND_FUNCTION(this, QueryStaging);
+        m_commands[{CommandArgument::Profiler, CommandArgument::Dump, CommandArgument::StringParameter}] = PK_BIND_FUNCTION(this, ProfilerDump);
+        m_commands[{CommandArgument::Profiler, CommandArgument::Clear}] = PK_BIND_FUNCTION(this, ProfilerClear);
         m_commands[{CommandArgument::Query, CommandArgument::Assets, CommandArgument::TypeShader}] = PK_BIND_FUNCTION(this, QueryLoadedShaders);
         m_commands[{CommandArgument::Query, CommandArgument::Assets, CommandArgument::TypeMaterial}] = PK_BIND_FUNCTION(this, QueryLoadedMaterials);
         m_commands[{CommandArgument::Query, CommandArgument::Assets, CommandArgument::TypeMesh}] = PK_BIND_FUNCTION(this, QueryLoadedMeshes);
@@ -22,6 +22,11 @@ namespace PK::ECS::Engines
 		StringParameter,
 		AssetMeta,
 		GPUMemory,
+		Pipelines,
+		Staging,
+		Profiler,
+		Dump,
+		Clear,
 		TypeShader,
 		TypeMesh,
 		TypeTexture,
@@ -70,6 +75,10 @@ namespace PK::ECS::Engines
 			}
 
 			void QueryGPUMemory(const ConsoleCommand& arguments);
+			void QueryPipelines(const ConsoleCommand& arguments);
+			void QueryStaging(const ConsoleCommand& arguments);
+			void ProfilerDump(const ConsoleCommand& arguments);
+			void ProfilerClear(const ConsoleCommand& arguments);
 			void ReloadTime(const ConsoleCommand& arguments);
 			void ReloadAppConfig(const ConsoleCommand& arguments);
 			void ReloadShaders(const ConsoleCommand& arguments);
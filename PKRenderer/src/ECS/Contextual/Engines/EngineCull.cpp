@@ -1,162 +1,525 @@
 #include "PrecompiledHeader.h"
 #include "EngineCull.h"
-#include "ECS/Contextual/EntityViews/BaseRenderableView.h"
 #include "Math/FunctionsIntersect.h"
+#include "Math/SIMD.h"
 
 namespace PK::ECS::Engines
 {
-    using namespace ECS::EntityViews;
     using namespace ECS::Tokens;
+    using namespace ECS::Services;
     using namespace Rendering::Structs;
     using namespace Math;
+    using namespace Math::SIMD;
 
-    EngineCull::EngineCull(EntityDatabase* entityDb) : m_entityDb(entityDb)
+    template<typename T>
+    struct PlaneSIMD
     {
+        T x, y, z, w;
+        bool sx, sy, sz;
+
+        PlaneSIMD() {}
+        PlaneSIMD(const float4& p) : x(p.x), y(p.y), z(p.z), w(p.w), sx(p.x > 0), sy(p.y > 0), sz(p.z > 0) {}
+
+        // Distance from the plane to the aabb corner furthest along the plane normal.
+        inline T MaxDistance(const T* bmin, const T* bmax) const
+        {
+            return x * (sx ? bmax[0] : bmin[0]) + y * (sy ? bmax[1] : bmin[1]) + z * (sz ? bmax[2] : bmin[2]) + w;
+        }
+
+        inline T MinDistance(const T* bmin, const T* bmax) const
+        {
+            return x * (sx ? bmin[0] : bmax[0]) + y * (sy ? bmin[1] : bmax[1]) + z * (sz ? bmin[2] : bmax[2]) + w;
+        }
+    };
+
+    template<typename T>
+    static inline void LoadBounds(const CullingCache* cache, size_t i, T* bmin, T* bmax)
+    {
+        bmin[0] = T::Load(cache->minX.GetOffset(i));
+        bmin[1] = T::Load(cache->minY.GetOffset(i));
+        bmin[2] = T::Load(cache->minZ.GetOffset(i));
+        bmax[0] = T::Load(cache->maxX.GetOffset(i));
+        bmax[1] = T::Load(cache->maxY.GetOffset(i));
+        bmax[2] = T::Load(cache->maxZ.GetOffset(i));
     }
 
-    void EngineCull::Step(TokenCullFrustum* token)
+    // Lanes past the end of the range are masked out. Cache arrays are padded so that the loads remain valid.
+    template<typename T>
+    static inline uint32_t GetLaneMask(size_t i, size_t end)
+    {
+        auto remaining = end - i;
+        return remaining >= T::Width ? T::LaneMask : ((1u << remaining) - 1u);
+    }
+
+    template<typename T>
+    static inline T GetFixedDepth(const T& depth)
+    {
+        return Min(Max(depth, T(0.0f)), T((float)0xFFFF));
+    }
+
+    // Scales the lod screen size thresholds to the depth at which a radius of one projects to them.
+    template<typename T>
+    static inline void GetLodThresholds(float sizePerDepth, T* thresholds)
+    {
+        for (auto i = 0u; i < PK_MAX_MESH_LODS - 1u; ++i)
+        {
+            thresholds[i] = T(PK_MESH_LOD_SCREEN_SIZES[i] * sizePerDepth);
+        }
+    }
+
+    // Counts the thresholds that the projected bounding sphere falls below without dividing by depth.
+    // Perspective views clamp depth to the radius so that bounds intersecting the view origin select the base level.
+    template<typename T>
+    static inline T GetLodLevel(const T* thresholds, const T& radius, const T& distance)
+    {
+        auto one = T(1.0f);
+        auto level = T(0.0f);
+
+        for (auto i = 0u; i < PK_MAX_MESH_LODS - 1u; ++i)
+        {
+            level = level + ((radius < thresholds[i] * distance) & one);
+        }
+
+        return level;
+    }
+
+    template<typename T>
+    static inline T GetBoundingRadius(const T* bmin, const T* bmax)
     {
-        auto invDepthRange = (float)(0xFFFF) / token->depthRange;
-        auto results = token->results;
-        auto planes = token->planes.planes;
-        auto mask = token->mask;
-        auto cullables = m_entityDb->Query<BaseRenderableView>((uint32_t)ECS::ENTITY_GROUPS::ACTIVE);
+        auto half = T(0.5f);
+        auto ex = (bmax[0] - bmin[0]) * half;
+        auto ey = (bmax[1] - bmin[1]) * half;
+        auto ez = (bmax[2] - bmin[2]) * half;
+        return Sqrt(ex * ex + ey * ey + ez * ez);
+    }
 
-        for (auto i = 0u; i < cullables.count; ++i)
+    // Narrows the partial & inside frustum masks for a bvh node. Frustums that fully contain the node are moved to the inside mask.
+    static bool ClassifyFrustums(const FrustumPlanes* frustums, uint32_t count, const BoundingBox& bounds, uint32_t* partial, uint32_t* inside)
+    {
+        for (auto i = 0u; i < count; ++i)
         {
-            auto cullable = &cullables[i];
-            auto flags = cullable->renderable->flags;
+            auto bit = 1u << i;
 
-            if ((flags & mask) != mask)
+            if ((*partial & bit) == 0u)
             {
                 continue;
             }
 
-            auto isVisible = (flags & RenderableFlags::Cullable) == 0 || Functions::IntersectPlanesAABB(planes, 6, cullable->bounds->worldAABB);
+            auto isInside = true;
 
-            if (!isVisible)
+            for (auto j = 0u; j < 6u; ++j)
             {
-                continue;
+                auto& plane = frustums[i].planes[j];
+
+                if (Functions::PlaneMaxDistanceToAABB(plane, bounds) < 0.0f)
+                {
+                    *partial &= ~bit;
+                    isInside = false;
+                    break;
+                }
+
+                isInside &= Functions::PlaneMinDistanceToAABB(plane, bounds) >= 0.0f;
             }
 
-            auto depth = Functions::PlaneMaxDistanceToAABB(planes[4], cullable->bounds->worldAABB) * invDepthRange;
-            auto fixedDepth = glm::min(0xFFFFu, (uint32_t)glm::max(0.0f, depth));
-            results->Add(cullable->GID.entityID(), (uint16_t)fixedDepth, 0u);
+            if (isInside)
+            {
+                *partial &= ~bit;
+                *inside |= bit;
+            }
         }
+
+        return (*partial | *inside) != 0u;
     }
 
-    void EngineCull::Step(TokenCullCubeFaces* token)
+    template<typename T>
+    struct FrustumVisitor
     {
-        const float3 planeNormals[] = { {-1,1,0}, {1,1,0}, {1,0,1}, {1,0,-1}, {0,1,1}, {0,-1,1} };
-        const float3 absPlaneNormals[] = { {1,1,0}, {1,1,0}, {1,0,1}, {1,0,1}, {0,1,1}, {0,1,1} };
+        const CullingCache* cache;
+        TokenCullFrustum* token;
+        PlaneSIMD<T> planes[6];
+        T invDepthRange;
+        T lodThresholds[PK_MAX_MESH_LODS - 1u];
 
-        auto invDepthRange = (float)(0xFFFF) / token->depthRange;
-        auto results = token->results;
-        auto aabbCenter = token->aabb.GetCenter();
-        auto aabb = token->aabb;
-        auto mask = token->mask;
-        auto cullables = m_entityDb->Query<BaseRenderableView>((uint32_t)ECS::ENTITY_GROUPS::ACTIVE);
+        FrustumVisitor(const CullingCache* cache, TokenCullFrustum* token) : cache(cache), token(token), invDepthRange((float)(0xFFFF) / token->depthRange)
+        {
+            for (auto i = 0u; i < 6u; ++i)
+            {
+                planes[i] = PlaneSIMD<T>(token->planes.planes[i]);
+            }
+
+            GetLodThresholds(token->lodSizePerDepth, lodThresholds);
+        }
 
-        for (auto i = 0u; i < cullables.count; ++i)
+        inline bool Classify(const BoundingBox& bounds, uint32_t* partial, uint32_t* inside) const
         {
-            auto cullable = &cullables[i];
-            auto flags = cullable->renderable->flags;
+            return ClassifyFrustums(&token->planes, 1u, bounds, partial, inside);
+        }
+
+        void Visit(uint32_t first, uint32_t count, uint32_t partial, uint32_t inside)
+        {
+            auto results = token->results;
+            auto mask = (uint32_t)token->mask;
+            auto isCullableFlag = (uint32_t)RenderableFlags::Cullable;
+            auto end = (size_t)first + count;
 
-            if ((flags & mask) != mask)
+            T bmin[3], bmax[3];
+            uint32_t depths[T::Width];
+            uint32_t lods[T::Width];
+            T half(0.5f);
+
+            for (size_t i = first; i < end; i += T::Width)
             {
-                continue;
+                auto isMasked = T::TestFlags(cache->flags.GetOffset(i), mask);
+                auto laneMask = isMasked.MoveMask() & GetLaneMask<T>(i, end);
+
+                if (laneMask == 0u)
+                {
+                    continue;
+                }
+
+                LoadBounds(cache, i, bmin, bmax);
+
+                if (partial != 0u)
+                {
+                    auto isVisible = T::TestFlagsZero(cache->flags.GetOffset(i), isCullableFlag);
+                    auto isInside = planes[0].MaxDistance(bmin, bmax) >= T(0.0f);
+
+                    for (auto j = 1u; j < 6u; ++j)
+                    {
+                        isInside = isInside & (planes[j].MaxDistance(bmin, bmax) >= T(0.0f));
+                    }
+
+                    laneMask &= (isVisible | isInside).MoveMask();
+
+                    if (laneMask == 0u)
+                    {
+                        continue;
+                    }
+                }
+
+                auto maxDepth = planes[4].MaxDistance(bmin, bmax);
+                auto centerDepth = (maxDepth + planes[4].MinDistance(bmin, bmax)) * half;
+                GetFixedDepth(maxDepth * invDepthRange).StoreUint(depths);
+                auto radius = GetBoundingRadius(bmin, bmax);
+                GetLodLevel(lodThresholds, radius, Max(centerDepth, radius)).StoreUint(lods);
+
+                for (auto lane = 0u; lane < T::Width; ++lane)
+                {
+                    if (laneMask & (1u << lane))
+                    {
+                        results->Add(cache->entityIds[i + lane], (uint16_t)depths[lane], 0u, (uint8_t)lods[lane]);
+                    }
+                }
             }
+        }
+    };
 
-            auto bounds = cullable->bounds->worldAABB;
+    template<typename T>
+    struct CubeFacesVisitor
+    {
+        const CullingCache* cache;
+        TokenCullCubeFaces* token;
+        T invDepthRange;
+        T aabbMin[3];
+        T aabbMax[3];
+        T center[3];
+        T lodThresholds[PK_MAX_MESH_LODS - 1u];
 
-            if (!Functions::IntersectAABB(aabb, bounds))
+        CubeFacesVisitor(const CullingCache* cache, TokenCullCubeFaces* token) : cache(cache), token(token), invDepthRange((float)(0xFFFF) / token->depthRange)
+        {
+            auto aabbCenter = token->aabb.GetCenter();
+
+            for (auto i = 0u; i < 3u; ++i)
             {
-                continue;
+                aabbMin[i] = T(token->aabb.min[i]);
+                aabbMax[i] = T(token->aabb.max[i]);
+                center[i] = T(aabbCenter[i]);
             }
 
-            auto center = bounds.GetCenter() - aabbCenter;
-            auto extents = bounds.GetExtents();
+            GetLodThresholds(token->lodSizePerDepth, lodThresholds);
+        }
 
-            // Not accurate but fast(er than other solutions)
-            auto depth = glm::min(0xFFFFu, (uint32_t)(glm::length(center) * invDepthRange));
+        inline bool Classify(const BoundingBox& bounds, uint32_t* partial, uint32_t* inside) const
+        {
+            auto& aabb = token->aabb;
 
-            bool rp[6], rn[6], vis[6];
+            if (!Functions::IntersectAABB(aabb, bounds))
+            {
+                return false;
+            }
 
-            // Source: https://newq.net/dl/pub/s2015_shadows.pdf
-            for (uint32_t j = 0u; j < 6; ++j)
+            if (Functions::BoundsContains(aabb, bounds))
             {
-                auto dist = glm::dot(center, planeNormals[j]);
-                auto radius = glm::dot(extents, absPlaneNormals[j]);
-                rp[j] = dist > -radius;
-                rn[j] = dist < radius;
+                *partial = 0u;
+                *inside = 1u;
             }
 
-            vis[PK_CUBE_FACE_RIGHT] = rn[0] && rp[1] && rp[2] && rp[3] && bounds.max.x > aabbCenter.x;
-            vis[PK_CUBE_FACE_LEFT] = rp[0] && rn[1] && rn[2] && rn[3] && bounds.min.x < aabbCenter.x;
-            vis[PK_CUBE_FACE_UP] = rp[0] && rp[1] && rp[4] && rn[5] && bounds.max.y > aabbCenter.y;
-            vis[PK_CUBE_FACE_DOWN] = rn[0] && rn[1] && rn[4] && rp[5] && bounds.min.y < aabbCenter.y;
-            vis[PK_CUBE_FACE_FRONT] = rp[2] && rn[3] && rp[4] && rp[5] && bounds.max.z > aabbCenter.z;
-            vis[PK_CUBE_FACE_BACK] = rn[2] && rp[3] && rn[4] && rn[5] && bounds.min.z < aabbCenter.z;
+            return true;
+        }
 
-            auto isCullable = (flags & RenderableFlags::Cullable) != 0;
-            auto id = cullable->GID.entityID();
+        void Visit(uint32_t first, uint32_t count, uint32_t partial, uint32_t inside)
+        {
+            auto results = token->results;
+            auto mask = (uint32_t)token->mask;
+            auto isCullableFlag = (uint32_t)RenderableFlags::Cullable;
+            auto end = (size_t)first + count;
+            T half(0.5f);
+            T zero(0.0f);
 
-            for (auto j = 0u; j < 6u; ++j)
+            T bmin[3], bmax[3];
+            uint32_t depths[T::Width];
+            uint32_t lods[T::Width];
+
+            for (size_t i = first; i < end; i += T::Width)
             {
-                if (!isCullable || vis[j])
+                auto isMasked = T::TestFlags(cache->flags.GetOffset(i), mask);
+                auto laneMask = isMasked.MoveMask() & GetLaneMask<T>(i, end);
+
+                if (laneMask == 0u)
                 {
-                    results->Add(id, (uint16_t)depth, j);
+                    continue;
+                }
+
+                LoadBounds(cache, i, bmin, bmax);
+
+                if (partial != 0u)
+                {
+                    auto overlap = (bmax[0] >= aabbMin[0]) & (bmin[0] <= aabbMax[0]) &
+                                   (bmax[1] >= aabbMin[1]) & (bmin[1] <= aabbMax[1]) &
+                                   (bmax[2] >= aabbMin[2]) & (bmin[2] <= aabbMax[2]);
+
+                    laneMask &= overlap.MoveMask();
+
+                    if (laneMask == 0u)
+                    {
+                        continue;
+                    }
+                }
+
+                auto cx = (bmin[0] + bmax[0]) * half - center[0];
+                auto cy = (bmin[1] + bmax[1]) * half - center[1];
+                auto cz = (bmin[2] + bmax[2]) * half - center[2];
+                auto ex = (bmax[0] - bmin[0]) * half;
+                auto ey = (bmax[1] - bmin[1]) * half;
+                auto ez = (bmax[2] - bmin[2]) * half;
+
+                // Plane normals: { {-1,1,0}, {1,1,0}, {1,0,1}, {1,0,-1}, {0,1,1}, {0,-1,1} }
+                // Source: https://newq.net/dl/pub/s2015_shadows.pdf
+                T dist[6] = { cy - cx, cx + cy, cx + cz, cx - cz, cy + cz, cz - cy };
+                T radius[6] = { ex + ey, ex + ey, ex + ez, ex + ez, ey + ez, ey + ez };
+                T rp[6], rn[6];
+
+                for (auto j = 0u; j < 6u; ++j)
+                {
+                    rp[j] = dist[j] > (zero - radius[j]);
+                    rn[j] = dist[j] < radius[j];
+                }
+
+                auto isNonCullable = T::TestFlagsZero(cache->flags.GetOffset(i), isCullableFlag);
+
+                uint32_t vis[6];
+                vis[PK_CUBE_FACE_RIGHT] = (isNonCullable | (rn[0] & rp[1] & rp[2] & rp[3] & (bmax[0] > center[0]))).MoveMask();
+                vis[PK_CUBE_FACE_LEFT] = (isNonCullable | (rp[0] & rn[1] & rn[2] & rn[3] & (bmin[0] < center[0]))).MoveMask();
+                vis[PK_CUBE_FACE_UP] = (isNonCullable | (rp[0] & rp[1] & rp[4] & rn[5] & (bmax[1] > center[1]))).MoveMask();
+                vis[PK_CUBE_FACE_DOWN] = (isNonCullable | (rn[0] & rn[1] & rn[4] & rp[5] & (bmin[1] < center[1]))).MoveMask();
+                vis[PK_CUBE_FACE_FRONT] = (isNonCullable | (rp[2] & rn[3] & rp[4] & rp[5] & (bmax[2] > center[2]))).MoveMask();
+                vis[PK_CUBE_FACE_BACK] = (isNonCullable | (rn[2] & rp[3] & rn[4] & rn[5] & (bmin[2] < center[2]))).MoveMask();
+
+                // Not accurate but fast(er than other solutions)
+                auto distance = Sqrt(cx * cx + cy * cy + cz * cz);
+                Min(distance * invDepthRange, T((float)0xFFFF)).StoreUint(depths);
+                auto boundingRadius = Sqrt(ex * ex + ey * ey + ez * ez);
+                GetLodLevel(lodThresholds, boundingRadius, Max(distance, boundingRadius)).StoreUint(lods);
+
+                for (auto lane = 0u; lane < T::Width; ++lane)
+                {
+                    auto bit = 1u << lane;
+
+                    if ((laneMask & bit) == 0u)
+                    {
+                        continue;
+                    }
+
+                    auto id = cache->entityIds[i + lane];
+
+                    for (auto j = 0u; j < 6u; ++j)
+                    {
+                        if (vis[j] & bit)
+                        {
+                            results->Add(id, (uint16_t)depths[lane], j, (uint8_t)lods[lane]);
+                        }
+                    }
                 }
             }
         }
-    }
+    };
 
-    void EngineCull::Step(TokenCullCascades* token)
+    template<typename T>
+    struct CascadesVisitor
     {
-        auto count = token->count;
-        auto visibilities = PK_STACK_ALLOC(bool, count);
-        auto invDepthRange = (float)(0xFFFF) / token->depthRange;
-        auto results = token->results;
-        auto cascades = token->cascades;
-        auto mask = token->mask;
-        auto cullables = m_entityDb->Query<BaseRenderableView>((uint32_t)ECS::ENTITY_GROUPS::ACTIVE);
+        const CullingCache* cache;
+        TokenCullCascades* token;
+        T invDepthRange;
+        // Stack arrays instead of alloca to guarantee register width alignment.
+        PlaneSIMD<T> planes[PK_SHADOW_CASCADE_COUNT * 6u];
+        T lodThresholds[PK_SHADOW_CASCADE_COUNT * (PK_MAX_MESH_LODS - 1u)];
 
-        for (auto i = 0; i < cullables.count; ++i)
+        CascadesVisitor(const CullingCache* cache, TokenCullCascades* token) : cache(cache), token(token), invDepthRange((float)(0xFFFF) / token->depthRange)
         {
-            auto cullable = &cullables[i];
-            auto flags = cullable->renderable->flags;
+            PK_THROW_ASSERT(token->count <= PK_SHADOW_CASCADE_COUNT, "Cascade count exceeds maximum supported count!");
 
-            if ((flags & mask) != mask)
+            for (auto i = 0u; i < token->count * 6u; ++i)
             {
-                continue;
+                planes[i] = PlaneSIMD<T>(token->cascades[i / 6u].planes[i % 6u]);
             }
 
-            auto isVisible = false;
-            auto isCullable = (flags & RenderableFlags::Cullable) != 0;
-            auto bounds = cullable->bounds->worldAABB;
-
-            for (auto j = 0u; j < count; ++j)
+            // Cascades are orthographic. The half height is the distance between the normalized top & bottom planes halved.
+            for (auto i = 0u; i < token->count; ++i)
             {
-                isVisible |= visibilities[j] = !isCullable || Functions::IntersectPlanesAABB(cascades[j].planes, 6, bounds);
+                auto& cascade = token->cascades[i].planes;
+                auto halfHeight = (cascade[2].w + cascade[3].w) * 0.5f;
+                GetLodThresholds(token->lodSizePerDepth * halfHeight, lodThresholds + i * (PK_MAX_MESH_LODS - 1u));
             }
+        }
 
-            if (!isVisible)
-            {
-                continue;
-            }
+        inline bool Classify(const BoundingBox& bounds, uint32_t* partial, uint32_t* inside) const
+        {
+            return ClassifyFrustums(token->cascades, token->count, bounds, partial, inside);
+        }
 
-            auto id = cullable->GID.entityID();
+        void Visit(uint32_t first, uint32_t count, uint32_t partial, uint32_t inside)
+        {
+            auto cascadeCount = token->count;
+            auto results = token->results;
+            auto mask = (uint32_t)token->mask;
+            auto isCullableFlag = (uint32_t)RenderableFlags::Cullable;
+            auto end = (size_t)first + count;
+
+            uint32_t visibilities[PK_SHADOW_CASCADE_COUNT];
+            uint32_t depths[PK_SHADOW_CASCADE_COUNT * T::Width];
+            uint32_t lods[PK_SHADOW_CASCADE_COUNT * T::Width];
+            T bmin[3], bmax[3];
+            T one(1.0f);
 
-            for (auto j = 0u; j < count; ++j)
+            for (size_t i = first; i < end; i += T::Width)
             {
-                if (visibilities[j])
+                auto isMasked = T::TestFlags(cache->flags.GetOffset(i), mask);
+                auto laneMask = isMasked.MoveMask() & GetLaneMask<T>(i, end);
+
+                if (laneMask == 0u)
                 {
-                    auto depth = Functions::PlaneMinDistanceToAABB(cascades[j].planes[4], bounds) * invDepthRange;
-                    auto fixedDepth = glm::min(0xFFFFu, (uint32_t)glm::max(0.0f, depth));
-                    results->Add(id, (uint16_t)fixedDepth, j);
+                    continue;
+                }
+
+                LoadBounds(cache, i, bmin, bmax);
+
+                auto isNonCullable = T::TestFlagsZero(cache->flags.GetOffset(i), isCullableFlag);
+                auto radius = GetBoundingRadius(bmin, bmax);
+                auto anyVisible = 0u;
+
+                for (auto j = 0u; j < cascadeCount; ++j)
+                {
+                    auto bit = 1u << j;
+                    auto cascade = planes + j * 6u;
+                    visibilities[j] = 0u;
+
+                    if (inside & bit)
+                    {
+                        visibilities[j] = laneMask;
+                    }
+                    else if (partial & bit)
+                    {
+                        auto isInside = cascade[0].MaxDistance(bmin, bmax) >= T(0.0f);
+
+                        for (auto k = 1u; k < 6u; ++k)
+                        {
+                            isInside = isInside & (cascade[k].MaxDistance(bmin, bmax) >= T(0.0f));
+                        }
+
+                        visibilities[j] = (isNonCullable | isInside).MoveMask() & laneMask;
+                    }
+
+                    if (visibilities[j] != 0u)
+                    {
+                        anyVisible |= visibilities[j];
+                        GetFixedDepth(cascade[4].MinDistance(bmin, bmax) * invDepthRange).StoreUint(depths + j * T::Width);
+                        GetLodLevel(lodThresholds + j * (PK_MAX_MESH_LODS - 1u), radius, one).StoreUint(lods + j * T::Width);
+                    }
+                }
+
+                if (anyVisible == 0u)
+                {
+                    continue;
+                }
+
+                for (auto lane = 0u; lane < T::Width; ++lane)
+                {
+                    auto bit = 1u << lane;
+
+                    if ((anyVisible & bit) == 0u)
+                    {
+                        continue;
+                    }
+
+                    auto id = cache->entityIds[i + lane];
+
+                    for (auto j = 0u; j < cascadeCount; ++j)
+                    {
+                        if (visibilities[j] & bit)
+                        {
+                            results->Add(id, (uint16_t)depths[j * T::Width + lane], j, (uint8_t)lods[j * T::Width + lane]);
+                        }
+                    }
                 }
             }
         }
+    };
+
+    template<typename TVisitor, typename TToken>
+    static void Cull(const CullingCache* cache, TToken* token, uint32_t testMask)
+    {
+        TVisitor visitor(cache, token);
+        cache->Traverse(visitor, (uint32_t)token->mask, testMask);
+    }
+
+    EngineCull::EngineCull(EntityDatabase* entityDb, CullingCache* cullingCache) : m_entityDb(entityDb), m_cullingCache(cullingCache)
+    {
+        m_useAVX2 = SupportsAVX2();
     }
 
+    void EngineCull::Step(TokenCullFrustum* token)
+    {
+        if (m_useAVX2)
+        {
+            Cull<FrustumVisitor<floatx8>>(m_cullingCache, token, 1u);
+        }
+        else
+        {
+            Cull<FrustumVisitor<floatx4>>(m_cullingCache, token, 1u);
+        }
+    }
+
+    void EngineCull::Step(TokenCullCubeFaces* token)
+    {
+        if (m_useAVX2)
+        {
+            Cull<CubeFacesVisitor<floatx8>>(m_cullingCache, token, 1u);
+        }
+        else
+        {
+            Cull<CubeFacesVisitor<floatx4>>(m_cullingCache, token, 1u);
+        }
+    }
+
+    void EngineCull::Step(TokenCullCascades* token)
+    {
+        if (m_useAVX2)
+        {
+            Cull<CascadesVisitor<floatx8>>(m_cullingCache, token, (1u << token->count) - 1u);
+        }
+        else
+        {
+            Cull<CascadesVisitor<floatx4>>(m_cullingCache, token, (1u << token->count) - 1u);
+        }
+    }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Core/Services/Sequencer.h"
 #include "ECS/EntityDatabase.h"
 #include "ECS/Contextual/Tokens/CullingTokens.h"
+#include "ECS/Contextual/Services/CullingCache.h"
 
 namespace PK::ECS::Engines
 {
@@ -12,12 +13,14 @@ namespace PK::ECS::Engines
 					   public Core::Services::IStep<Tokens::TokenCullCascades>
 	{
 		public:
-			EngineCull(EntityDatabase* entityDb);
+			EngineCull(EntityDatabase* entityDb, Services::CullingCache* cullingCache);
 			void Step(Tokens::TokenCullFrustum* token) override final;
 			void Step(Tokens::TokenCullCubeFaces* token) override final;
 			void Step(Tokens::TokenCullCascades* token) override final;
 
 		private:
 			EntityDatabase* m_entityDb = nullptr;
+			Services::CullingCache* m_cullingCache = nullptr;
+			bool m_useAVX2 = false;
 	};
 }
\ No newline at end of file
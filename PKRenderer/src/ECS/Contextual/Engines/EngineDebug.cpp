@@ -30,6 +30,19 @@ namespace PK::ECS::Engines
 
         BufferLayout positionLayout = { { ElementType::Float3, PK_VS_POSITION } };
 
+        // Octahedral normals & tangents, half texcoords & positions. 20 bytes per vertex instead of 48.
+        if (config->EnableCompactVertices)
+        {
+            defaultLayout =
+            {
+                { ElementType::Uint, PK_VS_NORMAL },
+                { ElementType::Uint, PK_VS_TANGENT },
+                { ElementType::Half2, PK_VS_TEXCOORD0 },
+            };
+
+            positionLayout = { { ElementType::Half4, PK_VS_POSITION } };
+        }
+
         auto virtualVBuffer0 = Buffer::Create(defaultLayout, 2000000, BufferUsage::SparseVertex, "VirtualMesh.VertexBuffer0");
         auto virtualVBuffer1 = Buffer::Create(positionLayout, 2000000, BufferUsage::SparseVertex, "VirtualMesh.VertexBuffer1");
         auto virtualIBuffer = Buffer::Create(ElementType::Uint, 2000000, BufferUsage::SparseIndex, "VirtualMesh.IndexBuffer");
@@ -100,8 +113,8 @@ namespace PK::ECS::Engines
         {
             // auto ypos = sin(time * 2 + ((float)i * 4 / lights.count));
             auto rotation = glm::quat(float3(0, time + float(i), 0));
-            lights[i].transformLight->rotation = rotation;
-            lights[i].transformMesh->rotation = rotation;
+            lights[i].transformLight->SetRotation(rotation);
+            lights[i].transformMesh->SetRotation(rotation);
             //lights[i].transformLight->position.y = ypos;
             //lights[i].transformMesh->position.y = ypos;
         }
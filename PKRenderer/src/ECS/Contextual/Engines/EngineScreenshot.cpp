@@ -1,7 +1,10 @@
 #include "PrecompiledHeader.h"
 #include "EngineScreenshot.h"
 #include "Rendering/GraphicsAPI.h"
-#include "Utilities/FileIOBMP.h"
+#include "Utilities/FileIOPNG.h"
+#include "Utilities/FileIOEXR.h"
+#include "Math/SIMD.h"
+#include <filesystem>
 
 namespace PK::ECS::Engines
 {
@@ -12,113 +15,404 @@ namespace PK::ECS::Engines
     using namespace Rendering::Structs;
     using namespace Rendering::Objects;
 
-    EngineScreenshot::EngineScreenshot() : m_accumulatedPixels(1)
+    static_assert(255u * PK_SCREENSHOT_ACCUMULATION_FRAMES <= 0xFFFFu, "Accumulated 8 bit values must fit into 16 bits!");
+
+    static void AccumulateUNorm8(uint16_t* sums, const uint8_t* values, size_t count)
     {
+        auto i = 0ull;
+        auto zero = _mm_setzero_si128();
+
+        for (; i + 16ull <= count; i += 16ull)
+        {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+            auto s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i));
+            auto s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i + 8ull));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), _mm_add_epi16(s0, _mm_unpacklo_epi8(v, zero)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i + 8ull), _mm_add_epi16(s1, _mm_unpackhi_epi8(v, zero)));
+        }
+
+        for (; i < count; ++i)
+        {
+            sums[i] += values[i];
+        }
     }
 
-    void EngineScreenshot::Step(Window* window)
+    // F16C conversions are available on every cpu that supports AVX2.
+    static void AccumulateHalf(float* sums, const uint16_t* values, size_t count)
     {
-        m_currentResolution = uint2(window->GetResolution().xy);
+        auto i = 0ull;
 
-        if (m_currentResolution != m_captureResolution)
+        if (SIMD::SupportsAVX2())
         {
-            m_captureCounter = 0u;
-            m_copyFence.Invalidate();
-            return;
+            for (; i + 8ull <= count; i += 8ull)
+            {
+                auto v = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)));
+                _mm256_storeu_ps(sums + i, _mm256_add_ps(_mm256_loadu_ps(sums + i), v));
+            }
         }
 
-        if (m_captureCounter == 0 || (m_copyFence.IsValid() && !m_copyFence.IsComplete()))
+        for (; i < count; ++i)
         {
-            return;
+            sums[i] += glm::unpackHalf1x16(values[i]);
         }
+    }
 
-        auto elementCount = m_captureResolution.x * m_captureResolution.y * 4;
+    static void ResolveHalf(uint16_t* values, const float* sums, size_t count, float scale)
+    {
+        auto i = 0ull;
 
-        auto cmd = GraphicsAPI::GetQueues()->GetCommandBuffer(QueueType::Graphics);
+        if (SIMD::SupportsAVX2())
+        {
+            auto s = _mm256_set1_ps(scale);
+
+            for (; i + 8ull <= count; i += 8ull)
+            {
+                auto v = _mm256_mul_ps(_mm256_loadu_ps(sums + i), s);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+            }
+        }
 
-        if (m_copyFence.IsValid() && m_copyFence.IsComplete())
+        for (; i < count; ++i)
         {
-            auto pxView = m_copyBuffer->BeginRead<unsigned char>();
+            values[i] = glm::packHalf1x16(sums[i] * scale);
+        }
+    }
 
-            for (auto i = 0u; i < elementCount; ++i)
+    // Window pixels are bgra.
+    static void ResolveUNorm8(uint8_t* rgb, const uint16_t* sums, size_t pixelCount, uint32_t frameCount)
+    {
+        for (auto i = 0ull; i < pixelCount; ++i)
+        {
+            for (auto c = 0u; c < 3u; ++c)
             {
-                m_accumulatedPixels[i] += pxView[i];
+                auto value = (sums[i * 4ull + 2ull - c] + frameCount / 2u) / frameCount;
+                rgb[i * 3ull + c] = (uint8_t)(value > 255u ? 255u : value);
             }
+        }
+    }
 
-            m_copyBuffer->EndRead();
+    static void ConvertUNorm8(uint8_t* rgb, const uint8_t* bgra, size_t pixelCount)
+    {
+        for (auto i = 0ull; i < pixelCount; ++i)
+        {
+            rgb[i * 3ull + 0ull] = bgra[i * 4ull + 2ull];
+            rgb[i * 3ull + 1ull] = bgra[i * 4ull + 1ull];
+            rgb[i * 3ull + 2ull] = bgra[i * 4ull + 0ull];
         }
+    }
 
-        m_captureCounter--;
-        m_copyFence.Invalidate();
+    EngineScreenshot::EngineScreenshot(RenderPipeline* renderPipeline) :
+        m_renderPipeline(renderPipeline),
+        m_accumulatedPixels(1),
+        m_accumulatedPixelsHDR(1)
+    {
+        m_worker = std::thread(&EngineScreenshot::WorkerMain, this);
+    }
 
-        if (m_captureCounter > 0)
+    EngineScreenshot::~EngineScreenshot()
+    {
         {
-            cmd->Blit(window, m_copyBuffer.get());
-            m_copyFence = cmd->GetFenceRef();
-            return;
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_isRunning = false;
+        }
+
+        m_condition.notify_all();
+        m_worker.join();
+    }
+
+    void EngineScreenshot::Step(Window* window)
+    {
+        m_currentResolution = uint2(window->GetResolution().xy);
+
+        // Copies complete in submission order as they are all recorded on the graphics queue.
+        while (!m_copyJobs.empty() && m_copyJobs.front().slot->fence.IsComplete())
+        {
+            auto& job = m_copyJobs.front();
+            job.slot->fence.Invalidate();
+            job.slot->state = SlotState::Queued;
+
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_jobs.push_back(job);
+            }
+
+            m_condition.notify_one();
+            m_copyJobs.pop_front();
         }
 
-        auto pixels = PK_CONTIGUOUS_ALLOC(byte, elementCount);
+        if (m_capture.framesRemaining == 0u)
+        {
+            return;
+        }
 
-        for (auto i = 0u; i < elementCount; ++i)
+        if (m_currentResolution != m_capture.resolution)
         {
-            auto value = m_accumulatedPixels[i] / m_captureFrameCount;
+            PK_LOG_WARNING("Screenshot capture canceled due to a resolution change.");
+            m_capture.framesRemaining = 0u;
+            return;
+        }
+
+        ReadbackSlot* slot = nullptr;
 
-            if (value > 255)
+        for (auto& candidate : m_slots)
+        {
+            if (candidate.state == SlotState::Free)
             {
-                value = 255;
+                slot = &candidate;
+                break;
             }
+        }
+
+        if (slot == nullptr)
+        {
+            m_capture.droppedFrames += m_capture.isSequence ? 1u : 0u;
+            return;
+        }
+
+        auto isHDR = m_capture.format == CaptureFormat::EXR;
+        auto elementCount = m_capture.resolution.x * m_capture.resolution.y * (isHDR ? 2u : 1u);
 
-            pixels[i] = value;
+        if (slot->buffer == nullptr)
+        {
+            slot->buffer = Buffer::Create(
+                { { ElementType::Uint, "DATA"} },
+                elementCount,
+                BufferUsage::GPUToCPU | BufferUsage::TransferDst | BufferUsage::TransferSrc,
+                "Screenshot Copy Buffer");
+        }
+        else
+        {
+            slot->buffer->Validate(elementCount);
         }
 
-        auto filename = std::string("Screenshot0.bmp");
-        auto index = 0;
+        auto cmd = GraphicsAPI::GetQueues()->GetCommandBuffer(QueueType::Graphics);
 
-        while (std::filesystem::exists(filename))
+        if (isHDR)
         {
-            filename = std::string("Screenshot") + std::to_string(++index) + std::string(".bmp");
+            cmd->Blit(m_renderPipeline->GetSceneColorHDR(), slot->buffer.get());
         }
+        else
+        {
+            cmd->Blit(window, slot->buffer.get());
+        }
+
+        slot->fence = cmd->GetFenceRef();
+        slot->state = SlotState::Copying;
 
-        Utilities::FileIO::WriteBMP(filename.c_str(), pixels, m_captureResolution.x, m_captureResolution.y);
-        free(pixels);
+        Job job{ slot, m_capture.format, m_capture.resolution, m_capture.frameCount, m_capture.sequenceFrame++, false };
 
-        PK_LOG_INFO("Screenshot captured: %s", filename.c_str());
+        if (!m_capture.isSequence)
+        {
+            job.isLast = --m_capture.framesRemaining == 0u;
+        }
+
+        m_copyJobs.push_back(job);
     }
 
     void EngineScreenshot::Step(TokenConsoleCommand* token)
     {
-        if (token->isConsumed || token->argument != "take_screenshot")
+        if (token->isConsumed)
+        {
+            return;
+        }
+
+        if (token->argument == "take_screenshot")
+        {
+            BeginCapture(CaptureFormat::PNG, false);
+        }
+        else if (token->argument == "take_screenshot_exr")
+        {
+            BeginCapture(CaptureFormat::EXR, false);
+        }
+        else if (token->argument == "toggle_screenshot_sequence" || token->argument == "toggle_screenshot_sequence_exr")
+        {
+            if (m_capture.isSequence && m_capture.framesRemaining > 0u)
+            {
+                PK_LOG_INFO("Screenshot sequence ended. Frames: %i, Dropped: %i", m_capture.sequenceFrame, m_capture.droppedFrames);
+                m_capture.framesRemaining = 0u;
+            }
+            else
+            {
+                BeginCapture(token->argument == "toggle_screenshot_sequence" ? CaptureFormat::PNG : CaptureFormat::EXR, true);
+            }
+        }
+        else
         {
             return;
         }
 
         token->isConsumed = true;
+    }
 
-        if (m_captureCounter > 0 || m_currentResolution.x == 0 || m_currentResolution.y == 0)
+    bool EngineScreenshot::IsIdle() const
+    {
+        for (auto& slot : m_slots)
+        {
+            if (slot.state != SlotState::Free)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void EngineScreenshot::BeginCapture(CaptureFormat format, bool isSequence)
+    {
+        if (m_currentResolution.x == 0 || m_currentResolution.y == 0)
         {
             return;
         }
 
-        m_captureResolution = m_currentResolution;
+        // Accumulation buffers are owned by the worker until all previous captures have been written.
+        if (m_capture.framesRemaining > 0u || !IsIdle())
+        {
+            PK_LOG_WARNING("Previous screenshot capture is still in progress.");
+            return;
+        }
 
-        if (m_copyBuffer == nullptr)
+        m_capture = Capture();
+        m_capture.format = format;
+        m_capture.resolution = m_currentResolution;
+        m_capture.isSequence = isSequence;
+        m_capture.frameCount = isSequence ? 0u : PK_SCREENSHOT_ACCUMULATION_FRAMES;
+        m_capture.framesRemaining = isSequence ? 0xFFFFFFFFu : PK_SCREENSHOT_ACCUMULATION_FRAMES;
+
+        if (!isSequence && format == CaptureFormat::PNG)
         {
-            m_copyBuffer = Buffer::Create(
-                { { ElementType::Uint, "DATA"} },
-                m_currentResolution.x * m_currentResolution.y,
-                BufferUsage::GPUToCPU | BufferUsage::TransferDst | BufferUsage::TransferSrc,
-                "Screenshot Copy Buffer");
+            m_accumulatedPixels.Validate(m_currentResolution.x * m_currentResolution.y * 4, true);
+            m_accumulatedPixels.Clear();
+        }
+
+        if (!isSequence && format == CaptureFormat::EXR)
+        {
+            m_accumulatedPixelsHDR.Validate(m_currentResolution.x * m_currentResolution.y * 4, true);
+            m_accumulatedPixelsHDR.Clear();
+        }
+    }
+
+    void EngineScreenshot::WorkerMain()
+    {
+        while (true)
+        {
+            Job job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_condition.wait(lock, [this]() { return !m_jobs.empty() || !m_isRunning; });
+
+                // Pending jobs are still written when closing.
+                if (m_jobs.empty())
+                {
+                    return;
+                }
+
+                job = m_jobs.front();
+                m_jobs.pop_front();
+            }
+
+            ProcessJob(job);
+        }
+    }
+
+    void EngineScreenshot::ProcessJob(const Job& job)
+    {
+        auto slot = job.slot;
+        auto isHDR = job.format == CaptureFormat::EXR;
+        auto pixelCount = (size_t)job.resolution.x * (size_t)job.resolution.y;
+        auto data = slot->buffer->BeginRead(0ull, pixelCount * (isHDR ? 8ull : 4ull));
+
+        if (job.frameCount == 0u)
+        {
+            if (isHDR)
+            {
+                m_encodePixelsHDR.resize(pixelCount * 4ull);
+                memcpy(m_encodePixelsHDR.data(), data, pixelCount * 8ull);
+            }
+            else
+            {
+                m_encodePixels.resize(pixelCount * 3ull);
+                ConvertUNorm8(m_encodePixels.data(), reinterpret_cast<const uint8_t*>(data), pixelCount);
+            }
+        }
+        else if (isHDR)
+        {
+            AccumulateHalf(m_accumulatedPixelsHDR.GetData(), reinterpret_cast<const uint16_t*>(data), pixelCount * 4ull);
         }
         else
         {
-            m_copyBuffer->Validate(m_currentResolution.x * m_currentResolution.y);
+            AccumulateUNorm8(m_accumulatedPixels.GetData(), reinterpret_cast<const uint8_t*>(data), pixelCount * 4ull);
+        }
+
+        slot->buffer->EndRead();
+
+        // Accumulated captures keep their last slot until written so that a new capture cannot reset the accumulation buffers meanwhile.
+        if (job.frameCount == 0u || !job.isLast)
+        {
+            slot->state = SlotState::Free;
+        }
+
+        if (job.frameCount > 0u && !job.isLast)
+        {
+            return;
+        }
+
+        if (job.frameCount > 0u && isHDR)
+        {
+            m_encodePixelsHDR.resize(pixelCount * 4ull);
+            ResolveHalf(m_encodePixelsHDR.data(), m_accumulatedPixelsHDR.GetData(), pixelCount * 4ull, 1.0f / job.frameCount);
+        }
+        else if (job.frameCount > 0u)
+        {
+            m_encodePixels.resize(pixelCount * 3ull);
+            ResolveUNorm8(m_encodePixels.data(), m_accumulatedPixels.GetData(), pixelCount, job.frameCount);
+        }
+
+        auto filename = GetFileName(job);
+
+        auto isWritten = isHDR ?
+            Utilities::FileIO::WriteEXR(filename.c_str(), m_encodePixelsHDR.data(), job.resolution.x, job.resolution.y) :
+            Utilities::FileIO::WritePNG(filename.c_str(), m_encodePixels.data(), job.resolution.x, job.resolution.y, 3u);
+
+        slot->state = SlotState::Free;
+
+        if (!isWritten)
+        {
+            PK_LOG_WARNING("Failed to write screenshot: %s", filename.c_str());
+        }
+        else if (job.frameCount > 0u)
+        {
+            PK_LOG_INFO("Screenshot captured: %s", filename.c_str());
+        }
+    }
+
+    std::string EngineScreenshot::GetFileName(const Job& job)
+    {
+        auto extension = job.format == CaptureFormat::EXR ? "exr" : "png";
+        char filename[256];
+
+        // Indices only advance so existing files are probed once per session.
+        if (job.frameCount > 0u)
+        {
+            do
+            {
+                snprintf(filename, sizeof(filename), "Screenshot%u.%s", m_fileIndex++, extension);
+            }
+            while (std::filesystem::exists(filename));
+
+            return filename;
+        }
+
+        if (job.sequenceFrame == 0u)
+        {
+            do
+            {
+                snprintf(filename, sizeof(filename), "ScreenshotSequence%u_00000.%s", ++m_sequenceIndex, extension);
+            }
+            while (std::filesystem::exists(filename));
         }
 
-        m_copyFence.Invalidate();
-        m_accumulatedPixels.Validate(m_currentResolution.x * m_currentResolution.y * 4, true);
-        m_accumulatedPixels.Clear();
-        m_captureCounter = 9;
-        m_captureFrameCount = 8;
+        snprintf(filename, sizeof(filename), "ScreenshotSequence%u_%05u.%s", m_sequenceIndex, job.sequenceFrame, extension);
+        return filename;
     }
 }
\ No newline at end of file
@@ -6,25 +6,103 @@
 #include "Utilities/MemoryBlock.h"
 #include "Rendering/Objects/Buffer.h"
 #include "Rendering/Structs/FenceRef.h"
+#include "Rendering/RenderPipeline.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 namespace PK::ECS::Engines
 {
+    constexpr static const uint32_t PK_SCREENSHOT_READBACK_SLOTS = 4u;
+    constexpr static const uint32_t PK_SCREENSHOT_ACCUMULATION_FRAMES = 8u;
+
+    /*
+     * Captures are copied into readback buffers on the graphics queue & handed to a worker thread once their copy has completed.
+     * The worker accumulates, resolves & encodes them so that the main thread only records copies.
+     * Console commands:
+     *  take_screenshot: png of the window accumulated over multiple frames.
+     *  take_screenshot_exr: half float exr of the lit scene color before post effects, accumulated over multiple frames.
+     *  toggle_screenshot_sequence(_exr): writes every frame until toggled again. Frames are dropped instead of stalling when the worker falls behind.
+     */
     class EngineScreenshot : public Core::Services::IService,
         public Core::Services::IStep<Core::Window>,
         public Core::Services::IStep<Core::TokenConsoleCommand>
     {
     public:
-        EngineScreenshot();
+        EngineScreenshot(Rendering::RenderPipeline* renderPipeline);
+        ~EngineScreenshot();
         void Step(Core::Window* window) override final;
         void Step(Core::TokenConsoleCommand* token) override final;
 
     private:
-        Rendering::Structs::FenceRef m_copyFence;
-        Utilities::MemoryBlock<uint16_t> m_accumulatedPixels;
-        Utilities::Ref<Rendering::Objects::Buffer> m_copyBuffer;
-        uint32_t m_captureCounter = 0u;
-        uint32_t m_captureFrameCount = 0u;
-        Math::uint2 m_captureResolution = Math::PK_UINT2_ZERO;
+        enum class CaptureFormat
+        {
+            PNG,
+            EXR
+        };
+
+        enum class SlotState : uint32_t
+        {
+            Free,
+            Copying,
+            Queued
+        };
+
+        struct ReadbackSlot
+        {
+            Utilities::Ref<Rendering::Objects::Buffer> buffer;
+            Rendering::Structs::FenceRef fence;
+            std::atomic<SlotState> state = SlotState::Free;
+        };
+
+        struct Job
+        {
+            ReadbackSlot* slot;
+            CaptureFormat format;
+            Math::uint2 resolution;
+            // Number of accumulated frames. Zero for sequence frames.
+            uint32_t frameCount;
+            uint32_t sequenceFrame;
+            bool isLast;
+        };
+
+        struct Capture
+        {
+            CaptureFormat format = CaptureFormat::PNG;
+            Math::uint2 resolution = Math::PK_UINT2_ZERO;
+            uint32_t framesRemaining = 0u;
+            uint32_t frameCount = 0u;
+            uint32_t sequenceFrame = 0u;
+            uint32_t droppedFrames = 0u;
+            bool isSequence = false;
+        };
+
+        bool IsIdle() const;
+        void BeginCapture(CaptureFormat format, bool isSequence);
+        void WorkerMain();
+        void ProcessJob(const Job& job);
+        std::string GetFileName(const Job& job);
+
+        Rendering::RenderPipeline* m_renderPipeline = nullptr;
+        ReadbackSlot m_slots[PK_SCREENSHOT_READBACK_SLOTS];
+        std::deque<Job> m_copyJobs;
+        Capture m_capture{};
         Math::uint2 m_currentResolution = Math::PK_UINT2_ZERO;
+
+        // Owned by the worker while jobs are pending.
+        Utilities::MemoryBlock<uint16_t> m_accumulatedPixels;
+        Utilities::MemoryBlock<float> m_accumulatedPixelsHDR;
+        std::vector<uint8_t> m_encodePixels;
+        std::vector<uint16_t> m_encodePixelsHDR;
+        uint32_t m_fileIndex = 0u;
+        uint32_t m_sequenceIndex = 0u;
+
+        std::deque<Job> m_jobs;
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+        std::thread m_worker;
+        bool m_isRunning = true;
     };
 }
\ No newline at end of file
@@ -1,27 +1,187 @@
 #include "PrecompiledHeader.h"
 #include "EngineUpdateTransforms.h"
 #include "ECS/Contextual/EntityViews/TransformView.h"
+#include "ECS/Contextual/EntityViews/BaseRenderableView.h"
 #include "Math/FunctionsIntersect.h"
 
 namespace PK::ECS::Engines
 {
     using namespace PK::Math;
+    using namespace PK::ECS::EntityViews;
 
-    EngineUpdateTransforms::EngineUpdateTransforms(EntityDatabase* entityDb)
+    static uint32_t GetHierarchyDepth(const Components::Transform* transform)
+    {
+        auto depth = 0u;
+
+        for (auto parent = transform->parent; parent != nullptr; parent = parent->parent)
+        {
+            ++depth;
+        }
+
+        return depth;
+    }
+
+    static void UpdateWorldMatrices(TransformView* view, uint32_t updateIndex)
+    {
+        auto transform = view->transform;
+        transform->localToWorld = transform->GetLocalToWorld();
+        transform->worldToLocal = transform->GetWorldToLocal();
+
+        if (transform->parent != nullptr)
+        {
+            transform->localToWorld = transform->parent->localToWorld * transform->localToWorld;
+            transform->worldToLocal = transform->worldToLocal * transform->parent->worldToLocal;
+        }
+
+        transform->isDirty = false;
+        transform->updateIndex = updateIndex;
+        view->bounds->worldAABB = Functions::BoundsTransform(transform->localToWorld, view->bounds->localAABB);
+    }
+
+    EngineUpdateTransforms::EngineUpdateTransforms(EntityDatabase* entityDb, 
+                                                   Core::Services::JobSystem* jobSystem, 
+                                                   Services::CullingCache* cullingCache, 
+                                                   Services::TransformChangeList* changeList,
+                                                   Services::RenderableChangeList* renderableChangeList)
     {
         m_entityDb = entityDb;
+        m_jobSystem = jobSystem;
+        m_cullingCache = cullingCache;
+        m_changeList = changeList;
+        m_renderableChangeList = renderableChangeList;
     }
 
     void EngineUpdateTransforms::Step(int condition)
     {
-        auto views = m_entityDb->Query<EntityViews::TransformView>((int)ENTITY_GROUPS::ACTIVE);
+        auto views = m_entityDb->Query<TransformView>((int)ENTITY_GROUPS::ACTIVE);
+        auto updateIndex = ++m_updateIndex;
+        auto changeList = m_changeList;
+        changeList->entityIds.clear();
+        changeList->updateIndex = updateIndex;
+        m_children.clear();
+
+        // Root transforms. Children are deferred & resolved in depth order once their parents are up to date.
+        m_jobSystem->ParallelFor((uint32_t)views.count, 256u, [this, &views, changeList, updateIndex](uint32_t begin, uint32_t end)
+        {
+            std::vector<uint32_t> changed;
+            std::vector<std::pair<uint32_t, uint32_t>> children;
+
+            for (auto i = begin; i < end; ++i)
+            {
+                auto view = views.data + i;
+
+                if (view->transform->parent != nullptr)
+                {
+                    children.emplace_back(GetHierarchyDepth(view->transform), i);
+                    continue;
+                }
 
-        for (auto i = 0; i < views.count; ++i)
+                if (view->transform->isDirty)
+                {
+                    UpdateWorldMatrices(view, updateIndex);
+                    changed.push_back(view->GID.entityID());
+                }
+            }
+
+            if (!changed.empty() || !children.empty())
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                changeList->entityIds.insert(changeList->entityIds.end(), changed.begin(), changed.end());
+                m_children.insert(m_children.end(), children.begin(), children.end());
+            }
+        });
+
+        std::sort(m_children.begin(), m_children.end());
+
+        for (size_t first = 0ull, last = 0ull; first < m_children.size(); first = last)
         {
-            auto view = &views[i];
-            view->transform->localToWorld = view->transform->GetLocalToWorld();
-            view->transform->worldToLocal = glm::inverse(view->transform->localToWorld);
-            view->bounds->worldAABB = Functions::BoundsTransform(view->transform->localToWorld, view->bounds->localAABB);
+            auto depth = m_children[first].first;
+
+            for (last = first; last < m_children.size() && m_children[last].first == depth; ++last);
+
+            auto children = m_children.data() + first;
+
+            m_jobSystem->ParallelFor((uint32_t)(last - first), 256u, [this, &views, children, changeList, updateIndex](uint32_t begin, uint32_t end)
+            {
+                std::vector<uint32_t> changed;
+
+                for (auto i = begin; i < end; ++i)
+                {
+                    auto view = views.data + children[i].second;
+
+                    if (view->transform->isDirty || view->transform->parent->updateIndex == updateIndex)
+                    {
+                        UpdateWorldMatrices(view, updateIndex);
+                        changed.push_back(view->GID.entityID());
+                    }
+                }
+
+                if (!changed.empty())
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    changeList->entityIds.insert(changeList->entityIds.end(), changed.begin(), changed.end());
+                }
+            });
+        }
+
+        UpdateCullingCache();
+    }
+
+    void EngineUpdateTransforms::UpdateCullingCache()
+    {
+        auto renderables = m_entityDb->Query<BaseRenderableView>((int)ENTITY_GROUPS::ACTIVE);
+        auto version = m_entityDb->GetViewVersion<BaseRenderableView>((int)ENTITY_GROUPS::ACTIVE);
+        auto cullableFlag = (uint32_t)Rendering::Structs::RenderableFlags::Cullable;
+        auto cache = m_cullingCache;
+
+        // Slots map to view indices. Refresh everything when views have been added or removed.
+        if (cache->count != renderables.count || cache->sourceVersion != version)
+        {
+            cache->Reset(renderables.count);
+            cache->sourceVersion = version;
+
+            m_jobSystem->ParallelFor((uint32_t)renderables.count, 1024u, [&renderables, cache, cullableFlag](uint32_t begin, uint32_t end)
+            {
+                for (auto i = begin; i < end; ++i)
+                {
+                    auto view = renderables.data + i;
+                    cache->Write(i, view->bounds->worldAABB, (uint32_t)view->renderable->flags, view->GID.entityID(), cullableFlag);
+                }
+            });
+
+            cache->UpdateHierarchy(nullptr, 0ull);
+            m_renderableChangeList->entityIds.clear();
+            return;
         }
+
+        m_writtenSlots.clear();
+
+        auto& flagChanges = m_renderableChangeList->entityIds;
+        m_changedEntities.assign(m_changeList->entityIds.begin(), m_changeList->entityIds.end());
+
+        // Writing a slot twice would discard the change recorded by the first write.
+        if (!flagChanges.empty())
+        {
+            m_changedEntities.insert(m_changedEntities.end(), flagChanges.begin(), flagChanges.end());
+            std::sort(m_changedEntities.begin(), m_changedEntities.end());
+            m_changedEntities.erase(std::unique(m_changedEntities.begin(), m_changedEntities.end()), m_changedEntities.end());
+            flagChanges.clear();
+        }
+
+        for (auto entityId : m_changedEntities)
+        {
+            auto view = m_entityDb->TryQuery<BaseRenderableView>(EGID(entityId, (uint32_t)ENTITY_GROUPS::ACTIVE));
+
+            if (view == nullptr)
+            {
+                continue;
+            }
+
+            auto slot = cache->slotIndices[(uint32_t)(view - renderables.data)];
+            cache->Write(slot, view->bounds->worldAABB, (uint32_t)view->renderable->flags, entityId, cullableFlag);
+            m_writtenSlots.push_back(slot);
+        }
+
+        cache->UpdateHierarchy(m_writtenSlots.data(), m_writtenSlots.size());
     }
 }
\ No newline at end of file
@@ -1,17 +1,37 @@
 #pragma once
 #include "Core/Services/IService.h"
 #include "Core/Services/Sequencer.h"
+#include "Core/Services/JobSystem.h"
 #include "ECS/EntityDatabase.h"
+#include "ECS/Contextual/Services/CullingCache.h"
+#include "ECS/Contextual/Services/TransformChangeList.h"
+#include "ECS/Contextual/Services/RenderableChangeList.h"
 
 namespace PK::ECS::Engines
 {
 	class EngineUpdateTransforms : public Core::Services::IService, public Core::Services::ISimpleStep
 	{
 		public:
-			EngineUpdateTransforms(EntityDatabase* entityDb);
+			EngineUpdateTransforms(EntityDatabase* entityDb, 
+								   Core::Services::JobSystem* jobSystem, 
+								   Services::CullingCache* cullingCache, 
+								   Services::TransformChangeList* changeList,
+								   Services::RenderableChangeList* renderableChangeList);
+
 			void Step(int condition) override final;
 		
 		private:
+			void UpdateCullingCache();
+
 			EntityDatabase* m_entityDb = nullptr;
+			Core::Services::JobSystem* m_jobSystem = nullptr;
+			Services::CullingCache* m_cullingCache = nullptr;
+			Services::TransformChangeList* m_changeList = nullptr;
+			Services::RenderableChangeList* m_renderableChangeList = nullptr;
+			std::vector<std::pair<uint32_t, uint32_t>> m_children;
+			std::vector<uint32_t> m_changedEntities;
+			std::vector<uint32_t> m_writtenSlots;
+			std::mutex m_mutex;
+			uint32_t m_updateIndex = 0u;
 	};
 }
\ No newline at end of file
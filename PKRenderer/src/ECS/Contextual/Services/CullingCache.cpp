@@ -0,0 +1,267 @@
+#include "PrecompiledHeader.h"
+#include "CullingCache.h"
+#include "Math/FunctionsIntersect.h"
+#include "Rendering/Structs/Enums.h"
+
+namespace PK::ECS::Services
+{
+    using namespace Math;
+    using namespace Rendering::Structs;
+
+    static float GetSurfaceArea(const BoundingBox& bounds)
+    {
+        auto size = bounds.max - bounds.min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    template<typename T>
+    static void PermuteSlots(Utilities::MemoryBlock<T>& block, const std::vector<uint32_t>& indices, size_t count)
+    {
+        std::vector<T> source(block.GetData(), block.GetData() + count);
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            block[i] = source[indices[i]];
+        }
+    }
+
+    CullingCache::CullingCache() :
+        minX(1024),
+        minY(1024),
+        minZ(1024),
+        maxX(1024),
+        maxY(1024),
+        maxZ(1024),
+        flags(1024),
+        entityIds(1024),
+        sourceIndices(1024),
+        slotIndices(1024),
+        slotLeaves(1024),
+        changes(1024)
+    {
+    }
+
+    void CullingCache::Reset(size_t newCount)
+    {
+        auto capacity = ((newCount + PK_CULLING_CACHE_ALIGNMENT - 1ull) & ~(size_t)(PK_CULLING_CACHE_ALIGNMENT - 1u)) + PK_CULLING_CACHE_ALIGNMENT;
+        minX.Validate(capacity, true);
+        minY.Validate(capacity, true);
+        minZ.Validate(capacity, true);
+        maxX.Validate(capacity, true);
+        maxY.Validate(capacity, true);
+        maxZ.Validate(capacity, true);
+        flags.Validate(capacity, true);
+        entityIds.Validate(capacity, true);
+        sourceIndices.Validate(capacity, true);
+        slotIndices.Validate(capacity, true);
+        slotLeaves.Validate(capacity, true);
+        changes.Validate(capacity, true);
+
+        for (auto i = 0u; i < newCount; ++i)
+        {
+            sourceIndices[i] = i;
+            slotIndices[i] = i;
+        }
+
+        count = newCount;
+        m_requiresBuild = true;
+    }
+
+    void CullingCache::UpdateHierarchy(const uint32_t* writtenSlots, size_t writtenCount)
+    {
+        m_refitLeaves.clear();
+
+        for (auto i = 0u; i < writtenCount && !m_requiresBuild; ++i)
+        {
+            auto slot = writtenSlots[i];
+            auto change = changes[slot];
+
+            if (change & SlotChange::Cullability)
+            {
+                m_requiresBuild = true;
+            }
+            else if (change != SlotChange::None && slot >= nonCullableCount)
+            {
+                m_refitLeaves.push_back(slotLeaves[slot]);
+            }
+        }
+
+        if (!m_requiresBuild)
+        {
+            std::sort(m_refitLeaves.begin(), m_refitLeaves.end());
+            auto end = std::unique(m_refitLeaves.begin(), m_refitLeaves.end());
+
+            for (auto iter = m_refitLeaves.begin(); iter != end; ++iter)
+            {
+                RefitLeaf(*iter, true);
+            }
+        }
+
+        // Refitting degrades the hierarchy as renderables move apart. Rebuild once the root has grown significantly.
+        if (!m_requiresBuild && !nodes.empty() && GetSurfaceArea(nodes[0].bounds) > m_buildArea * 4.0f)
+        {
+            m_requiresBuild = true;
+        }
+
+        if (m_requiresBuild)
+        {
+            Build();
+        }
+    }
+
+    void CullingCache::Build()
+    {
+        m_requiresBuild = false;
+        nodes.clear();
+        leaves.clear();
+
+        auto& indices = m_buildIndices;
+        auto& centroids = m_buildCentroids;
+        indices.resize(count);
+        centroids.resize(count);
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            indices[i] = i;
+            centroids[i] = float3(minX[i] + maxX[i], minY[i] + maxY[i], minZ[i] + maxZ[i]) * 0.5f;
+        }
+
+        auto isCullableFlag = (uint32_t)RenderableFlags::Cullable;
+        auto cullableBegin = std::stable_partition(indices.begin(), indices.end(), [this, isCullableFlag](uint32_t i) { return (flags[i] & isCullableFlag) == 0u; });
+        nonCullableCount = (uint32_t)(cullableBegin - indices.begin());
+
+        if (nonCullableCount < count)
+        {
+            nodes.push_back({ BoundingBox(), nonCullableCount, (uint32_t)count - nonCullableCount, 0u, PK_CULLING_BVH_INVALID_NODE, 0u });
+        }
+
+        // Split at the centroid midpoint of the longest axis. Fall back to a median split for degenerate ranges & deep branches to bound the depth.
+        std::vector<std::pair<uint32_t, uint32_t>> stack;
+        stack.emplace_back(0u, 0u);
+
+        while (!nodes.empty() && !stack.empty())
+        {
+            auto [index, depth] = stack.back();
+            stack.pop_back();
+
+            auto first = nodes[index].first;
+            auto length = nodes[index].count;
+
+            if (length <= PK_CULLING_BVH_LEAF_SIZE)
+            {
+                leaves.push_back(index);
+                continue;
+            }
+
+            auto begin = indices.begin() + first;
+            auto end = begin + length;
+            BoundingBox centroidBounds(centroids[*begin], centroids[*begin]);
+
+            for (auto iter = begin; iter != end; ++iter)
+            {
+                centroidBounds.min = glm::min(centroidBounds.min, centroids[*iter]);
+                centroidBounds.max = glm::max(centroidBounds.max, centroids[*iter]);
+            }
+
+            auto axis = Functions::BoundsLongestAxis(centroidBounds);
+            auto pivot = centroidBounds.GetCenter()[axis];
+            auto middle = begin;
+
+            if (depth < PK_CULLING_BVH_MAX_DEPTH / 2u)
+            {
+                middle = std::partition(begin, end, [&centroids, axis, pivot](uint32_t i) { return centroids[i][axis] < pivot; });
+            }
+
+            if (middle == begin || middle == end)
+            {
+                middle = begin + length / 2u;
+                std::nth_element(begin, middle, end, [&centroids, axis](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+            }
+
+            auto left = (uint32_t)nodes.size();
+            auto leftCount = (uint32_t)(middle - begin);
+            nodes[index].left = left;
+            nodes.push_back({ BoundingBox(), first, leftCount, 0u, index, 0u });
+            nodes.push_back({ BoundingBox(), first + leftCount, length - leftCount, 0u, index, 0u });
+            stack.emplace_back(left + 1u, depth + 1u);
+            stack.emplace_back(left, depth + 1u);
+        }
+
+        PermuteSlots(minX, indices, count);
+        PermuteSlots(minY, indices, count);
+        PermuteSlots(minZ, indices, count);
+        PermuteSlots(maxX, indices, count);
+        PermuteSlots(maxY, indices, count);
+        PermuteSlots(maxZ, indices, count);
+        PermuteSlots(flags, indices, count);
+        PermuteSlots(entityIds, indices, count);
+        PermuteSlots(sourceIndices, indices, count);
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            slotIndices[sourceIndices[i]] = i;
+        }
+
+        for (auto leaf : leaves)
+        {
+            for (auto i = nodes[leaf].first; i < nodes[leaf].first + nodes[leaf].count; ++i)
+            {
+                slotLeaves[i] = leaf;
+            }
+        }
+
+        // Children are always stored after their parents.
+        for (auto i = (int32_t)nodes.size() - 1; i >= 0; --i)
+        {
+            auto& node = nodes[i];
+
+            if (node.left == 0u)
+            {
+                RefitLeaf(i, false);
+                continue;
+            }
+
+            auto& l = nodes[node.left];
+            auto& r = nodes[node.left + 1u];
+            node.bounds = BoundingBox(glm::min(l.bounds.min, r.bounds.min), glm::max(l.bounds.max, r.bounds.max));
+            node.flags = l.flags | r.flags;
+        }
+
+        m_buildArea = nodes.empty() ? 0.0f : GetSurfaceArea(nodes[0].bounds);
+    }
+
+    void CullingCache::RefitLeaf(uint32_t index, bool propagate)
+    {
+        auto& leaf = nodes[index];
+        auto first = leaf.first;
+        leaf.bounds.min = float3(minX[first], minY[first], minZ[first]);
+        leaf.bounds.max = float3(maxX[first], maxY[first], maxZ[first]);
+        leaf.flags = 0u;
+
+        for (auto i = first; i < first + leaf.count; ++i)
+        {
+            leaf.bounds.min = glm::min(leaf.bounds.min, float3(minX[i], minY[i], minZ[i]));
+            leaf.bounds.max = glm::max(leaf.bounds.max, float3(maxX[i], maxY[i], maxZ[i]));
+            leaf.flags |= flags[i];
+        }
+
+        // Propagate upwards until a parent remains unchanged.
+        for (auto parent = propagate ? leaf.parent : PK_CULLING_BVH_INVALID_NODE; parent != PK_CULLING_BVH_INVALID_NODE; parent = nodes[parent].parent)
+        {
+            auto& node = nodes[parent];
+            auto& l = nodes[node.left];
+            auto& r = nodes[node.left + 1u];
+            auto bmin = glm::min(l.bounds.min, r.bounds.min);
+            auto bmax = glm::max(l.bounds.max, r.bounds.max);
+            auto nodeFlags = l.flags | r.flags;
+
+            if (bmin == node.bounds.min && bmax == node.bounds.max && nodeFlags == node.flags)
+            {
+                break;
+            }
+
+            node.bounds = BoundingBox(bmin, bmax);
+            node.flags = nodeFlags;
+        }
+    }
+}
\ No newline at end of file
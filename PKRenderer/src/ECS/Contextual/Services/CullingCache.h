@@ -0,0 +1,152 @@
+#pragma once
+#include "Core/Services/IService.h"
+#include "Utilities/MemoryBlock.h"
+#include "Math/Types.h"
+
+namespace PK::ECS::Services
+{
+    // Structure of arrays copy of active renderable world bounds & flags.
+    // Refreshed by EngineUpdateTransforms once per frame & consumed by the SIMD kernels in EngineCull.
+    // Arrays are padded by PK_CULLING_CACHE_ALIGNMENT elements so that kernels can load full lanes past the end of a range.
+    constexpr static const uint32_t PK_CULLING_CACHE_ALIGNMENT = 8u;
+    constexpr static const uint32_t PK_CULLING_BVH_LEAF_SIZE = PK_CULLING_CACHE_ALIGNMENT;
+    constexpr static const uint32_t PK_CULLING_BVH_MAX_DEPTH = 64u;
+    constexpr static const uint32_t PK_CULLING_BVH_INVALID_NODE = 0xFFFFFFFFu;
+
+    // Every node references a contiguous range of slots so that a fully visible subtree can be accepted without descending into it.
+    struct CullingNode
+    {
+        Math::BoundingBox bounds;
+        uint32_t first;
+        uint32_t count;
+        // Index of the left child. Right child is left + 1. 0 for leaves as the root cannot be a child.
+        uint32_t left;
+        uint32_t parent;
+        // Union of child renderable flags. Used to skip subtrees that cannot pass a required flag mask.
+        uint32_t flags;
+    };
+
+    struct CullingCache : public Core::Services::IService
+    {
+        enum SlotChange : uint8_t
+        {
+            None = 0,
+            Bounds = 1 << 0,
+            Flags = 1 << 1,
+            Cullability = 1 << 2
+        };
+
+        Utilities::MemoryBlock<float> minX;
+        Utilities::MemoryBlock<float> minY;
+        Utilities::MemoryBlock<float> minZ;
+        Utilities::MemoryBlock<float> maxX;
+        Utilities::MemoryBlock<float> maxY;
+        Utilities::MemoryBlock<float> maxZ;
+        Utilities::MemoryBlock<uint32_t> flags;
+        Utilities::MemoryBlock<uint32_t> entityIds;
+        // Mapping between slots & source entity view indices. Slots are reordered by the hierarchy build.
+        Utilities::MemoryBlock<uint32_t> sourceIndices;
+        Utilities::MemoryBlock<uint32_t> slotIndices;
+        Utilities::MemoryBlock<uint32_t> slotLeaves;
+        Utilities::MemoryBlock<uint8_t> changes;
+        size_t count = 0ull;
+        // View collection version the slot mapping was created for.
+        uint32_t sourceVersion = 0u;
+
+        // Non cullable renderables occupy the slots [0, nonCullableCount) & are not part of the hierarchy.
+        std::vector<CullingNode> nodes;
+        std::vector<uint32_t> leaves;
+        uint32_t nonCullableCount = 0u;
+
+        CullingCache();
+
+        // Resets the slot mapping to source order. The hierarchy is rebuilt on the next update.
+        void Reset(size_t newCount);
+
+        inline uint8_t Write(uint32_t slot, const Math::BoundingBox& bounds, uint32_t newFlags, uint32_t entityId, uint32_t cullableFlag)
+        {
+            uint8_t change = SlotChange::None;
+
+            if (minX[slot] != bounds.min.x || minY[slot] != bounds.min.y || minZ[slot] != bounds.min.z ||
+                maxX[slot] != bounds.max.x || maxY[slot] != bounds.max.y || maxZ[slot] != bounds.max.z)
+            {
+                change |= SlotChange::Bounds;
+            }
+
+            if (flags[slot] != newFlags)
+            {
+                change |= SlotChange::Flags;
+                change |= ((flags[slot] ^ newFlags) & cullableFlag) != 0u ? SlotChange::Cullability : SlotChange::None;
+            }
+
+            minX[slot] = bounds.min.x;
+            minY[slot] = bounds.min.y;
+            minZ[slot] = bounds.min.z;
+            maxX[slot] = bounds.max.x;
+            maxY[slot] = bounds.max.y;
+            maxZ[slot] = bounds.max.z;
+            flags[slot] = newFlags;
+            entityIds[slot] = entityId;
+            changes[slot] = change;
+            return change;
+        }
+
+        // Rebuilds the hierarchy if required or refits the leaves of the written slots.
+        void UpdateHierarchy(const uint32_t* writtenSlots, size_t writtenCount);
+
+        /*
+         * Visits the non cullable range followed by the bvh node ranges that pass the visitor.
+         * TVisitor::Classify(const BoundingBox&, uint32_t* partialMask, uint32_t* insideMask) narrows the masks for a node & returns false if it can be skipped.
+         * TVisitor::Visit(uint32_t first, uint32_t count, uint32_t partialMask, uint32_t insideMask) processes a contiguous range of slots.
+         * A node without partial tests remaining is accepted as a whole.
+         */
+        template<typename TVisitor>
+        void Traverse(TVisitor& visitor, uint32_t requiredFlags, uint32_t mask) const
+        {
+            if (nonCullableCount > 0u)
+            {
+                visitor.Visit(0u, nonCullableCount, mask, 0u);
+            }
+
+            if (nodes.empty())
+            {
+                return;
+            }
+
+            struct Entry { uint32_t node, partial, inside; };
+            Entry stack[PK_CULLING_BVH_MAX_DEPTH + 1u];
+            auto size = 0u;
+            stack[size++] = { 0u, mask, 0u };
+
+            while (size > 0u)
+            {
+                auto entry = stack[--size];
+                auto& node = nodes[entry.node];
+
+                if ((node.flags & requiredFlags) != requiredFlags || (entry.partial != 0u && !visitor.Classify(node.bounds, &entry.partial, &entry.inside)))
+                {
+                    continue;
+                }
+
+                if (entry.partial == 0u || node.left == 0u)
+                {
+                    visitor.Visit(node.first, node.count, entry.partial, entry.inside);
+                    continue;
+                }
+
+                stack[size++] = { node.left + 1u, entry.partial, entry.inside };
+                stack[size++] = { node.left, entry.partial, entry.inside };
+            }
+        }
+
+        private:
+            void Build();
+            void RefitLeaf(uint32_t index, bool propagate);
+
+            std::vector<uint32_t> m_buildIndices;
+            std::vector<uint32_t> m_refitLeaves;
+            std::vector<Math::float3> m_buildCentroids;
+            float m_buildArea = 0.0f;
+            bool m_requiresBuild = true;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+#include "Core/Services/IService.h"
+#include "ECS/Contextual/Components/Renderable.h"
+
+namespace PK::ECS::Services
+{
+    // Entities whose renderable flags changed since the last transform update.
+    // Flags of existing renderables should be changed through SetFlags so that the culling cache picks them up.
+    struct RenderableChangeList : public Core::Services::IService
+    {
+        std::vector<uint32_t> entityIds;
+
+        inline void SetFlags(Components::Renderable* renderable, uint32_t entityId, Rendering::Structs::RenderableFlags flags)
+        {
+            if (renderable->flags != flags)
+            {
+                renderable->flags = flags;
+                entityIds.push_back(entityId);
+            }
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include "Core/Services/IService.h"
+
+namespace PK::ECS::Services
+{
+    // Entities whose world matrices were recomputed by the last transform update.
+    // Lets consumers skip work for the static majority of the scene.
+    struct TransformChangeList : public Core::Services::IService
+    {
+        std::vector<uint32_t> entityIds;
+        uint32_t updateIndex = 0u;
+    };
+}
\ No newline at end of file
@@ -4,9 +4,9 @@
 
 namespace PK::ECS::Tokens
 {
-    void VisibilityList::Add(uint32_t entityId, uint16_t depth, uint16_t clipId)
+    void VisibilityList::Add(uint32_t entityId, uint16_t depth, uint8_t clipId, uint8_t lod)
     {
         results.Validate(count + 1u);
-        results[count++] = { entityId, depth, clipId };
+        results[count++] = { entityId, depth, clipId, lod };
     }
 }
\ No newline at end of file
@@ -9,7 +9,8 @@ namespace PK::ECS::Tokens
 	{
 		uint32_t entityId;
 		uint16_t depth;
-		uint16_t clipId;
+		uint8_t clipId;
+		uint8_t lod;
 	};
 
 	struct VisibilityList
@@ -17,7 +18,7 @@ namespace PK::ECS::Tokens
 		Utilities::MemoryBlock<VisibleItem> results;
 		size_t count;
 		VisibilityList(size_t count) : results(512), count(count){}
-		void Add(uint32_t entityId, uint16_t depth, uint16_t clipId);
+		void Add(uint32_t entityId, uint16_t depth, uint8_t clipId, uint8_t lod = 0u);
 		inline void Clear() { count = 0ull; }
 		inline const VisibleItem& operator [] (size_t index) const { return results[index]; }
 	};
@@ -27,6 +28,9 @@ namespace PK::ECS::Tokens
 		VisibilityList* results;
 		Rendering::Structs::RenderableFlags mask;
 		float depthRange;
+		// View half height per unit of depth used to select mesh lods. 0 selects the base level.
+		// Cascades are orthographic & scale this by the half height of each cascade instead.
+		float lodSizePerDepth;
 	};
 
 	struct TokenCullFrustum : public TokenCullBase
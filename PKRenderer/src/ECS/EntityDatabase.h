@@ -49,6 +49,7 @@ namespace PK::ECS
     };
     
     constexpr static const uint32_t PK_ECS_BUCKET_SIZE = 32000;
+    constexpr static const uint32_t PK_ECS_SPARSE_PAGE_SIZE = 4096;
 
     struct ImplementerBucket
     {
@@ -62,25 +63,94 @@ namespace PK::ECS
     {
         size_t count = 0;
         std::vector<Utilities::Scope<ImplementerBucket>> buckets;
+        // Released implementers are recycled before new bucket space is used as views hold pointers to them.
+        std::vector<void*> freelist;
     };
 
-    struct EntityViewsCollection
+    struct SparsePage
     {
-        std::map<uint32_t, size_t> indices;
-        std::vector<uint8_t> buffer;
+        // Dense index + 1. 0 for entities that are not present.
+        uint32_t indices[PK_ECS_SPARSE_PAGE_SIZE] = {};
     };
 
-    struct ViewCollectionKey
+    // Sparse set of views. Views are stored contiguously in the dense buffer & removed by swapping with the last element.
+    struct EntityViewsCollection
     {
-        std::type_index type;
-        uint32_t group;
-        
-        inline bool operator < (const ViewCollectionKey& r) const noexcept
+        std::vector<Utilities::Scope<SparsePage>> pages;
+        std::vector<uint32_t> entities;
+        std::vector<uint8_t> buffer;
+        size_t stride = 0ull;
+        // Incremented whenever views are inserted or removed. Consumers caching view indices can use it to detect structural changes.
+        uint32_t version = 0u;
+
+        inline uint32_t* GetSparse(uint32_t entityId)
         {
-            return (type < r.type) || ((type == r.type) && (group < r.group));
+            auto page = entityId / PK_ECS_SPARSE_PAGE_SIZE;
+            return page < pages.size() && pages[page] ? pages[page]->indices + (entityId % PK_ECS_SPARSE_PAGE_SIZE) : nullptr;
         }
-    };
 
+        inline uint32_t* ReserveSparse(uint32_t entityId)
+        {
+            auto page = entityId / PK_ECS_SPARSE_PAGE_SIZE;
+
+            if (page >= pages.size())
+            {
+                pages.resize(page + 1);
+            }
+
+            if (!pages[page])
+            {
+                pages[page] = Utilities::CreateScope<SparsePage>();
+            }
+
+            return pages[page]->indices + (entityId % PK_ECS_SPARSE_PAGE_SIZE);
+        }
+
+        inline void* Find(uint32_t entityId)
+        {
+            auto sparse = GetSparse(entityId);
+            return sparse != nullptr && *sparse != 0u ? buffer.data() + (*sparse - 1u) * stride : nullptr;
+        }
+
+        void* Insert(uint32_t entityId)
+        {
+            auto sparse = ReserveSparse(entityId);
+            PK_THROW_ASSERT(*sparse == 0u, "Entity view already exists for entity: %u", entityId);
+
+            auto offset = buffer.size();
+            entities.push_back(entityId);
+            buffer.resize(offset + stride);
+            *sparse = (uint32_t)entities.size();
+            ++version;
+            return buffer.data() + offset;
+        }
+
+        bool Remove(uint32_t entityId)
+        {
+            auto sparse = GetSparse(entityId);
+
+            if (sparse == nullptr || *sparse == 0u)
+            {
+                return false;
+            }
+
+            auto index = *sparse - 1u;
+            auto last = (uint32_t)entities.size() - 1u;
+
+            if (index != last)
+            {
+                memcpy(buffer.data() + index * stride, buffer.data() + last * stride, stride);
+                entities[index] = entities[last];
+                *GetSparse(entities[index]) = index + 1u;
+            }
+
+            *sparse = 0u;
+            entities.pop_back();
+            buffer.resize(last * stride);
+            ++version;
+            return true;
+        }
+    };
 
     class EntityDatabase : public Core::Services::IService
     {
@@ -93,8 +163,14 @@ namespace PK::ECS
             {
                 static_assert(std::is_base_of<IImplementer, T>::value, "Template argument type does not derive from IImplementer!");
 
-                auto type = std::type_index(typeid(T));
-                auto& container = m_implementerBuckets[type];
+                auto& container = GetImplementerContainer<T>();
+
+                if (!container.freelist.empty())
+                {
+                    auto implementer = reinterpret_cast<T*>(container.freelist.back());
+                    container.freelist.pop_back();
+                    return implementer;
+                }
 
                 uint64_t elementsPerBucket = PK_ECS_BUCKET_SIZE / sizeof(T);
                 uint64_t bucketIndex = container.count / elementsPerBucket;
@@ -112,17 +188,23 @@ namespace PK::ECS
                 return reinterpret_cast<T*>(container.buckets.at(bucketIndex).get()->data) + subIndex;
             }
 
+            // Resets the implementer to its default state & returns it for reuse. Views referencing it should be removed first.
+            template<typename T>
+            void ReleaseImplementer(T* implementer)
+            {
+                static_assert(std::is_base_of<IImplementer, T>::value, "Template argument type does not derive from IImplementer!");
+                implementer->~T();
+                new(implementer) T();
+                GetImplementerContainer<T>().freelist.push_back(implementer);
+            }
+
             template<typename TView>
             TView* ReserveEntityView(const EGID& egid)
             {
                 static_assert(std::is_base_of<IEntityView, TView>::value, "Template argument type does not derive from IEntityView!");
                 PK_THROW_ASSERT(egid.IsValid(), "Trying to acquire resources for an invalid egid!");
 
-                auto& views = m_entityViews[{ std::type_index(typeid(TView)), egid.groupID() }];
-                auto offset = views.buffer.size();
-                views.buffer.resize(offset + sizeof(TView));
-                views.indices[egid.entityID()] = offset;
-                auto* element = reinterpret_cast<TView*>(views.buffer.data() + offset);
+                auto element = reinterpret_cast<TView*>(GetViewCollection<TView>(egid.groupID()).Insert(egid.entityID()));
                 element->GID = egid;
                 return element;
             }
@@ -142,9 +224,8 @@ namespace PK::ECS
                 static_assert(std::is_base_of<IEntityView, TView>::value, "Template argument type does not derive from IEntityView!");
                 PK_THROW_ASSERT(group, "Trying to acquire resources for an invalid egid!");
 
-                auto& views = m_entityViews[{ std::type_index(typeid(TView)), group }];
-                auto count = views.buffer.size() / sizeof(TView);
-                return { reinterpret_cast<TView*>(views.buffer.data()), count };
+                auto views = FindViewCollection<TView>(group);
+                return views != nullptr ? Utilities::BufferView<TView>{ reinterpret_cast<TView*>(views->buffer.data()), views->entities.size() } : Utilities::BufferView<TView>();
             }
 
             template<typename TView>
@@ -153,14 +234,127 @@ namespace PK::ECS
                 static_assert(std::is_base_of<IEntityView, TView>::value, "Template argument type does not derive from IEntityView!");
                 PK_THROW_ASSERT(egid.IsValid(), "Trying to acquire resources for an invalid egid!");
 
-                auto& views = m_entityViews.at({ std::type_index(typeid(TView)), egid.groupID() });
-                auto offset = views.indices.at(egid.entityID());
-                return reinterpret_cast<TView*>(views.buffer.data() + offset);
+                auto view = TryQuery<TView>(egid);
+                PK_THROW_ASSERT(view != nullptr, "Entity view not found for entity: %u", egid.entityID());
+                return view;
+            }
+
+            // Returns nullptr for entities without a view of the requested type.
+            template<typename TView>
+            TView* TryQuery(const EGID& egid)
+            {
+                static_assert(std::is_base_of<IEntityView, TView>::value, "Template argument type does not derive from IEntityView!");
+                PK_THROW_ASSERT(egid.IsValid(), "Trying to acquire resources for an invalid egid!");
+                auto views = FindViewCollection<TView>(egid.groupID());
+                return views != nullptr ? reinterpret_cast<TView*>(views->Find(egid.entityID())) : nullptr;
+            }
+
+            template<typename TView>
+            uint32_t GetViewVersion(const uint32_t group)
+            {
+                auto views = FindViewCollection<TView>(group);
+                return views != nullptr ? views->version : 0u;
+            }
+
+            template<typename TView>
+            void RemoveEntityView(const EGID& egid)
+            {
+                static_assert(std::is_base_of<IEntityView, TView>::value, "Template argument type does not derive from IEntityView!");
+                auto views = FindViewCollection<TView>(egid.groupID());
+
+                if (views != nullptr)
+                {
+                    views->Remove(egid.entityID());
+                }
+            }
+
+            // Removes all views of an entity. Remaining views of the group are compacted so that query iteration stays contiguous.
+            // Implementers are owned by the caller & should be returned through ReleaseImplementer.
+            void DestroyEntity(const EGID& egid)
+            {
+                PK_THROW_ASSERT(egid.IsValid(), "Trying to destroy an invalid egid!");
+
+                for (auto& collections : m_entityViews)
+                {
+                    if (egid.groupID() < collections.size() && collections[egid.groupID()])
+                    {
+                        collections[egid.groupID()]->Remove(egid.entityID());
+                    }
+                }
             }
 
         private:
-            std::map<ViewCollectionKey, EntityViewsCollection> m_entityViews;
-            std::map<std::type_index, ImplementerContainer> m_implementerBuckets;
+            // Sequential per type index. Used instead of a type_index map for constant time collection lookups.
+            template<typename T>
+            static uint32_t GetTypeIndex()
+            {
+                static const uint32_t index = s_typeCounter++;
+                return index;
+            }
+
+            // Does not allocate. Query paths use this as they can be called concurrently from jobs.
+            template<typename TView>
+            EntityViewsCollection* FindViewCollection(uint32_t group) const
+            {
+                auto type = GetTypeIndex<TView>();
+
+                if (type >= m_entityViews.size() || group >= m_entityViews[type].size())
+                {
+                    return nullptr;
+                }
+
+                return m_entityViews[type][group].get();
+            }
+
+            // Creates the collection if needed. Only called when inserting views.
+            template<typename TView>
+            EntityViewsCollection& GetViewCollection(uint32_t group)
+            {
+                auto type = GetTypeIndex<TView>();
+
+                if (type >= m_entityViews.size())
+                {
+                    m_entityViews.resize(type + 1);
+                }
+
+                auto& collections = m_entityViews[type];
+
+                if (group >= collections.size())
+                {
+                    collections.resize(group + 1);
+                }
+
+                if (!collections[group])
+                {
+                    collections[group] = Utilities::CreateScope<EntityViewsCollection>();
+                    collections[group]->stride = sizeof(TView);
+                }
+
+                return *collections[group];
+            }
+
+            template<typename T>
+            ImplementerContainer& GetImplementerContainer()
+            {
+                auto type = GetTypeIndex<T>();
+
+                if (type >= m_implementerBuckets.size())
+                {
+                    m_implementerBuckets.resize(type + 1);
+                }
+
+                if (!m_implementerBuckets[type])
+                {
+                    m_implementerBuckets[type] = Utilities::CreateScope<ImplementerContainer>();
+                }
+
+                return *m_implementerBuckets[type];
+            }
+
+            inline static std::atomic<uint32_t> s_typeCounter = 0u;
+
+            std::vector<std::vector<Utilities::Scope<EntityViewsCollection>>> m_entityViews;
+            std::vector<Utilities::Scope<ImplementerContainer>> m_implementerBuckets;
             uint32_t m_idCounter = 0;
     };
 }
\ No newline at end of file
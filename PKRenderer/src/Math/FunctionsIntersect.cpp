@@ -211,6 +211,19 @@ namespace PK::Math::Functions
         return true;
     }
 
+    bool BoundsContains(const BoundingBox& bounds, const BoundingBox& other)
+    {
+        for (auto i = 0; i < 3; ++i)
+        {
+            if (bounds.min[i] > other.min[i] || bounds.max[i] < other.max[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     BoundingBox BoundsTransform(const float4x4& matrix, const BoundingBox& bounds)
     {
         BoundingBox out(matrix[3].xyz, matrix[3].xyz);
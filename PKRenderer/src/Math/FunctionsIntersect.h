@@ -18,6 +18,7 @@ namespace PK::Math::Functions
     uint32_t BoundsShortestAxis(const BoundingBox& bounds);
     void BoundsSplit(const BoundingBox& bounds, uint32_t axis, BoundingBox* out0, BoundingBox* out1);
     bool BoundsContains(const BoundingBox& bounds, const float3& point);
+    bool BoundsContains(const BoundingBox& bounds, const BoundingBox& other);
     BoundingBox BoundsTransform(const float4x4& matrix, const BoundingBox& bounds);
     BoundingBox GetInverseFrustumBounds(const float4x4& inverseMatrix);
     BoundingBox GetInverseFrustumBounds(const float4x4& inverseMatrix, float lznear, float lzfar);
@@ -38,9 +38,35 @@ namespace PK::Math::Functions
         return GetMatrixTRS(position, glm::quat(euler), scale);
     }
 
+    // Analytic inverse: (T * R * S)^-1 = S^-1 * transpose(R) * T^-1
     float4x4 GetMatrixInvTRS(const float3& position, const quaternion& rotation, const float3& scale)
     {
-        return glm::inverse(GetMatrixTRS(position, rotation, scale));
+        float qxx(rotation.x * rotation.x);
+        float qyy(rotation.y * rotation.y);
+        float qzz(rotation.z * rotation.z);
+        float qxz(rotation.x * rotation.z);
+        float qxy(rotation.x * rotation.y);
+        float qyz(rotation.y * rotation.z);
+        float qwx(rotation.w * rotation.x);
+        float qwy(rotation.w * rotation.y);
+        float qwz(rotation.w * rotation.z);
+        float3 invScale = 1.0f / scale;
+
+        float4x4 m(1.0f);
+        m[0][0] = invScale[0] * (1.0f - 2.0f * (qyy + qzz));
+        m[1][0] = invScale[0] * (2.0f * (qxy + qwz));
+        m[2][0] = invScale[0] * (2.0f * (qxz - qwy));
+
+        m[0][1] = invScale[1] * (2.0f * (qxy - qwz));
+        m[1][1] = invScale[1] * (1.0f - 2.0f * (qxx + qzz));
+        m[2][1] = invScale[1] * (2.0f * (qyz + qwx));
+
+        m[0][2] = invScale[2] * (2.0f * (qxz + qwy));
+        m[1][2] = invScale[2] * (2.0f * (qyz - qwx));
+        m[2][2] = invScale[2] * (1.0f - 2.0f * (qxx + qyy));
+
+        m[3].xyz = -(float3x3(m) * position);
+        return m;
     }
 
     float4x4 GetMatrixInvTRS(const float3& position, const float3& euler, const float3& scale)
@@ -142,6 +142,53 @@ namespace PK::Math::Functions
         return { UnPackHalf(v.x), UnPackHalf(v.y), UnPackHalf(v.z), UnPackHalf(v.w) };
     }
 
+    static float2 OctaEncode(float3 n)
+    {
+        n /= glm::max(glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z), 1e-20f);
+        auto f = float2(n.x, n.z);
+
+        if (n.y < 0.0f)
+        {
+            f = (1.0f - glm::abs(float2(f.y, f.x))) * float2(f.x >= 0.0f ? 1.0f : -1.0f, f.y >= 0.0f ? 1.0f : -1.0f);
+        }
+
+        return glm::clamp(f * 0.5f + 0.5f, 0.0f, 1.0f);
+    }
+
+    static float3 OctaDecode(float2 f)
+    {
+        f = f * 2.0f - 1.0f;
+        auto n = float3(f.x, 1.0f - glm::abs(f.x) - glm::abs(f.y), f.y);
+        auto t = glm::max(-n.y, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.z += n.z >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    uint PackOctaUnorm16(const float3& direction)
+    {
+        auto f = OctaEncode(direction);
+        return (uint)glm::round(f.x * 65535.0f) | ((uint)glm::round(f.y * 65535.0f) << 16u);
+    }
+
+    float3 UnPackOctaUnorm16(uint v)
+    {
+        return OctaDecode(float2(v & 0xFFFFu, v >> 16u) / 65535.0f);
+    }
+
+    uint PackOctaTangent(const float4& tangent)
+    {
+        auto f = OctaEncode(float3(tangent));
+        auto sign = tangent.w < 0.0f ? 1u : 0u;
+        return (uint)glm::round(f.x * 65535.0f) | ((uint)glm::round(f.y * 32767.0f) << 16u) | (sign << 31u);
+    }
+
+    float4 UnPackOctaTangent(uint v)
+    {
+        auto f = float2(v & 0xFFFFu, (v >> 16u) & 0x7FFFu) / float2(65535.0f, 32767.0f);
+        return float4(OctaDecode(f), (v >> 31u) != 0u ? -1.0f : 1.0f);
+    }
+
     size_t GetNextExponentialSize(size_t start, size_t min)
     {
         if (start < 1)
@@ -23,6 +23,12 @@ namespace PK::Math::Functions
     float2 UnPackHalf(ushort2 v);
     float3 UnPackHalf(ushort3 v);
     float4 UnPackHalf(ushort4 v);
+    // Octahedral unit vectors with 16 bit unorm components. Matches OctaEncode in Encoding.glsl.
+    uint PackOctaUnorm16(const float3& direction);
+    float3 UnPackOctaUnorm16(uint v);
+    // Tangent direction with 16 & 15 bit components. The bitangent sign is stored in the top bit.
+    uint PackOctaTangent(const float4& tangent);
+    float4 UnPackOctaTangent(uint v);
     size_t GetNextExponentialSize(size_t start, size_t min);
     uint32_t GetMaxMipLevelPow2(uint32_t resolution);
     uint32_t GetMaxMipLevelPow2(uint2 resolution);
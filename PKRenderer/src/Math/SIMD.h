@@ -0,0 +1,138 @@
+#pragma once
+#include <immintrin.h>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace PK::Math::SIMD
+{
+    // Thin wrappers over SSE & AVX registers so that kernels can be written once & instantiated for both widths.
+    // Comparison results are lane masks stored in the same register type.
+    struct floatx4
+    {
+        constexpr static const uint32_t Width = 4u;
+        constexpr static const uint32_t LaneMask = 0xFu;
+        __m128 v;
+
+        floatx4() : v(_mm_setzero_ps()) {}
+        floatx4(__m128 value) : v(value) {}
+        floatx4(float value) : v(_mm_set1_ps(value)) {}
+
+        inline static floatx4 Load(const float* ptr) { return _mm_loadu_ps(ptr); }
+        inline static floatx4 LoadMask(__m128i value) { return _mm_castsi128_ps(value); }
+        inline void Store(float* ptr) const { _mm_storeu_ps(ptr, v); }
+
+        // Lanes where (flags & required) == required
+        inline static floatx4 TestFlags(const uint32_t* flags, uint32_t required)
+        {
+            auto r = _mm_set1_epi32((int)required);
+            auto f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags));
+            return LoadMask(_mm_cmpeq_epi32(_mm_and_si128(f, r), r));
+        }
+
+        // Lanes where (flags & bits) == 0
+        inline static floatx4 TestFlagsZero(const uint32_t* flags, uint32_t bits)
+        {
+            auto f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags));
+            return LoadMask(_mm_cmpeq_epi32(_mm_and_si128(f, _mm_set1_epi32((int)bits)), _mm_setzero_si128()));
+        }
+
+        inline void StoreUint(uint32_t* ptr) const { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), _mm_cvttps_epi32(v)); }
+        inline uint32_t MoveMask() const { return (uint32_t)_mm_movemask_ps(v); }
+    };
+
+    inline floatx4 operator + (const floatx4& a, const floatx4& b) { return _mm_add_ps(a.v, b.v); }
+    inline floatx4 operator - (const floatx4& a, const floatx4& b) { return _mm_sub_ps(a.v, b.v); }
+    inline floatx4 operator * (const floatx4& a, const floatx4& b) { return _mm_mul_ps(a.v, b.v); }
+    inline floatx4 operator & (const floatx4& a, const floatx4& b) { return _mm_and_ps(a.v, b.v); }
+    inline floatx4 operator | (const floatx4& a, const floatx4& b) { return _mm_or_ps(a.v, b.v); }
+    inline floatx4 operator < (const floatx4& a, const floatx4& b) { return _mm_cmplt_ps(a.v, b.v); }
+    inline floatx4 operator > (const floatx4& a, const floatx4& b) { return _mm_cmpgt_ps(a.v, b.v); }
+    inline floatx4 operator <= (const floatx4& a, const floatx4& b) { return _mm_cmple_ps(a.v, b.v); }
+    inline floatx4 operator >= (const floatx4& a, const floatx4& b) { return _mm_cmpge_ps(a.v, b.v); }
+    inline floatx4 Min(const floatx4& a, const floatx4& b) { return _mm_min_ps(a.v, b.v); }
+    inline floatx4 Max(const floatx4& a, const floatx4& b) { return _mm_max_ps(a.v, b.v); }
+    inline floatx4 Sqrt(const floatx4& a) { return _mm_sqrt_ps(a.v); }
+    inline floatx4 Abs(const floatx4& a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+    inline floatx4 Select(const floatx4& mask, const floatx4& a, const floatx4& b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+
+    struct floatx8
+    {
+        constexpr static const uint32_t Width = 8u;
+        constexpr static const uint32_t LaneMask = 0xFFu;
+        __m256 v;
+
+        floatx8() : v(_mm256_setzero_ps()) {}
+        floatx8(__m256 value) : v(value) {}
+        floatx8(float value) : v(_mm256_set1_ps(value)) {}
+
+        inline static floatx8 Load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+        inline static floatx8 LoadMask(__m256i value) { return _mm256_castsi256_ps(value); }
+        inline void Store(float* ptr) const { _mm256_storeu_ps(ptr, v); }
+
+        inline static floatx8 TestFlags(const uint32_t* flags, uint32_t required)
+        {
+            auto r = _mm256_set1_epi32((int)required);
+            auto f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flags));
+            return LoadMask(_mm256_cmpeq_epi32(_mm256_and_si256(f, r), r));
+        }
+
+        inline static floatx8 TestFlagsZero(const uint32_t* flags, uint32_t bits)
+        {
+            auto f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flags));
+            return LoadMask(_mm256_cmpeq_epi32(_mm256_and_si256(f, _mm256_set1_epi32((int)bits)), _mm256_setzero_si256()));
+        }
+
+        inline void StoreUint(uint32_t* ptr) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), _mm256_cvttps_epi32(v)); }
+        inline uint32_t MoveMask() const { return (uint32_t)_mm256_movemask_ps(v); }
+    };
+
+    inline floatx8 operator + (const floatx8& a, const floatx8& b) { return _mm256_add_ps(a.v, b.v); }
+    inline floatx8 operator - (const floatx8& a, const floatx8& b) { return _mm256_sub_ps(a.v, b.v); }
+    inline floatx8 operator * (const floatx8& a, const floatx8& b) { return _mm256_mul_ps(a.v, b.v); }
+    inline floatx8 operator & (const floatx8& a, const floatx8& b) { return _mm256_and_ps(a.v, b.v); }
+    inline floatx8 operator | (const floatx8& a, const floatx8& b) { return _mm256_or_ps(a.v, b.v); }
+    inline floatx8 operator < (const floatx8& a, const floatx8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+    inline floatx8 operator > (const floatx8& a, const floatx8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+    inline floatx8 operator <= (const floatx8& a, const floatx8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+    inline floatx8 operator >= (const floatx8& a, const floatx8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+    inline floatx8 Min(const floatx8& a, const floatx8& b) { return _mm256_min_ps(a.v, b.v); }
+    inline floatx8 Max(const floatx8& a, const floatx8& b) { return _mm256_max_ps(a.v, b.v); }
+    inline floatx8 Sqrt(const floatx8& a) { return _mm256_sqrt_ps(a.v); }
+    inline floatx8 Abs(const floatx8& a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+    inline floatx8 Select(const floatx8& mask, const floatx8& a, const floatx8& b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+    inline bool SupportsAVX2()
+    {
+        static const bool isSupported = []()
+        {
+            #if defined(_MSC_VER)
+                int info[4];
+                __cpuid(info, 0);
+
+                if (info[0] < 7)
+                {
+                    return false;
+                }
+
+                __cpuid(info, 1);
+                auto osxsave = (info[2] & (1 << 27)) != 0;
+                auto avx = (info[2] & (1 << 28)) != 0;
+
+                if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+                {
+                    return false;
+                }
+
+                __cpuidex(info, 7, 0);
+                return (info[1] & (1 << 5)) != 0;
+            #else
+                return __builtin_cpu_supports("avx2");
+            #endif
+        }();
+
+        return isSupported;
+    }
+}
\ No newline at end of file
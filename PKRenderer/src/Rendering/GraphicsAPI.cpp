@@ -74,6 +74,8 @@ namespace PK::Rendering
     APIType GraphicsAPI::GetActiveAPI() { return s_currentDriver->GetAPI(); }
     QueueSet* GraphicsAPI::GetQueues() { return s_currentDriver->GetQueues(); }
     DriverMemoryInfo GraphicsAPI::GetMemoryInfo() { return s_currentDriver->GetMemoryInfo(); }
+    DriverPipelineInfo GraphicsAPI::GetPipelineInfo() { return s_currentDriver->GetPipelineInfo(); }
+    DriverStagingInfo GraphicsAPI::GetStagingInfo() { return s_currentDriver->GetStagingInfo(); }
     size_t GraphicsAPI::GetBufferOffsetAlignment(BufferUsage usage) { return s_currentDriver->GetBufferOffsetAlignment(usage); }
 
     void GraphicsAPI::SetBuffer(uint32_t nameHashId, Buffer* buffer, const IndexRange& range) { s_currentDriver->SetBuffer(nameHashId, buffer, range); }
@@ -26,12 +26,50 @@ namespace PK::Rendering
         size_t unusedRangeSizeMax;
     };
 
+    constexpr static const uint32_t PK_PIPELINE_MISS_HISTORY_SIZE = 32u;
+
+    // Pipeline creation outside of precompilation stalls the recording thread. Misses are tracked per frame to locate hitches.
+    struct DriverPipelineInfo
+    {
+        uint32_t pipelineCount;
+        uint32_t manifestCount;
+        uint32_t precompiledCount;
+        uint32_t missCount;
+        uint32_t maxFrameMissCount;
+        double missMilliseconds;
+        double maxMissMilliseconds;
+        double precompileMilliseconds;
+        // Most recent completed frame first.
+        uint32_t frameMissCounts[PK_PIPELINE_MISS_HISTORY_SIZE];
+        float frameMissMilliseconds[PK_PIPELINE_MISS_HISTORY_SIZE];
+    };
+
+    // Staging memory for uploads. Frame values are those of the last completed frame.
+    struct DriverStagingInfo
+    {
+        size_t ringCapacity;
+        size_t ringUsedBytes;
+        size_t ringPeakUsedBytes;
+        uint32_t ringGrowCount;
+        // Allocations that found the ring full of in flight uploads.
+        uint32_t ringExhaustedCount;
+        uint32_t allocationCount;
+        uint32_t frameAllocationCount;
+        size_t frameBytes;
+        size_t peakFrameBytes;
+        uint32_t dedicatedCount;
+        uint32_t dedicatedActiveCount;
+        size_t dedicatedBytes;
+    };
+
     struct GraphicsDriver : public PK::Utilities::NoCopy
     {
         virtual ~GraphicsDriver() = default;
         virtual Structs::APIType GetAPI() const = 0;
         virtual Objects::QueueSet* GetQueues() const = 0;
         virtual DriverMemoryInfo GetMemoryInfo() const = 0;
+        virtual DriverPipelineInfo GetPipelineInfo() const = 0;
+        virtual DriverStagingInfo GetStagingInfo() const = 0;
         virtual std::string GetDriverHeader() const = 0;
         virtual size_t GetBufferOffsetAlignment(Structs::BufferUsage usage) const = 0;
 
@@ -44,6 +82,8 @@ namespace PK::Rendering
         virtual void SetConstant(uint32_t nameHashId, const void* data, uint32_t size) = 0;
         virtual void SetKeyword(uint32_t nameHashId, bool value) = 0;
 
+        // Recreates the pipelines recorded by previous sessions. Shaders are expected to be loaded.
+        virtual void PrecompilePipelines(Core::Services::AssetDatabase* assetDatabase, Core::Services::JobSystem* jobSystem) = 0;
         virtual void WaitForIdle() const = 0;
         virtual void GC() = 0;
 
@@ -66,6 +106,8 @@ namespace PK::Rendering
         Structs::APIType GetActiveAPI();
         PK::Rendering::Objects::QueueSet* GetQueues();
         DriverMemoryInfo GetMemoryInfo();
+        DriverPipelineInfo GetPipelineInfo();
+        DriverStagingInfo GetStagingInfo();
         size_t GetBufferOffsetAlignment(Structs::BufferUsage usage);
 
         void SetBuffer(uint32_t nameHashId, PK::Rendering::Objects::Buffer* buffer, const Structs::IndexRange& range);
@@ -73,7 +73,10 @@ namespace PK::Rendering
         DECLARE_HASH(pk_ScreenGI_SHY_Write)
         DECLARE_HASH(pk_ScreenGI_CoCg_Read)
         DECLARE_HASH(pk_ScreenGI_CoCg_Write)
-        DECLARE_HASH(pk_SceneGI_ST)
+        DECLARE_HASH(pk_SceneGI_ClipmapOrigins)
+        DECLARE_HASH(pk_SceneGI_ClipmapScroll)
+        DECLARE_HASH(pk_SceneGI_VoxelizeLevel)
+        DECLARE_HASH(pk_SceneGI_ScrollLevel)
         DECLARE_HASH(pk_SceneGI_Swizzle)
         DECLARE_HASH(pk_SceneGI_Checkerboard_Offset)
         DECLARE_HASH(pk_SceneGI_VoxelSize)
@@ -153,6 +156,7 @@ namespace PK::Rendering
         DECLARE_HASH(PK_INSTANCING_ENABLED)
         DECLARE_HASH(PK_META_PASS_GBUFFER)
         DECLARE_HASH(PK_META_PASS_GIVOXELIZE)
+        DECLARE_HASH(PK_VERTEX_COMPACT)
         DECLARE_HASH(SHADOW_SOURCE_CUBE)
         DECLARE_HASH(SHADOW_SOURCE_2D)
         DECLARE_HASH(SHADOW_BLUR_PASS0)
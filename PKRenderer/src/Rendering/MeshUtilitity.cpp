@@ -1,7 +1,9 @@
 #include "PrecompiledHeader.h"
 #include "MeshUtility.h"
 #include "Rendering/Structs/StructsCommon.h"
+#include "Rendering/Structs/Enums.h"
 #include "Rendering/GraphicsAPI.h"
+#include "Math/FunctionsIntersect.h"
 #include <mikktspace/mikktspace.h>
 
 namespace PK::Rendering::MeshUtility
@@ -249,6 +251,929 @@ namespace PK::Rendering::MeshUtility
         PK_THROW_ASSERT(genTangSpaceDefault(&context), "Failed to calculate tangents");
     }
 
+    static uint32_t CacheVertex(uint32_t vertex, uint32_t* cacheTimes, uint32_t* timestamp, uint32_t cacheSize)
+    {
+        // Timestamps only advance on misses. An entry is evicted once cacheSize newer entries have been inserted.
+        if (*timestamp - cacheTimes[vertex] > cacheSize)
+        {
+            cacheTimes[vertex] = (*timestamp)++;
+            return 1u;
+        }
+
+        return 0u;
+    }
+
+    VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, uint32_t icount, uint32_t vcount, uint32_t cacheSize)
+    {
+        std::vector<uint32_t> cacheTimes(vcount, 0u);
+        std::vector<uint8_t> isReferenced(vcount, 0u);
+        auto timestamp = cacheSize + 1u;
+        auto misses = 0u;
+        auto referenced = 0u;
+
+        for (auto i = 0u; i < icount; ++i)
+        {
+            misses += CacheVertex(indices[i], cacheTimes.data(), &timestamp, cacheSize);
+            referenced += isReferenced[indices[i]] == 0u ? 1u : 0u;
+            isReferenced[indices[i]] = 1u;
+        }
+
+        VertexCacheStatistics statistics;
+        statistics.acmr = icount >= 3u ? (float)misses / (float)(icount / 3u) : 0.0f;
+        statistics.atvr = referenced > 0u ? (float)misses / (float)referenced : 0.0f;
+        return statistics;
+    }
+
+    void OptimizeVertexCache(uint32_t* indices, uint32_t icount, uint32_t vcount, std::vector<uint32_t>* outClusters, uint32_t cacheSize)
+    {
+        auto tcount = icount / 3u;
+        std::vector<uint32_t> liveCounts(vcount, 0u);
+        std::vector<uint32_t> offsets(vcount + 1u, 0u);
+        std::vector<uint32_t> adjacency(tcount * 3u);
+
+        for (auto i = 0u; i < tcount * 3u; ++i)
+        {
+            liveCounts[indices[i]]++;
+        }
+
+        for (auto i = 0u; i < vcount; ++i)
+        {
+            offsets[i + 1u] = offsets[i] + liveCounts[i];
+        }
+
+        {
+            std::vector<uint32_t> heads(offsets.begin(), offsets.end() - 1);
+
+            for (auto i = 0u; i < tcount * 3u; ++i)
+            {
+                adjacency[heads[indices[i]]++] = i / 3u;
+            }
+        }
+
+        std::vector<uint32_t> cacheTimes(vcount, 0u);
+        std::vector<uint8_t> isEmitted(tcount, 0u);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(tcount * 3u);
+        deadEnds.reserve(tcount * 3u);
+
+        auto timestamp = cacheSize + 1u;
+        auto cursor = 0u;
+        auto fanningVertex = ~0u;
+        auto isColdStart = true;
+
+        while (cursor < vcount && liveCounts[cursor] == 0u)
+        {
+            ++cursor;
+        }
+
+        fanningVertex = cursor < vcount ? cursor : ~0u;
+
+        while (fanningVertex != ~0u)
+        {
+            if (isColdStart && outClusters != nullptr)
+            {
+                outClusters->push_back((uint32_t)output.size() / 3u);
+            }
+
+            candidates.clear();
+
+            for (auto i = offsets[fanningVertex]; i < offsets[fanningVertex + 1u]; ++i)
+            {
+                auto triangle = adjacency[i];
+
+                if (isEmitted[triangle])
+                {
+                    continue;
+                }
+
+                for (auto j = 0u; j < 3u; ++j)
+                {
+                    auto vertex = indices[triangle * 3u + j];
+                    output.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveCounts[vertex]--;
+                    CacheVertex(vertex, cacheTimes.data(), &timestamp, cacheSize);
+                }
+
+                isEmitted[triangle] = 1u;
+            }
+
+            // Prefer the 1-ring vertex that stays in cache for all of its remaining triangles & was inserted the earliest.
+            auto bestVertex = ~0u;
+            auto bestPriority = -1;
+
+            for (auto vertex : candidates)
+            {
+                if (liveCounts[vertex] == 0u)
+                {
+                    continue;
+                }
+
+                auto age = timestamp - cacheTimes[vertex];
+                auto priority = age + 2u * liveCounts[vertex] <= cacheSize ? (int)age : 0;
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    bestVertex = vertex;
+                }
+            }
+
+            isColdStart = bestVertex == ~0u;
+
+            while (bestVertex == ~0u && !deadEnds.empty())
+            {
+                auto vertex = deadEnds.back();
+                deadEnds.pop_back();
+                bestVertex = liveCounts[vertex] > 0u ? vertex : ~0u;
+            }
+
+            while (bestVertex == ~0u && cursor < vcount)
+            {
+                bestVertex = liveCounts[cursor] > 0u ? cursor : ~0u;
+                cursor += bestVertex == ~0u ? 1u : 0u;
+            }
+
+            fanningVertex = bestVertex;
+        }
+
+        memcpy(indices, output.data(), sizeof(uint32_t) * output.size());
+    }
+
+    void OptimizeOverdraw(uint32_t* indices, uint32_t icount, uint32_t vcount, const void* positions, uint32_t positionStride, const std::vector<uint32_t>& clusters, float threshold, uint32_t cacheSize)
+    {
+        auto tcount = icount / 3u;
+
+        if (tcount == 0u || clusters.empty())
+        {
+            return;
+        }
+
+        // Split clusters further where the cache miss ratio of the prefix is already within the threshold of the whole cluster.
+        // Each split starts from a cold cache so that reordering the splits does not exceed the threshold.
+        std::vector<uint32_t> cacheTimes(vcount, 0u);
+        std::vector<uint32_t> splits;
+        auto timestamp = cacheSize + 1u;
+
+        for (auto i = 0u; i < clusters.size(); ++i)
+        {
+            auto begin = clusters[i];
+            auto end = i + 1u < clusters.size() ? clusters[i + 1u] : tcount;
+            auto clusterMisses = 0u;
+            timestamp += cacheSize + 1u;
+
+            for (auto j = begin * 3u; j < end * 3u; ++j)
+            {
+                clusterMisses += CacheVertex(indices[j], cacheTimes.data(), &timestamp, cacheSize);
+            }
+
+            auto clusterThreshold = threshold * (float)clusterMisses / (float)(end - begin);
+            auto start = begin;
+            auto misses = 0u;
+            timestamp += cacheSize + 1u;
+            splits.push_back(begin);
+
+            for (auto j = begin; j < end; ++j)
+            {
+                misses += CacheVertex(indices[j * 3u + 0u], cacheTimes.data(), &timestamp, cacheSize);
+                misses += CacheVertex(indices[j * 3u + 1u], cacheTimes.data(), &timestamp, cacheSize);
+                misses += CacheVertex(indices[j * 3u + 2u], cacheTimes.data(), &timestamp, cacheSize);
+
+                if (j + 1u < end && (float)misses / (float)(j + 1u - start) <= clusterThreshold)
+                {
+                    splits.push_back(j + 1u);
+                    start = j + 1u;
+                    misses = 0u;
+                    timestamp += cacheSize + 1u;
+                }
+            }
+        }
+
+        struct ClusterInfo
+        {
+            float3 centroid = PK_FLOAT3_ZERO;
+            float3 normal = PK_FLOAT3_ZERO;
+            float area = 0.0f;
+            float sortKey = 0.0f;
+            uint32_t index = 0u;
+        };
+
+        auto getPosition = [positions, positionStride](uint32_t vertex)
+        {
+            return *reinterpret_cast<const float3*>(reinterpret_cast<const char*>(positions) + (size_t)vertex * positionStride);
+        };
+
+        std::vector<ClusterInfo> infos(splits.size());
+        auto meshCentroid = PK_FLOAT3_ZERO;
+        auto meshArea = 0.0f;
+
+        for (auto i = 0u; i < splits.size(); ++i)
+        {
+            auto& info = infos[i];
+            auto end = i + 1u < splits.size() ? splits[i + 1u] : tcount;
+            info.index = i;
+
+            for (auto j = splits[i]; j < end; ++j)
+            {
+                auto p0 = getPosition(indices[j * 3u + 0u]);
+                auto p1 = getPosition(indices[j * 3u + 1u]);
+                auto p2 = getPosition(indices[j * 3u + 2u]);
+                auto normal = glm::cross(p1 - p0, p2 - p0);
+                auto area = glm::length(normal);
+                info.centroid += (p0 + p1 + p2) * (area / 3.0f);
+                info.normal += normal;
+                info.area += area;
+            }
+
+            meshCentroid += info.centroid;
+            meshArea += info.area;
+        }
+
+        meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+        for (auto& info : infos)
+        {
+            auto normalLength = glm::length(info.normal);
+            auto centroid = info.area > 0.0f ? info.centroid / info.area : info.centroid;
+            info.sortKey = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, info.normal / normalLength) : 0.0f;
+        }
+
+        std::stable_sort(infos.begin(), infos.end(), [](const ClusterInfo& a, const ClusterInfo& b) { return a.sortKey > b.sortKey; });
+
+        std::vector<uint32_t> output;
+        output.reserve(tcount * 3u);
+
+        for (auto& info : infos)
+        {
+            auto end = info.index + 1u < splits.size() ? splits[info.index + 1u] : tcount;
+            output.insert(output.end(), indices + splits[info.index] * 3u, indices + end * 3u);
+        }
+
+        memcpy(indices, output.data(), sizeof(uint32_t) * output.size());
+    }
+
+    uint32_t OptimizeVertexFetch(uint32_t* indices, uint32_t icount, uint32_t vcount, uint32_t* outRemap)
+    {
+        auto next = 0u;
+
+        for (auto i = 0u; i < vcount; ++i)
+        {
+            outRemap[i] = ~0u;
+        }
+
+        for (auto i = 0u; i < icount; ++i)
+        {
+            auto& remapped = outRemap[indices[i]];
+            remapped = remapped == ~0u ? next++ : remapped;
+            indices[i] = remapped;
+        }
+
+        auto referencedCount = next;
+
+        for (auto i = 0u; i < vcount; ++i)
+        {
+            outRemap[i] = outRemap[i] == ~0u ? next++ : outRemap[i];
+        }
+
+        return referencedCount;
+    }
+
+    void RemapVertices(void* vertices, uint32_t stride, uint32_t vcount, const uint32_t* remap)
+    {
+        auto source = std::vector<char>(reinterpret_cast<char*>(vertices), reinterpret_cast<char*>(vertices) + (size_t)stride * vcount);
+
+        for (auto i = 0u; i < vcount; ++i)
+        {
+            memcpy(reinterpret_cast<char*>(vertices) + (size_t)remap[i] * stride, source.data() + (size_t)i * stride, stride);
+        }
+    }
+
+    void OptimizeMesh(const MeshOptimizationInfo& info, VertexCacheStatistics* outBefore, VertexCacheStatistics* outAfter)
+    {
+        if (outBefore != nullptr)
+        {
+            *outBefore = AnalyzeVertexCache(info.indices, info.indexCount, info.vertexCount);
+        }
+
+        std::vector<uint32_t> clusters;
+
+        for (auto i = 0u; i < info.rangeCount; ++i)
+        {
+            auto range = info.ranges[i];
+            PK_THROW_ASSERT(range.x + range.y <= info.indexCount, "Mesh optimization range is out of bounds!");
+            clusters.clear();
+            OptimizeVertexCache(info.indices + range.x, range.y, info.vertexCount, &clusters);
+
+            if (info.positions != nullptr)
+            {
+                OptimizeOverdraw(info.indices + range.x, range.y, info.vertexCount, info.positions, info.positionStride, clusters);
+            }
+        }
+
+        std::vector<uint32_t> remap(info.vertexCount);
+        OptimizeVertexFetch(info.indices, info.indexCount, info.vertexCount, remap.data());
+
+        for (auto i = 0u; i < info.streamCount; ++i)
+        {
+            RemapVertices(info.streams[i], info.streamStrides[i], info.vertexCount, remap.data());
+        }
+
+        if (outAfter != nullptr)
+        {
+            *outAfter = AnalyzeVertexCache(info.indices, info.indexCount, info.vertexCount);
+        }
+    }
+
+    struct Quadric
+    {
+        // Upper triangle of the symmetric plane equation outer product. Weighted by triangle area.
+        float a00, a11, a22, a10, a20, a21, b0, b1, b2, c, w;
+    };
+
+    static void AddQuadric(Quadric* q, const Quadric& other)
+    {
+        q->a00 += other.a00;
+        q->a11 += other.a11;
+        q->a22 += other.a22;
+        q->a10 += other.a10;
+        q->a20 += other.a20;
+        q->a21 += other.a21;
+        q->b0 += other.b0;
+        q->b1 += other.b1;
+        q->b2 += other.b2;
+        q->c += other.c;
+        q->w += other.w;
+    }
+
+    // Squared distance to the accumulated planes averaged by weight.
+    static float GetQuadricError(const Quadric& a, const Quadric& b, const float3& p)
+    {
+        Quadric q = a;
+        AddQuadric(&q, b);
+        auto error = q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z;
+        error += 2.0f * (q.a10 * p.x * p.y + q.a20 * p.x * p.z + q.a21 * p.y * p.z);
+        error += 2.0f * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+        return glm::abs(error) / glm::max(q.w, 1e-20f);
+    }
+
+    static float3 GetTriangleNormal(const float3& p0, const float3& p1, const float3& p2)
+    {
+        return glm::cross(p1 - p0, p2 - p0);
+    }
+
+    uint32_t SimplifyIndices(const uint32_t* indices, uint32_t icount, const void* positions, uint32_t positionStride, uint32_t vcount, uint32_t targetIndexCount, float targetError, uint32_t* outIndices, float* outError)
+    {
+        auto getPosition = [positions, positionStride](uint32_t i) { return *reinterpret_cast<const float3*>(reinterpret_cast<const char*>(positions) + (size_t)i * positionStride); };
+
+        std::vector<uint32_t> current(indices, indices + icount);
+        std::vector<uint32_t> canonical(vcount, ~0u);
+        std::vector<uint8_t> locked(vcount, 0u);
+        std::vector<uint32_t> referenced;
+
+        for (auto i = 0u; i < icount; ++i)
+        {
+            if (canonical[indices[i]] == ~0u)
+            {
+                canonical[indices[i]] = indices[i];
+                referenced.push_back(indices[i]);
+            }
+        }
+
+        // Vertices sharing a position are welded. Wedges of a seam differ by their other attributes & are locked.
+        std::sort(referenced.begin(), referenced.end(), [&getPosition](uint32_t a, uint32_t b)
+            {
+                auto pa = getPosition(a);
+                auto pb = getPosition(b);
+                return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z != pb.z ? pa.z < pb.z : a < b;
+            });
+
+        for (auto i = 0u; i < referenced.size();)
+        {
+            auto end = i + 1u;
+
+            while (end < referenced.size() && getPosition(referenced[end]) == getPosition(referenced[i]))
+            {
+                canonical[referenced[end++]] = referenced[i];
+            }
+
+            for (auto j = i; j < end && end - i > 1u; ++j)
+            {
+                locked[referenced[j]] = 1u;
+            }
+
+            i = end;
+        }
+
+        // Welded edges that are not shared by exactly two triangles are open or non manifold. Their vertices are locked.
+        std::vector<uint64_t> edges;
+        edges.reserve(icount);
+
+        for (auto i = 0u; i + 2u < icount; i += 3u)
+        {
+            for (auto j = 0u; j < 3u; ++j)
+            {
+                auto a = canonical[indices[i + j]];
+                auto b = canonical[indices[i + (j + 1u) % 3u]];
+                edges.push_back(((uint64_t)glm::min(a, b) << 32ull) | glm::max(a, b));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+
+        for (auto i = 0u; i < edges.size();)
+        {
+            auto end = i + 1u;
+
+            while (end < edges.size() && edges[end] == edges[i])
+            {
+                ++end;
+            }
+
+            if (end - i != 2u)
+            {
+                locked[(uint32_t)(edges[i] >> 32ull)] = 1u;
+                locked[(uint32_t)(edges[i] & 0xFFFFFFFFull)] = 1u;
+            }
+
+            i = end;
+        }
+
+        for (auto v : referenced)
+        {
+            locked[v] |= locked[canonical[v]];
+        }
+
+        std::vector<Quadric> quadrics(vcount, Quadric{});
+
+        for (auto i = 0u; i + 2u < icount; i += 3u)
+        {
+            auto p0 = getPosition(indices[i + 0u]);
+            auto normal = GetTriangleNormal(p0, getPosition(indices[i + 1u]), getPosition(indices[i + 2u]));
+            auto length = glm::length(normal);
+
+            if (length <= 0.0f)
+            {
+                continue;
+            }
+
+            auto w = length * 0.5f;
+            auto n = normal / length;
+            auto d = -glm::dot(n, p0);
+            Quadric q = { n.x * n.x * w, n.y * n.y * w, n.z * n.z * w, n.y * n.x * w, n.z * n.x * w, n.z * n.y * w, n.x * d * w, n.y * d * w, n.z * d * w, d * d * w, w };
+
+            for (auto j = 0u; j < 3u; ++j)
+            {
+                AddQuadric(&quadrics[canonical[indices[i + j]]], q);
+            }
+        }
+
+        struct Collapse
+        {
+            uint32_t source;
+            uint32_t target;
+            float error;
+        };
+
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> remap(vcount);
+        std::vector<uint8_t> passLocked(vcount);
+        std::vector<uint32_t> adjacencyOffsets(vcount + 1u);
+        std::vector<uint32_t> adjacency;
+        auto maxError = 0.0f;
+        auto maxErrorSquared = targetError * targetError;
+
+        while (current.size() > targetIndexCount)
+        {
+            auto tcount = (uint32_t)(current.size() / 3u);
+
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+
+            for (auto i = 0u; i < tcount * 3u; ++i)
+            {
+                adjacencyOffsets[current[i] + 1u]++;
+            }
+
+            for (auto i = 0u; i < vcount; ++i)
+            {
+                adjacencyOffsets[i + 1u] += adjacencyOffsets[i];
+            }
+
+            adjacency.resize(tcount * 3u);
+
+            for (auto i = 0u; i < tcount * 3u; ++i)
+            {
+                adjacency[adjacencyOffsets[current[i]]++] = i / 3u;
+            }
+
+            for (auto i = vcount; i > 0u; --i)
+            {
+                adjacencyOffsets[i] = adjacencyOffsets[i - 1u];
+            }
+
+            adjacencyOffsets[0] = 0u;
+
+            collapses.clear();
+
+            for (auto i = 0u; i < tcount * 3u; ++i)
+            {
+                auto source = current[i];
+                auto target = current[i - i % 3u + (i + 1u) % 3u];
+
+                for (auto j = 0u; j < 2u; ++j, std::swap(source, target))
+                {
+                    if (!locked[source] && canonical[source] != canonical[target])
+                    {
+                        auto error = GetQuadricError(quadrics[canonical[source]], quadrics[canonical[target]], getPosition(target));
+
+                        if (error <= maxErrorSquared)
+                        {
+                            collapses.push_back({ source, target, error });
+                        }
+                    }
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            for (auto i = 0u; i < vcount; ++i)
+            {
+                remap[i] = i;
+            }
+
+            std::fill(passLocked.begin(), passLocked.end(), 0u);
+
+            // A collapse removes two triangles from a manifold neighbourhood. Stop once the remaining budget would be exceeded.
+            auto removeBudget = (tcount - targetIndexCount / 3u + 1u) / 2u;
+            auto collapseCount = 0u;
+
+            for (auto& collapse : collapses)
+            {
+                if (collapseCount >= removeBudget)
+                {
+                    break;
+                }
+
+                if (passLocked[collapse.source] || passLocked[collapse.target])
+                {
+                    continue;
+                }
+
+                auto targetPosition = getPosition(collapse.target);
+                auto isFlipping = false;
+
+                for (auto j = adjacencyOffsets[collapse.source]; j < adjacencyOffsets[collapse.source + 1u] && !isFlipping; ++j)
+                {
+                    auto t = current.data() + adjacency[j] * 3u;
+
+                    if (t[0] == collapse.target || t[1] == collapse.target || t[2] == collapse.target)
+                    {
+                        continue;
+                    }
+
+                    float3 p[3] = { getPosition(t[0]), getPosition(t[1]), getPosition(t[2]) };
+                    auto n0 = GetTriangleNormal(p[0], p[1], p[2]);
+
+                    for (auto k = 0u; k < 3u; ++k)
+                    {
+                        p[k] = t[k] == collapse.source ? targetPosition : p[k];
+                    }
+
+                    auto n1 = GetTriangleNormal(p[0], p[1], p[2]);
+                    isFlipping = glm::dot(n0, n1) <= 1e-2f * glm::length(n0) * glm::length(n1);
+                }
+
+                if (isFlipping)
+                {
+                    continue;
+                }
+
+                // Neighbourhoods of collapsed vertices are frozen for the rest of the pass so that adjacency & flip tests remain valid.
+                for (auto j = adjacencyOffsets[collapse.source]; j < adjacencyOffsets[collapse.source + 1u]; ++j)
+                {
+                    auto t = current.data() + adjacency[j] * 3u;
+                    passLocked[t[0]] = 1u;
+                    passLocked[t[1]] = 1u;
+                    passLocked[t[2]] = 1u;
+                }
+
+                remap[collapse.source] = collapse.target;
+                AddQuadric(&quadrics[canonical[collapse.target]], quadrics[canonical[collapse.source]]);
+                maxError = glm::max(maxError, collapse.error);
+                collapseCount++;
+            }
+
+            if (collapseCount == 0u)
+            {
+                break;
+            }
+
+            auto count = 0u;
+
+            for (auto i = 0u; i < tcount * 3u; i += 3u)
+            {
+                auto a = remap[current[i + 0u]];
+                auto b = remap[current[i + 1u]];
+                auto c = remap[current[i + 2u]];
+
+                if (a != b && b != c && c != a)
+                {
+                    current[count++] = a;
+                    current[count++] = b;
+                    current[count++] = c;
+                }
+            }
+
+            current.resize(count);
+        }
+
+        memcpy(outIndices, current.data(), sizeof(uint32_t) * current.size());
+
+        if (outError != nullptr)
+        {
+            *outError = glm::sqrt(maxError);
+        }
+
+        return (uint32_t)current.size();
+    }
+
+    uint32_t GenerateLodChain(std::vector<uint32_t>& indices, const uint2* ranges, uint32_t rangeCount, const void* positions, uint32_t positionStride, uint32_t vcount, std::vector<uint2>* outRanges)
+    {
+        outRanges->resize((PK_MAX_MESH_LODS - 1u) * rangeCount);
+        std::vector<uint32_t> simplified;
+        auto lodCount = 1u;
+
+        for (auto i = 0u; i < rangeCount; ++i)
+        {
+            auto range = ranges[i];
+            auto bounds = BoundingBox::GetMinBounds();
+
+            for (auto j = range.x; j < range.x + range.y; ++j)
+            {
+                auto position = *reinterpret_cast<const float3*>(reinterpret_cast<const char*>(positions) + (size_t)indices[j] * positionStride);
+                bounds.min = glm::min(bounds.min, position);
+                bounds.max = glm::max(bounds.max, position);
+            }
+
+            auto radius = range.y > 0u ? glm::length(bounds.GetExtents()) : 0.0f;
+            auto previous = range;
+            auto isExhausted = false;
+            simplified.resize(range.y);
+
+            for (auto lod = 1u; lod < PK_MAX_MESH_LODS; ++lod)
+            {
+                // A level is first used when the radius covers PK_MESH_LOD_SCREEN_SIZES[lod - 1] of half the view height.
+                // Scale the error so that it projects to at most PK_MESH_LOD_MAX_SCREEN_ERROR at that size.
+                auto targetError = radius * PK_MESH_LOD_MAX_SCREEN_ERROR / PK_MESH_LOD_SCREEN_SIZES[lod - 1u];
+                auto targetCount = (range.y >> lod) / 3u * 3u;
+                auto count = isExhausted ? 0u : SimplifyIndices(indices.data() + range.x, range.y, positions, positionStride, vcount, targetCount, targetError, simplified.data());
+
+                // Levels that barely reduce the triangle count are not worth switching to.
+                if (count == 0u || count > previous.y - previous.y / 8u)
+                {
+                    isExhausted = true;
+                }
+                else
+                {
+                    OptimizeVertexCache(simplified.data(), count, vcount);
+                    previous = uint2((uint32_t)indices.size(), count);
+                    indices.insert(indices.end(), simplified.begin(), simplified.begin() + count);
+                    lodCount = glm::max(lodCount, lod + 1u);
+                }
+
+                (*outRanges)[(lod - 1u) * rangeCount + i] = previous;
+            }
+        }
+
+        outRanges->resize((lodCount - 1u) * rangeCount);
+        return lodCount;
+    }
+
+    void LinkSubmeshLods(SubMesh* submeshes, uint32_t baseCount, uint32_t lodCount)
+    {
+        for (auto i = 0u; i < baseCount; ++i)
+        {
+            submeshes[i].lodLevel = 0u;
+            submeshes[i].nextLod = ~0u;
+
+            for (auto lod = 1u, previous = i; lod < lodCount; ++lod)
+            {
+                auto current = lod * baseCount + i;
+                submeshes[current].lodLevel = lod;
+                submeshes[current].nextLod = ~0u;
+
+                if (submeshes[current].firstIndex != submeshes[previous].firstIndex || submeshes[current].indexCount != submeshes[previous].indexCount)
+                {
+                    submeshes[previous].nextLod = current;
+                    previous = current;
+                }
+            }
+        }
+    }
+
+    uint32_t GenerateSubmeshLods(std::vector<SubMesh>& submeshes, std::vector<uint32_t>& indices, const void* positions, uint32_t positionStride, uint32_t vcount)
+    {
+        auto baseCount = (uint32_t)submeshes.size();
+        std::vector<uint2> ranges;
+        std::vector<uint2> lodRanges;
+
+        for (auto& submesh : submeshes)
+        {
+            ranges.emplace_back(submesh.firstIndex, submesh.indexCount);
+        }
+
+        auto lodCount = GenerateLodChain(indices, ranges.data(), baseCount, positions, positionStride, vcount, &lodRanges);
+
+        // Levels share the vertex range & bounds of their base submesh.
+        for (auto i = 0u; i < lodRanges.size(); ++i)
+        {
+            auto submesh = submeshes[i % baseCount];
+            submesh.firstIndex = lodRanges[i].x;
+            submesh.indexCount = lodRanges[i].y;
+            submeshes.push_back(submesh);
+        }
+
+        LinkSubmeshLods(submeshes.data(), baseCount, lodCount);
+        return lodCount;
+    }
+
+    // Triangle normals point out of front faces for the counter clockwise front face of the default rasterizer state.
+    static const float PK_MESHLET_WINDING_SIGN = RasterizationParameters().frontFace == FrontFace::CounterClockwise ? 1.0f : -1.0f;
+
+    static Meshlet GetMeshletBounds(const uint32_t* indices, uint32_t first, uint32_t count, const std::vector<uint32_t>& vertices, const void* positions, uint32_t positionStride)
+    {
+        auto getPosition = [positions, positionStride](uint32_t i) { return *reinterpret_cast<const float3*>(reinterpret_cast<const char*>(positions) + (size_t)i * positionStride); };
+
+        Meshlet meshlet{};
+        meshlet.firstIndex = first;
+        meshlet.indexCount = count;
+
+        auto bmin = getPosition(vertices[0]);
+        auto bmax = bmin;
+
+        for (auto vertex : vertices)
+        {
+            bmin = glm::min(bmin, getPosition(vertex));
+            bmax = glm::max(bmax, getPosition(vertex));
+        }
+
+        auto center = (bmin + bmax) * 0.5f;
+        auto radius = 0.0f;
+
+        for (auto vertex : vertices)
+        {
+            radius = glm::max(radius, glm::length(getPosition(vertex) - center));
+        }
+
+        meshlet.sphere = float4(center, radius);
+
+        std::vector<float3> faceNormals;
+        auto axis = PK_FLOAT3_ZERO;
+
+        for (auto i = first; i < first + count; i += 3u)
+        {
+            auto normal = GetTriangleNormal(getPosition(indices[i]), getPosition(indices[i + 1u]), getPosition(indices[i + 2u]));
+            auto length = glm::length(normal);
+
+            if (length < 1e-20f)
+            {
+                continue;
+            }
+
+            normal *= PK_MESHLET_WINDING_SIGN / length;
+            faceNormals.push_back(normal);
+            axis += normal;
+        }
+
+        auto axisLength = glm::length(axis);
+
+        if (faceNormals.empty() || axisLength < 1e-6f)
+        {
+            return meshlet;
+        }
+
+        axis /= axisLength;
+        auto minDot = 1.0f;
+
+        for (auto& normal : faceNormals)
+        {
+            minDot = glm::min(minDot, glm::dot(axis, normal));
+        }
+
+        // Cones wider than ~84 degrees are rarely fully back facing & would only add test overhead.
+        meshlet.cone = float4(axis, minDot <= 0.1f ? 1.0f : sqrtf(1.0f - minDot * minDot));
+        return meshlet;
+    }
+
+    void BuildMeshlets(const uint32_t* indices, uint32_t icount, const void* positions, uint32_t positionStride, std::vector<Meshlet>* outMeshlets)
+    {
+        if (icount < 3u)
+        {
+            return;
+        }
+
+        auto maxIndex = 0u;
+
+        for (auto i = 0u; i < icount; ++i)
+        {
+            maxIndex = glm::max(maxIndex, indices[i]);
+        }
+
+        // Stamped with the meshlet index + 1 so that the table doesn't need clearing between meshlets.
+        std::vector<uint32_t> stamps(maxIndex + 1u, 0u);
+        std::vector<uint32_t> vertices;
+        vertices.reserve(PK_MESHLET_MAX_VERTICES);
+        auto stamp = 1u;
+        auto first = 0u;
+
+        for (auto i = 0u; i + 2u < icount; i += 3u)
+        {
+            auto a = indices[i + 0u];
+            auto b = indices[i + 1u];
+            auto c = indices[i + 2u];
+            auto newVertices = (stamps[a] != stamp ? 1u : 0u) + (stamps[b] != stamp && b != a ? 1u : 0u) + (stamps[c] != stamp && c != a && c != b ? 1u : 0u);
+
+            if (i > first && (vertices.size() + newVertices > PK_MESHLET_MAX_VERTICES || (i - first) / 3u >= PK_MESHLET_MAX_TRIANGLES))
+            {
+                outMeshlets->push_back(GetMeshletBounds(indices, first, i - first, vertices, positions, positionStride));
+                vertices.clear();
+                first = i;
+                ++stamp;
+            }
+
+            for (auto j = 0u; j < 3u; ++j)
+            {
+                if (stamps[indices[i + j]] != stamp)
+                {
+                    stamps[indices[i + j]] = stamp;
+                    vertices.push_back(indices[i + j]);
+                }
+            }
+        }
+
+        auto last = icount - icount % 3u;
+        outMeshlets->push_back(GetMeshletBounds(indices, first, last - first, vertices, positions, positionStride));
+    }
+
+    void GenerateSubmeshMeshlets(SubMesh* submeshes, uint32_t submeshCount, const uint32_t* indices, const void* positions, uint32_t positionStride, std::vector<Meshlet>* outMeshlets)
+    {
+        for (auto i = 0u; i < submeshCount; ++i)
+        {
+            // Indices are relative to the first vertex of the submesh.
+            auto& submesh = submeshes[i];
+            auto pPositions = reinterpret_cast<const char*>(positions) + (size_t)submesh.firstVertex * positionStride;
+            submesh.firstMeshlet = (uint32_t)outMeshlets->size();
+            BuildMeshlets(indices + submesh.firstIndex, submesh.indexCount, pPositions, positionStride, outMeshlets);
+            submesh.meshletCount = (uint32_t)outMeshlets->size() - submesh.firstMeshlet;
+        }
+    }
+
+    uint32_t CullMeshlets(const Meshlet* meshlets, uint32_t count, const FrustumPlanes& planes, const float3& viewOrigin, bool cullBackfaces, uint2* outRanges)
+    {
+        auto rangeCount = 0u;
+        auto isRangeOpen = false;
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            auto& meshlet = meshlets[i];
+            auto center = float3(meshlet.sphere);
+            auto radius = meshlet.sphere.w;
+            auto isVisible = true;
+
+            for (auto j = 0u; j < 6u && isVisible; ++j)
+            {
+                isVisible = Functions::PlaneDistanceToPoint(planes.planes[j], center) >= -radius;
+            }
+
+            // Every triangle faces away if the view direction lies within the cone widened by the bounding sphere.
+            if (isVisible && cullBackfaces && meshlet.cone.w < 1.0f)
+            {
+                auto direction = center - viewOrigin;
+                isVisible = glm::dot(direction, float3(meshlet.cone)) < meshlet.cone.w * glm::length(direction) + radius;
+            }
+
+            if (!isVisible)
+            {
+                isRangeOpen = false;
+                continue;
+            }
+
+            // Meshlets are contiguous. Adjacent visible meshlets are merged into a single range.
+            if (isRangeOpen)
+            {
+                outRanges[rangeCount - 1u].y += meshlet.indexCount;
+                continue;
+            }
+
+            outRanges[rangeCount++] = uint2(meshlet.firstIndex, meshlet.indexCount);
+            isRangeOpen = true;
+        }
+
+        return rangeCount;
+    }
+
     Ref<Mesh> GetBox(const float3& offset, const float3& extents)
     {
         float3 p0 = { offset.x - extents.x, offset.y - extents.y, offset.z + extents.z };
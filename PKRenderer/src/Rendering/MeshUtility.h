@@ -5,9 +5,72 @@
 
 namespace PK::Rendering::MeshUtility
 {
+    constexpr static const uint32_t PK_MESH_VERTEX_CACHE_SIZE = 16u;
+    // Maximum allowed increase in cache misses when splitting clusters for overdraw sorting.
+    constexpr static const float PK_MESH_OVERDRAW_THRESHOLD = 1.05f;
+    constexpr static const uint32_t PK_MESHLET_MAX_VERTICES = PK::Assets::PK_ASSET_MESHLET_MAX_VERTICES;
+    constexpr static const uint32_t PK_MESHLET_MAX_TRIANGLES = PK::Assets::PK_ASSET_MESHLET_MAX_TRIANGLES;
+
+    // Measured with a fifo post transform cache of PK_MESH_VERTEX_CACHE_SIZE entries.
+    struct VertexCacheStatistics
+    {
+        // Transformed vertices per triangle. 3.0 is the worst case, 0.5 the limit for large regular meshes.
+        float acmr = 0.0f;
+        // Transformed vertices per referenced vertex. 1.0 is optimal.
+        float atvr = 0.0f;
+    };
+
+    struct MeshOptimizationInfo
+    {
+        uint32_t* indices = nullptr;
+        uint32_t indexCount = 0u;
+        uint32_t vertexCount = 0u;
+        // Index ranges (first index, index count) that are optimized independently. Triangles are not moved between ranges.
+        const Math::uint2* ranges = nullptr;
+        uint32_t rangeCount = 0u;
+        // Float3 positions used for overdraw sorting.
+        const void* positions = nullptr;
+        uint32_t positionStride = 0u;
+        // Non interleaved vertex streams that are reordered for fetch locality.
+        void* const* streams = nullptr;
+        const uint32_t* streamStrides = nullptr;
+        uint32_t streamCount = 0u;
+    };
+
     void CalculateNormals(const Math::float3* vertices, const uint32_t* indices, Math::float3* normals, uint32_t vcount, uint32_t icount, float sign = 1.0f);
     void CalculateTangents(const Math::float3* vertices, const Math::float3* normals, const Math::float2* texcoords, const uint32_t indices, Math::float4* tangents, uint32_t vcount, uint32_t icount);
     void CalculateTangents(void* vertices, uint32_t stride, uint32_t vertexOffset, uint32_t normalOffset, uint32_t tangentOffset, uint32_t texcoordOffset, const uint32_t* indices, uint32_t vcount, uint32_t icount);
+
+    VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, uint32_t icount, uint32_t vcount, uint32_t cacheSize = PK_MESH_VERTEX_CACHE_SIZE);
+    // Tipsify triangle reordering. Optionally outputs the first triangle of each cluster that starts from a cold cache.
+    void OptimizeVertexCache(uint32_t* indices, uint32_t icount, uint32_t vcount, std::vector<uint32_t>* outClusters = nullptr, uint32_t cacheSize = PK_MESH_VERTEX_CACHE_SIZE);
+    // Sorts clusters from OptimizeVertexCache so that outward facing clusters are drawn first.
+    void OptimizeOverdraw(uint32_t* indices, uint32_t icount, uint32_t vcount, const void* positions, uint32_t positionStride, const std::vector<uint32_t>& clusters, float threshold = PK_MESH_OVERDRAW_THRESHOLD, uint32_t cacheSize = PK_MESH_VERTEX_CACHE_SIZE);
+    // Remaps vertices to the order of their first reference. Unreferenced vertices are moved to the end. Returns the number of referenced vertices.
+    uint32_t OptimizeVertexFetch(uint32_t* indices, uint32_t icount, uint32_t vcount, uint32_t* outRemap);
+    void RemapVertices(void* vertices, uint32_t stride, uint32_t vcount, const uint32_t* remap);
+    void OptimizeMesh(const MeshOptimizationInfo& info, VertexCacheStatistics* outBefore = nullptr, VertexCacheStatistics* outAfter = nullptr);
+
+    // Quadric error edge collapse that only rewrites indices. Vertices are never moved so that all levels can share a vertex buffer.
+    // Open borders & attribute seams are locked. Error is a distance in position units. Returns the output index count.
+    uint32_t SimplifyIndices(const uint32_t* indices, uint32_t icount, const void* positions, uint32_t positionStride, uint32_t vcount, uint32_t targetIndexCount, float targetError, uint32_t* outIndices, float* outError = nullptr);
+    // Appends simplified levels of each range to indices. Level l of range r is output to outRanges[(l - 1) * rangeCount + r].
+    // Ranges that could not be simplified further repeat their previous level. Returns the number of levels including the source level.
+    uint32_t GenerateLodChain(std::vector<uint32_t>& indices, const Math::uint2* ranges, uint32_t rangeCount, const void* positions, uint32_t positionStride, uint32_t vcount, std::vector<Math::uint2>* outRanges);
+    // Links lod major submeshes (level l of submesh s at l * baseCount + s) into per submesh chains. A level that repeats the previous range ends the chain.
+    void LinkSubmeshLods(Objects::SubMesh* submeshes, uint32_t baseCount, uint32_t lodCount);
+    // Appends generated levels to submeshes & indices for meshes that were not processed by the asset builder. Returns the number of levels.
+    uint32_t GenerateSubmeshLods(std::vector<Objects::SubMesh>& submeshes, std::vector<uint32_t>& indices, const void* positions, uint32_t positionStride, uint32_t vcount);
+
+    // Splits an index range into meshlets of consecutive triangles. Expects a vertex cache optimized triangle order so that triangles are not moved.
+    // Backface cones assume the front face winding of the default rasterizer state.
+    void BuildMeshlets(const uint32_t* indices, uint32_t icount, const void* positions, uint32_t positionStride, std::vector<Objects::Meshlet>* outMeshlets);
+    // Builds the meshlets of each submesh & assigns their ranges in outMeshlets.
+    void GenerateSubmeshMeshlets(Objects::SubMesh* submeshes, uint32_t submeshCount, const uint32_t* indices, const void* positions, uint32_t positionStride, std::vector<Objects::Meshlet>* outMeshlets);
+    // Outputs merged index ranges (first index, index count) of the meshlets that intersect the frustum & may contain front faces.
+    // Planes & view origin are in object space. Ranges are relative to the submesh. Returns the range count, at most (count + 1) / 2.
+    uint32_t CullMeshlets(const Objects::Meshlet* meshlets, uint32_t count, const Math::FrustumPlanes& planes, const Math::float3& viewOrigin, bool cullBackfaces, Math::uint2* outRanges);
+
     Utilities::Ref<Objects::Mesh> GetBox(const Math::float3& offset, const Math::float3& extents);
     Utilities::Ref<Objects::Mesh> GetQuad(const Math::float2& min, const Math::float2& max);
     Utilities::Ref<Objects::VirtualMesh> GetPlane(Utilities::Ref<Objects::Mesh> baseMesh, const Math::float2& center, const Math::float2& extents, Math::uint2 resolution);
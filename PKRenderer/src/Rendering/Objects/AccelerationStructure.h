@@ -12,7 +12,12 @@ namespace PK::Rendering::Objects
         static Utilities::Ref<AccelerationStructure> Create(const char* name);
 
         virtual void BeginWrite(Structs::QueueType queue, uint32_t instanceLimit) = 0;
-        virtual void AddInstance(Mesh* mesh, uint32_t submesh, uint32_t customIndex, const PK::Math::float4x4& matrix) = 0;
+        // Returns false if the instance was skipped because its mesh is still being uploaded.
+        // Instances are matched against the slots of the previous write. Only modified slots are uploaded.
+        virtual bool AddInstance(Mesh* mesh, uint32_t submesh, uint32_t customIndex, const PK::Math::float4x4& matrix) = 0;
+        // Keeps the instances of the previous write. Only their transforms can be modified.
+        virtual void BeginUpdate(Structs::QueueType queue) = 0;
+        virtual void SetInstanceTransform(uint32_t index, const PK::Math::float4x4& matrix) = 0;
         virtual void EndWrite() = 0;
 
         virtual uint32_t GetInstanceCount() const = 0;
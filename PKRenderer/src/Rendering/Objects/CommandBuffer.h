@@ -48,10 +48,16 @@ namespace PK::Rendering::Objects
         // @TODO Nasty dependency. Rethink this one!
         virtual void Blit(Texture* src, Core::Window* dst, Structs::FilterMode filter) = 0;
         virtual void Blit(Core::Window* src, Buffer* dst) = 0;
+        // Copies the first level & layer of a color texture into a buffer.
+        virtual void Blit(Texture* src, Buffer* dst) = 0;
+        // Copies a buffer into the first level & layer of a color texture.
+        virtual void Blit(Buffer* src, Texture* dst) = 0;
         virtual void Blit(Texture* src, Texture* dst, const Structs::TextureViewRange& srcRange, const Structs::TextureViewRange& dstRange, Structs::FilterMode filter) = 0;
 
         virtual void Clear(Buffer* dst, size_t offset, size_t size, uint32_t value) = 0;
         virtual void Clear(Texture* dst, const Structs::TextureViewRange& range, const Math::uint4& value) = 0;
+        // Marks the contents of a texture as undefined. The next access waits for all prior work on the queue as the texture might alias memory used by it.
+        virtual void DiscardTexture(Texture* texture) = 0;
         
         virtual void* BeginBufferWrite(Buffer* buffer, size_t offset, size_t size) = 0;
         virtual void EndBufferWrite(Buffer* buffer) = 0;
@@ -62,6 +68,13 @@ namespace PK::Rendering::Objects
         virtual void BeginDebugScope(const char* name, const Math::color& color) = 0;
         virtual void EndDebugScope() = 0;
 
+        // Secondary buffers inherit the current render target & viewports of this buffer & can only record draws.
+        // They can be recorded on any thread. Buffers begun with the same thread index share a pool & must not be recorded concurrently.
+        // This buffer must not be recorded to while its secondary buffers are being recorded.
+        virtual CommandBuffer* BeginSecondary(uint32_t threadIndex) = 0;
+        // Ends the secondary buffers & executes them in a render pass for the current render target.
+        virtual void ExecuteSecondary(CommandBuffer* const* secondaries, uint32_t count) = 0;
+
         void SetViewPort(const Math::uint4& rect);
         void SetScissor(const Math::uint4& rect);
 
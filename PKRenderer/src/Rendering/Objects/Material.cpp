@@ -32,7 +32,7 @@ namespace YAML
 
 namespace PK::Rendering::Objects
 {
-    void Material::CopyTo(char* dst, BindSet<Texture>* textureSet) const
+    void Material::CopyTo(char* dst, const uint32_t* textureIndices) const
     {
         auto& layout = m_shader->GetMaterialPropertyLayout();
 
@@ -43,8 +43,7 @@ namespace PK::Rendering::Objects
             switch (element.Type)
             {
             case ElementType::Texture2DHandle:
-                auto texIndex = textureSet->Set(*Get<Texture*>(element.NameHashId));
-                memcpy(dst + element.AlignedOffset, &texIndex, sizeof(int32_t));
+                memcpy(dst + element.AlignedOffset, textureIndices++, sizeof(int32_t));
                 break;
             }
         }
@@ -3,7 +3,6 @@
 #include "Rendering/Objects/ShaderPropertyBlock.h"
 #include "Rendering/Objects/Shader.h"
 #include "Rendering/Objects/Texture.h"
-#include "Rendering/Objects/BindSet.h"
 
 namespace PK::Rendering::Objects
 {
@@ -24,7 +23,8 @@ namespace PK::Rendering::Objects
             inline bool SupportsKeyword(const uint32_t hashId) const { return m_shader->SupportsKeyword(hashId); }
             inline bool SupportsKeywords(const uint32_t* hashIds, const uint32_t count) const { return m_shader->SupportsKeywords(hashIds, count); }
 
-            void CopyTo(char* dst, BindSet<Texture>* textureSet) const;
+            // Texture handles are replaced with the given bindless indices in layout order.
+            void CopyTo(char* dst, const uint32_t* textureIndices) const;
 
             void Import(const char* filepath) override final;
 
@@ -3,6 +3,7 @@
 #include "Math/FunctionsIntersect.h"
 #include "Math/FunctionsMisc.h"
 #include "Rendering/GraphicsAPI.h"
+#include "Rendering/MeshUtility.h"
 #include <PKAssets/PKAssetLoader.h>
 
 using namespace PK::Math;
@@ -14,11 +15,50 @@ using namespace PK::Rendering::Structs;
 
 namespace PK::Rendering::Objects
 {
-    static void AlignVertices(char* vertices, size_t vcount, const BufferLayout& layout, const std::vector<const BufferLayout*> targetLayouts)
+    // Quantizes float attributes into the types of a compact target layout.
+    static void ConvertVertexElement(const char* src, ElementType srcType, char* dst, ElementType dstType)
+    {
+        if (srcType == dstType)
+        {
+            memcpy(dst, src, ElementConvert::Size(dstType));
+            return;
+        }
+
+        float4 value = PK_FLOAT4_ZERO;
+        memcpy(&value, src, std::min<size_t>(ElementConvert::Size(srcType), sizeof(float4)));
+
+        if (dstType == ElementType::Half2 && srcType == ElementType::Float2)
+        {
+            auto packed = Functions::PackHalf(float2(value));
+            memcpy(dst, &packed, sizeof(packed));
+            return;
+        }
+
+        // Half3 is not widely supported as a vertex format. Positions are padded to four components instead.
+        if (dstType == ElementType::Half4 && (srcType == ElementType::Float3 || srcType == ElementType::Float4))
+        {
+            auto packed = Functions::PackHalf(float4(float3(value), srcType == ElementType::Float3 ? 1.0f : value.w));
+            memcpy(dst, &packed, sizeof(packed));
+            return;
+        }
+
+        if (dstType == ElementType::Uint && (srcType == ElementType::Float3 || srcType == ElementType::Float4))
+        {
+            auto packed = srcType == ElementType::Float3 ? Functions::PackOctaUnorm16(float3(value)) : Functions::PackOctaTangent(value);
+            memcpy(dst, &packed, sizeof(packed));
+            return;
+        }
+
+        PK_THROW_ASSERT(false, "Unsupported vertex element conversion!");
+    }
+
+    // Returns the vertices laid out in the streams of the target layouts. Data is written to buffer if it needs to be reordered or converted.
+    static const char* AlignVertices(const char* vertices, size_t vcount, const BufferLayout& layout, const std::vector<const BufferLayout*> targetLayouts, std::vector<char>* buffer)
     {
         auto stride = layout.GetStride();
         auto fullStride = 0ull;
         auto needsAlignment = false;
+        auto needsConversion = false;
         auto streamIndex = 0u;
 
         for (auto& targetLayout : targetLayouts)
@@ -28,7 +68,7 @@ namespace PK::Rendering::Objects
                 uint32_t elementIndex = 0u;
                 auto other = layout.TryGetElement(element.NameHashId, &elementIndex);
                 PK_THROW_ASSERT(other, "Required element not present in source layout!");
-                PK_THROW_ASSERT(other->Type == element.Type, "Element type missmatch!");
+                needsConversion |= other->Type != element.Type;
                 needsAlignment |= other->Location != streamIndex || other->Offset != element.Offset;
             }
 
@@ -36,15 +76,15 @@ namespace PK::Rendering::Objects
             ++streamIndex;
         }
 
-        PK_THROW_ASSERT(fullStride == stride, "Layout stride missmatch!");
+        PK_THROW_ASSERT(needsConversion || fullStride == stride, "Layout stride missmatch!");
 
-        if (!needsAlignment)
+        if (!needsAlignment && !needsConversion)
         {
-            return;
+            return vertices;
         }
 
-        auto buffer = (char*)calloc(vcount, stride);
-        auto subBuffer = buffer;
+        buffer->resize(vcount * fullStride);
+        auto subBuffer = buffer->data();
 
         for (auto& targetLayout : targetLayouts)
         {
@@ -57,17 +97,21 @@ namespace PK::Rendering::Objects
                 auto srcOffset = element->Offset;
                 auto size = targetElement.Size();
 
-                for (auto i = 0u; i < vcount; ++i)
+                for (auto i = 0u; i < vcount && element->Type == targetElement.Type; ++i)
                 {
                     memcpy(subBuffer + targetStride * i + targetElement.Offset, vertices + stride * i + srcOffset, size);
                 }
+
+                for (auto i = 0u; i < vcount && element->Type != targetElement.Type; ++i)
+                {
+                    ConvertVertexElement(vertices + stride * i + srcOffset, element->Type, subBuffer + targetStride * i + targetElement.Offset, targetElement.Type);
+                }
             }
 
             subBuffer += targetStride * vcount;
         }
 
-        memcpy(vertices, buffer, vcount * stride);
-        free(buffer);
+        return buffer->data();
     }
 
     static void FindAllocationRange(const std::vector<SubMesh>& submeshes, SubMesh* range)
@@ -95,8 +139,208 @@ namespace PK::Rendering::Objects
         }
     }
 
+    // Reorders the streams of assets that were not optimized by the asset builder.
+    // Operates on a heap copy of the vertex streams followed by the indices. Mapped asset memory is never written to.
+    static void OptimizeStreams(PK::Assets::Mesh::PKMesh* mesh, void* pVertices, const PK::Assets::Mesh::PKSubmesh* pSubmeshes, const std::vector<BufferLayout>& layouts)
+    {
+        auto vertexBytes = 0ull;
+        auto positionHash = Core::Services::StringHashID::StringToID(PK_VS_POSITION);
+        std::vector<void*> streams;
+        std::vector<uint32_t> strides;
+        std::vector<uint2> ranges;
+
+        MeshUtility::MeshOptimizationInfo info{};
+
+        for (auto& layout : layouts)
+        {
+            auto stream = reinterpret_cast<char*>(pVertices) + vertexBytes;
+            uint32_t elementIndex = 0u;
+            auto position = layout.TryGetElement(positionHash, &elementIndex);
+
+            if (position != nullptr && position->Type == ElementType::Float3)
+            {
+                info.positions = stream + position->Offset;
+                info.positionStride = layout.GetStride();
+            }
+
+            streams.push_back(stream);
+            strides.push_back(layout.GetStride());
+            vertexBytes += layout.GetStride() * mesh->vertexCount;
+        }
+
+        for (auto i = 0u; i < mesh->submeshCount; ++i)
+        {
+            ranges.emplace_back(pSubmeshes[i].firstIndex, pSubmeshes[i].indexCount);
+        }
+
+        // Indices follow the vertex streams.
+        auto pIndices = reinterpret_cast<char*>(pVertices) + vertexBytes;
+        auto is16Bit = ElementConvert::Size(mesh->indexType) == 2;
+        std::vector<uint32_t> indices32;
+
+        if (is16Bit)
+        {
+            indices32.resize(mesh->indexCount);
+            Functions::ReinterpretIndex16ToIndex32(indices32.data(), reinterpret_cast<uint16_t*>(pIndices), mesh->indexCount);
+        }
+
+        info.indices = is16Bit ? indices32.data() : reinterpret_cast<uint32_t*>(pIndices);
+        info.indexCount = mesh->indexCount;
+        info.vertexCount = mesh->vertexCount;
+        info.ranges = ranges.data();
+        info.rangeCount = (uint32_t)ranges.size();
+        info.streams = streams.data();
+        info.streamStrides = strides.data();
+        info.streamCount = (uint32_t)streams.size();
+
+        MeshUtility::VertexCacheStatistics before, after;
+        MeshUtility::OptimizeMesh(info, &before, &after);
+
+        for (auto i = 0u; is16Bit && i < mesh->indexCount; ++i)
+        {
+            reinterpret_cast<uint16_t*>(pIndices)[i] = (uint16_t)indices32[i];
+        }
+
+        PK_LOG_VERBOSE("Optimized mesh streams: ACMR %4.3f -> %4.3f, ATVR %4.3f -> %4.3f", before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+
+    // Returns a float3 element from non interleaved asset streams. Null if the element is not present or of a different type.
+    static const char* FindFloat3Element(void* pVertices, uint32_t vertexCount, const std::vector<BufferLayout>& layouts, const char* name, uint32_t* outStride)
+    {
+        auto vertexBytes = 0ull;
+        auto nameHash = Core::Services::StringHashID::StringToID(name);
+
+        for (auto& layout : layouts)
+        {
+            uint32_t elementIndex = 0u;
+            auto element = layout.TryGetElement(nameHash, &elementIndex);
+
+            if (element != nullptr && element->Type == ElementType::Float3)
+            {
+                *outStride = layout.GetStride();
+                return reinterpret_cast<const char*>(pVertices) + vertexBytes + element->Offset;
+            }
+
+            vertexBytes += layout.GetStride() * vertexCount;
+        }
+
+        return nullptr;
+    }
+
+    // Generates lods for assets that were not processed by the asset builder.
+    // Outputs the extended index buffer in the source index format. Left empty if no levels were generated.
+    static void GenerateLods(const PK::Assets::Mesh::PKMesh* mesh, void* pVertices, const std::vector<BufferLayout>& layouts, std::vector<SubMesh>& submeshes, std::vector<char>* outIndices)
+    {
+        auto positionStride = 0u;
+        auto positions = FindFloat3Element(pVertices, mesh->vertexCount, layouts, PK_VS_POSITION, &positionStride);
+
+        if (positions == nullptr)
+        {
+            return;
+        }
+
+        auto vertexBytes = 0ull;
+
+        for (auto& layout : layouts)
+        {
+            vertexBytes += layout.GetStride() * mesh->vertexCount;
+        }
+
+        auto pIndices = reinterpret_cast<char*>(pVertices) + vertexBytes;
+        auto is16Bit = ElementConvert::Size(mesh->indexType) == 2;
+        std::vector<uint32_t> indices(mesh->indexCount);
+
+        if (is16Bit)
+        {
+            Functions::ReinterpretIndex16ToIndex32(indices.data(), reinterpret_cast<uint16_t*>(pIndices), mesh->indexCount);
+        }
+        else
+        {
+            memcpy(indices.data(), pIndices, sizeof(uint32_t) * mesh->indexCount);
+        }
+
+        auto lodCount = MeshUtility::GenerateSubmeshLods(submeshes, indices, positions, positionStride, mesh->vertexCount);
+
+        if (lodCount <= 1u)
+        {
+            return;
+        }
+
+        outIndices->resize(indices.size() * (is16Bit ? sizeof(uint16_t) : sizeof(uint32_t)));
+
+        for (auto i = 0u; i < indices.size(); ++i)
+        {
+            if (is16Bit)
+            {
+                reinterpret_cast<uint16_t*>(outIndices->data())[i] = (uint16_t)indices[i];
+            }
+            else
+            {
+                reinterpret_cast<uint32_t*>(outIndices->data())[i] = indices[i];
+            }
+        }
+
+        PK_LOG_VERBOSE("Generated %i mesh lods: %i -> %i indices", lodCount, mesh->indexCount, (uint32_t)indices.size());
+    }
+
+    // Generates meshlets for assets that were not processed by the asset builder. Indices include generated lod levels.
+    static void GenerateMeshlets(const PK::Assets::Mesh::PKMesh* mesh, void* pVertices, const std::vector<BufferLayout>& layouts, const void* pIndices, uint32_t indexCount, std::vector<SubMesh>& submeshes, std::vector<Meshlet>* outMeshlets)
+    {
+        auto positionStride = 0u;
+        auto positions = FindFloat3Element(pVertices, mesh->vertexCount, layouts, PK_VS_POSITION, &positionStride);
+
+        if (positions == nullptr)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> indices32;
+        auto indices = reinterpret_cast<const uint32_t*>(pIndices);
+
+        if (ElementConvert::Size(mesh->indexType) == 2)
+        {
+            indices32.resize(indexCount);
+            Functions::ReinterpretIndex16ToIndex32(indices32.data(), reinterpret_cast<uint16_t*>(const_cast<void*>(pIndices)), indexCount);
+            indices = indices32.data();
+        }
+
+        MeshUtility::GenerateSubmeshMeshlets(submeshes.data(), (uint32_t)submeshes.size(), indices, positions, positionStride, outMeshlets);
+        PK_LOG_VERBOSE("Generated %i meshlets for %i submeshes", (uint32_t)outMeshlets->size(), (uint32_t)submeshes.size());
+    }
+
+    // Meshlet ranges of released submeshes are reused. Returns the first meshlet of a free range of count meshlets.
+    static uint32_t FindMeshletRange(const std::vector<SubMesh>& submeshes, uint32_t count)
+    {
+        std::vector<uint2> ranges;
+
+        for (auto& submesh : submeshes)
+        {
+            if (submesh.meshletCount > 0u)
+            {
+                ranges.emplace_back(submesh.firstMeshlet, submesh.meshletCount);
+            }
+        }
+
+        std::sort(ranges.begin(), ranges.end(), [](const uint2& a, const uint2& b) { return a.x < b.x; });
+        auto offset = 0u;
+
+        for (auto& range : ranges)
+        {
+            if (range.x >= offset + count)
+            {
+                break;
+            }
+
+            offset = glm::max(offset, range.x + range.y);
+        }
+
+        return offset;
+    }
+
     Mesh::Mesh() {}
 
+    Mesh::~Mesh() { ReleaseDecodedAsset(); }
+
     Mesh::Mesh(const Ref<Buffer>& vertexBuffer, const Ref<Buffer>& indexBuffer) : Mesh()
     {
         AddVertexBuffer(vertexBuffer);
@@ -108,18 +352,77 @@ namespace PK::Rendering::Objects
         m_fullRange = { 0u, (uint32_t)vertexBuffer->GetCount(), 0u, (uint32_t)indexBuffer->GetCount(), bounds };
     }
 
+    void Mesh::Prepare(const char* filepath)
+    {
+        m_preparedAsset.Prepare(filepath);
+
+        // Failures are reported by Import on the owning thread, which decodes the asset again if nothing was prepared.
+        try
+        {
+            DecodeAsset(filepath);
+        }
+        catch (std::exception&)
+        {
+            ReleaseDecodedAsset();
+        }
+    }
+
     void Mesh::Import(const char* filepath)
     {
         m_indexBuffer = nullptr;
         m_vertexBuffers.clear();
         m_submeshes.clear();
+        m_meshlets.clear();
+        m_hasCompactVertices = false;
 
-        PK::Assets::PKAsset asset;
+        if (m_decodedAsset.filepath != filepath)
+        {
+            DecodeAsset(filepath);
+        }
 
-        PK_THROW_ASSERT(PK::Assets::OpenAsset(filepath, &asset) == 0, "Failed to open asset at path: %s", filepath);
-        PK_THROW_ASSERT(asset.header->type == PK::Assets::PKAssetType::Mesh, "Trying to read a mesh from a non mesh file!")
+        auto& decoded = m_decodedAsset;
+        m_freeSubmeshIndices.clear();
+        m_submeshes = std::move(decoded.submeshes);
+        m_meshlets = std::move(decoded.meshlets);
+        m_lodSubmeshCount = decoded.lodSubmeshCount;
+        m_fullRange = SubMesh();
 
-            auto mesh = PK::Assets::ReadAsMesh(&asset);
+        for (auto& submesh : m_submeshes)
+        {
+            Functions::BoundsEncapsulate(&m_fullRange.bounds, submesh.bounds);
+        }
+
+        auto pBufferOffset = 0ull;
+        auto vertexBufferName = GetFileName() + std::string(".VertexBuffer");
+        auto indexBufferName = GetFileName() + std::string(".IndexBuffer");
+        auto cmd = GraphicsAPI::GetQueues()->GetCommandBuffer(QueueType::Transfer);
+
+        for (auto& layout : decoded.layouts)
+        {
+            AddVertexBuffer(Buffer::Create(layout, decoded.vertexCount, BufferUsage::DefaultVertex, vertexBufferName.c_str()));
+            cmd->UploadBufferData(m_vertexBuffers.back().get(), decoded.pVertices + pBufferOffset);
+            pBufferOffset += m_vertexBuffers.back()->GetLayout().GetStride() * decoded.vertexCount;
+        }
+
+        SetIndexBuffer(Buffer::Create(decoded.indexType, decoded.indexCount, BufferUsage::DefaultIndex, indexBufferName.c_str()));
+        cmd->UploadBufferData(m_indexBuffer.get(), decoded.pIndices);
+        m_uploadFence = cmd->GetFenceRef();
+
+        // Streams were copied into staging memory. The decoded data & the mapping are no longer needed.
+        ReleaseDecodedAsset();
+    }
+
+    void Mesh::DecodeAsset(const char* filepath)
+    {
+        ReleaseDecodedAsset();
+
+        auto& decoded = m_decodedAsset;
+        auto& asset = decoded.asset;
+
+        PK_THROW_ASSERT(m_preparedAsset.Open(filepath, &asset) == 0, "Failed to open asset at path: %s", filepath);
+        PK_THROW_ASSERT(asset.header->type == PK::Assets::PKAssetType::Mesh, "Trying to read a mesh from a non mesh file!");
+
+        auto mesh = PK::Assets::ReadAsMesh(&asset);
         auto base = asset.rawData;
 
         PK_THROW_ASSERT(mesh->vertexAttributeCount > 0, "Trying to read a mesh with 0 vertex attributes!");
@@ -128,19 +431,17 @@ namespace PK::Rendering::Objects
         PK_THROW_ASSERT(mesh->submeshCount > 0, "Trying to read a shader with 0 submeshes!");
 
         auto pAttributes = mesh->vertexAttributes.Get(base);
-        auto pVertices = mesh->vertexBuffer.Get(base);
-        auto pIndexBuffer = mesh->indexBuffer.Get(base);
+        auto pVertices = reinterpret_cast<char*>(mesh->vertexBuffer.Get(base));
         auto pSubmeshes = mesh->submeshes.Get(base);
-
-        m_freeSubmeshIndices.clear();
-        m_fullRange = SubMesh();
         std::map<uint32_t, std::vector<BufferElement>> layoutMap;
 
-        for (auto i = 0u; i < mesh->submeshCount; ++i)
+        auto hasLods = ((uint32_t)mesh->flags & (uint32_t)PK::Assets::Mesh::PKMeshFlags::HasLods) != 0u;
+        auto lodCount = hasLods ? glm::clamp(mesh->lodCount, 1u, PK_MAX_MESH_LODS) : 1u;
+
+        for (auto i = 0u; i < mesh->submeshCount * lodCount; ++i)
         {
             auto bounds = BoundingBox::MinMax(Functions::ToFloat3(pSubmeshes[i].bbmin), Functions::ToFloat3(pSubmeshes[i].bbmax));
-            m_submeshes.push_back({ 0u, mesh->vertexCount, pSubmeshes[i].firstIndex, pSubmeshes[i].indexCount, bounds });
-            Functions::BoundsEncapsulate(&m_fullRange.bounds, bounds);
+            decoded.submeshes.push_back({ 0u, mesh->vertexCount, pSubmeshes[i].firstIndex, pSubmeshes[i].indexCount, bounds });
         }
 
         for (auto i = 0u; i < mesh->vertexAttributeCount; ++i)
@@ -148,23 +449,68 @@ namespace PK::Rendering::Objects
             layoutMap[pAttributes[i].stream].emplace_back(pAttributes[i].type, std::string(pAttributes[i].name));
         }
 
-        auto pBufferOffset = 0ull;
-        auto vertexBufferName = GetFileName() + std::string(".VertexBuffer");
-        auto indexBufferName = GetFileName() + std::string(".IndexBuffer");
-        auto cmd = GraphicsAPI::GetQueues()->GetCommandBuffer(QueueType::Transfer);
-
         for (auto& kv : layoutMap)
         {
-            AddVertexBuffer(Buffer::Create(BufferLayout(kv.second), mesh->vertexCount, BufferUsage::DefaultVertex, vertexBufferName.c_str()));
-            cmd->UploadBufferData(m_vertexBuffers.back().get(), (char*)pVertices + pBufferOffset);
-            pBufferOffset += m_vertexBuffers.back()->GetLayout().GetStride() * mesh->vertexCount;
+            decoded.layouts.emplace_back(kv.second);
         }
 
-        SetIndexBuffer(Buffer::Create(mesh->indexType, mesh->indexCount, BufferUsage::DefaultIndex, indexBufferName.c_str()));
-        cmd->UploadBufferData(m_indexBuffer.get(), (char*)pVertices + pBufferOffset);
-        m_uploadFence = cmd->GetFenceRef();
+        auto vertexBytes = 0ull;
+
+        for (auto& layout : decoded.layouts)
+        {
+            vertexBytes += layout.GetStride() * mesh->vertexCount;
+        }
 
-        PK::Assets::CloseAsset(&asset);
+        if (((uint32_t)mesh->flags & (uint32_t)PK::Assets::Mesh::PKMeshFlags::Optimized) == 0u)
+        {
+            auto streamBytes = vertexBytes + ElementConvert::Size(mesh->indexType) * mesh->indexCount;
+            decoded.streams.assign(pVertices, pVertices + streamBytes);
+            pVertices = decoded.streams.data();
+            OptimizeStreams(mesh, pVertices, pSubmeshes, decoded.layouts);
+        }
+
+        if (hasLods)
+        {
+            MeshUtility::LinkSubmeshLods(decoded.submeshes.data(), mesh->submeshCount, lodCount);
+        }
+        else
+        {
+            GenerateLods(mesh, pVertices, decoded.layouts, decoded.submeshes, &decoded.lodIndices);
+        }
+
+        decoded.lodSubmeshCount = (uint32_t)decoded.submeshes.size() - mesh->submeshCount;
+        decoded.indexType = mesh->indexType;
+        decoded.vertexCount = mesh->vertexCount;
+        decoded.indexCount = decoded.lodIndices.empty() ? mesh->indexCount : (uint32_t)(decoded.lodIndices.size() / ElementConvert::Size(mesh->indexType));
+        decoded.pVertices = pVertices;
+        decoded.pIndices = decoded.lodIndices.empty() ? pVertices + vertexBytes : decoded.lodIndices.data();
+
+        if (((uint32_t)mesh->flags & (uint32_t)PK::Assets::Mesh::PKMeshFlags::HasMeshlets) != 0u)
+        {
+            auto pMeshlets = mesh->meshlets.Get(base);
+
+            for (auto i = 0u; i < mesh->meshletCount; ++i)
+            {
+                auto& submesh = decoded.submeshes.at(pMeshlets[i].submesh);
+                submesh.firstMeshlet = submesh.meshletCount == 0u ? i : submesh.firstMeshlet;
+                submesh.meshletCount++;
+                auto sphere = float4(Functions::ToFloat3(pMeshlets[i].center), pMeshlets[i].radius);
+                auto cone = float4(Functions::ToFloat3(pMeshlets[i].coneAxis), pMeshlets[i].coneCutoff);
+                decoded.meshlets.push_back({ pMeshlets[i].firstIndex, pMeshlets[i].indexCount, sphere, cone });
+            }
+        }
+        else
+        {
+            GenerateMeshlets(mesh, pVertices, decoded.layouts, decoded.pIndices, decoded.indexCount, decoded.submeshes, &decoded.meshlets);
+        }
+
+        decoded.filepath = filepath;
+    }
+
+    void Mesh::ReleaseDecodedAsset()
+    {
+        PK::Assets::CloseAsset(&m_decodedAsset.asset);
+        m_decodedAsset = DecodedAsset();
     }
 
     void Mesh::AllocateSubmeshRange(const SubmeshRangeAllocationInfo& allocationInfo,
@@ -174,6 +520,40 @@ namespace PK::Rendering::Objects
         SubMesh range = { 0u, allocationInfo.vertexCount, 0u, allocationInfo.indexCount, BoundingBox::GetMinBounds() };
         FindAllocationRange(m_submeshes, &range);
 
+        std::vector<SubMesh> submeshes(allocationInfo.pSubmeshes, allocationInfo.pSubmeshes + allocationInfo.submeshCount);
+        std::vector<Meshlet> generatedMeshlets;
+        auto pMeshlets = allocationInfo.pMeshlets;
+        auto meshletCount = allocationInfo.meshletCount;
+        uint32_t elementIndex = 0u;
+        auto position = allocationInfo.vertexLayout.TryGetElement(Core::Services::StringHashID::StringToID(PK_VS_POSITION), &elementIndex);
+
+        if (pMeshlets == nullptr && position != nullptr && position->Type == ElementType::Float3)
+        {
+            std::vector<uint32_t> indices32;
+            auto indices = reinterpret_cast<const uint32_t*>(allocationInfo.pIndices);
+
+            if (ElementConvert::Size(allocationInfo.indexType) == 2)
+            {
+                indices32.resize(allocationInfo.indexCount);
+                Functions::ReinterpretIndex16ToIndex32(indices32.data(), reinterpret_cast<uint16_t*>(allocationInfo.pIndices), allocationInfo.indexCount);
+                indices = indices32.data();
+            }
+
+            auto stride = allocationInfo.vertexLayout.GetStride();
+            auto positions = reinterpret_cast<const char*>(allocationInfo.pVertices) + position->Offset;
+            MeshUtility::GenerateSubmeshMeshlets(submeshes.data(), (uint32_t)submeshes.size(), indices, positions, stride, &generatedMeshlets);
+            pMeshlets = generatedMeshlets.data();
+            meshletCount = (uint32_t)generatedMeshlets.size();
+        }
+
+        auto firstMeshlet = FindMeshletRange(m_submeshes, meshletCount);
+        m_meshlets.resize(glm::max((uint32_t)m_meshlets.size(), firstMeshlet + meshletCount));
+
+        if (meshletCount > 0u)
+        {
+            memcpy(m_meshlets.data() + firstMeshlet, pMeshlets, sizeof(Meshlet) * meshletCount);
+        }
+
         for (auto i = 0u; i < allocationInfo.submeshCount; ++i)
         {
             if (m_freeSubmeshIndices.size() > 0)
@@ -188,17 +568,27 @@ namespace PK::Rendering::Objects
             }
 
             auto& submesh = m_submeshes[outSubmeshIndices[i]];
-            submesh = allocationInfo.pSubmeshes[i];
+            submesh = submeshes[i];
             submesh.firstVertex += range.firstVertex;
             submesh.firstIndex += range.firstIndex;
+            submesh.firstMeshlet += firstMeshlet;
+            m_lodSubmeshCount += submesh.lodLevel > 0u ? 1u : 0u;
             Math::Functions::BoundsEncapsulate(&m_fullRange.bounds, submesh.bounds);
             Math::Functions::BoundsEncapsulate(&range.bounds, submesh.bounds);
         }
 
+        // Lod chains reference submeshes within the allocation. Remap them to the assigned indices.
+        for (auto i = 0u; i < allocationInfo.submeshCount; ++i)
+        {
+            auto& submesh = m_submeshes[outSubmeshIndices[i]];
+            submesh.nextLod = submesh.nextLod != ~0u ? outSubmeshIndices[submesh.nextLod] : ~0u;
+        }
+
         m_fullRange.vertexCount = glm::max(m_fullRange.vertexCount, range.firstVertex + range.vertexCount);
         m_fullRange.indexCount = glm::max(m_fullRange.indexCount, range.firstIndex + range.indexCount);
 
-        AlignVertices((char*)allocationInfo.pVertices, allocationInfo.vertexCount, allocationInfo.vertexLayout, GetVertexBufferLayouts());
+        std::vector<char> alignedBuffer;
+        auto pVertices = AlignVertices((char*)allocationInfo.pVertices, allocationInfo.vertexCount, allocationInfo.vertexLayout, GetVertexBufferLayouts(), &alignedBuffer);
 
         auto cmd = GraphicsAPI::GetQueues()->GetCommandBuffer(QueueType::Transfer);
         auto pBufferOffset = 0ull;
@@ -212,7 +602,7 @@ namespace PK::Rendering::Objects
             auto vertexStride = layout.GetStride();
 
             vertexBuffer->MakeRangeResident({ range.firstVertex * vertexStride, range.vertexCount * vertexStride }, QueueType::Transfer);
-            cmd->UploadBufferSubData(vertexBuffer.get(), (char*)allocationInfo.pVertices + pBufferOffset, range.firstVertex * vertexStride, range.vertexCount * vertexStride);
+            cmd->UploadBufferSubData(vertexBuffer.get(), pVertices + pBufferOffset, range.firstVertex * vertexStride, range.vertexCount * vertexStride);
             pBufferOffset += vertexStride * range.vertexCount;
         }
 
@@ -254,7 +644,8 @@ namespace PK::Rendering::Objects
         for (auto i = 0u; i < submeshCount; ++i)
         {
             m_freeSubmeshIndices.push_back(submeshIndices[i]);
-            m_submeshes[i] = SubMesh();
+            m_lodSubmeshCount -= m_submeshes[submeshIndices[i]].lodLevel > 0u ? 1u : 0u;
+            m_submeshes[submeshIndices[i]] = SubMesh();
         }
     }
 
@@ -265,6 +656,9 @@ namespace PK::Rendering::Objects
             PK_LOG_WARNING("Warning! Trying to add more vertex buffers than supported!");
         }
 
+        uint32_t elementIndex = 0u;
+        auto normal = vertexBuffer->GetLayout().TryGetElement(Core::Services::StringHashID::StringToID(PK_VS_NORMAL), &elementIndex);
+        m_hasCompactVertices |= normal != nullptr && normal->Type == ElementType::Uint;
         m_vertexBuffers.push_back(vertexBuffer);
     }
 
@@ -274,10 +668,12 @@ namespace PK::Rendering::Objects
         m_fullRange = SubMesh();
         m_submeshes.resize(submeshCount);
         m_freeSubmeshIndices.clear();
+        m_lodSubmeshCount = 0u;
 
         for (auto i = 0u; i < submeshCount; ++i)
         {
             m_submeshes[i] = submeshes[i];
+            m_lodSubmeshCount += submeshes[i].lodLevel > 0u ? 1u : 0u;
             Functions::BoundsEncapsulate(&m_fullRange.bounds, submeshes[i].bounds);
             m_fullRange.vertexCount = glm::max(m_fullRange.vertexCount, submeshes[i].firstVertex + submeshes[i].vertexCount);
             m_fullRange.indexCount = glm::max(m_fullRange.indexCount, submeshes[i].firstIndex + submeshes[i].indexCount);
@@ -306,6 +702,16 @@ namespace PK::Rendering::Objects
         auto idx = glm::min((uint)submesh, (uint)m_submeshes.size());
         return m_submeshes.at(idx);
     }
+
+    uint32_t Mesh::GetSubmeshLod(uint32_t submesh, uint32_t lod) const
+    {
+        for (auto i = 0u; i < lod && submesh < m_submeshes.size() && m_submeshes[submesh].nextLod != ~0u; ++i)
+        {
+            submesh = m_submeshes[submesh].nextLod;
+        }
+
+        return submesh;
+    }
 }
 
 template<>
@@ -315,4 +721,4 @@ template<>
 Ref<Mesh> PK::Core::Services::AssetImporters::Create()
 {
     return CreateRef<Mesh>();
-}
+}
\ No newline at end of file
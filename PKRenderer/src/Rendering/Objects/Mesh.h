@@ -1,11 +1,24 @@
 #pragma once
 #include "Core/Services/AssetDatabase.h"
+#include "Core/Services/PreparedPKAsset.h"
 #include "Rendering/Objects/Buffer.h"
 #include "Rendering/Structs/StructsCommon.h"
 #include "Rendering/Structs/FenceRef.h"
 
 namespace PK::Rendering::Objects
 {
+    // Cluster of consecutive triangles within a submesh. Bounds & normal cone are in object space.
+    struct Meshlet
+    {
+        // Relative to the first index of the submesh.
+        uint32_t firstIndex = 0u;
+        uint32_t indexCount = 0u;
+        // xyz: center, w: radius.
+        Math::float4 sphere = Math::PK_FLOAT4_ZERO;
+        // xyz: axis, w: sine of the cone angle. 1 disables backface culling.
+        Math::float4 cone = { 0.0f, 0.0f, 0.0f, 1.0f };
+    };
+
     struct SubMesh
     {
         uint32_t firstVertex = 0u;
@@ -13,6 +26,11 @@ namespace PK::Rendering::Objects
         uint32_t firstIndex = 0u;
         uint32_t indexCount = 0u;
         Math::BoundingBox bounds = Math::BoundingBox::GetMinBounds();
+        // Index of the next coarser level of detail. ~0u for the last level.
+        uint32_t nextLod = ~0u;
+        uint32_t lodLevel = 0u;
+        uint32_t firstMeshlet = 0u;
+        uint32_t meshletCount = 0u;
 
         constexpr bool operator < (const SubMesh& other)
         {
@@ -30,13 +48,16 @@ namespace PK::Rendering::Objects
         void* pIndices;
         Structs::BufferLayout vertexLayout;
         SubMesh* pSubmeshes;
+        // Optional. Submesh meshlet ranges are relative to this array. Generated from float3 positions if null.
+        const Meshlet* pMeshlets;
         Structs::ElementType indexType;
         uint32_t vertexCount;
         uint32_t indexCount;
         uint32_t submeshCount;
+        uint32_t meshletCount;
     };
 
-    class Mesh : public Core::Services::Asset, public Core::Services::IAssetImportSimple
+    class Mesh : public Core::Services::Asset, public Core::Services::IAssetImportSimple, public Core::Services::IAssetPrepare
     {
         friend Utilities::Ref<Mesh> Core::Services::AssetImporters::Create();
 
@@ -44,8 +65,11 @@ namespace PK::Rendering::Objects
             Mesh();
             Mesh(const Utilities::Ref<Buffer>& vertexBuffer, const Utilities::Ref<Buffer>& indexBuffer);
             Mesh(const Utilities::Ref<Buffer>& vertexBuffer, const Utilities::Ref<Buffer>& indexBuffer, const Math::BoundingBox& bounds);
+            ~Mesh();
 
             void Import(const char* filepath) override final;
+            // Decodes, optimizes & generates missing lods & meshlets ahead of import.
+            void Prepare(const char* filepath) override final;
 
             /// Allocates a submesh range by appending submitted data to the first assigned vertex buffer.
             /// - Requires the first vertex buffer to be virtual.
@@ -67,11 +91,41 @@ namespace PK::Rendering::Objects
             const Buffer* GetVertexBuffer(uint32_t index) const { return m_vertexBuffers.at(index).get(); }
             const Buffer* GetIndexBuffer() const { return m_indexBuffer.get(); }
             const SubMesh& GetSubmesh(int32_t submesh) const;
-            inline const uint32_t GetSubmeshCount() const { return glm::max(1u, (uint32_t)m_submeshes.size() - (uint32_t)m_freeSubmeshIndices.size()); }
+            // Follows the lod chain of a submesh. Clamps to the coarsest available level.
+            uint32_t GetSubmeshLod(uint32_t submesh, uint32_t lod) const;
+            // Lod levels are not included. Base submeshes occupy the first indices.
+            inline const uint32_t GetSubmeshCount() const { return glm::max(1u, (uint32_t)m_submeshes.size() - (uint32_t)m_freeSubmeshIndices.size() - m_lodSubmeshCount); }
             constexpr const SubMesh& GetFullRange() const { return m_fullRange; }
             const bool HasPendingUpload() const { return !m_uploadFence.WaitInvalidate(0ull); }
+            // Normals & tangents are octahedral encoded. Requires the PK_VERTEX_COMPACT shader keyword.
+            constexpr bool HasCompactVertices() const { return m_hasCompactVertices; }
+            inline const Meshlet* GetMeshlets(const SubMesh& submesh) const { return m_meshlets.data() + submesh.firstMeshlet; }
 
         private:
+            // Cpu side data of an asset. Decoded by Prepare on a job system worker or by Import if nothing was prepared.
+            struct DecodedAsset
+            {
+                std::string filepath;
+                PK::Assets::PKAsset asset{};
+                std::vector<Structs::BufferLayout> layouts;
+                std::vector<SubMesh> submeshes;
+                std::vector<Meshlet> meshlets;
+                // Heap copy of the vertex streams followed by the indices for assets that were optimized on load.
+                std::vector<char> streams;
+                // Index buffer extended with generated lod levels.
+                std::vector<char> lodIndices;
+                // Point into the asset or the buffers above.
+                const char* pVertices = nullptr;
+                const char* pIndices = nullptr;
+                Structs::ElementType indexType = Structs::ElementType::Uint;
+                uint32_t vertexCount = 0u;
+                uint32_t indexCount = 0u;
+                uint32_t lodSubmeshCount = 0u;
+            };
+
+            void DecodeAsset(const char* filepath);
+            void ReleaseDecodedAsset();
+
             std::vector<Utilities::Ref<Buffer>> m_vertexBuffers;
             Utilities::Ref<Buffer> m_indexBuffer;
             SubMesh m_fullRange{};
@@ -79,5 +133,10 @@ namespace PK::Rendering::Objects
 
             std::vector<SubMesh> m_submeshes;
             std::vector<uint32_t> m_freeSubmeshIndices;
+            std::vector<Meshlet> m_meshlets;
+            uint32_t m_lodSubmeshCount = 0u;
+            bool m_hasCompactVertices = false;
+            Core::Services::PreparedPKAsset m_preparedAsset;
+            DecodedAsset m_decodedAsset;
     };
 }
\ No newline at end of file
@@ -11,6 +11,8 @@ namespace PK::Rendering::Objects
         constexpr static const uint32_t MAX_DEPENDENCIES = (uint32_t)Structs::QueueType::MaxCount;
         virtual Objects::CommandBuffer* GetCommandBuffer(Structs::QueueType type) = 0;
         virtual Structs::FenceRef GetFenceRef(Structs::QueueType type, int32_t submitOffset = 0) = 0;
+        // Number of submits to the queue so far. Sync offsets are relative to this.
+        virtual uint64_t GetSubmitCount(Structs::QueueType type) = 0;
         virtual Objects::CommandBuffer* Submit(Structs::QueueType type) = 0;
         virtual void Sync(Structs::QueueType from, Structs::QueueType to, int32_t submitOffset = 0) = 0;
 
@@ -78,6 +78,27 @@ namespace PK::Rendering::Objects
         }
     }
 
+    void ShaderVariantMap::Selector::SetKeyword(uint32_t hashId, bool value)
+    {
+        auto kv = map->keywords.find(hashId);
+
+        if (kv == map->keywords.end())
+        {
+            return;
+        }
+
+        auto& keyword = keywords[kv->second >> 4];
+
+        if (value)
+        {
+            keyword = hashId;
+        }
+        else if (keyword == hashId)
+        {
+            keyword = 0u;
+        }
+    }
+
     void Shader::Import(const char* filepath)
     {
         for (auto& variant : m_variants)
@@ -89,7 +110,7 @@ namespace PK::Rendering::Objects
 
         PK::Assets::PKAsset asset;
 
-        PK_THROW_ASSERT(PK::Assets::OpenAsset(filepath, &asset) == 0, "Failed to open asset at path: %s", filepath);
+        PK_THROW_ASSERT(m_preparedAsset.Open(filepath, &asset) == 0, "Failed to open asset at path: %s", filepath);
         PK_THROW_ASSERT(asset.header->type == PK::Assets::PKAssetType::Shader, "Trying to read a shader from a non shader file!")
 
             auto shader = PK::Assets::ReadAsShader(&asset);
@@ -164,6 +185,9 @@ namespace PK::Rendering::Objects
             {
                 case APIType::Vulkan: m_variants.push_back(CreateRef<VulkanShader>(base, pVariant, name.c_str()));
             }
+
+            m_variants.back()->m_assetId = GetAssetID();
+            m_variants.back()->m_variantIndex = i;
         }
 
         PK::Assets::CloseAsset(&asset);
@@ -273,4 +297,4 @@ template<>
 bool AssetImporters::IsValidExtension<Shader>(const std::filesystem::path& extension) { return extension.compare(".pkshader") == 0; }
 
 template<>
-Ref<Shader> AssetImporters::Create() { return CreateRef<Shader>(); }
+Ref<Shader> AssetImporters::Create() { return CreateRef<Shader>(); }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Utilities/NativeInterface.h"
 #include "Utilities/PropertyBlock.h"
 #include "Core/Services/AssetDatabase.h"
+#include "Core/Services/PreparedPKAsset.h"
 #include "Rendering/Structs/Descriptors.h"
 #include "Rendering/Structs/Layout.h"
 
@@ -25,6 +26,7 @@ namespace PK::Rendering::Objects
             const ShaderVariantMap* map;
             uint32_t keywords[MAX_DIRECTIVES]{};
             void SetKeywordsFrom(const Utilities::PropertyBlock& block);
+            void SetKeyword(uint32_t hashId, bool value);
             inline uint32_t GetIndex() const { return map->GetIndex(keywords, map->directivecount); }
         };
     };
@@ -45,6 +47,9 @@ namespace PK::Rendering::Objects
             constexpr const Math::uint3& GetGroupSize() const { return m_groupSize; }
             virtual Structs::ShaderBindingTableInfo GetShaderBindingTableInfo() const = 0;
             bool HasRayTracingShaderGroup(Structs::RayTracingShaderGroup group) const;
+            // Identifies the variant across reloads & sessions.
+            constexpr Core::Services::AssetID GetAssetID() const { return m_assetId; }
+            constexpr uint32_t GetVariantIndex() const { return m_variantIndex; }
 
         protected:
             Structs::BufferLayout m_vertexLayout;
@@ -53,9 +58,11 @@ namespace PK::Rendering::Objects
             Structs::ShaderType m_type = Structs::ShaderType::Graphics;
             uint32_t m_stageFlags = 0u;
             Math::uint3 m_groupSize{};
+            Core::Services::AssetID m_assetId = 0u;
+            uint32_t m_variantIndex = 0u;
     };
 
-    class Shader : public Core::Services::Asset, public Core::Services::IAssetImportSimple
+    class Shader : public Core::Services::Asset, public Core::Services::IAssetImportSimple, public Core::Services::IAssetPrepare
     {
         friend Utilities::Ref<Shader> Core::Services::AssetImporters::Create();
 
@@ -67,6 +74,7 @@ namespace PK::Rendering::Objects
             inline uint32_t GetVariantIndex(const std::initializer_list<uint32_t>& keywords) const { return GetVariantIndex(keywords.begin(), (uint32_t)(keywords.end() - keywords.begin())); }
             inline const ShaderVariant* GetVariant(const uint32_t* keywords, uint32_t count) const { return m_variants[m_variantMap.GetIndex(keywords, count)].get(); }
             inline const ShaderVariant* GetVariant(uint32_t index) const { return m_variants[index].get(); }
+            inline uint32_t GetVariantCount() const { return (uint32_t)m_variants.size(); }
             inline ShaderVariantMap::Selector GetVariantSelector() const { return { &m_variantMap }; }
             inline bool SupportsKeyword(const uint32_t hashId) const { return m_variantMap.SupportsKeyword(hashId); }
             inline bool SupportsKeywords(const uint32_t* hashIds, const uint32_t count) const { return m_variantMap.SupportsKeywords(hashIds, count); }
@@ -76,6 +84,7 @@ namespace PK::Rendering::Objects
             inline Structs::ShaderBindingTableInfo GetShaderBindingTableInfo() const { return m_variants.at(0)->GetShaderBindingTableInfo(); }
 
             void Import(const char* filepath) override final;
+            void Prepare(const char* filepath) override final { m_preparedAsset.Prepare(filepath); }
             std::string GetMetaInfo() const override final;
 
         protected:
@@ -83,5 +92,6 @@ namespace PK::Rendering::Objects
             ShaderVariantMap m_variantMap;
             Structs::FixedFunctionShaderAttributes m_attributes;
             Structs::BufferLayout m_materialPropertyLayout;
+            Core::Services::PreparedPKAsset m_preparedAsset;
     };
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "PrecompiledHeader.h"
+#include "TransientHeap.h"
+#include "Rendering/VulkanRHI/Objects/VulkanTransientHeap.h"
+
+namespace PK::Rendering::Objects
+{
+    using namespace PK::Rendering::VulkanRHI::Objects;
+    using namespace PK::Utilities;
+
+    Ref<TransientHeap> TransientHeap::Create(const char* name)
+    {
+        auto api = GraphicsAPI::GetActiveAPI();
+
+        switch (api)
+        {
+        case APIType::Vulkan: return CreateRef<VulkanTransientHeap>(name);
+        }
+
+        return nullptr;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "Utilities/NoCopy.h"
+#include "Utilities/NativeInterface.h"
+#include "Utilities/Ref.h"
+#include "Rendering/Objects/Texture.h"
+
+namespace PK::Rendering::Objects
+{
+    // Device memory shared by textures placed at explicit offsets. Textures in overlapping ranges alias each other.
+    class TransientHeap : public Utilities::NoCopy, public Utilities::NativeInterface<TransientHeap>
+    {
+    public:
+        static Utilities::Ref<TransientHeap> Create(const char* name);
+
+        // Size & alignment of a texture created from the descriptor. Narrows the memory types the heap can be allocated from.
+        virtual size_t GetRequirements(const Structs::TextureDescriptor& descriptor, size_t* outAlignment) = 0;
+        // Reallocates if the heap is smaller than the requested size. Textures placed in the previous allocation must be recreated.
+        virtual bool Validate(size_t size) = 0;
+        virtual Utilities::Ref<Texture> CreateTexture(const Structs::TextureDescriptor& descriptor, size_t offset, const char* name) = 0;
+        virtual size_t GetSize() const = 0;
+
+        virtual ~TransientHeap() = default;
+    };
+}
\ No newline at end of file
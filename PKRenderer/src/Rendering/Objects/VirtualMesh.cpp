@@ -3,6 +3,7 @@
 #include <PKAssets/PKAssetLoader.h>
 #include "Math/FunctionsMisc.h"
 #include "Math/FunctionsIntersect.h"
+#include "Rendering/MeshUtility.h"
 
 namespace PK::Rendering::Objects
 {
@@ -20,6 +21,11 @@ namespace PK::Rendering::Objects
         m_mesh = mesh;
         m_submeshIndices.resize(data.submeshCount);
         m_mesh->AllocateSubmeshRange(data, &m_fullRange, m_submeshIndices.data());
+
+        for (auto i = 0u; i < data.submeshCount; ++i)
+        {
+            m_lodSubmeshCount += data.pSubmeshes[i].lodLevel > 0u ? 1u : 0u;
+        }
     }
 
     VirtualMesh::~VirtualMesh()
@@ -38,7 +44,7 @@ namespace PK::Rendering::Objects
 
         PK::Assets::PKAsset asset;
 
-        PK_THROW_ASSERT(PK::Assets::OpenAsset(filepath, &asset) == 0, "Failed to open asset at path: %s", filepath);
+        PK_THROW_ASSERT(m_preparedAsset.Open(filepath, &asset) == 0, "Failed to open asset at path: %s", filepath);
         PK_THROW_ASSERT(asset.header->type == PK::Assets::PKAssetType::Mesh, "Trying to read a mesh from a non mesh file!")
 
             auto mesh = PK::Assets::ReadAsMesh(&asset);
@@ -56,9 +62,14 @@ namespace PK::Rendering::Objects
 
         std::vector<BufferElement> bufferElements;
         std::vector<SubMesh> submeshes;
-        submeshes.reserve(mesh->submeshCount);
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> lodIndices;
 
-        for (auto i = 0u; i < mesh->submeshCount; ++i)
+        auto hasLods = ((uint32_t)mesh->flags & (uint32_t)PK::Assets::Mesh::PKMeshFlags::HasLods) != 0u;
+        auto lodCount = hasLods ? glm::clamp(mesh->lodCount, 1u, PK_MAX_MESH_LODS) : 1u;
+        submeshes.reserve(mesh->submeshCount * lodCount);
+
+        for (auto i = 0u; i < mesh->submeshCount * lodCount; ++i)
         {
             auto bounds = BoundingBox::MinMax(Functions::ToFloat3(pSubmeshes[i].bbmin), Functions::ToFloat3(pSubmeshes[i].bbmax));
             submeshes.push_back({ 0u, mesh->vertexCount, pSubmeshes[i].firstIndex, pSubmeshes[i].indexCount, bounds });
@@ -69,17 +80,68 @@ namespace PK::Rendering::Objects
             bufferElements.emplace_back(pAttributes[i].type, std::string(pAttributes[i].name), (byte)1u, (byte)pAttributes[i].stream, pAttributes[i].offset);
         }
 
-        m_submeshIndices.resize(mesh->submeshCount);
-
         SubmeshRangeAllocationInfo allocInfo{};
         allocInfo.pVertices = pVertices;
         allocInfo.pIndices = pIndices;
         allocInfo.vertexLayout = BufferLayout(bufferElements, false);
-        allocInfo.pSubmeshes = submeshes.data();
         allocInfo.indexType = mesh->indexType;
         allocInfo.vertexCount = mesh->vertexCount;
         allocInfo.indexCount = mesh->indexCount;
-        allocInfo.submeshCount = mesh->submeshCount;
+
+        uint32_t elementIndex = 0u;
+        auto position = allocInfo.vertexLayout.TryGetElement(Core::Services::StringHashID::StringToID(PK_VS_POSITION), &elementIndex);
+
+        if (hasLods)
+        {
+            MeshUtility::LinkSubmeshLods(submeshes.data(), mesh->submeshCount, lodCount);
+        }
+        else if (position != nullptr && position->Type == ElementType::Float3)
+        {
+            // Assets that were not processed by the asset builder. Levels are uploaded as 32bit indices.
+            lodIndices.resize(mesh->indexCount);
+
+            if (ElementConvert::Size(mesh->indexType) == 2)
+            {
+                Functions::ReinterpretIndex16ToIndex32(lodIndices.data(), reinterpret_cast<uint16_t*>(pIndices), mesh->indexCount);
+            }
+            else
+            {
+                memcpy(lodIndices.data(), pIndices, sizeof(uint32_t) * mesh->indexCount);
+            }
+
+            auto positions = reinterpret_cast<char*>(pVertices) + position->Offset;
+
+            if (MeshUtility::GenerateSubmeshLods(submeshes, lodIndices, positions, allocInfo.vertexLayout.GetStride(), mesh->vertexCount) > 1u)
+            {
+                allocInfo.pIndices = lodIndices.data();
+                allocInfo.indexType = ElementType::Uint;
+                allocInfo.indexCount = (uint32_t)lodIndices.size();
+            }
+        }
+
+        // Meshlets are generated by the base mesh if the asset doesn't contain them.
+        if (((uint32_t)mesh->flags & (uint32_t)PK::Assets::Mesh::PKMeshFlags::HasMeshlets) != 0u)
+        {
+            auto pMeshlets = mesh->meshlets.Get(base);
+
+            for (auto i = 0u; i < mesh->meshletCount; ++i)
+            {
+                auto& submesh = submeshes.at(pMeshlets[i].submesh);
+                submesh.firstMeshlet = submesh.meshletCount == 0u ? i : submesh.firstMeshlet;
+                submesh.meshletCount++;
+                auto sphere = float4(Functions::ToFloat3(pMeshlets[i].center), pMeshlets[i].radius);
+                auto cone = float4(Functions::ToFloat3(pMeshlets[i].coneAxis), pMeshlets[i].coneCutoff);
+                meshlets.push_back({ pMeshlets[i].firstIndex, pMeshlets[i].indexCount, sphere, cone });
+            }
+
+            allocInfo.pMeshlets = meshlets.data();
+            allocInfo.meshletCount = (uint32_t)meshlets.size();
+        }
+
+        m_submeshIndices.resize(submeshes.size());
+        m_lodSubmeshCount = (uint32_t)submeshes.size() - mesh->submeshCount;
+        allocInfo.pSubmeshes = submeshes.data();
+        allocInfo.submeshCount = (uint32_t)submeshes.size();
         m_mesh->AllocateSubmeshRange(allocInfo, &m_fullRange, m_submeshIndices.data());
 
         PK::Assets::CloseAsset(&asset);
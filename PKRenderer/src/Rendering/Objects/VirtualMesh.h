@@ -3,7 +3,7 @@
 
 namespace PK::Rendering::Objects
 {
-    class VirtualMesh : public Core::Services::Asset, public Core::Services::IAssetImport<Utilities::Ref<Mesh>*>
+    class VirtualMesh : public Core::Services::Asset, public Core::Services::IAssetImport<Utilities::Ref<Mesh>*>, public Core::Services::IAssetPrepare
     {
         friend Utilities::Ref<VirtualMesh> Core::Services::AssetImporters::Create();
 
@@ -13,14 +13,18 @@ namespace PK::Rendering::Objects
             ~VirtualMesh();
 
             virtual void Import(const char* filepath, Utilities::Ref<Mesh>* pParams) override final;
+            void Prepare(const char* filepath) override final { m_preparedAsset.Prepare(filepath); }
             inline Mesh* GetBaseMesh() const { return m_mesh.get(); }
             uint32_t GetSubmeshIndex(uint32_t submesh) const;
             uint32_t GetBaseSubmeshIndex() const { return m_submeshIndices.at(0); }
-            inline const uint32_t GetSubmeshCount() const { return glm::max(1, (int)m_submeshIndices.size()); }
+            // Lod levels are not included. Base submeshes occupy the first indices.
+            inline const uint32_t GetSubmeshCount() const { return glm::max(1, (int)m_submeshIndices.size() - (int)m_lodSubmeshCount); }
 
         private:
             Utilities::Ref<Mesh> m_mesh = nullptr;
             SubMesh m_fullRange{};
             std::vector<uint32_t> m_submeshIndices;
+            uint32_t m_lodSubmeshCount = 0u;
+            Core::Services::PreparedPKAsset m_preparedAsset;
     };
 }
\ No newline at end of file
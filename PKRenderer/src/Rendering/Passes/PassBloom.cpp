@@ -10,7 +10,7 @@ namespace PK::Rendering::Passes
     using namespace Objects;
     using namespace Structs;
 
-    PassBloom::PassBloom(AssetDatabase* assetDatabase, uint32_t initialWidth, uint32_t initialHeight)
+    PassBloom::PassBloom(AssetDatabase* assetDatabase, RenderGraph* renderGraph) : m_renderGraph(renderGraph)
     {
         TextureDescriptor descriptor{};
         descriptor.samplerType = SamplerType::Sampler2D;
@@ -18,12 +18,10 @@ namespace PK::Rendering::Passes
         descriptor.format = TextureFormat::RGBA16F;
         descriptor.layers = 2;
         descriptor.levels = 6;
-        descriptor.resolution.x = initialWidth / 2;
-        descriptor.resolution.y = initialWidth / 2;
         descriptor.sampler.filterMin = FilterMode::Trilinear;
         descriptor.sampler.filterMag = FilterMode::Trilinear;
 
-        m_bloomTexture = Texture::Create(descriptor, "Bloom.Texture");
+        m_bloomTexture = renderGraph->CreateTexture("Bloom.Texture", descriptor, 0.5f);
         m_computeBloom = assetDatabase->Find<Shader>("CS_Bloom");
         m_passPrefilter = m_computeBloom->GetVariantIndex(StringHashID::StringToID("PASS_DOWNSAMPLE"));
         m_passDiskblur = m_computeBloom->GetVariantIndex(StringHashID::StringToID("PASS_BLUR"));
@@ -34,13 +32,8 @@ namespace PK::Rendering::Passes
         cmd->BeginDebugScope("Bloom", PK_COLOR_MAGENTA);
 
         auto color = source->GetColor(0);
-        auto bloom = m_bloomTexture.get();
-
-        auto res = source->GetResolution();
-        res.x /= 2;
-        res.y /= 2;
-
-        bloom->Validate(res);
+        auto bloom = GetTexture();
+        auto res = bloom->GetResolution();
 
         auto hash = HashCache::Get();
         auto ls = 0u;
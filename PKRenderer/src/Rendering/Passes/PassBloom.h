@@ -3,20 +3,23 @@
 #include "Rendering/Objects/RenderTexture.h"
 #include "Rendering/Objects/Shader.h"
 #include "Rendering/Objects/CommandBuffer.h"
+#include "Rendering/Services/RenderGraph.h"
 
 namespace PK::Rendering::Passes
 {
     class PassBloom : public Utilities::NoCopy
     {
         public:
-            PassBloom(Core::Services::AssetDatabase* assetDatabase, uint32_t initialWidth, uint32_t initialHeight);
+            PassBloom(Core::Services::AssetDatabase* assetDatabase, RenderGraph* renderGraph);
             void Render(Objects::CommandBuffer* cmd, Objects::RenderTexture* source);
 
-            Objects::Texture* GetTexture() { return m_bloomTexture.get(); }
+            Objects::Texture* GetTexture() { return m_renderGraph->GetTexture(m_bloomTexture); }
+            constexpr RenderGraphResource GetTextureResource() const { return m_bloomTexture; }
 
         private:
             Objects::Shader* m_computeBloom = nullptr;
-            Utilities::Ref<Objects::Texture> m_bloomTexture;
+            RenderGraph* m_renderGraph = nullptr;
+            RenderGraphResource m_bloomTexture = PK_RENDER_GRAPH_INVALID_RESOURCE;
             uint32_t m_passPrefilter = 0;
             uint32_t m_passDiskblur = 0;
     };
@@ -10,7 +10,7 @@ namespace PK::Rendering::Passes
     using namespace Rendering::Objects;
     using namespace Rendering::Structs;
 
-    PassDepthOfField::PassDepthOfField(AssetDatabase* assetDatabase, const ApplicationConfig* config)
+    PassDepthOfField::PassDepthOfField(AssetDatabase* assetDatabase, RenderGraph* renderGraph, const ApplicationConfig* config) : m_renderGraph(renderGraph)
     {
         m_shaderBlur = assetDatabase->Find<Shader>("VS_DepthOfFieldBlur");
         m_shaderComposite = assetDatabase->Find<Shader>("VS_DepthOfFieldComposite");
@@ -24,13 +24,11 @@ namespace PK::Rendering::Passes
         TextureDescriptor descriptor{};
         descriptor.samplerType = SamplerType::Sampler2D;
         descriptor.format = TextureFormat::RGBA16F;
-        descriptor.resolution.x = config->InitialWidth / 2;
-        descriptor.resolution.y = config->InitialHeight / 2;
         descriptor.layers = 3;
         descriptor.usage = TextureUsage::RTColorSample;
         descriptor.sampler.filterMin = FilterMode::Bilinear;
         descriptor.sampler.filterMag = FilterMode::Bilinear;
-        m_renderTarget = Texture::Create(descriptor, "DepthOfField.Texture");
+        m_renderTarget = renderGraph->CreateTexture("DepthOfField.Texture", descriptor, 0.5f);
         m_autoFocusParams = Buffer::Create(ElementType::Float2, 1, BufferUsage::DefaultStorage, "DepthOfField.AutoFocus.Parameters");
 
         m_passPrefilter = m_shaderBlur->GetVariantIndex(StringHashID::StringToID("PASS_PREFILTER"));
@@ -43,15 +41,9 @@ namespace PK::Rendering::Passes
 
         auto hash = HashCache::Get();
         auto autoFocusParams = m_autoFocusParams.get();
-        auto renderTarget = m_renderTarget.get();
+        auto renderTarget = m_renderGraph->GetTexture(m_renderTarget);
         auto source = destination->GetColor(0);
 
-        auto res = destination->GetResolution();
-        res.x /= 2;
-        res.y /= 2;
-
-        renderTarget->Validate(res);
-
         m_constants.pk_MaximumCoC = std::min(0.05f, 10.0f / destination->GetResolution().y);
         GraphicsAPI::SetConstant<Constants>(hash->pk_DofParams, m_constants);
 
@@ -4,6 +4,7 @@
 #include "Rendering/Objects/RenderTexture.h"
 #include "Rendering/Objects/ConstantBuffer.h"
 #include "Rendering/Objects/Shader.h"
+#include "Rendering/Services/RenderGraph.h"
 
 namespace PK::Rendering::Passes
 {
@@ -19,15 +20,18 @@ namespace PK::Rendering::Passes
         };
 
         public:
-            PassDepthOfField(Core::Services::AssetDatabase* assetDatabase, const Core::ApplicationConfig* config);
+            PassDepthOfField(Core::Services::AssetDatabase* assetDatabase, RenderGraph* renderGraph, const Core::ApplicationConfig* config);
             void Render(Objects::CommandBuffer* cmd, Objects::RenderTexture* destination);
             void OnUpdateParameters(const Core::ApplicationConfig* config);
 
+            constexpr RenderGraphResource GetTextureResource() const { return m_renderTarget; }
+
         private:
             Objects::Shader* m_shaderBlur = nullptr;
             Objects::Shader* m_shaderComposite = nullptr;
             Objects::Shader* m_computeAutoFocus = nullptr;
-            Utilities::Ref<Objects::Texture> m_renderTarget;
+            RenderGraph* m_renderGraph = nullptr;
+            RenderGraphResource m_renderTarget = PK_RENDER_GRAPH_INVALID_RESOURCE;
             Utilities::Ref<Objects::Buffer> m_autoFocusParams;
             uint32_t m_passPrefilter = 0u;
             uint32_t m_passDiskblur = 0u;
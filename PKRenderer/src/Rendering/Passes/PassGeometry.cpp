@@ -15,7 +15,11 @@ namespace PK::Rendering::Passes
     using namespace Objects;
     using namespace Structs;
 
-    PassGeometry::PassGeometry(EntityDatabase* entityDb, Sequencer* sequencer, Batcher* batcher) : m_entityDb(entityDb), m_sequencer(sequencer), m_batcher(batcher)
+    PassGeometry::PassGeometry(EntityDatabase* entityDb, Sequencer* sequencer, JobSystem* jobSystem, Batcher* batcher) :
+        m_entityDb(entityDb),
+        m_sequencer(sequencer),
+        m_jobSystem(jobSystem),
+        m_batcher(batcher)
     {
         m_gbufferAttribs.depthStencil.depthCompareOp = Comparison::LessEqual;
         m_gbufferAttribs.depthStencil.depthWriteEnable = true;
@@ -23,13 +27,14 @@ namespace PK::Rendering::Passes
         m_gbufferAttribs.blending.colorMask = ColorMask::RGBA;
     }
 
-    void PassGeometry::Cull(void* engineRoot, VisibilityList* visibilityList, const float4x4& viewProjection, float depthRange)
+    void PassGeometry::Cull(void* engineRoot, VisibilityList* visibilityList, const float4x4& viewProjection, const float3& viewOrigin, float depthRange, float lodSizePerDepth)
     {
         visibilityList->Clear();
 
         TokenCullFrustum tokenFrustum{};
         tokenFrustum.results = visibilityList;
         tokenFrustum.mask = RenderableFlags::Mesh;
+        tokenFrustum.lodSizePerDepth = lodSizePerDepth;
         Functions::ExtractFrustrumPlanes(viewProjection, &tokenFrustum.planes, true);
         m_sequencer->Next(engineRoot, &tokenFrustum);
         m_passGroup = 0xFFFFFFFF;
@@ -39,20 +44,24 @@ namespace PK::Rendering::Passes
             return;
         }
 
-        m_passGroup = m_batcher->BeginNewGroup();
+        m_passGroup = m_batcher->BeginNewGroup(viewProjection, viewOrigin);
 
-        for (auto i = 0u; i < visibilityList->count; ++i)
+        m_jobSystem->ParallelFor((uint32_t)visibilityList->count, 256u, [this, visibilityList](uint32_t begin, uint32_t end)
         {
-            auto& item = (*visibilityList)[i];
-            auto entity = m_entityDb->Query<MeshRenderableView>(EGID(item.entityId, (uint32_t)ENTITY_GROUPS::ACTIVE));
-
-            for (auto& kv : entity->materials->materials)
+            for (auto i = begin; i < end; ++i)
             {
-                auto transform = entity->transform;
-                auto shader = kv.material->GetShader();
-                m_batcher->SubmitDraw(transform, shader, kv.material, entity->mesh->sharedMesh, kv.submesh, 0u);
+                auto& item = (*visibilityList)[i];
+                auto entity = m_entityDb->Query<MeshRenderableView>(EGID(item.entityId, (uint32_t)ENTITY_GROUPS::ACTIVE));
+                auto mesh = entity->mesh->sharedMesh;
+
+                for (auto& kv : entity->materials->materials)
+                {
+                    auto transform = entity->transform;
+                    auto shader = kv.material->GetShader();
+                    m_batcher->SubmitDraw(m_passGroup, transform, shader, kv.material, mesh, mesh->GetSubmeshLod(kv.submesh, item.lod), 0u);
+                }
             }
-        }
+        });
     }
 
     void PassGeometry::RenderForward(CommandBuffer* cmd)
@@ -12,14 +12,15 @@ namespace PK::Rendering::Passes
     class PassGeometry : public PK::Utilities::NoCopy
     {
         public:
-            PassGeometry(ECS::EntityDatabase* entityDb, Core::Services::Sequencer* sequencer, Batcher* batcher);
-            void Cull(void* engineRoot, ECS::Tokens::VisibilityList* visibilityList, const Math::float4x4& viewProjection, float depthRange);
+            PassGeometry(ECS::EntityDatabase* entityDb, Core::Services::Sequencer* sequencer, Core::Services::JobSystem* jobSystem, Batcher* batcher);
+            void Cull(void* engineRoot, ECS::Tokens::VisibilityList* visibilityList, const Math::float4x4& viewProjection, const Math::float3& viewOrigin, float depthRange, float lodSizePerDepth);
             void RenderForward(Objects::CommandBuffer* cmd);
             void RenderGBuffer(Objects::CommandBuffer* cmd);
             constexpr uint32_t GetPassGroup() const { return m_passGroup; }
         private:
             ECS::EntityDatabase* m_entityDb = nullptr;
             Core::Services::Sequencer* m_sequencer = nullptr;
+            Core::Services::JobSystem* m_jobSystem = nullptr;
             Batcher* m_batcher = nullptr;
             uint32_t m_passGroup = 0u;
             Structs::FixedFunctionShaderAttributes m_gbufferAttribs{};
@@ -5,6 +5,7 @@
 #include "Math/FunctionsMisc.h"
 #include "ECS/Contextual/EntityViews/MeshRenderableView.h"
 #include "Rendering/HashCache.h"
+#include "Utilities/HashHelpers.h"
 
 using namespace PK::Core;
 using namespace PK::Core::Services;
@@ -50,10 +51,13 @@ struct Vector::Comparer<LightRenderableView*>
 
 namespace PK::Rendering::Passes
 {
-    PassLights::PassLights(AssetDatabase* assetDatabase, EntityDatabase* entityDb, Sequencer* sequencer, Batcher* batcher, const ApplicationConfig* config) :
+    PassLights::PassLights(AssetDatabase* assetDatabase, EntityDatabase* entityDb, Sequencer* sequencer, JobSystem* jobSystem, Batcher* batcher, const ApplicationConfig* config) :
         m_entityDb(entityDb),
         m_sequencer(sequencer),
+        m_jobSystem(jobSystem),
         m_batcher(batcher),
+        m_clusterBuilder(jobSystem),
+        m_shadowmapAllocator(PK_SHADOWMAP_ATLAS_LEVELS),
         m_lights(1024)
     {
         m_computeLightAssignment = assetDatabase->Find<Shader>("LightAssignment");
@@ -62,12 +66,18 @@ namespace PK::Rendering::Passes
         auto hash = HashCache::Get();
 
         m_cascadeLinearity = config->CascadeLinearity;
+        m_useCPULightAssignment = config->EnableCPULightAssignment;
         m_shadowmapTileSize = config->ShadowmapTileSize;
         m_shadowmapCubeFaceSize = (uint)sqrt((m_shadowmapTileSize * m_shadowmapTileSize) / 6);
 
+        // Atlas texels are two 32bit floats.
+        auto layerSize = m_shadowmapTileSize * m_shadowmapTileSize * 8ull;
+        auto budgetLayers = (size_t)((config->ShadowmapAtlasBudgetMB * 1024ull * 1024ull) / layerSize);
+        m_shadowmapMaxLayers = (uint32_t)glm::clamp(budgetLayers, (size_t)PK_SHADOW_CASCADE_COUNT, (size_t)PK_SHADOWMAP_ATLAS_MAX_LAYERS);
+        m_shadowmapAllocator.SetPageCount(glm::min(32u, m_shadowmapMaxLayers));
+
         auto descriptor = RenderTextureDescriptor();
         descriptor.samplerType = SamplerType::CubemapArray;
-        descriptor.resolution = { m_shadowmapCubeFaceSize, m_shadowmapCubeFaceSize , 1u };
         descriptor.colorFormats[0] = { TextureFormat::RG32F };
         descriptor.depthFormat = TextureFormat::Depth16;
         descriptor.layers = 6 * PK_SHADOW_CASCADE_COUNT;
@@ -77,7 +87,15 @@ namespace PK::Rendering::Passes
         descriptor.sampler.filterMin = FilterMode::Bilinear;
         descriptor.sampler.filterMag = FilterMode::Bilinear;
         descriptor.usage = TextureUsage::Sample;
-        m_shadowmapTypeData[(int)LightType::Point].SceneRenderTarget = CreateRef<RenderTexture>(descriptor, "Lights.Shadowmap.PointRenderTarget");
+
+        // Scene depth is rendered at the resolution of the light's atlas tile level.
+        for (auto level = 0u; level < PK_SHADOWMAP_ATLAS_LEVELS; ++level)
+        {
+            auto name = std::string("Lights.Shadowmap.PointRenderTarget") + std::to_string(level);
+            descriptor.resolution = { m_shadowmapCubeFaceSize >> level, m_shadowmapCubeFaceSize >> level, 1u };
+            m_shadowmapTypeData[(int)LightType::Point].SceneRenderTargets[level] = CreateRef<RenderTexture>(descriptor, name.c_str());
+        }
+
         m_shadowmapTypeData[(int)LightType::Point].BlurPass0 = m_shadowmapBlur->GetVariantIndex({ hash->SHADOW_SOURCE_CUBE });
         m_shadowmapTypeData[(int)LightType::Point].BlurPass1 = m_shadowmapBlur->GetVariantIndex({ hash->SHADOW_SOURCE_2D });
         m_shadowmapTypeData[(int)LightType::Point].TileCount = 1u;
@@ -85,16 +103,23 @@ namespace PK::Rendering::Passes
         m_shadowmapTypeData[(int)LightType::Point].LayerStride = 6u;
 
         descriptor.samplerType = SamplerType::Sampler2DArray;
-        descriptor.resolution = { m_shadowmapTileSize, m_shadowmapTileSize, 1u };
         descriptor.layers = PK_SHADOW_CASCADE_COUNT;
-        m_shadowmapTypeData[(int)LightType::Spot].SceneRenderTarget = CreateRef<RenderTexture>(descriptor, "Lights.Shadowmap.SpotRenderTarget");
+
+        for (auto level = 0u; level < PK_SHADOWMAP_ATLAS_LEVELS; ++level)
+        {
+            auto name = std::string("Lights.Shadowmap.SpotRenderTarget") + std::to_string(level);
+            descriptor.resolution = { m_shadowmapTileSize >> level, m_shadowmapTileSize >> level, 1u };
+            m_shadowmapTypeData[(int)LightType::Spot].SceneRenderTargets[level] = CreateRef<RenderTexture>(descriptor, name.c_str());
+        }
+
         m_shadowmapTypeData[(int)LightType::Spot].BlurPass0 = m_shadowmapBlur->GetVariantIndex({ hash->SHADOW_SOURCE_2D });
         m_shadowmapTypeData[(int)LightType::Spot].BlurPass1 = m_shadowmapBlur->GetVariantIndex({ hash->SHADOW_SOURCE_2D });
         m_shadowmapTypeData[(int)LightType::Spot].TileCount = 1u;
         m_shadowmapTypeData[(int)LightType::Spot].MaxBatchSize = PK_SHADOW_CASCADE_COUNT;
         m_shadowmapTypeData[(int)LightType::Spot].LayerStride = 1u;
 
-        m_shadowmapTypeData[(int)LightType::Directional].SceneRenderTarget = m_shadowmapTypeData[(int)LightType::Spot].SceneRenderTarget;
+        // Cascades always use whole atlas layers.
+        m_shadowmapTypeData[(int)LightType::Directional].SceneRenderTargets[0] = m_shadowmapTypeData[(int)LightType::Spot].SceneRenderTargets[0];
         m_shadowmapTypeData[(int)LightType::Directional].BlurPass0 = m_shadowmapBlur->GetVariantIndex({ hash->SHADOW_SOURCE_2D });
         m_shadowmapTypeData[(int)LightType::Directional].BlurPass1 = m_shadowmapBlur->GetVariantIndex({ hash->SHADOW_SOURCE_2D });
         m_shadowmapTypeData[(int)LightType::Directional].TileCount = PK_SHADOW_CASCADE_COUNT;
@@ -105,7 +130,7 @@ namespace PK::Rendering::Passes
         atlasDescriptor.samplerType = SamplerType::Sampler2DArray;
         atlasDescriptor.format = TextureFormat::RG32F;
         atlasDescriptor.usage = TextureUsage::RTColorSample;
-        atlasDescriptor.layers = 32;
+        atlasDescriptor.layers = m_shadowmapAllocator.GetPageCount();
         atlasDescriptor.resolution = { m_shadowmapTileSize, m_shadowmapTileSize, 1u };
         atlasDescriptor.sampler.wrap[0] = WrapMode::Clamp;
         atlasDescriptor.sampler.wrap[1] = WrapMode::Clamp;
@@ -117,7 +142,7 @@ namespace PK::Rendering::Passes
         TextureDescriptor imageDescriptor;
         imageDescriptor.samplerType = SamplerType::Sampler3D;
         imageDescriptor.format = TextureFormat::R32UI;
-        imageDescriptor.usage = TextureUsage::Storage | TextureUsage::Concurrent;
+        imageDescriptor.usage = TextureUsage::Upload | TextureUsage::Storage | TextureUsage::Concurrent;
         imageDescriptor.resolution = { GridSizeX, GridSizeY, GridSizeZ };
         imageDescriptor.sampler.filterMin = FilterMode::Point;
         imageDescriptor.sampler.filterMag = FilterMode::Point;
@@ -126,6 +151,11 @@ namespace PK::Rendering::Passes
         imageDescriptor.sampler.wrap[2] = WrapMode::Clamp;
         m_lightTiles = Texture::Create(imageDescriptor, "Lights.Tiles");
 
+        if (m_useCPULightAssignment)
+        {
+            m_lightTilesUpload = Buffer::Create(ElementType::Uint, ClusterCount, BufferUsage::GPUOnly | BufferUsage::TransferDst | BufferUsage::TransferSrc, "Lights.Tiles.Upload");
+        }
+
         m_lightsBuffer = Buffer::Create(
             {
                 { ElementType::Float4, "POSITION"},
@@ -146,7 +176,7 @@ namespace PK::Rendering::Passes
 
     void PassLights::Cull(void* engineRoot, VisibilityList* visibilityList, const float4x4& viewProjection, float znear, float zfar)
     {
-        m_shadowmapCount = 0u;
+        ++m_frameIndex;
         m_projectionCount = 0u;
         m_cascadeSplits = GetCascadeZSplits(znear, zfar);
 
@@ -162,6 +192,7 @@ namespace PK::Rendering::Passes
         visibilityList->Clear();
         m_sequencer->Next(engineRoot, &tokens.frustum);
         m_lightCount = (uint32_t)visibilityList->count;
+        m_clusterBuilder.Reset(m_lightCount);
 
         if (visibilityList->count == 0)
         {
@@ -178,6 +209,23 @@ namespace PK::Rendering::Passes
         Vector::QuickSort(m_lights.GetData(), m_lightCount);
 
         m_shadowBatches.clear();
+        m_shadowRequests.clear();
+
+        // Lights keep their atlas tiles across frames so that unchanged shadowmaps can be reused.
+        for (auto iter = m_shadowmapCache.begin(); iter != m_shadowmapCache.end();)
+        {
+            if (m_frameIndex - iter->second.lastVisibleFrame > PK_SHADOWMAP_CACHE_RETAIN_FRAMES)
+            {
+                ReleaseShadowmapTile(&iter->second);
+                iter = m_shadowmapCache.erase(iter);
+                continue;
+            }
+
+            ++iter;
+        }
+
+        // Clip space w is the view depth & the length of the upper 3x3's second row is the vertical projection scale.
+        auto projectionScale = glm::length(float3(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1]));
 
         for (auto i = 0u; i < m_lightCount; ++i)
         {
@@ -190,7 +238,46 @@ namespace PK::Rendering::Passes
 
             if ((view->renderable->flags & RenderableFlags::CastShadows) != 0)
             {
-                BuildShadowmapBatches(engineRoot, &tokens, view, i, inverseViewProjection);
+                auto entry = &m_shadowmapCache[view->GID.entityID()];
+                entry->lastVisibleFrame = m_frameIndex;
+                entry->importance = 1.0f;
+
+                // Importance is the fraction of the view's height covered by the light's bounds.
+                if (view->light->type != LightType::Directional)
+                {
+                    auto center = view->bounds->worldAABB.GetCenter();
+                    auto radius = glm::length(view->bounds->worldAABB.GetExtents());
+                    auto depth = viewProjection[0][3] * center.x + viewProjection[1][3] * center.y + viewProjection[2][3] * center.z + viewProjection[3][3];
+                    entry->importance = depth > radius ? glm::min(1.0f, radius * projectionScale / depth) : 1.0f;
+                }
+
+                m_shadowRequests.push_back({ view, entry, i });
+            }
+        }
+
+        AllocateShadowmapTiles();
+
+        // Lights of the same type & tile level share batches.
+        std::sort(m_shadowRequests.begin(), m_shadowRequests.end(), [](const ShadowmapRequest& a, const ShadowmapRequest& b)
+        {
+            if (a.view->light->type != b.view->light->type)
+            {
+                return a.view->light->type < b.view->light->type;
+            }
+
+            if (a.entry->tile.level != b.entry->tile.level)
+            {
+                return a.entry->tile.level < b.entry->tile.level;
+            }
+
+            return a.index < b.index;
+        });
+
+        for (auto& request : m_shadowRequests)
+        {
+            if (request.entry->tileCount > 0u)
+            {
+                BuildShadowmapBatches(engineRoot, &tokens, request.view, request.entry, request.index, inverseViewProjection);
             }
         }
 
@@ -208,21 +295,23 @@ namespace PK::Rendering::Passes
             auto& view = m_lights[i];
             auto info = view->lightFrameInfo;
             auto position = PK_FLOAT4_ZERO;
+            auto direction = PK_FLOAT4_ZERO;
 
             switch (view->light->type)
             {
             case LightType::Point:
-                position = float4(view->transform->position, view->light->radius);
+                position = float4(view->transform->GetWorldPosition(), view->light->radius);
                 break;
 
             case LightType::Spot:
-                position = float4(view->transform->position, view->light->radius);
+                position = float4(view->transform->GetWorldPosition(), view->light->radius);
                 matricesView[info->projectionIndex] = Functions::GetPerspective(view->light->angle, 1.0f, 0.1f, view->light->radius) * view->transform->worldToLocal;
-                directionsView[info->projectionIndex] = float4(view->transform->rotation * PK_FLOAT3_FORWARD, view->light->angle * PK_FLOAT_DEG2RAD);
+                direction = float4(view->transform->GetWorldForward(), view->light->angle * PK_FLOAT_DEG2RAD);
+                directionsView[info->projectionIndex] = direction;
                 break;
 
             case LightType::Directional:
-                position = float4(view->transform->rotation * PK_FLOAT3_FORWARD, 0.0f);
+                position = float4(view->transform->GetWorldForward(), 0.0f);
                 position.w = Functions::GetShadowCascadeMatrices(
                     view->transform->worldToLocal,
                     inverseViewProjection,
@@ -233,7 +322,7 @@ namespace PK::Rendering::Passes
                 break;
             }
 
-            lightsView[i] =
+            PK_Light light =
             {
                 position,
                 view->light->color,
@@ -244,6 +333,10 @@ namespace PK::Rendering::Passes
                     (ushort)view->light->type
                 }
             };
+
+            lightsView[i] = light;
+            // Filled for the gpu path as well so that the cpu path can be timed on demand.
+            m_clusterBuilder.SetLight(i, light, direction);
         }
 
         lightsView[m_lightCount] = { PK_FLOAT4_ZERO, PK_COLOR_CLEAR, { 0xFFFF, 0u, 0xFFFF, 0xFFFF } };
@@ -255,11 +348,6 @@ namespace PK::Rendering::Passes
             cmd->EndBufferWrite(m_lightDirectionsBuffer.get());
         }
 
-        if (m_shadowmaps->GetLayers() < m_shadowmapCount + PK_SHADOW_CASCADE_COUNT)
-        {
-            m_shadowmaps->Validate(1u, m_shadowmapCount + PK_SHADOW_CASCADE_COUNT);
-        }
-
         auto hash = HashCache::Get();
         GraphicsAPI::SetConstant<uint32_t>(hash->pk_LightCount, m_lightCount);
         GraphicsAPI::SetBuffer(hash->pk_Lights, m_lightsBuffer.get());
@@ -271,44 +359,140 @@ namespace PK::Rendering::Passes
     void PassLights::RenderShadows(Objects::CommandBuffer* cmd)
     {
         auto hash = HashCache::Get();
-        auto atlasIndex = 0u;
+        auto batchCount = (uint32_t)m_shadowBatches.size();
+        auto threadCount = glm::min(m_jobSystem->GetWorkerCount(), batchCount);
+
+        // Batch draws are independent & recorded into secondary buffers in parallel.
+        // Buffers that share a thread index are recorded sequentially by the same job.
+        m_shadowCommandBuffers.resize(batchCount);
+
+        for (auto i = 0u; i < batchCount; ++i)
+        {
+            auto& shadowBatch = m_shadowBatches.at(i);
+            auto& shadow = m_shadowmapTypeData[(int)shadowBatch.batchType];
+            cmd->SetRenderTarget(shadow.SceneRenderTargets[shadowBatch.batchLevel].get(), true);
+            m_shadowCommandBuffers.at(i) = cmd->BeginSecondary(i % threadCount);
+        }
+
+        m_jobSystem->ParallelFor(threadCount, 1u, [this, batchCount, threadCount](uint32_t begin, uint32_t end)
+        {
+            for (auto thread = begin; thread < end; ++thread)
+            {
+                for (auto i = thread; i < batchCount; i += threadCount)
+                {
+                    m_batcher->Render(m_shadowCommandBuffers.at(i), m_shadowBatches.at(i).batchGroup);
+                }
+            }
+        });
 
-        for (const auto& shadowBatch : m_shadowBatches)
+        for (auto i = 0u; i < batchCount; ++i)
         {
+            const auto& shadowBatch = m_shadowBatches.at(i);
             auto batchType = shadowBatch.batchType;
             auto& shadow = m_shadowmapTypeData[(int)batchType];
-            auto tileCount = shadow.TileCount * shadowBatch.count;
+            auto sceneRenderTarget = shadow.SceneRenderTargets[shadowBatch.batchLevel].get();
+            auto tileSize = m_shadowmapTileSize >> shadowBatch.batchLevel;
 
             cmd->BeginDebugScope("ShadowBatch", PK_COLOR_RED);
 
-            cmd->SetRenderTarget(shadow.SceneRenderTarget.get(), true);
+            cmd->SetRenderTarget(sceneRenderTarget, true);
             cmd->ClearColor(color(shadowBatch.maxDepthRange, shadowBatch.maxDepthRange * shadowBatch.maxDepthRange, 0.0f, 0.0f), 0u);
             cmd->ClearDepth(1.0f, 0u);
+            cmd->ExecuteSecondary(&m_shadowCommandBuffers.at(i), 1u);
 
             GraphicsAPI::SetConstant(hash->pk_ShadowmapData, shadowBatch.shadowBlurAmounts);
-            m_batcher->Render(cmd, shadowBatch.batchGroup);
 
-            cmd->SetViewPort({ 0, 0, m_shadowmapTileSize, m_shadowmapTileSize });
-            cmd->SetScissor({ 0, 0, m_shadowmapTileSize, m_shadowmapTileSize });
+            GraphicsAPI::SetTexture(hash->pk_ShadowmapSource, sceneRenderTarget->GetColor(0));
 
-            cmd->SetRenderTarget(m_shadowmaps.get(), TextureViewRange(0, atlasIndex, 1, tileCount));
-            GraphicsAPI::SetTexture(hash->pk_ShadowmapSource, shadow.SceneRenderTarget->GetColor(0));
-            cmd->Blit(m_shadowmapBlur, tileCount, 0u, shadow.BlurPass0);
+            // Lights are filtered into their tile's region of the atlas. Whole layer tiles in adjacent layers are filtered by a single draw.
+            // Instance indices address the batch local source layers.
+            for (auto first = 0u; first < shadowBatch.count;)
+            {
+                auto& tile = shadowBatch.tiles[first];
+                auto last = first + 1u;
 
-            cmd->EndDebugScope();
+                while (last < shadowBatch.count && tile.level == 0u && shadowBatch.tiles[last].page == shadowBatch.tiles[last - 1u].page + shadow.TileCount)
+                {
+                    ++last;
+                }
+
+                auto tileCount = (last - first) * shadow.TileCount;
+                cmd->SetRenderTarget(m_shadowmaps.get(), TextureViewRange(0, tile.page, 1, tileCount));
+                cmd->SetViewPort({ tile.x * tileSize, tile.y * tileSize, tileSize, tileSize });
+                cmd->SetScissor({ tile.x * tileSize, tile.y * tileSize, tileSize, tileSize });
+                cmd->Blit(m_shadowmapBlur, tileCount, first * shadow.TileCount, shadow.BlurPass0);
+                first = last;
+            }
 
-            atlasIndex += tileCount;
+            cmd->EndDebugScope();
         }
     }
 
-    void PassLights::ComputeClusters(CommandBuffer* cmd)
+    void PassLights::ComputeClusters(CommandBuffer* cmd, const float4x4& view, const float4x4& inverseProjection, float znear, float zfar)
     {
         cmd->BeginDebugScope("LightAssignment", PK_COLOR_CYAN);
+        m_clusterView = view;
+        m_clusterInverseProjection = inverseProjection;
+        m_clusterZNear = znear;
+        m_clusterZFar = zfar;
+
+        if (m_useCPULightAssignment)
+        {
+            auto timestamp = std::chrono::steady_clock::now();
+            m_clusterBuilder.Build(view, inverseProjection, znear, zfar, m_cascadeSplits.planes);
+            m_clusterBuildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - timestamp).count();
+
+            auto listCount = m_clusterBuilder.GetLightListCount();
+
+            if (listCount > m_globalLightsList->GetCount())
+            {
+                m_globalLightsList->Validate(listCount);
+            }
+
+            cmd->UploadBufferSubData(m_lightTilesUpload.get(), m_clusterBuilder.GetTiles(), 0ull, ClusterCount * sizeof(uint32_t));
+            cmd->Blit(m_lightTilesUpload.get(), m_lightTiles.get());
+
+            if (listCount > 0u)
+            {
+                cmd->UploadBufferSubData(m_globalLightsList.get(), m_clusterBuilder.GetLightList(), 0ull, listCount * sizeof(uint32_t));
+            }
+
+            cmd->EndDebugScope();
+            return;
+        }
+
         cmd->Clear(m_globalLightIndex.get(), 0, sizeof(uint32_t), 0u);
         cmd->Dispatch(m_computeLightAssignment, { GridSizeX , GridSizeY, GridSizeZ });
         cmd->EndDebugScope();
     }
 
+    LightAssignmentStats PassLights::MeasureLightAssignment(uint32_t sampleCount)
+    {
+        LightAssignmentStats stats{};
+        stats.lightCount = m_lightCount;
+        stats.frameMilliseconds = m_clusterBuildMilliseconds;
+        stats.isCPUActive = m_useCPULightAssignment;
+
+        if (m_clusterZNear <= 0.0f)
+        {
+            return stats;
+        }
+
+        // Rebuilds the lights & view of the last frame. The cpu path rebuilds before its next upload so the result can be discarded.
+        for (auto i = 0u; i < sampleCount; ++i)
+        {
+            auto timestamp = std::chrono::steady_clock::now();
+            m_clusterBuilder.Build(m_clusterView, m_clusterInverseProjection, m_clusterZNear, m_clusterZFar, m_cascadeSplits.planes);
+            auto milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - timestamp).count();
+            stats.minMilliseconds = i == 0u ? milliseconds : glm::min(stats.minMilliseconds, milliseconds);
+            stats.averageMilliseconds += milliseconds / sampleCount;
+        }
+
+        stats.sampleCount = sampleCount;
+        stats.listCount = m_clusterBuilder.GetLightListCount();
+        return stats;
+    }
+
     ShadowCascades PassLights::GetCascadeZSplits(float znear, float zfar) const
     {
         ShadowCascades cascadeSplits;
@@ -330,6 +514,7 @@ namespace PK::Rendering::Passes
     void PassLights::BuildShadowmapBatches(void* engineRoot,
         CullTokens* tokens,
         LightRenderableView* view,
+        ShadowmapCacheEntry* cacheEntry,
         uint32_t index,
         const float4x4& inverseViewProjection)
     {
@@ -346,6 +531,8 @@ namespace PK::Rendering::Passes
                 tokens->cube.mask = RenderableFlags::Mesh | RenderableFlags::CastShadows;
                 tokens->cube.depthRange = info->maxShadowDepth = view->light->radius - 0.1f;
                 tokens->cube.aabb = view->bounds->worldAABB;
+                // Cube faces have a 90 degree field of view.
+                tokens->cube.lodSizePerDepth = 1.0f;
                 m_sequencer->Next(engineRoot, &tokens->cube);
             }
             break;
@@ -354,6 +541,7 @@ namespace PK::Rendering::Passes
             {
                 tokens->frustum.mask = RenderableFlags::Mesh | RenderableFlags::CastShadows;
                 tokens->frustum.depthRange = info->maxShadowDepth = view->light->radius - 0.1f;
+                tokens->frustum.lodSizePerDepth = glm::tan(view->light->angle * PK_FLOAT_DEG2RAD * 0.5f);
                 auto projection = Functions::GetPerspective(view->light->angle, 1.0f, 0.1f, view->light->radius) * view->transform->worldToLocal;
                 Functions::ExtractFrustrumPlanes(projection, &tokens->frustum.planes, true);
                 m_sequencer->Next(engineRoot, &tokens->frustum);
@@ -381,6 +569,7 @@ namespace PK::Rendering::Passes
                 tokens->cascades.depthRange = info->maxShadowDepth = lightRange;
                 tokens->cascades.count = PK_SHADOW_CASCADE_COUNT;
                 tokens->cascades.cascades = planes;
+                tokens->cascades.lodSizePerDepth = 1.0f;
                 tokens->cascades.mask = RenderableFlags::Mesh | RenderableFlags::CastShadows;
                 m_sequencer->Next(engineRoot, &tokens->cascades);
             }
@@ -392,33 +581,87 @@ namespace PK::Rendering::Passes
             return;
         }
 
+        struct ShadowLightKey
+        {
+            float radius;
+            float angle;
+            float shadowBlur;
+            uint32_t type;
+            uint32_t entityId;
+            uint32_t updateIndex;
+        };
+
+        struct ShadowCasterKey
+        {
+            const Mesh* mesh;
+            uint32_t entityId;
+            uint32_t updateIndex;
+            uint32_t lod;
+            uint32_t clipId;
+        };
+
+        // Transform update indices change whenever a world matrix changes. Added or removed casters change the visible set.
+        ShadowLightKey lightKey =
+        {
+            view->light->radius,
+            view->light->angle,
+            view->light->shadowBlur,
+            (uint32_t)view->light->type,
+            view->GID.entityID(),
+            view->transform->updateIndex
+        };
+
+        auto signature = HashHelpers::MurmurHash(&lightKey, sizeof(lightKey), 0ull);
+        uint32_t minDepth = 0xFFFFFFFF;
+
+        for (auto i = 0u; i < visibilityList->count; ++i)
+        {
+            auto& item = (*visibilityList)[i];
+            auto entity = m_entityDb->Query<MeshRenderableView>(EGID(item.entityId, (uint32_t)ENTITY_GROUPS::ACTIVE));
+            ShadowCasterKey key = { entity->mesh->sharedMesh, item.entityId, entity->transform->updateIndex, item.lod, item.clipId };
+            signature = HashHelpers::MurmurHash(&key, sizeof(key), signature);
+            minDepth = item.depth < minDepth ? item.depth : minDepth;
+        }
+
+        // Zero is reserved for invalidated entries.
+        signature = signature != 0ull ? signature : 1ull;
+        info->minShadowDepth = (minDepth * info->maxShadowDepth) / (float)0xFFFF;
+        // Layer, level & tile coordinates are packed into 8, 2, 3 & 3 bits.
+        auto& tile = cacheEntry->tile;
+        info->shadowmapIndex = (uint16_t)(tile.page | (tile.level << 8u) | (tile.x << 10u) | (tile.y << 13u));
+
+        // Directional cascades follow the view & are rendered every frame.
+        if (view->light->type != LightType::Directional && cacheEntry->signature == signature)
+        {
+            return;
+        }
+
+        cacheEntry->signature = signature;
+
         auto& shadow = m_shadowmapTypeData[(int)view->light->type];
 
-        if (m_shadowBatches.size() == 0 || m_shadowBatches.back().count >= shadow.MaxBatchSize || m_shadowBatches.back().batchType != view->light->type)
+        if (m_shadowBatches.size() == 0 || 
+            m_shadowBatches.back().count >= shadow.MaxBatchSize || 
+            m_shadowBatches.back().batchType != view->light->type ||
+            m_shadowBatches.back().batchLevel != tile.level)
         {
             auto& newBatch = m_shadowBatches.emplace_back();
             newBatch.batchGroup = m_batcher->BeginNewGroup();
             newBatch.firstIndex = index;
             newBatch.batchType = view->light->type;
+            newBatch.batchLevel = tile.level;
         }
 
         auto& batch = m_shadowBatches.back();
 
-        uint32_t minDepth = 0xFFFFFFFF;
-        info->shadowmapIndex = m_shadowmapCount;
         info->batchGroup = batch.batchGroup;
-        m_shadowmapCount += view->light->type == LightType::Directional ? PK_SHADOW_CASCADE_COUNT : 1;
+        batch.tiles[batch.count] = tile;
 
         for (auto i = 0u; i < visibilityList->count; ++i)
         {
             auto& item = (*visibilityList)[i];
             auto entity = m_entityDb->Query<MeshRenderableView>(EGID(item.entityId, (uint32_t)ENTITY_GROUPS::ACTIVE));
 
-            if (item.depth < minDepth)
-            {
-                minDepth = item.depth;
-            }
-
             for (auto& kv : entity->materials->materials)
             {
                 auto transform = entity->transform;
@@ -427,13 +670,12 @@ namespace PK::Rendering::Passes
                 if (shader != nullptr)
                 {
                     uint32_t layerOffset = batch.count * shadow.LayerStride + item.clipId;
-                    m_batcher->SubmitDraw(transform, shader, nullptr, entity->mesh->sharedMesh, kv.submesh, (index & 0xFFFF) | (layerOffset << 16));
+                    auto submesh = entity->mesh->sharedMesh->GetSubmeshLod(kv.submesh, item.lod);
+                    m_batcher->SubmitDraw(batch.batchGroup, transform, shader, nullptr, entity->mesh->sharedMesh, submesh, (index & 0xFFFF) | (layerOffset << 16));
                 }
             }
         }
 
-        info->minShadowDepth = (minDepth * info->maxShadowDepth) / (float)0xFFFF;
-
         // Directional lights use same blur amount for all cascades.
         // Fill the vector so that every tile gets the correct value.
         for (auto i = 0u; i < shadow.TileCount; ++i)
@@ -444,4 +686,172 @@ namespace PK::Rendering::Passes
         batch.maxDepthRange = glm::max(batch.maxDepthRange, info->maxShadowDepth - info->minShadowDepth);
         batch.count++;
     }
-}
+
+    void PassLights::AllocateShadowmapTiles()
+    {
+        auto isResized = false;
+
+        // Important lights claim tiles first. When the atlas budget is exceeded the least important lights are demoted or lose their shadows.
+        std::sort(m_shadowRequests.begin(), m_shadowRequests.end(), [](const ShadowmapRequest& a, const ShadowmapRequest& b)
+        {
+            return a.entry->importance > b.entry->importance;
+        });
+
+        for (auto i = 0u; i < m_shadowRequests.size(); ++i)
+        {
+            auto entry = m_shadowRequests.at(i).entry;
+            auto tileCount = m_shadowmapTypeData[(int)m_shadowRequests.at(i).view->light->type].TileCount;
+            auto level = 0u;
+
+            // Each level halves the tile width. The level only changes once the importance has moved past the hysteresis margin.
+            if (tileCount == 1u)
+            {
+                auto desiredLevel = -glm::log2(glm::max(entry->importance, 1e-4f));
+                level = glm::min((uint32_t)desiredLevel, PK_SHADOWMAP_ATLAS_LEVELS - 1u);
+
+                if (entry->tileCount == tileCount && 
+                    desiredLevel > entry->tile.level - PK_SHADOWMAP_LEVEL_HYSTERESIS && 
+                    desiredLevel < entry->tile.level + 1.0f + PK_SHADOWMAP_LEVEL_HYSTERESIS)
+                {
+                    level = entry->tile.level;
+                }
+            }
+
+            if (entry->tileCount == tileCount && entry->tile.level == level)
+            {
+                continue;
+            }
+
+            // Upgrades keep the current tile when there is no room for a larger one.
+            if (entry->tileCount == tileCount && level < entry->tile.level)
+            {
+                auto previous = *entry;
+                auto isAllocated = false;
+
+                while (!(isAllocated = AllocateShadowmapTile(entry, tileCount, level)) && GrowShadowmapAtlas())
+                {
+                    isResized = true;
+                }
+
+                if (isAllocated)
+                {
+                    ReleaseShadowmapTile(&previous);
+                }
+
+                continue;
+            }
+
+            ReleaseShadowmapTile(entry);
+
+            while (!AllocateShadowmapTile(entry, tileCount, level))
+            {
+                if (GrowShadowmapAtlas())
+                {
+                    isResized = true;
+                    continue;
+                }
+
+                // Tiles of lights that are no longer visible are released first, then those of less important lights that have not been allocated yet.
+                ShadowmapCacheEntry* victim = nullptr;
+
+                for (auto& kv : m_shadowmapCache)
+                {
+                    if (kv.second.tileCount > 0u && kv.second.lastVisibleFrame != m_frameIndex)
+                    {
+                        victim = &kv.second;
+                        break;
+                    }
+                }
+
+                for (auto j = (uint32_t)m_shadowRequests.size() - 1u; victim == nullptr && j > i; --j)
+                {
+                    if (m_shadowRequests.at(j).entry->tileCount > 0u)
+                    {
+                        victim = m_shadowRequests.at(j).entry;
+                    }
+                }
+
+                if (victim != nullptr)
+                {
+                    ReleaseShadowmapTile(victim);
+                    continue;
+                }
+
+                if (tileCount > 1u || ++level >= PK_SHADOWMAP_ATLAS_LEVELS)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (isResized)
+        {
+            m_shadowmaps->Validate(1u, m_shadowmapAllocator.GetPageCount());
+
+            // Resizing discards the contents of cached shadowmaps.
+            for (auto& kv : m_shadowmapCache)
+            {
+                kv.second.signature = 0ull;
+            }
+        }
+    }
+
+    bool PassLights::AllocateShadowmapTile(ShadowmapCacheEntry* entry, uint32_t tileCount, uint32_t level)
+    {
+        QuadtreeNode tile{};
+
+        if (tileCount > 1u)
+        {
+            uint32_t firstPage;
+
+            if (!m_shadowmapAllocator.AllocatePages(tileCount, &firstPage))
+            {
+                return false;
+            }
+
+            tile.page = (uint16_t)firstPage;
+        }
+        else if (!m_shadowmapAllocator.Allocate(level, &tile))
+        {
+            return false;
+        }
+
+        entry->tile = tile;
+        entry->tileCount = tileCount;
+        entry->signature = 0ull;
+        return true;
+    }
+
+    bool PassLights::GrowShadowmapAtlas()
+    {
+        auto pageCount = m_shadowmapAllocator.GetPageCount();
+
+        if (pageCount >= m_shadowmapMaxLayers)
+        {
+            return false;
+        }
+
+        m_shadowmapAllocator.SetPageCount(glm::min(pageCount + glm::max(pageCount / 2u, PK_SHADOW_CASCADE_COUNT), m_shadowmapMaxLayers));
+        return true;
+    }
+
+    void PassLights::ReleaseShadowmapTile(ShadowmapCacheEntry* entry)
+    {
+        if (entry->tileCount == 0u)
+        {
+            return;
+        }
+
+        if (entry->tileCount > 1u)
+        {
+            m_shadowmapAllocator.FreePages(entry->tile.page, entry->tileCount);
+        }
+        else
+        {
+            m_shadowmapAllocator.Free(entry->tile);
+        }
+
+        entry->tileCount = 0u;
+        entry->signature = 0ull;
+    }
+}
\ No newline at end of file
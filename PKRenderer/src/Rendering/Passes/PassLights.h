@@ -1,21 +1,33 @@
 #pragma once
 #include "Utilities/NoCopy.h"
+#include "Utilities/QuadtreeAllocator.h"
 #include "Core/ApplicationConfig.h"
+#include "Core/Services/JobSystem.h"
 #include "ECS/Contextual/Tokens/CullingTokens.h"
 #include "ECS/Contextual/EntityViews/LightRenderableView.h"
 #include "Rendering/Objects/RenderTexture.h"
 #include "Rendering/Objects/ConstantBuffer.h"
 #include "Rendering/Objects/Shader.h"
 #include "Rendering/Services/Batcher.h"
+#include "Rendering/Services/LightClusterBuilder.h"
 
 namespace PK::Rendering::Passes
 {
     typedef struct ShadowCascades { float planes[5]; } ShadowCascades;
     typedef struct ShadowBlurAmounts { float values[4]{}; } ShadowBlurAmounts;
 
+    // Cached shadowmaps of lights that have not been visible for this many frames are released.
+    constexpr static const uint32_t PK_SHADOWMAP_CACHE_RETAIN_FRAMES = 120u;
+    // Atlas layers are subdivided into tiles of up to 1/8th of the layer's width.
+    constexpr static const uint32_t PK_SHADOWMAP_ATLAS_LEVELS = 4u;
+    // Packed tile indices store the layer in 8 bits. The last layer is excluded so that no index equals the invalid index.
+    constexpr static const uint32_t PK_SHADOWMAP_ATLAS_MAX_LAYERS = 255u;
+    // A light changes its tile level only once its desired level differs by more than this.
+    constexpr static const float PK_SHADOWMAP_LEVEL_HYSTERESIS = 0.25f;
+
     struct ShadowmapLightTypeData
     {
-        Utilities::Ref<Objects::RenderTexture> SceneRenderTarget = nullptr;
+        Utilities::Ref<Objects::RenderTexture> SceneRenderTargets[PK_SHADOWMAP_ATLAS_LEVELS]{};
         uint32_t BlurPass0 = 0u;
         uint32_t BlurPass1 = 0u;
         uint32_t TileCount = 0u;
@@ -29,8 +41,35 @@ namespace PK::Rendering::Passes
         uint32_t count = 0u;
         uint32_t batchGroup = 0u;
         Structs::LightType batchType = Structs::LightType::TypeCount;
+        uint32_t batchLevel = 0u;
         float maxDepthRange = 0.0f;
         ShadowBlurAmounts shadowBlurAmounts{};
+        // Atlas tile of each light in the batch.
+        Utilities::QuadtreeNode tiles[Structs::PK_SHADOW_CASCADE_COUNT]{};
+    };
+
+    // Atlas tile of a shadow casting light & a hash of the light & casters it was last rendered with.
+    // Directional lights occupy whole consecutive layers, one per cascade.
+    struct ShadowmapCacheEntry
+    {
+        uint64_t signature = 0ull;
+        Utilities::QuadtreeNode tile{};
+        uint32_t tileCount = 0u;
+        uint32_t lastVisibleFrame = 0u;
+        float importance = 0.0f;
+    };
+
+    // Cpu light assignment timings. Sampled on the lights & view of the last frame regardless of the active path.
+    struct LightAssignmentStats
+    {
+        uint32_t lightCount = 0u;
+        uint32_t listCount = 0u;
+        uint32_t sampleCount = 0u;
+        float minMilliseconds = 0.0f;
+        float averageMilliseconds = 0.0f;
+        // Build time of the last frame. Only measured while the cpu path is active.
+        float frameMilliseconds = 0.0f;
+        bool isCPUActive = false;
     };
 
     class PassLights : public Utilities::NoCopy
@@ -46,34 +85,62 @@ namespace PK::Rendering::Passes
             PassLights(Core::Services::AssetDatabase* assetDatabase, 
                        ECS::EntityDatabase* entityDb, 
                        Core::Services::Sequencer* sequencer, 
+                       Core::Services::JobSystem* jobSystem,
                        Batcher* batcher, 
                        const Core::ApplicationConfig* config);
             void Cull(void* engineRoot, ECS::Tokens::VisibilityList* visibilityList, const Math::float4x4& viewProjection, float znear, float zfar);
             void RenderShadows(Objects::CommandBuffer* cmd);
-            void ComputeClusters(Objects::CommandBuffer* cmd);
+            void ComputeClusters(Objects::CommandBuffer* cmd, const Math::float4x4& view, const Math::float4x4& inverseProjection, float znear, float zfar);
             ShadowCascades GetCascadeZSplits(float znear, float zfar) const;
+            LightAssignmentStats MeasureLightAssignment(uint32_t sampleCount);
         
         private:
+            struct ShadowmapRequest
+            {
+                ECS::EntityViews::LightRenderableView* view;
+                ShadowmapCacheEntry* entry;
+                uint32_t index;
+            };
+
             void BuildShadowmapBatches(void* engineRoot, 
                                        ECS::Tokens::CullTokens* tokens, 
                                        ECS::EntityViews::LightRenderableView* view, 
+                                       ShadowmapCacheEntry* cacheEntry,
                                        uint32_t index, 
                                        const Math::float4x4& inverseViewProjection);
 
+            void AllocateShadowmapTiles();
+            bool AllocateShadowmapTile(ShadowmapCacheEntry* entry, uint32_t tileCount, uint32_t level);
+            bool GrowShadowmapAtlas();
+            void ReleaseShadowmapTile(ShadowmapCacheEntry* entry);
+
             ECS::EntityDatabase* m_entityDb = nullptr;
             Core::Services::Sequencer* m_sequencer = nullptr;
+            Core::Services::JobSystem* m_jobSystem = nullptr;
             Batcher* m_batcher = nullptr;
+            LightClusterBuilder m_clusterBuilder;
             Objects::Shader* m_computeLightAssignment = nullptr;
             Objects::Shader* m_shadowmapBlur = nullptr;
             float m_cascadeLinearity;
             uint32_t m_shadowmapCubeFaceSize;
             uint32_t m_shadowmapTileSize;
-            uint32_t m_shadowmapCount;
+            uint32_t m_shadowmapMaxLayers;
             uint32_t m_projectionCount;
             uint32_t m_lightCount;
+            uint32_t m_frameIndex = 0u;
+            bool m_useCPULightAssignment = false;
+            Math::float4x4 m_clusterView = Math::PK_FLOAT4X4_IDENTITY;
+            Math::float4x4 m_clusterInverseProjection = Math::PK_FLOAT4X4_IDENTITY;
+            float m_clusterZNear = 0.0f;
+            float m_clusterZFar = 0.0f;
+            float m_clusterBuildMilliseconds = 0.0f;
             ShadowCascades m_cascadeSplits;
             ShadowmapLightTypeData m_shadowmapTypeData[(int)Structs::LightType::TypeCount];
             std::vector<ShadowbatchInfo> m_shadowBatches;
+            std::vector<Objects::CommandBuffer*> m_shadowCommandBuffers;
+            std::unordered_map<uint32_t, ShadowmapCacheEntry> m_shadowmapCache;
+            std::vector<ShadowmapRequest> m_shadowRequests;
+            Utilities::QuadtreeAllocator m_shadowmapAllocator;
             Utilities::MemoryBlock<ECS::EntityViews::LightRenderableView*> m_lights;
             Utilities::Ref<Objects::Buffer> m_lightsBuffer;
             Utilities::Ref<Objects::Buffer> m_lightMatricesBuffer;
@@ -81,6 +148,7 @@ namespace PK::Rendering::Passes
             Utilities::Ref<Objects::Buffer> m_globalLightsList;
             Utilities::Ref<Objects::Buffer> m_globalLightIndex;
             Utilities::Ref<Objects::Texture> m_lightTiles;      
+            Utilities::Ref<Objects::Buffer> m_lightTilesUpload;
             Utilities::Ref<Objects::Texture> m_shadowmaps;        
     };
 }
\ No newline at end of file
@@ -25,17 +25,25 @@ namespace PK::Rendering::Passes
         descr.format = TextureFormat::RGBA16F;
         descr.sampler.filterMin = FilterMode::Trilinear;
         descr.sampler.filterMag = FilterMode::Trilinear;
-        descr.sampler.wrap[0] = WrapMode::Border;
-        descr.sampler.wrap[1] = WrapMode::Border;
-        descr.sampler.wrap[2] = WrapMode::Border;
+        descr.sampler.wrap[0] = WrapMode::Repeat;
+        descr.sampler.wrap[1] = WrapMode::Repeat;
+        descr.sampler.wrap[2] = WrapMode::Repeat;
         descr.sampler.borderColor = BorderColor::FloatClear;
-        descr.sampler.mipMax = 6.0f;
-        descr.resolution = { 256u, 128u, 256u };
-        descr.levels = 7u;
+        descr.sampler.mipMax = (float)(PK_GI_CLIPMAP_MIP_LEVELS - 1u);
+        descr.resolution = { PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION };
+        descr.levels = PK_GI_CLIPMAP_MIP_LEVELS;
         descr.usage = TextureUsage::Sample | TextureUsage::Storage;
-        m_voxels = Texture::Create(descr, "GI.VoxelVolume");
+
+        m_voxelLevels = BindArray<Texture>::Create(PK_GI_CLIPMAP_LEVELS);
+
+        for (auto i = 0u; i < PK_GI_CLIPMAP_LEVELS; ++i)
+        {
+            m_voxels[i] = Texture::Create(descr, ("GI.VoxelVolume" + std::to_string(i)).c_str());
+            m_voxelLevels->Add(m_voxels[i].get());
+        }
 
         descr.format = TextureFormat::R8UI;
+        descr.resolution.y = PK_GI_CLIPMAP_RESOLUTION * PK_GI_CLIPMAP_LEVELS;
         descr.sampler.borderColor = BorderColor::IntClear;
         descr.levels = 1u;
         descr.sampler.mipMax = 0.0f;
@@ -72,27 +80,28 @@ namespace PK::Rendering::Passes
         auto hash = HashCache::Get();
         m_parameters = CreateRef<ConstantBuffer>(BufferLayout(
         {
-            { ElementType::Float4, hash->pk_SceneGI_ST },
+            { ElementType::Int4, hash->pk_SceneGI_ClipmapOrigins, PK_GI_CLIPMAP_LEVELS },
+            { ElementType::Int4, hash->pk_SceneGI_ClipmapScroll, PK_GI_CLIPMAP_LEVELS },
             { ElementType::Uint4, hash->pk_SceneGI_Swizzle },
             { ElementType::Int4, hash->pk_SceneGI_Checkerboard_Offset },
             { ElementType::Float, hash->pk_SceneGI_VoxelSize },
             { ElementType::Float, hash->pk_SceneGI_LuminanceGain },
             { ElementType::Float, hash->pk_SceneGI_ChrominanceGain },
+            { ElementType::Uint, hash->pk_SceneGI_VoxelizeLevel },
         }), "GI.Parameters");
 
-        m_parameters->Set<float4>(hash->pk_SceneGI_ST, float4(-76.8f, -6.0f, -76.8f, 1.0f / 0.6f));
-        m_parameters->Set<float>(hash->pk_SceneGI_VoxelSize, 0.6f);
+        m_parameters->Set<float>(hash->pk_SceneGI_VoxelSize, PK_GI_CLIPMAP_VOXEL_SIZE);
         m_parameters->Set<float>(hash->pk_SceneGI_LuminanceGain, 1.0f);
         m_parameters->Set<float>(hash->pk_SceneGI_ChrominanceGain, 3.0f);
 
         GraphicsAPI::SetBuffer(hash->pk_SceneGI_Params, m_parameters->GetBuffer());
         GraphicsAPI::SetImage(hash->pk_SceneGI_VolumeMaskWrite, m_voxelMask.get());
-        GraphicsAPI::SetImage(hash->pk_SceneGI_VolumeWrite, m_voxels.get());
-        GraphicsAPI::SetTexture(hash->pk_SceneGI_VolumeRead, m_voxels.get());
+        GraphicsAPI::SetImage(hash->pk_SceneGI_VolumeWrite, m_voxels[0].get());
+        GraphicsAPI::SetTextureArray(hash->pk_SceneGI_VolumeRead, m_voxelLevels.get());
         GraphicsAPI::SetImage(hash->pk_ScreenGI_Hits, m_screenSpaceRayhits.get());
     }
 
-    void PassSceneGI::PreRender(CommandBuffer* cmd, const uint3& resolution)
+    void PassSceneGI::PreRender(CommandBuffer* cmd, const uint3& resolution, const float3& viewOrigin)
     {
         auto hash = HashCache::Get();
 
@@ -117,22 +126,67 @@ namespace PK::Rendering::Passes
              { 1u, 2u, 0u, 0u },
         };
 
-        m_rasterAxis = (m_rasterAxis + 1) % 3;
+        m_scrollLevelMask = 0u;
+
+        for (auto i = 0u; i < PK_GI_CLIPMAP_LEVELS; ++i)
+        {
+            auto voxelSize = PK_GI_CLIPMAP_VOXEL_SIZE * (float)(1u << i);
+            auto center = glm::floor(viewOrigin / (voxelSize * PK_GI_CLIPMAP_SNAP));
+            auto origin = int4(int3(center) * PK_GI_CLIPMAP_SNAP - (int32_t)(PK_GI_CLIPMAP_RESOLUTION / 2u), 0);
+
+            // An invalid clipmap is cleared entirely by scrolling it by its full resolution.
+            m_clipmapScroll[i] = m_isClipmapValid ? origin - m_clipmapOrigins[i] : int4((int32_t)PK_GI_CLIPMAP_RESOLUTION);
+            m_clipmapOrigins[i] = origin;
+
+            if (m_clipmapScroll[i] != PK_INT4_ZERO)
+            {
+                m_scrollLevelMask |= 1u << i;
+            }
+        }
+
+        m_isClipmapValid = true;
+        m_voxelizeLevel = (m_frameIndex & 1u) == 0u ? 0u : 1u + (m_frameIndex >> 1u) % (PK_GI_CLIPMAP_LEVELS - 1u);
+        m_rasterAxes[m_voxelizeLevel] = (m_rasterAxes[m_voxelizeLevel] + 1) % 3;
         m_checkerboardIndex = (m_checkerboardIndex + 1) % 4;
+        m_frameIndex++;
 
-        m_parameters->Set<uint4>(hash->pk_SceneGI_Swizzle, swizzles[m_rasterAxis]);
+        GraphicsAPI::SetImage(hash->pk_SceneGI_VolumeWrite, m_voxels[m_voxelizeLevel].get());
+
+        m_parameters->Set<int4>(hash->pk_SceneGI_ClipmapOrigins, m_clipmapOrigins, PK_GI_CLIPMAP_LEVELS);
+        m_parameters->Set<int4>(hash->pk_SceneGI_ClipmapScroll, m_clipmapScroll, PK_GI_CLIPMAP_LEVELS);
+        m_parameters->Set<uint32_t>(hash->pk_SceneGI_VoxelizeLevel, m_voxelizeLevel);
+        m_parameters->Set<uint4>(hash->pk_SceneGI_Swizzle, swizzles[m_rasterAxes[m_voxelizeLevel]]);
         m_parameters->Set<int4>(hash->pk_SceneGI_Checkerboard_Offset, { m_checkerboardIndex / 2, m_checkerboardIndex % 2, 0, 0 });
         m_parameters->FlushBuffer(QueueType::Transfer);
     }
 
     void PassSceneGI::PruneVoxels(Objects::CommandBuffer* cmd)
     {
+        auto hash = HashCache::Get();
+
+        if (m_scrollLevelMask != 0u)
+        {
+            cmd->BeginDebugScope("SceneGI.ScrollVoxels", PK_COLOR_GREEN);
+
+            for (auto i = 0u; i < PK_GI_CLIPMAP_LEVELS; ++i)
+            {
+                if (m_scrollLevelMask & (1u << i))
+                {
+                    GraphicsAPI::SetImage(hash->_DestinationTex, m_voxels[i].get(), 0, 0);
+                    GraphicsAPI::SetConstant<uint32_t>(hash->pk_SceneGI_ScrollLevel, i);
+                    cmd->Dispatch(m_computeClear, 1, { PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION });
+                }
+            }
+
+            cmd->EndDebugScope();
+        }
+
         // Clear transparencies every axis cycle
-        if (m_rasterAxis == 0)
+        if (m_rasterAxes[m_voxelizeLevel] == 0)
         {
             cmd->BeginDebugScope("SceneGI.PruneVoxels", PK_COLOR_GREEN);
-            GraphicsAPI::SetImage(HashCache::Get()->_DestinationTex, m_voxels.get(), 0, 0);
-            cmd->Dispatch(m_computeClear, m_voxels->GetResolution());
+            GraphicsAPI::SetImage(hash->_DestinationTex, m_voxels[m_voxelizeLevel].get(), 0, 0);
+            cmd->Dispatch(m_computeClear, 0, { PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION });
             cmd->EndDebugScope();
         }
     }
@@ -166,27 +220,32 @@ namespace PK::Rendering::Passes
 
         cmd->BeginDebugScope("SceneGI.Voxelize", PK_COLOR_GREEN);
 
-        auto volres = m_voxels->GetResolution();
-
-        uint4 viewports[3] =
-        {
-            {0u, 0u, volres.x, volres.z },
-            {0u, 0u, volres.x, volres.y },
-            {0u, 0u, volres.y, volres.z },
-        };
+        auto viewport = uint4(0u, 0u, PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION);
 
-        cmd->SetRenderTarget({ viewports[m_rasterAxis].z, viewports[m_rasterAxis].w, 1 });
-        cmd->SetViewPort(viewports[m_rasterAxis]);
-        cmd->SetScissor(viewports[m_rasterAxis]);
+        cmd->SetRenderTarget({ PK_GI_CLIPMAP_RESOLUTION, PK_GI_CLIPMAP_RESOLUTION, 1 });
+        cmd->SetViewPort(viewport);
+        cmd->SetScissor(viewport);
 
         batcher->Render(cmd, batchGroup, &m_voxelizeAttribs, hash->PK_META_PASS_GIVOXELIZE);
 
-        GraphicsAPI::SetTexture(hash->_SourceTex, m_voxels.get());
+        auto dirtyLevelMask = m_scrollLevelMask | (1u << m_voxelizeLevel);
 
-        for (auto i = 1u; i < m_voxels->GetLevels(); ++i)
+        for (auto i = 0u; i < PK_GI_CLIPMAP_LEVELS; ++i)
         {
-            GraphicsAPI::SetImage(hash->_DestinationTex, m_voxels.get(), i, 0);
-            cmd->Dispatch(m_computeMipmap, 0, { volres.x >> i, volres.y >> i, volres.z >> i });
+            if ((dirtyLevelMask & (1u << i)) == 0u)
+            {
+                continue;
+            }
+
+            auto volume = m_voxels[i].get();
+            auto volres = volume->GetResolution();
+            GraphicsAPI::SetTexture(hash->_SourceTex, volume);
+
+            for (auto j = 1u; j < volume->GetLevels(); ++j)
+            {
+                GraphicsAPI::SetImage(hash->_DestinationTex, volume, j, 0);
+                cmd->Dispatch(m_computeMipmap, 0, { volres.x >> j, volres.y >> j, volres.z >> j });
+            }
         }
 
         cmd->EndDebugScope();
@@ -4,16 +4,29 @@
 #include "Rendering/Objects/RenderTexture.h"
 #include "Rendering/Objects/ConstantBuffer.h"
 #include "Rendering/Objects/Shader.h"
+#include "Rendering/Objects/BindArray.h"
 #include "Rendering/Objects/ShaderBindingTable.h"
 #include "Rendering/Services/Batcher.h"
 
 namespace PK::Rendering::Passes
 {
+    constexpr static const uint32_t PK_GI_CLIPMAP_LEVELS = 4u;
+    constexpr static const uint32_t PK_GI_CLIPMAP_RESOLUTION = 128u;
+    // Level origins move in steps of this many voxels. Keeps the mips of the level aligned to their parent voxels.
+    constexpr static const int32_t PK_GI_CLIPMAP_SNAP = 8;
+    constexpr static const uint32_t PK_GI_CLIPMAP_MIP_LEVELS = 4u;
+    constexpr static const float PK_GI_CLIPMAP_VOXEL_SIZE = 0.6f;
+
+    /*
+     * Scene voxels are stored in a clipmap centered on the camera. Each level has a volume of its own that wraps on all axes.
+     * Levels are addressed toroidally so that only voxels newly exposed by scrolling need to be cleared & revoxelized.
+     * One level is voxelized per frame. The first level is voxelized every other frame & the rest in turns.
+     */
     class PassSceneGI : public PK::Utilities::NoCopy
     {
         public:
             PassSceneGI(Core::Services::AssetDatabase* assetDatabase, const Core::ApplicationConfig* config);
-            void PreRender(Objects::CommandBuffer* cmd, const Math::uint3& resolution);
+            void PreRender(Objects::CommandBuffer* cmd, const Math::uint3& resolution, const Math::float3& viewOrigin);
             void PruneVoxels(Objects::CommandBuffer* cmd);
             void DispatchRays(Objects::CommandBuffer* cmd);
             void RenderVoxels(Objects::CommandBuffer* cmd, Batcher* batcher, uint32_t batchGroup);
@@ -29,13 +42,21 @@ namespace PK::Rendering::Passes
             Objects::Shader* m_rayTraceGatherGI = nullptr;
             Objects::ShaderBindingTable m_shaderBindingTable;
             Utilities::Ref<Objects::ConstantBuffer> m_parameters;
-            Utilities::Ref<Objects::Texture> m_voxels;
+            Utilities::Ref<Objects::Texture> m_voxels[PK_GI_CLIPMAP_LEVELS];
+            Utilities::Ref<Objects::BindArray<Objects::Texture>> m_voxelLevels;
             Utilities::Ref<Objects::Texture> m_voxelMask;
             Utilities::Ref<Objects::Texture> m_screenSpaceSHY;
             Utilities::Ref<Objects::Texture> m_screenSpaceCoCg;
             Utilities::Ref<Objects::Texture> m_screenSpaceMeta;
             Utilities::Ref<Objects::Texture> m_screenSpaceRayhits;
+            Math::int4 m_clipmapOrigins[PK_GI_CLIPMAP_LEVELS]{};
+            Math::int4 m_clipmapScroll[PK_GI_CLIPMAP_LEVELS]{};
+            int32_t m_rasterAxes[PK_GI_CLIPMAP_LEVELS]{};
+            // Levels that scrolled this frame. Their mips are rebuilt along with the voxelized level.
+            uint32_t m_scrollLevelMask = 0u;
+            uint32_t m_voxelizeLevel = 0u;
+            uint32_t m_frameIndex = 0u;
             uint32_t m_checkerboardIndex = 0u;
-            int32_t m_rasterAxis = 0;
+            bool m_isClipmapValid = false;
     };
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "PrecompiledHeader.h"
 #include "Core/Services/Log.h"
+#include "Core/Services/Profiler.h"
 #include "RenderPipeline.h"
 #include "Rendering/MeshUtility.h"
 #include "Rendering/HashCache.h"
@@ -17,18 +18,18 @@ namespace PK::Rendering
     using namespace Objects;
     using namespace Structs;
 
-    RenderPipeline::RenderPipeline(AssetDatabase* assetDatabase, EntityDatabase* entityDb, Sequencer* sequencer, ApplicationConfig* config) :
+    RenderPipeline::RenderPipeline(AssetDatabase* assetDatabase, EntityDatabase* entityDb, Sequencer* sequencer, JobSystem* jobSystem, ApplicationConfig* config) :
         m_passPostEffectsComposite(assetDatabase, config),
-        m_passGeometry(entityDb, sequencer, &m_batcher),
-        m_passLights(assetDatabase, entityDb, sequencer, &m_batcher, config),
+        m_passGeometry(entityDb, sequencer, jobSystem, &m_batcher),
+        m_passLights(assetDatabase, entityDb, sequencer, jobSystem, &m_batcher, config),
         m_passSceneGI(assetDatabase, config),
         m_passVolumeFog(assetDatabase, config),
         m_passFilmGrain(assetDatabase),
-        m_depthOfField(assetDatabase, config),
+        m_depthOfField(assetDatabase, &m_renderGraph, config),
         m_temporalAntialiasing(assetDatabase, config->InitialWidth, config->InitialHeight),
-        m_bloom(assetDatabase, config->InitialWidth, config->InitialHeight),
+        m_bloom(assetDatabase, &m_renderGraph),
         m_histogram(assetDatabase),
-        m_batcher(),
+        m_batcher(jobSystem),
         m_sequencer(sequencer),
         m_visibilityList(1024)
     {
@@ -138,6 +139,8 @@ namespace PK::Rendering
         GraphicsAPI::SetBuffer(hash->pk_PerFrameConstants, *m_constantsPerFrame.get());
         GraphicsAPI::SetBuffer(hash->pk_PostEffectsParams, *m_constantsPostProcess.get());
 
+        BuildRenderGraph();
+
         PK_LOG_HEADER("----------RENDER PIPELINE INITIALIZED----------");
     }
 
@@ -163,10 +166,12 @@ namespace PK::Rendering
 
         // Nonnjittered projection matrix;
         m_viewProjectionMatrix = token->projection * token->view;
+        m_lodSizePerDepth = 1.0f / glm::abs(token->projection[1][1]);
 
         token->projection = Functions::GetPerspectiveJittered(token->projection, jitter);
 
         auto cameraMatrix = glm::inverse(token->view);
+        m_viewOrigin = float3(cameraMatrix[3]);
 
         auto n = Functions::GetZNearFromProj(token->projection);
         auto f = Functions::GetZFarFromProj(token->projection);
@@ -211,12 +216,14 @@ namespace PK::Rendering
 
     void RenderPipeline::Step(Window* window, int condition)
     {
+        PK_PROFILE_FUNCTION();
         auto hash = HashCache::Get();
         auto queues = GraphicsAPI::GetQueues();
         auto resolution = window->GetResolution();
 
         m_renderTarget->Validate(resolution);
         m_renderTargetPrevious->Validate(resolution);
+        m_renderGraph.SetResolution(resolution);
 
         GraphicsAPI::SetTexture(hash->pk_ScreenDepthCurrent, m_renderTarget->GetDepth());
         GraphicsAPI::SetTexture(hash->pk_ScreenNormalsCurrent, m_renderTarget->GetColor(1));
@@ -228,98 +235,15 @@ namespace PK::Rendering
         m_constantsPerFrame->Set<float4>(hash->pk_ShadowCascadeZSplits, reinterpret_cast<float4*>(cascadeZSplits.planes));
         m_constantsPerFrame->Set<float4>(hash->pk_ScreenParams, { (float)resolution.x, (float)resolution.y, 1.0f / (float)resolution.x, 1.0f / (float)resolution.y });
         m_constantsPerFrame->Set<uint4>(hash->pk_ScreenSize, { resolution.x, resolution.y, 0u, 0u });
-        m_constantsPerFrame->FlushBuffer(QueueType::Transfer);
-
-        auto cmdtransfer = queues->GetCommandBuffer(QueueType::Transfer);
-        m_passSceneGI.PreRender(cmdtransfer, resolution);
-
-        m_batcher.BeginCollectDrawCalls();
-        m_passGeometry.Cull(this, &m_visibilityList, m_viewProjectionMatrix, m_zfar - m_znear);
-        m_passLights.Cull(this, &m_visibilityList, m_viewProjectionMatrix, m_znear, m_zfar);
-        m_batcher.EndCollectDrawCalls(cmdtransfer);
-
-        auto* cmdgraphics = queues->GetCommandBuffer(QueueType::Graphics);
-        auto* cmdcompute = queues->GetCommandBuffer(QueueType::Compute);
 
-        // Prune voxels & build AS.
-        // These can happen before the end of last frame. 
-        m_passSceneGI.PruneVoxels(cmdcompute);
-        Tokens::AccelerationStructureBuildToken token{ QueueType::Compute, m_sceneStructure.get(), RenderableFlags::DefaultMesh, {}, false };
-        m_sequencer->Next<Tokens::AccelerationStructureBuildToken>(this, &token);
-        GraphicsAPI::SetAccelerationStructure(hash->pk_SceneStructure, m_sceneStructure.get());
-        queues->Submit(QueueType::Compute, &cmdcompute);
-
-        // End transfer operations
-        queues->Sync(QueueType::Graphics, QueueType::Transfer, -1);
-        queues->Submit(QueueType::Transfer);
-        queues->Sync(QueueType::Transfer, QueueType::Graphics);
-        queues->Sync(QueueType::Transfer, QueueType::Compute);
+        m_renderGraph.Execute(queues);
 
         // Only buffering needs to wait for previous results.
         // Eliminate redundant rendering waits by waiting for transfer instead.
         window->SetFrameFence(queues->GetFenceRef(QueueType::Transfer));
 
-        // Concurrent Shadows & gbuffer
-        cmdgraphics->SetRenderTarget(m_renderTarget.get(), { 1 }, true, true);
-        cmdgraphics->ClearColor(PK_COLOR_CLEAR, 0);
-        cmdgraphics->ClearDepth(1.0f, 0u);
-        m_passGeometry.RenderGBuffer(cmdgraphics);
-        queues->Submit(QueueType::Graphics, &cmdgraphics);
-
-        m_passFilmGrain.Compute(cmdcompute);
-        m_passLights.ComputeClusters(cmdcompute);
-        queues->Submit(QueueType::Compute, &cmdcompute);
-        queues->Sync(QueueType::Graphics, QueueType::Compute);
-
-        // Depth tiles for volume fog filtering
-        m_passSceneGI.DispatchRays(cmdcompute);
-        m_passVolumeFog.ComputeDepthTiles(cmdcompute, m_renderTarget->GetResolution());
-        queues->Submit(QueueType::Compute, &cmdcompute);
-
-        // Voxelize, subsequent passes depend on this
-        m_passLights.RenderShadows(cmdgraphics);
-        queues->Submit(QueueType::Graphics, &cmdgraphics);
-        // Wait for light list build instead of depth tile pass
-        queues->Sync(QueueType::Compute, QueueType::Graphics, -1);
-
-        // Voxelize scene
-        m_passSceneGI.RenderVoxels(cmdgraphics, &m_batcher, m_passGeometry.GetPassGroup());
-        queues->Submit(QueueType::Graphics, &cmdgraphics);
-        queues->Sync(QueueType::Graphics, QueueType::Compute);
-        queues->Sync(QueueType::Compute, QueueType::Graphics);
-
-        // Forward Opaque on graphics queue
-        m_passSceneGI.RenderGI(cmdgraphics);
-        cmdgraphics->SetRenderTarget(m_renderTarget.get(), { 0 }, true, true);
-        cmdgraphics->ClearColor(PK_COLOR_CLEAR, 0);
-        m_passGeometry.RenderForward(cmdgraphics);
-        cmdgraphics->Blit(m_OEMBackgroundShader);
-        queues->Submit(QueueType::Graphics, &cmdgraphics);
-
-        // Compute voxel volumes on async queue
-        m_passVolumeFog.Compute(cmdcompute);
-        queues->Submit(QueueType::Compute, &cmdcompute);
-        queues->Sync(QueueType::Compute, QueueType::Graphics);
-
-        // Forward Transparent on graphics queue
-        m_passVolumeFog.Render(cmdgraphics, m_renderTarget.get());
-
-        // @TODO Add trasparent forward stuff here
-
-        // Cache forward output of current frame
-        cmdgraphics->Blit(m_renderTarget->GetColor(0u), m_renderTargetPrevious->GetColor(0u), {}, {}, FilterMode::Point);
-
-        // Post Effects
-        cmdgraphics->BeginDebugScope("PostEffects", PK_COLOR_YELLOW);
-        m_temporalAntialiasing.Render(cmdgraphics, m_renderTarget.get());
-        m_depthOfField.Render(cmdgraphics, m_renderTarget.get());
-        m_bloom.Render(cmdgraphics, m_renderTarget.get());
-        m_histogram.Render(cmdgraphics, m_bloom.GetTexture());
-        m_passPostEffectsComposite.Render(cmdgraphics, m_renderTarget.get());
-        cmdgraphics->EndDebugScope();
-        queues->Submit(QueueType::Graphics, &cmdgraphics);
-
         // Blit to window
+        auto cmdgraphics = queues->GetCommandBuffer(QueueType::Graphics);
         cmdgraphics->Blit(m_renderTarget->GetDepth(), m_renderTargetPrevious->GetDepth(), {}, {}, FilterMode::Point);
         cmdgraphics->Blit(m_renderTarget->GetColor(1), m_renderTargetPrevious->GetColor(1), {}, {}, FilterMode::Point);
         cmdgraphics->Blit(m_renderTarget->GetColor(0), window, FilterMode::Bilinear);
@@ -371,4 +295,175 @@ namespace PK::Rendering
         m_depthOfField.OnUpdateParameters(config);
         m_passVolumeFog.OnUpdateParameters(config);
     }
+
+    void RenderPipeline::Step(TokenConsoleCommand* token)
+    {
+        if (token->isConsumed)
+        {
+            return;
+        }
+
+        if (token->argument == "query_lightassignment")
+        {
+            token->isConsumed = true;
+
+            auto stats = m_passLights.MeasureLightAssignment(16u);
+            PK_LOG_HEADER("----------LIGHT ASSIGNMENT INFO----------");
+            PK_LOG_NEWLINE();
+            PK_LOG_INFO("Active path: %s, Lights: %i, List entries: %i", stats.isCPUActive ? "CPU" : "GPU", stats.lightCount, stats.listCount);
+            PK_LOG_INFO("CPU build over %i samples: %.3fms min, %.3fms average", stats.sampleCount, stats.minMilliseconds, stats.averageMilliseconds);
+
+            if (stats.isCPUActive)
+            {
+                PK_LOG_INFO("CPU build last frame: %.3fms", stats.frameMilliseconds);
+            }
+
+            PK_LOG_NEWLINE();
+            return;
+        }
+
+        if (token->argument != "query_rendergraph")
+        {
+            return;
+        }
+
+        token->isConsumed = true;
+
+        auto& stats = m_renderGraph.GetStats();
+        PK_LOG_HEADER("----------RENDER GRAPH INFO----------");
+        PK_LOG_NEWLINE();
+        PK_LOG_INFO("Passes: %i, Resources: %i", stats.passCount, stats.resourceCount);
+        PK_LOG_INFO("Compiles: %i, Last compile: %.3fms", stats.compileCount, stats.compileMilliseconds);
+        PK_LOG_INFO("Barrier hazards: %i, Cross queue dependencies: %i", stats.barrierCount, stats.dependencyCount);
+        PK_LOG_INFO("Transients: %i, Aliased: %i", stats.transientCount, stats.aliasedCount);
+        PK_LOG_INFO("Transient memory: %s, Peak: %s, Heap: %s", 
+            Functions::BytesToString(stats.transientBytes).c_str(),
+            Functions::BytesToString(stats.peakTransientBytes).c_str(),
+            Functions::BytesToString(stats.heapBytes).c_str());
+        PK_LOG_INFO("Last frame submits: %i, Syncs: %i, Redundant syncs: %i", stats.frameSubmitCount, stats.frameSyncCount, stats.frameRedundantSyncCount);
+        PK_LOG_NEWLINE();
+    }
+
+    void RenderPipeline::BuildRenderGraph()
+    {
+        auto graph = &m_renderGraph;
+
+        // Per frame constants, batches & other uploads recorded on the transfer queue.
+        auto sceneData = graph->Import("SceneData");
+        // Accessed asynchronously to the previous frame like before. Voxel pruning & the acceleration structure build can overlap the end of the last frame.
+        auto sceneStructure = graph->Import("SceneStructure", true);
+        auto voxels = graph->Import("SceneGI.Voxels", true);
+        auto rays = graph->Import("SceneGI.Rays", true);
+        auto gbuffer = graph->Import("GBuffer", true);
+        auto filmGrain = graph->Import("FilmGrain", true);
+        auto lightClusters = graph->Import("LightClusters", true);
+        auto shadowmaps = graph->Import("Shadowmaps", true);
+        auto depthTiles = graph->Import("VolumeFog.DepthTiles", true);
+        auto fogVolumes = graph->Import("VolumeFog.Volumes", true);
+        auto color = graph->Import("SceneColor", true);
+        auto histogram = graph->Import("Histogram", true);
+        auto bloom = m_bloom.GetTextureResource();
+        auto depthOfField = m_depthOfField.GetTextureResource();
+
+        graph->AddPass("Pass.Cull", QueueType::Transfer, {}, { sceneData }, [this](CommandBuffer* cmd)
+        {
+            m_constantsPerFrame->FlushBuffer(QueueType::Transfer);
+            m_passSceneGI.PreRender(cmd, m_renderTarget->GetResolution(), m_viewOrigin);
+            m_batcher.BeginCollectDrawCalls();
+            m_passGeometry.Cull(this, &m_visibilityList, m_viewProjectionMatrix, m_viewOrigin, m_zfar - m_znear, m_lodSizePerDepth);
+            m_passLights.Cull(this, &m_visibilityList, m_viewProjectionMatrix, m_znear, m_zfar);
+            m_batcher.EndCollectDrawCalls(cmd);
+        });
+
+        graph->AddPass("Pass.AccelerationStructure", QueueType::Compute, {}, { sceneStructure, voxels }, [this](CommandBuffer* cmd)
+        {
+            m_passSceneGI.PruneVoxels(cmd);
+            Tokens::AccelerationStructureBuildToken token{ QueueType::Compute, m_sceneStructure.get(), RenderableFlags::DefaultMesh, {}, false };
+            m_sequencer->Next<Tokens::AccelerationStructureBuildToken>(this, &token);
+            GraphicsAPI::SetAccelerationStructure(HashCache::Get()->pk_SceneStructure, m_sceneStructure.get());
+        });
+
+        graph->AddPass("Pass.GBuffer", QueueType::Graphics, { sceneData }, { gbuffer }, [this](CommandBuffer* cmd)
+        {
+            cmd->SetRenderTarget(m_renderTarget.get(), { 1 }, true, true);
+            cmd->ClearColor(PK_COLOR_CLEAR, 0);
+            cmd->ClearDepth(1.0f, 0u);
+            m_passGeometry.RenderGBuffer(cmd);
+        });
+
+        graph->AddPass("Pass.LightClusters", QueueType::Compute, { sceneData }, { filmGrain, lightClusters }, [this](CommandBuffer* cmd)
+        {
+            auto hash = HashCache::Get();
+            float4x4 view, inverseProjection;
+            m_constantsPerFrame->TryGet(hash->pk_MATRIX_V, view);
+            m_constantsPerFrame->TryGet(hash->pk_MATRIX_I_P, inverseProjection);
+            m_passFilmGrain.Compute(cmd);
+            m_passLights.ComputeClusters(cmd, view, inverseProjection, m_znear, m_zfar);
+        });
+
+        // Depth tiles for volume fog filtering
+        graph->AddPass("Pass.DepthTiles", QueueType::Compute, { sceneData, sceneStructure, gbuffer }, { rays, depthTiles }, [this](CommandBuffer* cmd)
+        {
+            m_passSceneGI.DispatchRays(cmd);
+            m_passVolumeFog.ComputeDepthTiles(cmd, m_renderTarget->GetResolution());
+        });
+
+        graph->AddPass("Pass.Shadows", QueueType::Graphics, { sceneData }, { shadowmaps }, [this](CommandBuffer* cmd)
+        {
+            m_passLights.RenderShadows(cmd);
+        });
+
+        graph->AddPass("Pass.Voxelize", QueueType::Graphics, { sceneData, lightClusters, shadowmaps }, { voxels }, [this](CommandBuffer* cmd)
+        {
+            m_passSceneGI.RenderVoxels(cmd, &m_batcher, m_passGeometry.GetPassGroup());
+        });
+
+        graph->AddPass("Pass.ForwardOpaque", QueueType::Graphics, { sceneData, lightClusters, shadowmaps, voxels, rays, gbuffer }, { color }, [this](CommandBuffer* cmd)
+        {
+            m_passSceneGI.RenderGI(cmd);
+            cmd->SetRenderTarget(m_renderTarget.get(), { 0 }, true, true);
+            cmd->ClearColor(PK_COLOR_CLEAR, 0);
+            m_passGeometry.RenderForward(cmd);
+            cmd->Blit(m_OEMBackgroundShader);
+        });
+
+        // Compute voxel volumes on async queue
+        graph->AddPass("Pass.VolumeFog", QueueType::Compute, { sceneData, lightClusters, shadowmaps, voxels, depthTiles }, { fogVolumes }, [this](CommandBuffer* cmd)
+        {
+            m_passVolumeFog.Compute(cmd);
+        });
+
+        // @TODO Add trasparent forward stuff here
+        graph->AddPass("Pass.ForwardTransparent", QueueType::Graphics, { sceneData, fogVolumes, gbuffer }, { color }, [this](CommandBuffer* cmd)
+        {
+            m_passVolumeFog.Render(cmd, m_renderTarget.get());
+            // Cache forward output of current frame
+            cmd->Blit(m_renderTarget->GetColor(0u), m_renderTargetPrevious->GetColor(0u), {}, {}, FilterMode::Point);
+        });
+
+        graph->AddPass("Pass.TemporalAntialiasing", QueueType::Graphics, { sceneData, gbuffer }, { color }, [this](CommandBuffer* cmd)
+        {
+            m_temporalAntialiasing.Render(cmd, m_renderTarget.get());
+        });
+
+        graph->AddPass("Pass.DepthOfField", QueueType::Graphics, { sceneData, gbuffer }, { color, depthOfField }, [this](CommandBuffer* cmd)
+        {
+            m_depthOfField.Render(cmd, m_renderTarget.get());
+        });
+
+        graph->AddPass("Pass.Bloom", QueueType::Graphics, { color }, { bloom }, [this](CommandBuffer* cmd)
+        {
+            m_bloom.Render(cmd, m_renderTarget.get());
+        });
+
+        graph->AddPass("Pass.Histogram", QueueType::Graphics, { bloom }, { histogram }, [this](CommandBuffer* cmd)
+        {
+            m_histogram.Render(cmd, m_bloom.GetTexture());
+        });
+
+        graph->AddPass("Pass.PostEffectsComposite", QueueType::Graphics, { sceneData, filmGrain, bloom, histogram }, { color }, [this](CommandBuffer* cmd)
+        {
+            m_passPostEffectsComposite.Render(cmd, m_renderTarget.get());
+        });
+    }
 }
\ No newline at end of file
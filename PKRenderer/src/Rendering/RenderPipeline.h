@@ -1,8 +1,10 @@
 #pragma once
 #include "Core/Services/IService.h"
 #include "Core/Services/Sequencer.h"
+#include "Core/Services/JobSystem.h"
 #include "Core/ApplicationConfig.h"
 #include "Core/Window.h"
+#include "Core/ConsoleCommandBinding.h"
 #include "ECS/Contextual/Tokens/ViewProjectionToken.h"
 #include "ECS/Contextual/Tokens/TimeToken.h"
 #include "ECS/Contextual/Tokens/CullingTokens.h"
@@ -15,6 +17,7 @@
 #include "Rendering/Passes/PassDepthOfField.h"
 #include "Rendering/Passes/PassTemporalAntiAliasing.h"
 #include "Rendering/Services/Batcher.h"
+#include "Rendering/Services/RenderGraph.h"
 
 namespace PK::Rendering
 {
@@ -22,12 +25,14 @@ namespace PK::Rendering
                            public Core::Services::IStep<PK::ECS::Tokens::ViewProjectionUpdateToken>,
                            public Core::Services::IStep<PK::ECS::Tokens::TimeToken>,
                            public Core::Services::IConditionalStep<Core::Window>,
-                           public Core::Services::IStep<Core::Services::AssetImportToken<Core::ApplicationConfig>>
+                           public Core::Services::IStep<Core::Services::AssetImportToken<Core::ApplicationConfig>>,
+                           public Core::Services::IStep<Core::TokenConsoleCommand>
     {
         public:
             RenderPipeline(Core::Services::AssetDatabase* assetDatabase, 
                            ECS::EntityDatabase* entityDb, 
                            Core::Services::Sequencer* sequencer, 
+                           Core::Services::JobSystem* jobSystem,
                            Core::ApplicationConfig* config);
 
             ~RenderPipeline();
@@ -36,8 +41,17 @@ namespace PK::Rendering
             void Step(PK::ECS::Tokens::TimeToken* token) override final;
             void Step(Core::Window* window, int condition) override final;
             void Step(Core::Services::AssetImportToken<Core::ApplicationConfig>* token) override final;
+            void Step(Core::TokenConsoleCommand* token) override final;
+
+            // Lit scene color of the last rendered frame before post effects.
+            inline Objects::Texture* GetSceneColorHDR() const { return m_renderTargetPrevious->GetColor(0u); }
 
         private:
+            void BuildRenderGraph();
+
+            // Declared first as passes create their transient textures in it.
+            RenderGraph m_renderGraph;
+
             Passes::PassGeometry m_passGeometry;
             Passes::PassLights m_passLights;
             Passes::PassSceneGI m_passSceneGI;
@@ -62,6 +76,9 @@ namespace PK::Rendering
 
             ECS::Tokens::VisibilityList m_visibilityList;
             Math::float4x4 m_viewProjectionMatrix;
+            Math::float3 m_viewOrigin;
+            // Half of the view height per unit of depth. Used for mesh lod selection.
+            float m_lodSizePerDepth;
             float m_znear;
             float m_zfar;
     };
@@ -6,7 +6,10 @@
 #include "ECS/Contextual/EntityViews/MeshRenderableView.h"
 #include "ECS/Contextual/EntityViews/LightRenderableView.h"
 #include "Utilities/VectorUtilities.h"
+#include "Utilities/RadixSort.h"
+#include "Core/Services/Profiler.h"
 #include "Math/FunctionsIntersect.h"
+#include "Rendering/MeshUtility.h"
 
 namespace PK::Rendering
 {
@@ -19,21 +22,12 @@ namespace PK::Rendering
     using namespace ECS;
     using namespace ECS::EntityViews;
 
-    uint16_t MaterialGroup::Add(Material* material)
-    {
-        if (stride == 0ull)
-        {
-            stride = material->GetShader()->GetMaterialPropertyLayout().GetPaddedStride();
-        }
-
-        return (uint16_t)materials.Add(material);
-    }
-
-    Batcher::Batcher() :
-        m_textures2D(PK_MAX_UNBOUNDED_SIZE),
+    Batcher::Batcher(JobSystem* jobSystem) :
+        m_materials(PK_MAX_UNBOUNDED_SIZE),
         m_meshes(32),
         m_shaders(32),
-        m_transforms(1024)
+        m_transforms(1024),
+        m_jobSystem(jobSystem)
     {
         m_matrices = Buffer::Create(ElementType::Float4x4, 1024, BufferUsage::PersistentStorage, "Batching.Matrices");
 
@@ -46,12 +40,6 @@ namespace PK::Rendering
             },
             1024, BufferUsage::PersistentStorage, "Batching.DrawInfos");
 
-        m_properties = Buffer::Create(
-            {
-                { ElementType::Uint, "DATA"},
-            },
-            4096, BufferUsage::PersistentStorage, "Batching.MaterialProperties");
-
         m_indirectArguments = Buffer::Create(
             {
                 { ElementType::Uint, "indexCount"},
@@ -64,191 +52,323 @@ namespace PK::Rendering
 
         m_drawCalls.reserve(512);
         m_passGroups.reserve(512);
-    }
 
-    void Batcher::BeginCollectDrawCalls()
-    {
-        for (auto i = 0u; i < m_materials.GetCount(); ++i)
+        for (auto i = 0u; i < jobSystem->GetWorkerCount(); ++i)
         {
-            m_materials[i]->Clear();
+            m_submissions.push_back(Utilities::CreateScope<std::vector<DrawSubmission>>());
+            m_submissions.back()->reserve(1024);
         }
+    }
 
+    void Batcher::BeginCollectDrawCalls()
+    {
         m_groupIndex = 0u;
         m_meshes.Clear();
         m_transforms.Clear();
-        m_textures2D.Clear();
         m_drawInfos.clear();
         m_passGroups.clear();
         m_drawCalls.clear();
+        m_cullViews.clear();
+
+        for (auto& submissions : m_submissions)
+        {
+            submissions->clear();
+        }
     }
 
     void Batcher::EndCollectDrawCalls(Objects::CommandBuffer* cmd)
     {
-        if (m_drawInfos.size() == 0)
+        PK_PROFILE_FUNCTION();
+        auto drawCount = 0ull;
+
+        for (auto& submissions : m_submissions)
+        {
+            drawCount += submissions->size();
+        }
+
+        if (drawCount == 0ull)
         {
             return;
         }
 
-        std::sort(m_drawInfos.begin(), m_drawInfos.end());
+        m_drawInfos.resize(drawCount);
+        m_sortKeys.resize(drawCount);
+        m_sortScratch.resize(drawCount);
 
-        m_matrices->Validate(m_transforms.GetCapacity());
-        auto matrixView = cmd->BeginBufferWrite<float4x4>(m_matrices.get(), 0u, m_transforms.GetCount());
+        // Consecutive submissions mostly share a shader, mesh & material. Skip redundant set lookups for those.
+        const Shader* previousShader = nullptr;
+        const Mesh* previousMesh = nullptr;
+        const Material* previousMaterial = nullptr;
+        const Components::Transform* previousTransform = nullptr;
+        auto hasMaterial = false;
+        DrawInfo info{};
+        auto drawIndex = 0u;
 
-        for (auto& view : m_transforms)
+        for (auto& submissions : m_submissions)
         {
-            matrixView[view.index] = (*view)->localToWorld;
-        }
+            for (auto& submission : *submissions)
+            {
+                if (submission.shader != previousShader)
+                {
+                    previousShader = submission.shader;
+                    info.shader = (uint16_t)m_shaders.Add(submission.shader);
+                    hasMaterial = false;
 
-        cmd->EndBufferWrite(m_matrices.get());
+                    PK_THROW_ASSERT(info.shader < (1u << PK_BATCHER_SHADER_BITS), "Batcher shader count exceeds sort key range!");
+                }
 
-        auto buffsize = 0ull;
+                if (submission.mesh != previousMesh)
+                {
+                    previousMesh = submission.mesh;
+                    info.mesh = (uint16_t)m_meshes.Add(submission.mesh);
+                    PK_THROW_ASSERT(info.mesh < (1u << PK_BATCHER_MESH_BITS), "Batcher mesh count exceeds sort key range!");
+                }
+
+                if (!hasMaterial || submission.material != previousMaterial)
+                {
+                    hasMaterial = true;
+                    previousMaterial = submission.material;
+                    info.material = submission.material != nullptr ? m_materials.Register(submission.material) : 0u;
+                }
+
+                if (submission.transform != previousTransform)
+                {
+                    previousTransform = submission.transform;
+                    info.transform = m_transforms.Add(submission.transform);
+                }
+
+                PK_THROW_ASSERT(submission.group < (1u << PK_BATCHER_GROUP_BITS), "Batcher group index exceeds sort key range!");
+                PK_THROW_ASSERT(submission.submesh < (1u << PK_BATCHER_SUBMESH_BITS), "Batcher submesh index exceeds sort key range!");
 
-        for (auto& group : m_materials)
+                info.group = submission.group;
+                info.submesh = submission.submesh;
+                info.userdata = submission.userdata;
+                m_drawInfos[drawIndex] = info;
+                m_sortKeys[drawIndex] = { info.userdata, drawIndex };
+                ++drawIndex;
+            }
+        }
+
+        // Radix sort is stable. Sorting by userdata first orders draws that share a sort key independent of submission order.
+        auto sorted = Utilities::RadixSort::Sort64(m_sortKeys.data(), m_sortScratch.data(), drawCount);
+        auto scratch = sorted == m_sortKeys.data() ? m_sortScratch.data() : m_sortKeys.data();
+
+        for (auto i = 0ull; i < drawCount; ++i)
         {
-            auto size = group->GetSize();
+            sorted[i].key = m_drawInfos[sorted[i].index].GetSortKey();
+        }
+
+        sorted = Utilities::RadixSort::Sort64(sorted, scratch, drawCount);
+        auto indirectCount = 1u;
 
-            if (size > 0)
+        for (auto i = 1ull; i < drawCount; ++i)
+        {
+            if ((sorted[i].key >> PK_BATCHER_MATERIAL_BITS) != (sorted[i - 1ull].key >> PK_BATCHER_MATERIAL_BITS))
             {
-                group->firstIndex = (size_t)ceil((double)buffsize / group->stride);
-                buffsize = group->firstIndex * group->stride;
-                buffsize += size;
+                ++indirectCount;
             }
         }
 
-        if (buffsize > 0)
+        // Culled commands follow the batch commands. Bounded by the number of separate visible meshlet ranges per instance.
+        auto culledCount = 0u;
+        auto rangeCount = 0u;
+        m_culledInstances.clear();
+
+        for (auto i = 0ull; i < drawCount && !m_cullViews.empty(); ++i)
         {
-            m_properties->Validate(buffsize / sizeof(uint32_t));
-            auto propertyView = cmd->BeginBufferWrite<char>(m_properties.get(), 0ull, buffsize);
+            auto& info = m_drawInfos[sorted[i].index];
 
-            for (auto& group : m_materials)
+            if (info.group < m_cullViews.size() && m_cullViews[info.group].isEnabled)
             {
-                if (group->GetSize() > 0)
-                {
-                    auto destination = propertyView.data + group->GetOffset();
+                auto meshletCount = m_meshes.GetValue(info.mesh)->GetSubmesh(info.submesh).meshletCount;
+                auto maxRangeCount = glm::max(1u, (meshletCount + 1u) / 2u);
+                culledCount += maxRangeCount;
 
-                    for (auto& material : group->materials)
-                    {
-                        (*material)->CopyTo(destination + material.index * group->stride, &m_textures2D);
-                    }
+                if (meshletCount > 1u)
+                {
+                    m_culledInstances.push_back({ (uint32_t)i, rangeCount, 0u });
+                    rangeCount += maxRangeCount;
                 }
             }
-
-            cmd->EndBufferWrite(m_properties.get());
         }
 
-        auto indirectCount = 1u;
-        auto current = m_drawInfos[0];
-
-        m_indices->Validate(m_drawInfos.capacity());
-        auto indexView = cmd->BeginBufferWrite<PK_Draw>(m_indices.get(), 0u, m_drawInfos.size());
+        m_meshletRanges.resize(rangeCount);
 
-        for (auto i = 0u; i < m_drawInfos.size(); ++i)
+        // Instances write their visible ranges into separate slots. No synchronization is needed between workers.
+        m_jobSystem->ParallelFor((uint32_t)m_culledInstances.size(), 64u, [this, sorted](uint32_t begin, uint32_t end)
         {
-            const auto info = m_drawInfos.data() + i;
-            indexView[i].material = (uint32_t)info->material + (uint32_t)m_materials[info->shader]->firstIndex;
-            indexView[i].transfrom = info->transform;
-            indexView[i].mesh = 0;
-            indexView[i].userdata = info->userdata;
-
-            if (info->group != current.group ||
-                info->shader != current.shader ||
-                info->mesh != current.mesh ||
-                info->submesh != current.submesh)
+            for (auto i = begin; i < end; ++i)
             {
-                current = *info;
-                ++indirectCount;
+                auto& instance = m_culledInstances[i];
+                auto& info = m_drawInfos[sorted[instance.x].index];
+                auto& view = m_cullViews[info.group];
+                auto mesh = m_meshes.GetValue(info.mesh);
+                auto& sm = mesh->GetSubmesh(info.submesh);
+                auto transform = m_transforms[info.transform];
+                auto viewOrigin = float3(transform->worldToLocal * float4(view.viewOrigin, 1.0f));
+                FrustumPlanes planes;
+                Functions::ExtractFrustrumPlanes(view.worldToClip * transform->localToWorld, &planes, true);
+
+                // Mirrored transforms flip the winding. Cones are only valid for the original orientation.
+                auto cullBackfaces = glm::determinant(float3x3(transform->localToWorld)) > 0.0f;
+                instance.z = MeshUtility::CullMeshlets(mesh->GetMeshlets(sm), sm.meshletCount, planes, viewOrigin, cullBackfaces, m_meshletRanges.data() + instance.y);
             }
-        }
+        });
 
-        cmd->EndBufferWrite(m_indices.get());
+        m_writtenTransforms.assign(m_transforms.GetCount(), 0u);
 
-        m_indirectArguments->Validate(indirectCount);
-        auto indirectView = cmd->BeginBufferWrite<DrawIndexedIndirectCommand>(m_indirectArguments.get(), 0u, indirectCount);
+        m_matrices->Validate(m_transforms.GetCapacity());
+        m_indices->Validate(drawCount);
+        m_indirectArguments->Validate(indirectCount + culledCount);
 
+        auto matrixView = cmd->BeginBufferWrite<float4x4>(m_matrices.get(), 0u, m_transforms.GetCount());
+        auto indexView = cmd->BeginBufferWrite<PK_Draw>(m_indices.get(), 0u, drawCount);
+        auto indirectView = cmd->BeginBufferWrite<DrawIndexedIndirectCommand>(m_indirectArguments.get(), 0u, indirectCount + culledCount);
+
+        // Single pass over the sorted draws. Transforms are written on first reference.
         auto indirectIndex = 0u;
+        auto culledIndex = indirectCount;
+        auto culledInstance = 0u;
         auto pbase = 0ull;
         auto dbase = 0ull;
         auto ibase = 0ull;
-        current = m_drawInfos[0];
+        auto cbase = (size_t)indirectCount;
+        auto current = m_drawInfos[sorted[0].index];
 
-        for (auto i = 0u; i < m_drawInfos.size(); ++i)
+        for (auto i = 0ull; i <= drawCount; ++i)
         {
-            const auto info = m_drawInfos.data() + i;
+            const DrawInfo* next = nullptr;
 
-            if (info->group == current.group &&
-                info->mesh == current.mesh &&
-                info->shader == current.shader &&
-                info->submesh == current.submesh)
+            if (i < drawCount)
             {
-                continue;
+                next = m_drawInfos.data() + sorted[i].index;
+
+                if (m_writtenTransforms[next->transform] == 0u)
+                {
+                    m_writtenTransforms[next->transform] = 1u;
+                    matrixView[next->transform] = m_transforms[next->transform]->localToWorld;
+                }
+
+                indexView[i].material = next->material;
+                indexView[i].transfrom = next->transform;
+                indexView[i].mesh = 0;
+                indexView[i].userdata = next->userdata;
+
+                if ((sorted[i].key >> PK_BATCHER_MATERIAL_BITS) == (sorted[dbase].key >> PK_BATCHER_MATERIAL_BITS))
+                {
+                    continue;
+                }
             }
 
             auto mesh = m_meshes.GetValue(current.mesh);
             auto& sm = mesh->GetSubmesh(current.submesh);
             auto indirect = &indirectView[indirectIndex++];
             indirect->indexCount = sm.indexCount;
-            indirect->instanceCount = i - (uint32_t)dbase;
+            indirect->instanceCount = (uint32_t)(i - dbase);
             indirect->firstIndex = sm.firstIndex;
             indirect->vertexOffset = sm.firstVertex;
             indirect->firstInstance = (uint32_t)dbase;
-            current.submesh = info->submesh;
+
+            if (current.group < m_cullViews.size() && m_cullViews[current.group].isEnabled)
+            {
+                for (auto j = dbase; j < i && sm.meshletCount > 1u;)
+                {
+                    auto& instance = m_culledInstances[culledInstance];
+                    auto ranges = m_meshletRanges.data() + instance.y;
+                    auto instanceCount = 1u;
+
+                    // Consecutive instances with identical visible ranges share the same commands.
+                    while (j + instanceCount < i)
+                    {
+                        auto& other = m_culledInstances[culledInstance + instanceCount];
+
+                        if (other.z != instance.z || !std::equal(ranges, ranges + instance.z, m_meshletRanges.data() + other.y))
+                        {
+                            break;
+                        }
+
+                        ++instanceCount;
+                    }
+
+                    for (auto k = 0u; k < instance.z; ++k)
+                    {
+                        auto culled = &indirectView[culledIndex++];
+                        culled->indexCount = ranges[k].y;
+                        culled->instanceCount = instanceCount;
+                        culled->firstIndex = sm.firstIndex + ranges[k].x;
+                        culled->vertexOffset = sm.firstVertex;
+                        culled->firstInstance = (uint32_t)j;
+                    }
+
+                    j += instanceCount;
+                    culledInstance += instanceCount;
+                }
+
+                if (sm.meshletCount <= 1u)
+                {
+                    indirectView[culledIndex++] = *indirect;
+                }
+            }
+
             dbase = i;
 
-            if (info->group == current.group &&
-                info->mesh == current.mesh &&
-                info->shader == current.shader)
+            if (next != nullptr && 
+                next->group == current.group &&
+                next->mesh == current.mesh &&
+                next->shader == current.shader)
             {
+                current = *next;
                 continue;
             }
 
-            m_drawCalls.push_back({ mesh, m_shaders[current.shader], { ibase, indirectIndex - ibase } });
+            auto isCulled = current.group < m_cullViews.size() && m_cullViews[current.group].isEnabled;
+            IndexRange indices = { ibase, indirectIndex - ibase };
+            m_drawCalls.push_back({ mesh, m_shaders[current.shader], indices, isCulled ? IndexRange{ cbase, culledIndex - cbase } : indices });
+            ibase = indirectIndex;
+            cbase = culledIndex;
 
-            if (info->group != current.group)
+            if (next == nullptr || next->group != current.group)
             {
+                // Groups without draws still need a range so that group indices map directly to pass groups.
+                while (m_passGroups.size() < current.group)
+                {
+                    m_passGroups.push_back({ pbase, 0ull });
+                }
+
                 m_passGroups.push_back({ pbase, m_drawCalls.size() - pbase });
                 pbase = m_drawCalls.size();
             }
 
-            ibase = indirectIndex;
-            current = *info;
+            if (next != nullptr)
+            {
+                current = *next;
+            }
         }
 
-        auto& lastsm = m_meshes.GetValue(current.mesh)->GetSubmesh(current.submesh);
-        indirectView[indirectIndex].indexCount = lastsm.indexCount;
-        indirectView[indirectIndex].instanceCount = (uint32_t)m_drawInfos.size() - (uint32_t)dbase;
-        indirectView[indirectIndex].firstIndex = lastsm.firstIndex;
-        indirectView[indirectIndex].vertexOffset = lastsm.firstVertex;
-        indirectView[indirectIndex++].firstInstance = (uint32_t)dbase;
-
-        m_drawCalls.push_back({ m_meshes[current.mesh], m_shaders[current.shader], { ibase, indirectIndex - ibase } });
-        m_passGroups.push_back({ pbase, m_drawCalls.size() - pbase });
-
+        cmd->EndBufferWrite(m_matrices.get());
+        cmd->EndBufferWrite(m_indices.get());
         cmd->EndBufferWrite(m_indirectArguments.get());
+        m_materials.Upload(cmd);
 
         auto hash = HashCache::Get();
         GraphicsAPI::SetBuffer(hash->pk_Instancing_Transforms, m_matrices.get());
         GraphicsAPI::SetBuffer(hash->pk_Instancing_Indices, m_indices.get());
-        GraphicsAPI::SetBuffer(hash->pk_Instancing_Properties, m_properties.get());
-        GraphicsAPI::SetTextureArray(hash->pk_Instancing_Textures2D, m_textures2D);
+        GraphicsAPI::SetBuffer(hash->pk_Instancing_Properties, m_materials.GetProperties());
+        GraphicsAPI::SetTextureArray(hash->pk_Instancing_Textures2D, m_materials.GetTextures());
     }
 
-    void Batcher::SubmitDraw(Components::Transform* transform, Shader* shader, Material* material, Mesh* mesh, uint32_t submesh, uint32_t clipIndex)
+    uint32_t Batcher::BeginNewGroup(const float4x4& worldToClip, const float3& viewOrigin)
     {
-        DrawInfo info{};
-
-        info.shader = m_shaders.Add(shader);
-
-        if (material != nullptr)
-        {
-            info.material = m_materials[info.shader]->Add(material);
-        }
+        auto group = BeginNewGroup();
+        m_cullViews.resize(group + 1u);
+        m_cullViews[group] = { worldToClip, viewOrigin, true };
+        return group;
+    }
 
-        info.transform = m_transforms.Add(transform);
-        info.mesh = m_meshes.Add(mesh);
-        info.submesh = submesh;
-        info.userdata = clipIndex;
-        info.group = m_groupIndex - 1;
-        m_drawInfos.push_back(info);
+    void Batcher::SubmitDraw(uint32_t group, Components::Transform* transform, Shader* shader, Material* material, Mesh* mesh, uint32_t submesh, uint32_t userdata)
+    {
+        auto& submissions = *m_submissions.at(JobSystem::GetWorkerIndex());
+        submissions.push_back({ transform, shader, material, mesh, (uint16_t)submesh, (uint16_t)group, userdata });
     }
 
     void Batcher::Render(CommandBuffer* cmd, uint32_t group, FixedFunctionShaderAttributes* overrideAttributes, uint32_t requireKeyword)
@@ -258,12 +378,8 @@ namespace PK::Rendering
             return;
         }
 
-        if (requireKeyword > 0u)
-        {
-            GraphicsAPI::SetKeyword(requireKeyword, true);
-        }
-
         auto hash = HashCache::Get();
+        auto globals = &GraphicsAPI::GetActiveDriver()->globalResources;
         auto& passGroup = m_passGroups.at(group);
         auto start = passGroup.offset;
         auto end = passGroup.offset + passGroup.count;
@@ -279,16 +395,30 @@ namespace PK::Rendering
                 continue;
             }
 
-            auto offset = dc.indices.offset * stride;
+            // Meshlet ranges exclude back facing clusters. Passes that rasterize back faces draw whole submeshes.
+            auto cullMode = overrideAttributes != nullptr ? overrideAttributes->rasterization.cullMode : shader->GetFixedFunctionAttributes().rasterization.cullMode;
+            auto& indices = cullMode == CullMode::Back ? dc.culledIndices : dc.indices;
 
-            cmd->SetShader(shader);
-            cmd->SetFixedStateAttributes(overrideAttributes);
-            cmd->DrawMeshIndirect(dc.mesh, m_indirectArguments.get(), offset, (uint32_t)dc.indices.count, (uint32_t)stride);
-        }
+            if (indices.count == 0ull)
+            {
+                continue;
+            }
 
-        if (requireKeyword > 0u)
-        {
-            GraphicsAPI::SetKeyword(requireKeyword, false);
+            auto offset = indices.offset * stride;
+
+            // Keywords are resolved locally as groups can be recorded on multiple threads.
+            auto selector = shader->GetVariantSelector();
+            selector.SetKeywordsFrom(*globals);
+            selector.SetKeyword(hash->PK_VERTEX_COMPACT, dc.mesh->HasCompactVertices());
+
+            if (requireKeyword > 0u)
+            {
+                selector.SetKeyword(requireKeyword, true);
+            }
+
+            cmd->SetShader(shader, (int32_t)selector.GetIndex());
+            cmd->SetFixedStateAttributes(overrideAttributes);
+            cmd->DrawMeshIndirect(dc.mesh, m_indirectArguments.get(), offset, (uint32_t)indices.count, (uint32_t)stride);
         }
     }
 }
\ No newline at end of file
@@ -1,16 +1,16 @@
 #pragma once
 #include "ECS/EntityDatabase.h"
 #include "Core/Services/Sequencer.h"
+#include "Core/Services/JobSystem.h"
 #include "Rendering/Objects/Texture.h"
 #include "Rendering/Objects/Shader.h"
 #include "Rendering/Objects/Mesh.h"
-#include "Rendering/Objects/BindSet.h"
 #include "Rendering/Objects/Material.h"
 #include "Rendering/Objects/CommandBuffer.h"
+#include "Rendering/Services/MaterialRegistry.h"
 #include "ECS/Contextual/Tokens/CullingTokens.h"
 #include "ECS/Contextual/Components/Transform.h"
 #include "Utilities/IndexedSet.h"
-#include "Utilities/FixedList.h"
 
 namespace PK::Rendering
 {
@@ -19,69 +19,102 @@ namespace PK::Rendering
         const Objects::Mesh* mesh = nullptr;
         const Objects::Shader* shader = nullptr;
         Structs::IndexRange indices{};
+        // Per instance ranges of visible meshlets. Same as indices for groups without a cull view.
+        Structs::IndexRange culledIndices{};
     };
 
-    struct MaterialGroup
+    // Meshlets of the draws in a group are frustum & backface culled against this view.
+    struct MeshletCullView
     {
-        Utilities::IndexedSet<Objects::Material> materials;
-        size_t firstIndex = 0ull;
-        size_t stride = 0ull;
-
-        MaterialGroup() : materials(32){}
-        uint16_t Add(Objects::Material* material);
-        inline void Clear() { firstIndex = 0ull; materials.Clear(); }
-        constexpr size_t GetSize() const { return materials.GetCount() * stride; }
-        constexpr size_t GetOffset() const { return firstIndex * stride; }
+        Math::float4x4 worldToClip = Math::PK_FLOAT4X4_IDENTITY;
+        Math::float3 viewOrigin = Math::PK_FLOAT3_ZERO;
+        bool isEnabled = false;
     };
 
+    // Sort key layout from most to least significant bits. Draws sharing everything but the material are instanced together.
+    // Material registry indices are truncated to the material bits as they only order draws within a batch.
+    // Userdata does not fit in the key. It is sorted in a preceding pass & breaks ties between otherwise equal keys.
+    constexpr static const uint32_t PK_BATCHER_GROUP_BITS = 12u;
+    constexpr static const uint32_t PK_BATCHER_SHADER_BITS = 12u;
+    constexpr static const uint32_t PK_BATCHER_MESH_BITS = 12u;
+    constexpr static const uint32_t PK_BATCHER_SUBMESH_BITS = 12u;
+    constexpr static const uint32_t PK_BATCHER_MATERIAL_BITS = 16u;
+
     struct DrawInfo
     {
         uint16_t group = 0u;
         uint16_t shader = 0u;
         uint16_t mesh = 0u;
-        uint16_t material = 0u;
-        uint16_t transform = 0u;
         uint16_t submesh = 0u;
+        uint32_t material = 0u;
+        uint32_t transform = 0u;
         uint32_t userdata = 0u;
 
-        bool operator < (DrawInfo& b)
+        inline uint64_t GetSortKey() const
         {
-            if (group != b.group) return group < b.group;
-            if (shader != b.shader) return shader < b.shader;
-            if (mesh != b.mesh) return mesh < b.mesh;
-            if (submesh != b.submesh) return submesh < b.submesh;
-            if (userdata != b.userdata) return userdata < b.userdata;
-            if (material != b.material) return material < b.material;
-            if (transform != b.transform) return transform < b.transform;
-            return false;
+            auto key = (uint64_t)group;
+            key = (key << PK_BATCHER_SHADER_BITS) | shader;
+            key = (key << PK_BATCHER_MESH_BITS) | mesh;
+            key = (key << PK_BATCHER_SUBMESH_BITS) | submesh;
+            key = (key << PK_BATCHER_MATERIAL_BITS) | (material & ((1u << PK_BATCHER_MATERIAL_BITS) - 1u));
+            return key;
         }
     };
+
+    struct DrawSortKey
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // Unresolved draw submitted from a job system worker. Resolved into a DrawInfo when collection ends.
+    struct DrawSubmission
+    {
+        const ECS::Components::Transform* transform;
+        const Objects::Shader* shader;
+        const Objects::Material* material;
+        const Objects::Mesh* mesh;
+        uint16_t submesh;
+        uint16_t group;
+        uint32_t userdata;
+    };
     
     class Batcher : public Utilities::NoCopy
     {
         public:
-            Batcher();
+            Batcher(Core::Services::JobSystem* jobSystem);
             void BeginCollectDrawCalls();
             void EndCollectDrawCalls(Objects::CommandBuffer* cmd);
             constexpr uint32_t BeginNewGroup() { return m_groupIndex++; }
-            void SubmitDraw(ECS::Components::Transform* transform, Objects::Shader* shader, Objects::Material* material, Objects::Mesh* mesh, uint32_t submesh, uint32_t userdata);
+            // Draws of the group are additionally split into per instance ranges of visible meshlets.
+            uint32_t BeginNewGroup(const Math::float4x4& worldToClip, const Math::float3& viewOrigin);
+            // Thread safe for job system workers.
+            void SubmitDraw(uint32_t group, ECS::Components::Transform* transform, Objects::Shader* shader, Objects::Material* material, Objects::Mesh* mesh, uint32_t submesh, uint32_t userdata);
+            // Does not modify global state. Groups can be recorded into secondary command buffers concurrently.
             void Render(Objects::CommandBuffer* cmd, uint32_t group, Structs::FixedFunctionShaderAttributes* overrideAttributes = nullptr, uint32_t requireKeyword = 0u);
 
         private:
             Utilities::Ref<Objects::Buffer> m_matrices;
             Utilities::Ref<Objects::Buffer> m_indices;
-            Utilities::Ref<Objects::Buffer> m_properties;
             Utilities::Ref<Objects::Buffer> m_indirectArguments;
-            Objects::BindSet<Objects::Texture> m_textures2D;
+            MaterialRegistry m_materials;
 
             std::vector<DrawCall> m_drawCalls;
             std::vector<Structs::IndexRange> m_passGroups;     
             std::vector<DrawInfo> m_drawInfos;
+            std::vector<DrawSortKey> m_sortKeys;
+            std::vector<DrawSortKey> m_sortScratch;
+            std::vector<uint8_t> m_writtenTransforms;
+            std::vector<Utilities::Scope<std::vector<DrawSubmission>>> m_submissions;
+            std::vector<MeshletCullView> m_cullViews;
+            std::vector<Math::uint2> m_meshletRanges;
+            // Sorted draw index, meshlet range offset & visible range count of each meshlet culled instance.
+            std::vector<Math::uint3> m_culledInstances;
 
-            Utilities::FixedList<MaterialGroup, 32> m_materials;
             Utilities::IndexedSet<Objects::Mesh> m_meshes;
             Utilities::IndexedSet<Objects::Shader> m_shaders;
             Utilities::IndexedSet<ECS::Components::Transform> m_transforms;
+            Core::Services::JobSystem* m_jobSystem = nullptr;
             uint16_t m_groupIndex = 0u;
     };
 }
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "PrecompiledHeader.h"
+#include "LightClusterBuilder.h"
+#include "Rendering/Structs/Enums.h"
+#include "Math/SIMD.h"
+
+namespace PK::Rendering
+{
+    using namespace Math;
+    using namespace Math::SIMD;
+    using namespace Rendering::Structs;
+
+    constexpr static const uint32_t LIGHT_FLAG_RADIUS = 1u << 0u;
+    constexpr static const uint32_t LIGHT_FLAG_SPOT = 1u << 1u;
+    constexpr static const uint32_t LIGHT_FLAG_DIRECTIONAL = 1u << 2u;
+    constexpr static const uint32_t LIGHT_PADDING = 8u;
+    // Slice depth bounds are widened by this fraction of the far plane so that lights touching a slice are never rejected due to rounding.
+    constexpr static const float SLICE_DEPTH_MARGIN = 1e-3f;
+
+    void LightClusterBuilder::LightArrays::Resize(uint32_t lightCount)
+    {
+        auto paddedCount = ((lightCount + LIGHT_PADDING - 1u) / LIGHT_PADDING) * LIGHT_PADDING;
+        count = lightCount;
+        positionX.resize(paddedCount);
+        positionY.resize(paddedCount);
+        positionZ.resize(paddedCount);
+        directionX.resize(paddedCount);
+        directionY.resize(paddedCount);
+        directionZ.resize(paddedCount);
+        radius.resize(paddedCount);
+        cosHalfAngle.resize(paddedCount);
+        sinHalfAngle.resize(paddedCount);
+        indices.resize(paddedCount);
+        flags.resize(paddedCount);
+        // Padding lanes have no flags & never intersect.
+        std::fill(flags.begin() + lightCount, flags.end(), 0u);
+    }
+
+    void LightClusterBuilder::LightArrays::Copy(uint32_t dst, const LightArrays& src, uint32_t index)
+    {
+        positionX[dst] = src.positionX[index];
+        positionY[dst] = src.positionY[index];
+        positionZ[dst] = src.positionZ[index];
+        directionX[dst] = src.directionX[index];
+        directionY[dst] = src.directionY[index];
+        directionZ[dst] = src.directionZ[index];
+        radius[dst] = src.radius[index];
+        cosHalfAngle[dst] = src.cosHalfAngle[index];
+        sinHalfAngle[dst] = src.sinHalfAngle[index];
+        flags[dst] = src.flags[index];
+        indices[dst] = src.indices[index];
+    }
+
+    void LightClusterBuilder::Reset(uint32_t lightCount)
+    {
+        m_lights.resize(lightCount);
+        m_directions.resize(lightCount);
+    }
+
+    void LightClusterBuilder::SetLight(uint32_t index, const PK_Light& light, const float4& direction)
+    {
+        m_lights.at(index) = light;
+        m_directions.at(index) = direction;
+    }
+
+    void LightClusterBuilder::Build(const float4x4& view, const float4x4& inverseProjection, float znear, float zfar, const float* cascadeSplits)
+    {
+        auto lightCount = (uint32_t)m_lights.size();
+        m_viewLights.Resize(lightCount);
+
+        for (auto i = 0u; i < lightCount; ++i)
+        {
+            auto& light = m_lights.at(i);
+            auto& direction = m_directions.at(i);
+            auto position = view * float4(float3(light.position), 1.0f);
+            auto viewDirection = view * float4(float3(direction), 0.0f);
+
+            m_viewLights.positionX[i] = position.x;
+            m_viewLights.positionY[i] = position.y;
+            m_viewLights.positionZ[i] = position.z;
+            m_viewLights.directionX[i] = viewDirection.x;
+            m_viewLights.directionY[i] = viewDirection.y;
+            m_viewLights.directionZ[i] = viewDirection.z;
+            m_viewLights.radius[i] = light.position.w;
+            m_viewLights.cosHalfAngle[i] = glm::cos(direction.w * 0.5f);
+            m_viewLights.sinHalfAngle[i] = glm::sin(direction.w * 0.5f);
+            m_viewLights.indices[i] = i;
+
+            switch ((LightType)light.indices.w)
+            {
+                case LightType::Point: m_viewLights.flags[i] = LIGHT_FLAG_RADIUS; break;
+                case LightType::Spot: m_viewLights.flags[i] = LIGHT_FLAG_RADIUS | LIGHT_FLAG_SPOT; break;
+                case LightType::Directional: m_viewLights.flags[i] = LIGHT_FLAG_DIRECTIONAL; break;
+                default: break;
+            }
+        }
+
+        m_tiles.resize(PK_LIGHT_CLUSTER_COUNT);
+        m_tileLights.resize(PK_LIGHT_CLUSTER_COUNT * PK_LIGHT_CLUSTER_TILE_MAX_LIGHT_COUNT);
+
+        auto useAVX2 = SupportsAVX2();
+
+        m_jobSystem->ParallelFor(PK_LIGHT_CLUSTER_TILE_COUNT_Z, 1u, [&](uint32_t begin, uint32_t end)
+        {
+            for (auto z = begin; z < end; ++z)
+            {
+                if (useAVX2)
+                {
+                    BuildSlice<floatx8>(z, inverseProjection, znear, zfar, cascadeSplits);
+                }
+                else
+                {
+                    BuildSlice<floatx4>(z, inverseProjection, znear, zfar, cascadeSplits);
+                }
+            }
+        });
+
+        // Tile lists are compacted in tile order.
+        m_lightList.clear();
+
+        for (auto i = 0u; i < PK_LIGHT_CLUSTER_COUNT; ++i)
+        {
+            auto count = (m_tiles[i] >> 20u) & 0xFFu;
+            auto lights = m_tileLights.data() + i * PK_LIGHT_CLUSTER_TILE_MAX_LIGHT_COUNT;
+            m_tiles[i] |= (uint32_t)m_lightList.size() & 0xFFFFFu;
+            m_lightList.insert(m_lightList.end(), lights, lights + count);
+        }
+    }
+
+    template<typename T>
+    void LightClusterBuilder::BuildSlice(uint32_t z, const float4x4& inverseProjection, float znear, float zfar, const float* cascadeSplits)
+    {
+        auto near = znear * glm::pow(zfar / znear, (float)z / PK_LIGHT_CLUSTER_TILE_COUNT_Z);
+        auto far = znear * glm::pow(zfar / znear, (float)(z + 1u) / PK_LIGHT_CLUSTER_TILE_COUNT_Z);
+        auto depth = glm::mix(near, far, 0.5f);
+        auto cascade = depth > cascadeSplits[1] ? depth > cascadeSplits[2] ? depth > cascadeSplits[3] ? 3u : 2u : 1u : 0u;
+        auto projectionScale = float2(inverseProjection[0][0], inverseProjection[1][1]);
+        auto invstep = 1.0f / float2(PK_LIGHT_CLUSTER_TILE_COUNT_X, PK_LIGHT_CLUSTER_TILE_COUNT_Y);
+
+        // Cells of a slice span its depth range. Lights that cannot reach it are culled once for the whole slice.
+        // Light index order is preserved so that per cell lists & the per cell light limit match the shader.
+        auto& lights = m_sliceLights[z];
+        auto margin = zfar * SLICE_DEPTH_MARGIN;
+        auto count = 0u;
+        lights.Resize(m_viewLights.count);
+
+        for (auto i = 0u; i < m_viewLights.count; ++i)
+        {
+            auto flags = m_viewLights.flags[i];
+            auto pz = m_viewLights.positionZ[i];
+            auto radius = m_viewLights.radius[i] + margin;
+
+            if ((flags & LIGHT_FLAG_DIRECTIONAL) != 0u || ((flags & LIGHT_FLAG_RADIUS) != 0u && pz + radius >= near && pz - radius <= far))
+            {
+                lights.Copy(count++, m_viewLights, i);
+            }
+        }
+
+        lights.Resize(count);
+
+        for (auto y = 0u; y < PK_LIGHT_CLUSTER_TILE_COUNT_Y; ++y)
+        for (auto x = 0u; x < PK_LIGHT_CLUSTER_TILE_COUNT_X; ++x)
+        {
+            auto uvmin = float2(x, y) * invstep;
+            auto uvmax = (float2(x, y) + 1.0f) * invstep;
+
+            // Same as ClipUVToViewPos
+            auto min00 = float3((uvmin * 2.0f - 1.0f) * projectionScale, 1.0f) * near;
+            auto max00 = float3((uvmin * 2.0f - 1.0f) * projectionScale, 1.0f) * far;
+            auto min11 = float3((uvmax * 2.0f - 1.0f) * projectionScale, 1.0f) * near;
+            auto max11 = float3((uvmax * 2.0f - 1.0f) * projectionScale, 1.0f) * far;
+
+            auto aabbmin = glm::min(glm::min(min00, max00), glm::min(min11, max11));
+            auto aabbmax = glm::max(glm::max(min00, max00), glm::max(min11, max11));
+            auto extents = (aabbmax - aabbmin) * 0.5f;
+            auto center = aabbmin + extents;
+
+            Cell cell = { { center.x, center.y, center.z }, { extents.x, extents.y, extents.z }, glm::length(extents) };
+
+            auto tileIndex = x + y * PK_LIGHT_CLUSTER_TILE_COUNT_X + z * PK_LIGHT_CLUSTER_TILE_COUNT_X * PK_LIGHT_CLUSTER_TILE_COUNT_Y;
+            auto tileCount = AssignCell<T>(lights, cell, m_tileLights.data() + tileIndex * PK_LIGHT_CLUSTER_TILE_MAX_LIGHT_COUNT);
+            m_tiles[tileIndex] = (tileCount << 20u) | (cascade << 28u);
+        }
+    }
+
+    template<typename T>
+    uint32_t LightClusterBuilder::AssignCell(const LightArrays& lights, const Cell& cell, uint32_t* indices)
+    {
+        auto zero = T(0.0f);
+        auto cx = T(cell.center[0]);
+        auto cy = T(cell.center[1]);
+        auto cz = T(cell.center[2]);
+        auto ex = T(cell.extents[0]);
+        auto ey = T(cell.extents[1]);
+        auto ez = T(cell.extents[2]);
+        auto cr = T(cell.radius);
+        auto ncr = T(-cell.radius);
+        auto count = 0u;
+
+        for (auto i = 0u; i < lights.count && count < PK_LIGHT_CLUSTER_TILE_MAX_LIGHT_COUNT; i += T::Width)
+        {
+            auto radiusBits = T::TestFlags(lights.flags.data() + i, LIGHT_FLAG_RADIUS).MoveMask();
+            auto directionalBits = T::TestFlags(lights.flags.data() + i, LIGHT_FLAG_DIRECTIONAL).MoveMask();
+            auto px = T::Load(lights.positionX.data() + i);
+            auto py = T::Load(lights.positionY.data() + i);
+            auto pz = T::Load(lights.positionZ.data() + i);
+            auto radius = T::Load(lights.radius.data() + i);
+
+            // Sphere vs aabb. Same as IntersectPointLight.
+            auto dx = Abs(px - cx) - ex;
+            auto dy = Abs(py - cy) - ey;
+            auto dz = Abs(pz - cz) - ez;
+            auto r = radius - Max(Max(Min(dx, zero), Min(dy, zero)), Min(dz, zero));
+            dx = Max(dx, zero);
+            dy = Max(dy, zero);
+            dz = Max(dz, zero);
+            auto sphereBits = ((radius > zero) & ((dx * dx + dy * dy + dz * dz) <= r * r)).MoveMask();
+
+            auto spotBits = T::TestFlags(lights.flags.data() + i, LIGHT_FLAG_SPOT).MoveMask() & sphereBits;
+            auto coneCullBits = 0u;
+
+            // Cone vs bounding sphere. Same as IntersectSpotLight.
+            if (spotBits != 0u)
+            {
+                auto vx = cx - px;
+                auto vy = cy - py;
+                auto vz = cz - pz;
+                auto vlenSq = vx * vx + vy * vy + vz * vz;
+                auto v1len = vx * T::Load(lights.directionX.data() + i) + vy * T::Load(lights.directionY.data() + i) + vz * T::Load(lights.directionZ.data() + i);
+                auto distanceClosestPoint = T::Load(lights.cosHalfAngle.data() + i) * Sqrt(vlenSq - v1len * v1len) - v1len * T::Load(lights.sinHalfAngle.data() + i);
+                coneCullBits = ((distanceClosestPoint > cr) | (v1len > cr + radius) | (v1len < ncr)).MoveMask();
+            }
+
+            auto hitBits = directionalBits | (radiusBits & sphereBits & ~(spotBits & coneCullBits));
+
+            for (auto lane = 0u; hitBits != 0u && count < PK_LIGHT_CLUSTER_TILE_MAX_LIGHT_COUNT; ++lane, hitBits >>= 1u)
+            {
+                if ((hitBits & 1u) != 0u)
+                {
+                    indices[count++] = lights.indices[i + lane];
+                }
+            }
+        }
+
+        return count;
+    }
+}
\ No newline at end of file
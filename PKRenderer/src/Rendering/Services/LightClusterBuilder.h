@@ -0,0 +1,83 @@
+#pragma once
+#include "Utilities/NoCopy.h"
+#include "Core/Services/JobSystem.h"
+#include "Rendering/Structs/StructsCommon.h"
+
+namespace PK::Rendering
+{
+    // Must match ClusterIndexing.glsl
+    constexpr static const uint32_t PK_LIGHT_CLUSTER_TILE_COUNT_X = 16u;
+    constexpr static const uint32_t PK_LIGHT_CLUSTER_TILE_COUNT_Y = 9u;
+    constexpr static const uint32_t PK_LIGHT_CLUSTER_TILE_COUNT_Z = 24u;
+    constexpr static const uint32_t PK_LIGHT_CLUSTER_COUNT = PK_LIGHT_CLUSTER_TILE_COUNT_X * PK_LIGHT_CLUSTER_TILE_COUNT_Y * PK_LIGHT_CLUSTER_TILE_COUNT_Z;
+    constexpr static const uint32_t PK_LIGHT_CLUSTER_TILE_MAX_LIGHT_COUNT = 128u;
+
+    /*
+     * Cpu implementation of CS_LightAssignment.
+     * Froxels are tested against 4 or 8 lights at a time & depth slices are processed in parallel. Lights are culled per slice before per froxel tests.
+     * Tile words use the same packing as the shader (offset: 20 bits, count: 8 bits, cascade: 4 bits) & per tile lists are in light index order.
+     * Unlike the shader, which reserves list ranges with an atomic counter, list offsets are assigned in tile order so that results are deterministic.
+     */
+    class LightClusterBuilder : public Utilities::NoCopy
+    {
+        public:
+            LightClusterBuilder(Core::Services::JobSystem* jobSystem) : m_jobSystem(jobSystem) {}
+
+            void Reset(uint32_t lightCount);
+            // Light in world space as written to the light buffer. Direction is the spot light's direction & angle in radians.
+            void SetLight(uint32_t index, const Structs::PK_Light& light, const Math::float4& direction);
+            void Build(const Math::float4x4& view, const Math::float4x4& inverseProjection, float znear, float zfar, const float* cascadeSplits);
+
+            // Indexed by x + y * X + z * X * Y like the tile image.
+            inline const uint32_t* GetTiles() const { return m_tiles.data(); }
+            inline const uint32_t* GetLightList() const { return m_lightList.data(); }
+            inline uint32_t GetLightListCount() const { return (uint32_t)m_lightList.size(); }
+
+        private:
+            struct Cell
+            {
+                float center[3];
+                float extents[3];
+                float radius;
+            };
+
+            // View space lights as structure of arrays. Padded to the widest simd register.
+            struct LightArrays
+            {
+                uint32_t count = 0u;
+                std::vector<float> positionX;
+                std::vector<float> positionY;
+                std::vector<float> positionZ;
+                std::vector<float> directionX;
+                std::vector<float> directionY;
+                std::vector<float> directionZ;
+                std::vector<float> radius;
+                std::vector<float> cosHalfAngle;
+                std::vector<float> sinHalfAngle;
+                std::vector<uint32_t> flags;
+                std::vector<uint32_t> indices;
+
+                void Resize(uint32_t count);
+                void Copy(uint32_t dst, const LightArrays& src, uint32_t index);
+            };
+
+            template<typename T>
+            void BuildSlice(uint32_t z, const Math::float4x4& inverseProjection, float znear, float zfar, const float* cascadeSplits);
+
+            template<typename T>
+            static uint32_t AssignCell(const LightArrays& lights, const Cell& cell, uint32_t* indices);
+
+            Core::Services::JobSystem* m_jobSystem = nullptr;
+
+            // World space lights as written to the light buffer.
+            std::vector<Structs::PK_Light> m_lights;
+            std::vector<Math::float4> m_directions;
+            LightArrays m_viewLights;
+            // Lights that overlap each depth slice.
+            LightArrays m_sliceLights[PK_LIGHT_CLUSTER_TILE_COUNT_Z];
+
+            std::vector<uint32_t> m_tiles;
+            std::vector<uint32_t> m_tileLights;
+            std::vector<uint32_t> m_lightList;
+    };
+}
\ No newline at end of file
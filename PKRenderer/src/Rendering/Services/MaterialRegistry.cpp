@@ -0,0 +1,138 @@
+#include "PrecompiledHeader.h"
+#include "MaterialRegistry.h"
+
+namespace PK::Rendering
+{
+    using namespace Utilities;
+    using namespace Rendering::Structs;
+    using namespace Rendering::Objects;
+
+    MaterialRegistry::MaterialRegistry(uint32_t textureCapacity) : m_textureCapacity(textureCapacity)
+    {
+        m_textures = BindArray<Texture>::Create(textureCapacity);
+        m_properties = Buffer::Create({ { ElementType::Uint, "DATA"} }, 4096, BufferUsage::DefaultStorage, "Batching.MaterialProperties");
+    }
+
+    uint32_t MaterialRegistry::Register(const Material* material)
+    {
+        auto& layout = material->GetShader()->GetMaterialPropertyLayout();
+        auto stride = layout.GetPaddedStride();
+
+        if (stride == 0ull)
+        {
+            return 0u;
+        }
+
+        auto& slot = m_slots[material];
+
+        // Slots are aligned to their stride so that shaders can index them as arrays of their property struct.
+        if (slot.stride != stride)
+        {
+            slot.stride = stride;
+            slot.offset = ((m_data.size() + stride - 1ull) / stride) * stride;
+            slot.version = 0ull;
+            m_data.resize(slot.offset + stride);
+        }
+
+        if (slot.version != material->GetVersion())
+        {
+            slot.version = material->GetVersion();
+            m_textureScratch.clear();
+
+            for (auto& element : layout)
+            {
+                if (element.Type == ElementType::Texture2DHandle)
+                {
+                    m_textureScratch.push_back(GetTextureIndex(*material->Get<Texture*>(element.NameHashId)));
+                }
+            }
+
+            material->CopyTo(m_data.data() + slot.offset, m_textureScratch.data());
+            m_modifiedRanges.push_back({ slot.offset, stride });
+        }
+
+        return (uint32_t)(slot.offset / stride);
+    }
+
+    void MaterialRegistry::Upload(CommandBuffer* cmd)
+    {
+        // Reimported textures have new bind handles. The table is rebuilt in the same order to keep indices stable.
+        auto isTextureReloaded = false;
+
+        for (auto& entry : m_textureEntries)
+        {
+            if (entry.assetVersion != entry.texture->GetAssetVersion())
+            {
+                entry.assetVersion = entry.texture->GetAssetVersion();
+                isTextureReloaded = true;
+            }
+        }
+
+        if (isTextureReloaded)
+        {
+            m_textures->Clear();
+
+            for (auto& entry : m_textureEntries)
+            {
+                m_textures->Add(entry.texture);
+            }
+        }
+
+        auto elementCount = (m_data.size() + sizeof(uint32_t) - 1ull) / sizeof(uint32_t);
+
+        // Resizing discards the previous contents.
+        if (elementCount > m_properties->GetCount())
+        {
+            m_properties->Validate(std::max<size_t>(elementCount, m_properties->GetCount() * 2ull));
+            m_modifiedRanges.clear();
+            m_modifiedRanges.push_back({ 0ull, m_data.size() });
+        }
+
+        if (m_modifiedRanges.empty())
+        {
+            return;
+        }
+
+        std::sort(m_modifiedRanges.begin(), m_modifiedRanges.end(), [](const IndexRange& a, const IndexRange& b) { return a.offset < b.offset; });
+
+        auto range = m_modifiedRanges.at(0);
+
+        for (auto i = 1ull; i <= m_modifiedRanges.size(); ++i)
+        {
+            if (i < m_modifiedRanges.size() && m_modifiedRanges.at(i).offset <= range.offset + range.count + PK_MATERIAL_UPLOAD_MERGE_DISTANCE)
+            {
+                auto& next = m_modifiedRanges.at(i);
+                range.count = std::max<size_t>(range.offset + range.count, next.offset + next.count) - range.offset;
+                continue;
+            }
+
+            auto view = cmd->BeginBufferWrite<char>(m_properties.get(), range.offset, range.count);
+            memcpy(view.data, m_data.data() + range.offset, range.count);
+            cmd->EndBufferWrite(m_properties.get());
+
+            if (i < m_modifiedRanges.size())
+            {
+                range = m_modifiedRanges.at(i);
+            }
+        }
+
+        m_modifiedRanges.clear();
+    }
+
+    uint32_t MaterialRegistry::GetTextureIndex(const Texture* texture)
+    {
+        auto iter = m_textureIndices.find(texture);
+
+        if (iter != m_textureIndices.end())
+        {
+            return iter->second;
+        }
+
+        PK_THROW_ASSERT(m_textureEntries.size() < m_textureCapacity, "Material texture count exceeds bindless table capacity!");
+
+        auto index = (uint32_t)m_textures->Add(texture);
+        m_textureIndices[texture] = index;
+        m_textureEntries.push_back({ texture, texture->GetAssetVersion() });
+        return index;
+    }
+}
\ No newline at end of file
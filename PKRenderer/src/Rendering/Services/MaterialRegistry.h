@@ -0,0 +1,60 @@
+#pragma once
+#include "Utilities/NoCopy.h"
+#include "Utilities/Ref.h"
+#include "Rendering/Objects/Buffer.h"
+#include "Rendering/Objects/BindArray.h"
+#include "Rendering/Objects/Material.h"
+#include "Rendering/Objects/CommandBuffer.h"
+
+namespace PK::Rendering
+{
+    // Modified ranges closer than this are uploaded with a single copy.
+    constexpr static const size_t PK_MATERIAL_UPLOAD_MERGE_DISTANCE = 4096ull;
+
+    /*
+     * Persistent property slots & bindless texture indices for materials.
+     * A material keeps its slot across frames & is only copied & uploaded when its property block version has changed.
+     * Slots & texture indices are not released as materials & textures are assets that live as long as the asset database.
+     */
+    class MaterialRegistry : public Utilities::NoCopy
+    {
+        public:
+            MaterialRegistry(uint32_t textureCapacity);
+
+            // Returns the index of the material's properties in units of its property stride.
+            uint32_t Register(const Objects::Material* material);
+
+            // Uploads modified slots & refreshes the handles of reloaded textures.
+            void Upload(Objects::CommandBuffer* cmd);
+
+            inline Objects::Buffer* GetProperties() const { return m_properties.get(); }
+            inline Objects::BindArray<Objects::Texture>* GetTextures() const { return m_textures.get(); }
+
+        private:
+            struct Slot
+            {
+                size_t offset = 0ull;
+                size_t stride = 0ull;
+                uint64_t version = 0ull;
+            };
+
+            struct TextureEntry
+            {
+                const Objects::Texture* texture;
+                uint32_t assetVersion;
+            };
+
+            uint32_t GetTextureIndex(const Objects::Texture* texture);
+
+            Utilities::Ref<Objects::Buffer> m_properties;
+            Utilities::Ref<Objects::BindArray<Objects::Texture>> m_textures;
+            std::unordered_map<const Objects::Material*, Slot> m_slots;
+            std::unordered_map<const Objects::Texture*, uint32_t> m_textureIndices;
+            std::vector<TextureEntry> m_textureEntries;
+            std::vector<uint32_t> m_textureScratch;
+            std::vector<Structs::IndexRange> m_modifiedRanges;
+            // Cpu side copy of the property buffer. Fully uploaded when the buffer is resized.
+            std::vector<char> m_data;
+            uint32_t m_textureCapacity = 0u;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,441 @@
+#include "PrecompiledHeader.h"
+#include "RenderGraph.h"
+#include "Core/Services/Log.h"
+#include "Core/Services/Profiler.h"
+#include "Math/FunctionsMisc.h"
+#include <chrono>
+
+namespace PK::Rendering
+{
+    using namespace Utilities;
+    using namespace Math;
+    using namespace Objects;
+    using namespace Structs;
+
+    constexpr static const uint32_t QUEUE_COUNT = (uint32_t)QueueType::MaxCount;
+    constexpr static const uint32_t UNUSED_PASS = 0xFFFFFFFFu;
+
+    RenderGraph::RenderGraph()
+    {
+        m_heap = TransientHeap::Create("RenderGraph.TransientHeap");
+
+        for (auto i = 0u; i < QUEUE_COUNT; ++i)
+        {
+            m_submitIndices[i] = 1ull;
+        }
+    }
+
+    RenderGraphResource RenderGraph::Import(const char* name, bool isFrameLocal)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.isFrameLocal = isFrameLocal;
+        resource.transient = -1;
+        m_resources.push_back(resource);
+        m_isDirty = true;
+        return (RenderGraphResource)(m_resources.size() - 1ull);
+    }
+
+    RenderGraphResource RenderGraph::CreateTexture(const char* name, const TextureDescriptor& descriptor, float resolutionScale)
+    {
+        auto handle = Import(name, true);
+        m_resources[handle].transient = (int32_t)m_transients.size();
+
+        Transient transient{};
+        transient.resource = handle;
+        transient.descriptor = descriptor;
+        transient.resolutionScale = resolutionScale;
+        m_transients.push_back(transient);
+        return handle;
+    }
+
+    Texture* RenderGraph::GetTexture(RenderGraphResource resource) const
+    {
+        PK_THROW_ASSERT(resource < m_resources.size() && m_resources[resource].transient != -1, "Render graph resource is not a transient texture!");
+        return m_transients[m_resources[resource].transient].texture.get();
+    }
+
+    void RenderGraph::AddPass(const char* name, QueueType queue, std::initializer_list<RenderGraphResource> reads, std::initializer_list<RenderGraphResource> writes, const ExecuteFunction& execute)
+    {
+        Pass pass{};
+        pass.name = name;
+        pass.queue = queue;
+        pass.firstAccess = (uint32_t)m_accesses.size();
+        pass.accessCount = (uint32_t)(reads.size() + writes.size());
+        pass.execute = execute;
+
+        for (auto resource : reads)
+        {
+            PK_THROW_ASSERT(resource < m_resources.size(), "Render graph pass %s reads an unknown resource!", name);
+            m_accesses.push_back({ resource, false });
+        }
+
+        for (auto resource : writes)
+        {
+            PK_THROW_ASSERT(resource < m_resources.size(), "Render graph pass %s writes an unknown resource!", name);
+            m_accesses.push_back({ resource, true });
+        }
+
+        m_passes.push_back(pass);
+        m_isDirty = true;
+    }
+
+    void RenderGraph::SetResolution(const uint3& resolution)
+    {
+        if (m_resolution != resolution)
+        {
+            m_resolution = resolution;
+            m_isDirty = true;
+        }
+    }
+
+    void RenderGraph::Execute(QueueSet* queues)
+    {
+        PK_PROFILE_FUNCTION();
+
+        if (m_isDirty)
+        {
+            Compile();
+            m_isDirty = false;
+        }
+
+        m_stats.frameSubmitCount = 0u;
+        m_stats.frameSyncCount = 0u;
+        m_stats.frameRedundantSyncCount = 0u;
+
+        for (auto& resource : m_resources)
+        {
+            if (resource.isFrameLocal)
+            {
+                resource.writeSubmit = 0ull;
+                memset(resource.readSubmits, 0, sizeof(resource.readSubmits));
+            }
+        }
+
+        for (auto i = 0u; i < m_passes.size(); ++i)
+        {
+            auto& pass = m_passes[i];
+            auto queueIndex = (uint32_t)pass.queue;
+            uint64_t waits[QUEUE_COUNT]{};
+
+            auto require = [&](QueueType queue, uint64_t submit)
+            {
+                if (submit == 0ull || queue == pass.queue)
+                {
+                    return;
+                }
+
+                // Producer is still recording.
+                if (submit == m_submitIndices[(uint32_t)queue])
+                {
+                    Submit(queues, queue);
+                }
+
+                auto value = GetSubmitValue(queue, submit);
+                waits[(uint32_t)queue] = value > waits[(uint32_t)queue] ? value : waits[(uint32_t)queue];
+            };
+
+            for (auto j = pass.firstAccess; j < pass.firstAccess + pass.accessCount; ++j)
+            {
+                auto& access = m_accesses[j];
+                auto& resource = m_resources[access.resource];
+                require(resource.writeQueue, resource.writeSubmit);
+
+                for (auto q = 0u; q < QUEUE_COUNT && access.isWrite; ++q)
+                {
+                    require((QueueType)q, resource.readSubmits[q]);
+                }
+            }
+
+            for (auto q = 0u; q < QUEUE_COUNT; ++q)
+            {
+                if (waits[q] == 0ull)
+                {
+                    continue;
+                }
+
+                if (waits[q] <= m_waitValues[queueIndex][q])
+                {
+                    m_stats.frameRedundantSyncCount++;
+                    continue;
+                }
+
+                // Work recorded before the dependency should not wait for it.
+                if (m_isRecording[queueIndex])
+                {
+                    Submit(queues, pass.queue);
+                }
+
+                auto offset = (int64_t)waits[q] - (int64_t)queues->GetSubmitCount((QueueType)q);
+                queues->Sync((QueueType)q, pass.queue, (int32_t)offset);
+                m_waitValues[queueIndex][q] = waits[q];
+                m_stats.frameSyncCount++;
+            }
+
+            auto cmd = queues->GetCommandBuffer(pass.queue);
+
+            for (auto resource : pass.discards)
+            {
+                cmd->DiscardTexture(GetTexture(resource));
+            }
+
+            {
+                PK_PROFILE_SCOPE(pass.name);
+                pass.execute(cmd);
+            }
+
+            m_isRecording[queueIndex] = true;
+
+            for (auto j = pass.firstAccess; j < pass.firstAccess + pass.accessCount; ++j)
+            {
+                auto& access = m_accesses[j];
+                auto& resource = m_resources[access.resource];
+
+                if (access.isWrite)
+                {
+                    resource.writeSubmit = m_submitIndices[queueIndex];
+                    resource.writeQueue = pass.queue;
+                    memset(resource.readSubmits, 0, sizeof(resource.readSubmits));
+                }
+                else
+                {
+                    resource.readSubmits[queueIndex] = m_submitIndices[queueIndex];
+                }
+            }
+
+            // Hand the batch over early so that the other queue can start on it.
+            if (i + 1u < m_passes.size() && m_passes[i + 1u].queue != pass.queue)
+            {
+                Submit(queues, pass.queue);
+            }
+        }
+
+        for (auto q = 0u; q < QUEUE_COUNT; ++q)
+        {
+            if (m_isRecording[q])
+            {
+                Submit(queues, (QueueType)q);
+            }
+        }
+    }
+
+    void RenderGraph::Compile()
+    {
+        PK_PROFILE_FUNCTION();
+        auto timestamp = std::chrono::steady_clock::now();
+
+        auto compileCount = m_stats.compileCount + 1u;
+        m_stats = {};
+        m_stats.compileCount = compileCount;
+        m_stats.passCount = (uint32_t)m_passes.size();
+        m_stats.resourceCount = (uint32_t)m_resources.size();
+        m_stats.transientCount = (uint32_t)m_transients.size();
+
+        for (auto& transient : m_transients)
+        {
+            transient.texture = nullptr;
+            transient.firstPass = UNUSED_PASS;
+            transient.lastPass = 0u;
+            transient.isSingleQueue = true;
+        }
+
+        // Hazards are counted within a single frame. Cross frame dependencies depend on the submits of the previous frame.
+        std::vector<uint32_t> writers(m_resources.size(), UNUSED_PASS);
+        std::vector<std::vector<uint32_t>> readers(m_resources.size());
+
+        for (auto i = 0u; i < m_passes.size(); ++i)
+        {
+            auto& pass = m_passes[i];
+            pass.discards.clear();
+
+            auto count = [&](uint32_t other)
+            {
+                if (other == UNUSED_PASS || other == i)
+                {
+                    return;
+                }
+
+                if (m_passes[other].queue == pass.queue)
+                {
+                    m_stats.barrierCount++;
+                }
+                else
+                {
+                    m_stats.dependencyCount++;
+                }
+            };
+
+            for (auto j = pass.firstAccess; j < pass.firstAccess + pass.accessCount; ++j)
+            {
+                auto& access = m_accesses[j];
+                auto& resource = m_resources[access.resource];
+
+                if (resource.transient != -1)
+                {
+                    auto& transient = m_transients[resource.transient];
+
+                    if (transient.firstPass == UNUSED_PASS)
+                    {
+                        transient.firstPass = i;
+                        transient.queue = pass.queue;
+                    }
+
+                    transient.lastPass = i;
+                    transient.isSingleQueue &= transient.queue == pass.queue;
+                }
+
+                count(writers[access.resource]);
+
+                if (!access.isWrite)
+                {
+                    readers[access.resource].push_back(i);
+                    continue;
+                }
+
+                for (auto reader : readers[access.resource])
+                {
+                    count(reader);
+                }
+
+                readers[access.resource].clear();
+                writers[access.resource] = i;
+            }
+        }
+
+        // Unused transients & transients shared between queues are alive for the whole frame.
+        for (auto& transient : m_transients)
+        {
+            if (transient.firstPass == UNUSED_PASS || !transient.isSingleQueue)
+            {
+                transient.firstPass = 0u;
+                transient.lastPass = m_passes.empty() ? 0u : (uint32_t)m_passes.size() - 1u;
+                transient.isSingleQueue = false;
+            }
+        }
+
+        auto isLifetimeOverlap = [](const Transient& a, const Transient& b)
+        {
+            if (!a.isSingleQueue || !b.isSingleQueue || a.queue != b.queue)
+            {
+                return true;
+            }
+
+            return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+        };
+
+        auto isMemoryOverlap = [](const Transient& a, const Transient& b)
+        {
+            return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+        };
+
+        std::vector<size_t> alignments(m_transients.size());
+        std::vector<uint32_t> order(m_transients.size());
+
+        for (auto i = 0u; i < m_transients.size(); ++i)
+        {
+            auto& transient = m_transients[i];
+
+            if (transient.resolutionScale > 0.0f)
+            {
+                transient.descriptor.resolution.x = std::max<uint32_t>(1u, (uint32_t)(m_resolution.x * transient.resolutionScale));
+                transient.descriptor.resolution.y = std::max<uint32_t>(1u, (uint32_t)(m_resolution.y * transient.resolutionScale));
+            }
+
+            transient.size = m_heap->GetRequirements(transient.descriptor, &alignments[i]);
+            transient.offset = 0ull;
+            m_stats.transientBytes += transient.size;
+            order[i] = i;
+        }
+
+        // Largest first. Each transient is placed at the lowest offset that does not overlap a placed transient with an overlapping lifetime.
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return m_transients[a].size > m_transients[b].size; });
+        size_t heapSize = 0ull;
+
+        for (auto i = 0u; i < order.size(); ++i)
+        {
+            auto& transient = m_transients[order[i]];
+
+            for (auto isMoved = true; isMoved;)
+            {
+                isMoved = false;
+
+                for (auto j = 0u; j < i; ++j)
+                {
+                    auto& placed = m_transients[order[j]];
+
+                    if (isLifetimeOverlap(transient, placed) && isMemoryOverlap(transient, placed))
+                    {
+                        auto alignment = alignments[order[i]];
+                        transient.offset = ((placed.offset + placed.size + alignment - 1ull) / alignment) * alignment;
+                        isMoved = true;
+                    }
+                }
+            }
+
+            heapSize = std::max<size_t>(heapSize, transient.offset + transient.size);
+        }
+
+        for (auto i = 0u; i < m_transients.size() && !m_passes.empty(); ++i)
+        {
+            for (auto j = 0u; j < m_transients.size(); ++j)
+            {
+                if (i != j && isMemoryOverlap(m_transients[i], m_transients[j]))
+                {
+                    m_passes[m_transients[i].firstPass].discards.push_back(m_transients[i].resource);
+                    m_stats.aliasedCount++;
+                    break;
+                }
+            }
+        }
+
+        for (auto i = 0u; i < m_passes.size(); ++i)
+        {
+            size_t aliveBytes = 0ull;
+
+            for (auto& transient : m_transients)
+            {
+                aliveBytes += transient.firstPass <= i && i <= transient.lastPass ? transient.size : 0ull;
+            }
+
+            m_stats.peakTransientBytes = std::max<size_t>(m_stats.peakTransientBytes, aliveBytes);
+        }
+
+        if (heapSize > 0ull)
+        {
+            m_heap->Validate(heapSize);
+
+            for (auto& transient : m_transients)
+            {
+                transient.texture = m_heap->CreateTexture(transient.descriptor, transient.offset, m_resources[transient.resource].name);
+            }
+        }
+
+        m_stats.heapBytes = m_heap->GetSize();
+        m_stats.compileMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - timestamp).count();
+
+        PK_LOG_VERBOSE("Compiled render graph: %i passes, %i transients, heap: %s, peak: %s, %.2fms",
+            m_stats.passCount,
+            m_stats.transientCount,
+            Functions::BytesToString(m_stats.heapBytes).c_str(),
+            Functions::BytesToString(m_stats.peakTransientBytes).c_str(),
+            m_stats.compileMilliseconds);
+    }
+
+    void RenderGraph::Submit(QueueSet* queues, QueueType queue)
+    {
+        auto index = (uint32_t)queue;
+        queues->Submit(queue);
+        m_submitValues[index][m_submitIndices[index] % PK_RENDER_GRAPH_SUBMIT_HISTORY] = queues->GetSubmitCount(queue);
+        m_submitIndices[index]++;
+        m_isRecording[index] = false;
+        m_stats.frameSubmitCount++;
+    }
+
+    uint64_t RenderGraph::GetSubmitValue(QueueType queue, uint64_t submit) const
+    {
+        auto index = (uint32_t)queue;
+        auto oldest = m_submitIndices[index] > PK_RENDER_GRAPH_SUBMIT_HISTORY ? m_submitIndices[index] - PK_RENDER_GRAPH_SUBMIT_HISTORY : 0ull;
+        submit = submit < oldest ? oldest : submit;
+        return m_submitValues[index][submit % PK_RENDER_GRAPH_SUBMIT_HISTORY];
+    }
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+#include "Utilities/NoCopy.h"
+#include "Rendering/Objects/QueueSet.h"
+#include "Rendering/Objects/TransientHeap.h"
+
+namespace PK::Rendering
+{
+    typedef uint32_t RenderGraphResource;
+    constexpr static const RenderGraphResource PK_RENDER_GRAPH_INVALID_RESOURCE = 0xFFFFFFFFu;
+    // Timeline values of older graph submits are discarded. Dependencies on them wait for the oldest retained submit instead.
+    constexpr static const uint32_t PK_RENDER_GRAPH_SUBMIT_HISTORY = 64u;
+
+    struct RenderGraphStats
+    {
+        uint32_t passCount = 0u;
+        uint32_t resourceCount = 0u;
+        uint32_t transientCount = 0u;
+        uint32_t compileCount = 0u;
+        // Same queue hazards between passes. These are resolved by barriers derived from the recorded resource accesses.
+        uint32_t barrierCount = 0u;
+        // Cross queue dependencies within a frame.
+        uint32_t dependencyCount = 0u;
+        // Transients that share memory with another transient & are discarded before their first access.
+        uint32_t aliasedCount = 0u;
+        // Sum of transient sizes without aliasing.
+        size_t transientBytes = 0ull;
+        // Largest sum of transient sizes alive during a single pass.
+        size_t peakTransientBytes = 0ull;
+        size_t heapBytes = 0ull;
+        float compileMilliseconds = 0.0f;
+        // Counts of the last executed frame.
+        uint32_t frameSubmitCount = 0u;
+        uint32_t frameSyncCount = 0u;
+        uint32_t frameRedundantSyncCount = 0u;
+    };
+
+    /*
+     * Passes declare the logical resources they read & write and are executed in declaration order.
+     * A pass batch is submitted when the next pass runs on another queue or when a pass on another queue depends on it.
+     * Cross queue dependencies become semaphore waits on the producing submit. Waits already covered by an earlier wait are skipped.
+     * Transient textures are placed in a shared heap. Transients used by non overlapping pass ranges of a single queue alias each other.
+     */
+    class RenderGraph : public Utilities::NoCopy
+    {
+        public:
+            typedef std::function<void(Objects::CommandBuffer*)> ExecuteFunction;
+
+            RenderGraph();
+
+            // Accesses to frame local resources are not synchronized against accesses of previous frames.
+            RenderGraphResource Import(const char* name, bool isFrameLocal = false);
+
+            // Contents are undefined at the first access of each frame.
+            // A resolution scale greater than zero overrides the descriptor resolution with the scaled graph resolution.
+            RenderGraphResource CreateTexture(const char* name, const Structs::TextureDescriptor& descriptor, float resolutionScale = 0.0f);
+            Objects::Texture* GetTexture(RenderGraphResource resource) const;
+
+            // Names are expected to point to static storage.
+            void AddPass(const char* name,
+                         Structs::QueueType queue,
+                         std::initializer_list<RenderGraphResource> reads,
+                         std::initializer_list<RenderGraphResource> writes,
+                         const ExecuteFunction& execute);
+
+            void SetResolution(const Math::uint3& resolution);
+
+            // Recompiles if passes, transients or the resolution have changed since the last execution.
+            void Execute(Objects::QueueSet* queues);
+
+            constexpr const RenderGraphStats& GetStats() const { return m_stats; }
+
+        private:
+            struct Access
+            {
+                RenderGraphResource resource;
+                bool isWrite;
+            };
+
+            struct Pass
+            {
+                const char* name;
+                Structs::QueueType queue;
+                uint32_t firstAccess;
+                uint32_t accessCount;
+                ExecuteFunction execute;
+                // Aliased transients first accessed by this pass.
+                std::vector<RenderGraphResource> discards;
+            };
+
+            struct Resource
+            {
+                const char* name;
+                bool isFrameLocal;
+                int32_t transient;
+                // Graph submit indices of the last write & the reads since then. Zero if there are none.
+                uint64_t writeSubmit;
+                Structs::QueueType writeQueue;
+                uint64_t readSubmits[(uint32_t)Structs::QueueType::MaxCount];
+            };
+
+            struct Transient
+            {
+                RenderGraphResource resource;
+                Structs::TextureDescriptor descriptor;
+                float resolutionScale;
+                Utilities::Ref<Objects::Texture> texture;
+                size_t offset;
+                size_t size;
+                uint32_t firstPass;
+                uint32_t lastPass;
+                Structs::QueueType queue;
+                bool isSingleQueue;
+            };
+
+            void Compile();
+            void Submit(Objects::QueueSet* queues, Structs::QueueType queue);
+            uint64_t GetSubmitValue(Structs::QueueType queue, uint64_t submit) const;
+
+            std::vector<Pass> m_passes;
+            std::vector<Access> m_accesses;
+            std::vector<Resource> m_resources;
+            std::vector<Transient> m_transients;
+            Utilities::Ref<Objects::TransientHeap> m_heap;
+            Math::uint3 m_resolution = Math::PK_UINT3_ONE;
+            bool m_isDirty = true;
+
+            // Index of the open submit per queue. Advances each time the queue is submitted.
+            uint64_t m_submitIndices[(uint32_t)Structs::QueueType::MaxCount]{};
+            uint64_t m_submitValues[(uint32_t)Structs::QueueType::MaxCount][PK_RENDER_GRAPH_SUBMIT_HISTORY]{};
+            bool m_isRecording[(uint32_t)Structs::QueueType::MaxCount]{};
+            // Largest timeline value of each queue (column) that a queue (row) has already waited for.
+            uint64_t m_waitValues[(uint32_t)Structs::QueueType::MaxCount][(uint32_t)Structs::QueueType::MaxCount]{};
+
+            RenderGraphStats m_stats{};
+    };
+}
\ No newline at end of file
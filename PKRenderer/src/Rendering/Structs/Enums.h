@@ -22,6 +22,11 @@ namespace PK::Rendering::Structs
     constexpr static const uint32_t PK_MAX_VERTEX_ATTRIBUTES = PK::Assets::PK_ASSET_MAX_VERTEX_ATTRIBUTES;
     constexpr static const uint32_t PK_MAX_UNBOUNDED_SIZE = PK::Assets::PK_ASSET_MAX_UNBOUNDED_SIZE;
     constexpr static const uint32_t PK_MAX_VIEWPORTS = 16;
+    constexpr static const uint32_t PK_MAX_MESH_LODS = PK::Assets::PK_ASSET_MAX_MESH_LODS;
+    // Projected radius relative to half of the view height below which lod level i + 1 is used.
+    constexpr static const float PK_MESH_LOD_SCREEN_SIZES[PK_MAX_MESH_LODS - 1] = { 0.25f, 0.1f, 0.04f };
+    // Maximum simplification error relative to half of the view height at the size a lod level is first used.
+    constexpr static const float PK_MESH_LOD_MAX_SCREEN_ERROR = 0.004f;
 
     constexpr const static char* PK_VS_POSITION = PK::Assets::Mesh::PK_VS_POSITION;
     constexpr const static char* PK_VS_NORMAL = PK::Assets::Mesh::PK_VS_NORMAL;
@@ -20,10 +20,16 @@ namespace PK::Rendering::VulkanRHI::Objects
         }
     }
 
+    static std::string GetSubStructureName(Mesh* mesh, uint32_t submeshIndex)
+    {
+        return mesh->GetFileName() + std::string(".Submesh") + std::to_string(submeshIndex) + std::string(".BLAS");
+    }
+
     VulkanAccelerationStructure::VulkanAccelerationStructure(const char* name) :
         m_driver(GraphicsAPI::GetActiveDriver<VulkanDriver>()),
         m_name(name)
     {
+        m_instanceInputBuffer = Buffer::Create(ElementType::Float4x4, 256ull, BufferUsage::InstanceInput | BufferUsage::GPUOnly | BufferUsage::TransferDst, (m_name + std::string(".InstanceInputBuffer")).c_str());
     }
 
     VulkanAccelerationStructure::~VulkanAccelerationStructure()
@@ -49,24 +55,6 @@ namespace PK::Rendering::VulkanRHI::Objects
         return m_scratchBuffer;
     }
 
-    VulkanRawBuffer* VulkanAccelerationStructure::GetInstanceBuffer(size_t size)
-    {
-        if (m_instanceInputBuffer == nullptr || m_instanceInputBuffer->capacity < size)
-        {
-            if (m_instanceInputBuffer != nullptr)
-            {
-                m_driver->disposer->Dispose(m_instanceInputBuffer, m_cmd->GetFenceRef());
-            }
-
-            m_instanceInputBuffer = new VulkanRawBuffer(m_driver->device,
-                m_driver->allocator,
-                VulkanBufferCreateInfo(BufferUsage::InstanceInput | BufferUsage::DefaultStaging, size),
-                (m_name + std::string(".InstanceInputBuffer")).c_str());
-        }
-
-        return m_instanceInputBuffer;
-    }
-
     VulkanRawAccelerationStructure* VulkanAccelerationStructure::GetMeshStructure(Mesh* mesh, uint32_t submeshIndex)
     {
         MeshKey key{ mesh, submeshIndex };
@@ -96,7 +84,7 @@ namespace PK::Rendering::VulkanRHI::Objects
         }
 
         PK_THROW_ASSERT(vertexElement, "Could not find position stream in mesh!");
-        PK_THROW_ASSERT(vertexElement->Type == ElementType::Float3, "Non float3 vertex positions are not supported!");
+        PK_THROW_ASSERT(vertexElement->Type == ElementType::Float3 || vertexElement->Type == ElementType::Half4, "Non float3 or half4 vertex positions are not supported!");
 
         auto submesh = mesh->GetSubmesh(submeshIndex);
         auto nativeVertexBuffer = vertexBuffer->GetNative<VulkanBuffer>();
@@ -108,8 +96,8 @@ namespace PK::Rendering::VulkanRHI::Objects
         accelerationStructureGeometry.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
         accelerationStructureGeometry.geometry.triangles.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
 
-        // Hardcoded format for float3
-        accelerationStructureGeometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
+        // Half4 is used by compact vertex layouts. The w component is ignored by the build.
+        accelerationStructureGeometry.geometry.triangles.vertexFormat = vertexElement->Type == ElementType::Half4 ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R32G32B32_SFLOAT;
         accelerationStructureGeometry.geometry.triangles.vertexData.deviceAddress = nativeVertexBuffer->GetRaw()->deviceAddress + vertexElement->Offset;
         accelerationStructureGeometry.geometry.triangles.maxVertex = (uint32_t)nativeVertexBuffer->GetCount() - 1u;
         accelerationStructureGeometry.geometry.triangles.vertexStride = nativeVertexBuffer->GetLayout().GetStride();
@@ -128,47 +116,193 @@ namespace PK::Rendering::VulkanRHI::Objects
             accelerationStructureGeometry,
             rangeInfo,
             VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
-            (mesh->GetFileName() + std::string(".Submesh") + std::to_string(submeshIndex) + std::string(".BLAS")).c_str());
+            VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR,
+            GetSubStructureName(mesh, submeshIndex).c_str());
 
         m_subStructures.AddValue(key, structure);
         return structure;
     }
 
+    void VulkanAccelerationStructure::CompactSubStructures()
+    {
+        while (!m_compactionBatches.empty() && m_compactionBatches.front().fence.IsComplete())
+        {
+            auto& batch = m_compactionBatches.front();
+            auto queryPool = batch.queryPool;
+            std::vector<VkDeviceSize> compactedSizes(queryPool->count);
+
+            auto result = vkGetQueryPoolResults(m_driver->device,
+                queryPool->pool,
+                0u,
+                queryPool->count,
+                sizeof(VkDeviceSize) * queryPool->count,
+                compactedSizes.data(),
+                sizeof(VkDeviceSize),
+                VK_QUERY_RESULT_64_BIT);
+
+            if (result == VK_SUCCESS)
+            {
+                auto keyValues = m_subStructures.GetKeyValues();
+
+                for (auto i = 0u; i < queryPool->count; ++i)
+                {
+                    auto index = batch.firstSubStructure + i;
+                    auto source = keyValues.values[index];
+
+                    if (compactedSizes[i] == 0ull || compactedSizes[i] >= source->rawBuffer->capacity)
+                    {
+                        continue;
+                    }
+
+                    const auto& key = keyValues.keys[index].key;
+                    auto compacted = new VulkanRawAccelerationStructure(m_driver->device, m_driver->allocator, *source, compactedSizes[i], GetSubStructureName(key.mesh, (uint32_t)key.submesh).c_str());
+
+                    VkCopyAccelerationStructureInfoKHR copyInfo{ VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR };
+                    copyInfo.src = source->structure;
+                    copyInfo.dst = compacted->structure;
+                    copyInfo.mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+                    m_cmd->CopyAccelerationStructure(&copyInfo);
+
+                    // Instances of the previous write may still reference the source.
+                    for (auto j = 0u; j < m_instanceCount; ++j)
+                    {
+                        if (m_instances[j].accelerationStructureReference == source->deviceAddress)
+                        {
+                            m_instances[j].accelerationStructureReference = compacted->deviceAddress;
+                            m_modifiedInstances.push_back(j);
+                            m_isInstanceSetModified = true;
+                        }
+                    }
+
+                    m_driver->disposer->Dispose(source, m_cmd->GetFenceRef());
+                    keyValues.values[index] = compacted;
+                }
+            }
+
+            m_driver->disposer->Dispose(queryPool, m_cmd->GetFenceRef());
+            m_compactionBatches.erase(m_compactionBatches.begin());
+        }
+    }
+
+    void VulkanAccelerationStructure::UploadInstances()
+    {
+        auto instanceSize = sizeof(VkAccelerationStructureInstanceKHR);
+        auto buffer = m_instanceInputBuffer.get();
+
+        // Resizing discards the previous contents. Slots past the current count are uploaded as well as they are matched against in later writes.
+        if (buffer->GetCount() < m_instances.size())
+        {
+            buffer->Validate(std::max<size_t>(m_instances.size(), buffer->GetCount() * 2ull));
+            memcpy(m_cmd->BeginBufferWrite(buffer, 0ull, instanceSize * m_instances.size()), m_instances.data(), instanceSize * m_instances.size());
+            m_cmd->EndBufferWrite(buffer);
+            return;
+        }
+
+        if (m_modifiedInstances.empty())
+        {
+            return;
+        }
+
+        // Updates are issued in transform change order & slots may have been modified by both compaction & a write.
+        std::sort(m_modifiedInstances.begin(), m_modifiedInstances.end());
+        m_modifiedInstances.erase(std::unique(m_modifiedInstances.begin(), m_modifiedInstances.end()), m_modifiedInstances.end());
+
+        auto first = m_modifiedInstances.at(0);
+        auto last = first;
+
+        for (auto i = 1u; i <= m_modifiedInstances.size(); ++i)
+        {
+            if (i < m_modifiedInstances.size() && m_modifiedInstances.at(i) <= last + PK_ACCELERATION_STRUCTURE_UPLOAD_MERGE_DISTANCE)
+            {
+                last = m_modifiedInstances.at(i);
+                continue;
+            }
+
+            auto count = last - first + 1u;
+            memcpy(m_cmd->BeginBufferWrite(buffer, instanceSize * first, instanceSize * count), m_instances.data() + first, instanceSize * count);
+            m_cmd->EndBufferWrite(buffer);
+
+            if (i < m_modifiedInstances.size())
+            {
+                first = last = m_modifiedInstances.at(i);
+            }
+        }
+    }
+
     void VulkanAccelerationStructure::BeginWrite(Structs::QueueType queue, uint32_t instanceLimit)
     {
-        PK_THROW_ASSERT(m_writeBuffer == nullptr, "Structure is already being written into!");
+        PK_THROW_ASSERT(m_cmd == nullptr, "Structure is already being written into!");
 
         m_cmd = m_driver->queues->GetQueue(queue)->commandPool->GetCurrent();
         m_previousSubStructureCount = m_subStructures.GetCount();
+        m_previousInstanceCount = m_instanceCount;
+        m_isInstanceSetModified = false;
+        m_modifiedInstances.clear();
+
+        // Compaction patches the slots of the previous write before they are matched against.
+        CompactSubStructures();
+
         m_instanceLimit = instanceLimit;
         m_instanceCount = 0u;
 
-        auto instanceInputBufferSize = sizeof(VkAccelerationStructureInstanceKHR) * m_instanceLimit;
-        auto instanceSize = sizeof(VkAccelerationStructureInstanceKHR);
-        auto instanceInputBuffer = GetInstanceBuffer(instanceInputBufferSize);
-        m_writeBuffer = reinterpret_cast<VkAccelerationStructureInstanceKHR*>(instanceInputBuffer->BeginMap(0ull));
+        if (m_instances.size() < m_instanceLimit)
+        {
+            m_instances.resize(m_instanceLimit);
+        }
     }
 
-    void VulkanAccelerationStructure::AddInstance(Mesh* mesh, uint32_t submesh, uint32_t customIndex, const PK::Math::float4x4& matrix)
+    void VulkanAccelerationStructure::BeginUpdate(Structs::QueueType queue)
+    {
+        PK_THROW_ASSERT(m_cmd == nullptr, "Structure is already being written into!");
+
+        m_cmd = m_driver->queues->GetQueue(queue)->commandPool->GetCurrent();
+        m_previousSubStructureCount = m_subStructures.GetCount();
+        m_previousInstanceCount = m_instanceCount;
+        m_instanceLimit = m_instanceCount;
+        m_isInstanceSetModified = false;
+        m_modifiedInstances.clear();
+        CompactSubStructures();
+    }
+
+    bool VulkanAccelerationStructure::AddInstance(Mesh* mesh, uint32_t submesh, uint32_t customIndex, const PK::Math::float4x4& matrix)
     {
         // Wait for mesh uploads to finnish before building BLAS
         if (mesh->HasPendingUpload())
         {
-            return;
+            return false;
         }
 
         PK_THROW_ASSERT(m_instanceCount < m_instanceLimit, "Instance limit exceeded!");
 
         auto substructure = GetMeshStructure(mesh, submesh);
+        auto index = m_instanceCount++;
+        auto instance = &m_instances[index];
+
+        VkAccelerationStructureInstanceKHR written{};
+        CopyVkMatrix(written.transform, matrix);
+        written.instanceCustomIndex = customIndex;
+        written.mask = 0xFF;
+        written.instanceShaderBindingTableRecordOffset = 0;
+        written.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+        written.accelerationStructureReference = substructure->deviceAddress;
+
+        if (memcmp(instance, &written, sizeof(VkAccelerationStructureInstanceKHR)) == 0)
+        {
+            return true;
+        }
 
-        VkAccelerationStructureInstanceKHR* instance = m_writeBuffer + m_instanceCount++;
+        // Transform only changes can be refit.
+        m_isInstanceSetModified |= instance->accelerationStructureReference != written.accelerationStructureReference || instance->instanceCustomIndex != customIndex;
+        *instance = written;
+        m_modifiedInstances.push_back(index);
+        return true;
+    }
 
-        CopyVkMatrix(instance->transform, matrix);
-        instance->instanceCustomIndex = 0;
-        instance->mask = 0xFF;
-        instance->instanceShaderBindingTableRecordOffset = 0;
-        instance->flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
-        instance->accelerationStructureReference = substructure->deviceAddress;
+    void VulkanAccelerationStructure::SetInstanceTransform(uint32_t index, const PK::Math::float4x4& matrix)
+    {
+        PK_THROW_ASSERT(index < m_instanceCount, "Instance index out of bounds!");
+        CopyVkMatrix(m_instances[index].transform, matrix);
+        m_modifiedInstances.push_back(index);
     }
 
     void VulkanAccelerationStructure::EndWrite()
@@ -178,9 +312,45 @@ namespace PK::Rendering::VulkanRHI::Objects
             PK_LOG_WARNING("Ray tracing structure build has no instances!");
         }
 
+        m_isInstanceSetModified |= m_structure == nullptr || m_instanceCount != m_previousInstanceCount;
+
+        // Refits degrade the top level hierarchy as instances move away from the placements it was built for.
+        auto isRebuild = m_isInstanceSetModified;
+
+        if (!isRebuild && !m_modifiedInstances.empty())
+        {
+            m_refitAmount += (float)m_modifiedInstances.size() / m_instanceCount;
+            isRebuild = m_refitAmount > PK_ACCELERATION_STRUCTURE_REFIT_LIMIT;
+        }
+
+        if (!isRebuild && m_modifiedInstances.empty())
+        {
+            m_cmd = nullptr;
+            return;
+        }
+
+        if (isRebuild)
+        {
+            m_refitAmount = 0.0f;
+        }
+
+        // Previous builds read the instance buffer & the scratch buffer. Updates also read the previous structure.
+        {
+            VkMemoryBarrier memoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+            memoryBarrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+            memoryBarrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_TRANSFER_WRITE_BIT;
+            VulkanBarrierInfo barrier;
+            barrier.srcStageMask = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+            barrier.dstStageMask = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_TRANSFER_BIT;
+            barrier.memoryBarrierCount = 1u;
+            barrier.pMemoryBarriers = &memoryBarrier;
+            m_cmd->PipelineBarrier(barrier);
+        }
+
+        UploadInstances();
+
         auto substructureCount = m_subStructures.GetCount() - m_previousSubStructureCount;
-        auto instanceInputBufferSize = sizeof(VkAccelerationStructureInstanceKHR) * m_instanceLimit;
-        auto instanceSize = sizeof(VkAccelerationStructureInstanceKHR);
+        auto tlasFlags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
         VkDeviceSize scratchBufferSize = 0ull;
 
         for (auto i = m_previousSubStructureCount; i < m_subStructures.GetCount(); ++i)
@@ -188,19 +358,17 @@ namespace PK::Rendering::VulkanRHI::Objects
             scratchBufferSize += m_subStructures.GetValues()[i]->scratchBufferSize;
         }
 
-        m_instanceInputBuffer->EndMap(0, instanceInputBufferSize);
-        m_writeBuffer = nullptr;
-
         VkAccelerationStructureGeometryKHR accelerationStructureGeometry{ VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR };
         accelerationStructureGeometry.geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR;
         accelerationStructureGeometry.flags = VK_GEOMETRY_OPAQUE_BIT_KHR;
         accelerationStructureGeometry.geometry.instances.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
         accelerationStructureGeometry.geometry.instances.arrayOfPointers = VK_FALSE;
-        accelerationStructureGeometry.geometry.instances.data.deviceAddress = m_instanceInputBuffer->deviceAddress;
+        accelerationStructureGeometry.geometry.instances.data.deviceAddress = m_instanceInputBuffer->GetNative<VulkanBuffer>()->GetRaw()->deviceAddress;
 
         auto accelerationStructureBuildSizesInfo = VulkanRHI::Utilities::VulkanGetAccelerationBuildSizesInfo(m_driver->device,
             accelerationStructureGeometry,
             VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+            tlasFlags,
             m_instanceCount);
 
         VkAccelerationStructureBuildRangeInfoKHR accelerationStructureBuildRangeInfo{};
@@ -209,7 +377,7 @@ namespace PK::Rendering::VulkanRHI::Objects
         accelerationStructureBuildRangeInfo.firstVertex = 0;
         accelerationStructureBuildRangeInfo.transformOffset = 0;
 
-        if (m_structure == nullptr || m_structure->rawBuffer->capacity < accelerationStructureBuildSizesInfo.accelerationStructureSize)
+        if (isRebuild && (m_structure == nullptr || m_structure->rawBuffer->capacity < accelerationStructureBuildSizesInfo.accelerationStructureSize))
         {
             if (m_structure != nullptr)
             {
@@ -221,10 +389,12 @@ namespace PK::Rendering::VulkanRHI::Objects
                 accelerationStructureGeometry,
                 accelerationStructureBuildRangeInfo,
                 VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+                tlasFlags,
                 (m_name + std::string(".TLAS")).c_str());
         }
 
-        auto scratchBuffer = GetScratchBuffer(scratchBufferSize + accelerationStructureBuildSizesInfo.buildScratchSize);
+        auto tlasScratchSize = isRebuild ? accelerationStructureBuildSizesInfo.buildScratchSize : accelerationStructureBuildSizesInfo.updateScratchSize;
+        auto scratchBuffer = GetScratchBuffer(scratchBufferSize + tlasScratchSize);
         auto scratchOffset = 0ull;
 
         if (substructureCount > 0)
@@ -239,7 +409,7 @@ namespace PK::Rendering::VulkanRHI::Objects
                 const auto& blas = m_subStructures.GetValueAt(i);
                 VkAccelerationStructureBuildGeometryInfoKHR blasGeometryInfo{ VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR };
                 blasGeometryInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
-                blasGeometryInfo.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+                blasGeometryInfo.flags = blas->flags;
                 blasGeometryInfo.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
                 blasGeometryInfo.dstAccelerationStructure = blas->structure;
                 blasGeometryInfo.geometryCount = 1;
@@ -251,22 +421,42 @@ namespace PK::Rendering::VulkanRHI::Objects
             }
 
             m_cmd->BuildAccelerationStructures((uint32_t)buildGeometryInfos.size(), buildGeometryInfos.data(), buildStructureRangeInfoPtrs.data());
+        }
 
+        // Covers bottom level builds, compacting copies & instance uploads. Builds read instance data with shader read access.
+        {
             VkMemoryBarrier memoryBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
-            memoryBarrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
-            memoryBarrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+            memoryBarrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
             VulkanBarrierInfo barrier;
-            barrier.srcStageMask = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+            barrier.srcStageMask = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_TRANSFER_BIT;
             barrier.dstStageMask = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
             barrier.memoryBarrierCount = 1u;
             barrier.pMemoryBarriers = &memoryBarrier;
             m_cmd->PipelineBarrier(barrier);
         }
 
+        if (substructureCount > 0)
+        {
+            std::vector<VkAccelerationStructureKHR> structures;
+            structures.reserve(substructureCount);
+
+            for (auto i = m_previousSubStructureCount; i < m_subStructures.GetCount(); ++i)
+            {
+                structures.push_back(m_subStructures.GetValueAt(i)->structure);
+            }
+
+            auto queryPool = new VulkanQueryPool(m_driver->device, VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, substructureCount, (m_name + std::string(".CompactionQueryPool")).c_str());
+            m_cmd->ResetQueryPool(queryPool->pool, 0u, substructureCount);
+            m_cmd->WriteAccelerationStructuresProperties(substructureCount, structures.data(), queryPool->type, queryPool->pool, 0u);
+            m_compactionBatches.push_back({ queryPool, m_cmd->GetFenceRef(), m_previousSubStructureCount });
+        }
+
         VkAccelerationStructureBuildGeometryInfoKHR tlasGeometryInfo{ VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR };
         tlasGeometryInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
-        tlasGeometryInfo.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-        tlasGeometryInfo.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+        tlasGeometryInfo.flags = tlasFlags;
+        tlasGeometryInfo.mode = isRebuild ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR;
+        tlasGeometryInfo.srcAccelerationStructure = isRebuild ? VK_NULL_HANDLE : m_structure->structure;
         tlasGeometryInfo.dstAccelerationStructure = m_structure->structure;
         tlasGeometryInfo.geometryCount = 1;
         tlasGeometryInfo.pGeometries = &accelerationStructureGeometry;
@@ -275,18 +465,17 @@ namespace PK::Rendering::VulkanRHI::Objects
 
         m_cmd->BuildAccelerationStructures(1, &tlasGeometryInfo, &pBuildStructureRangeInfo);
 
-        m_bindHandle.acceleration.structure = m_structure->structure;
-        m_bindHandle.IncrementVersion();
+        if (m_bindHandle.acceleration.structure != m_structure->structure)
+        {
+            m_bindHandle.acceleration.structure = m_structure->structure;
+            m_bindHandle.IncrementVersion();
+        }
+
         m_cmd = nullptr;
     }
 
     void VulkanAccelerationStructure::Dispose(const FenceRef& fence)
     {
-        if (m_instanceInputBuffer != nullptr)
-        {
-            m_driver->disposer->Dispose(m_instanceInputBuffer, fence);
-        }
-
         if (m_scratchBuffer != nullptr)
         {
             m_driver->disposer->Dispose(m_scratchBuffer, fence);
@@ -303,5 +492,10 @@ namespace PK::Rendering::VulkanRHI::Objects
         {
             m_driver->disposer->Dispose(substructures[i], fence);
         }
+
+        for (auto& batch : m_compactionBatches)
+        {
+            m_driver->disposer->Dispose(batch.queryPool, fence);
+        }
     }
 }
\ No newline at end of file
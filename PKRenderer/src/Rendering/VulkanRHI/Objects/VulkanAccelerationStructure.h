@@ -2,10 +2,21 @@
 #include "Rendering/VulkanRHI/VulkanDriver.h"
 #include "Rendering/VulkanRHI/Utilities/VulkanEnumConversion.h"
 #include "Rendering/Objects/AccelerationStructure.h"
+#include "Rendering/Objects/Buffer.h"
 #include "Utilities/IndexedSet.h"
 
 namespace PK::Rendering::VulkanRHI::Objects
 {
+    // Sum of refitted instance fractions after which the top level structure is rebuilt instead of updated.
+    constexpr static const float PK_ACCELERATION_STRUCTURE_REFIT_LIMIT = 8.0f;
+    // Modified instances closer than this are uploaded with a single copy.
+    constexpr static const uint32_t PK_ACCELERATION_STRUCTURE_UPLOAD_MERGE_DISTANCE = 16u;
+
+    /*
+     * The top level structure is updated in place when only instance transforms have changed & rebuilt when the instance set changes.
+     * Only modified instances are copied into the instance buffer.
+     * Bottom level structures are compacted once their compacted size queries have completed.
+     */
     struct VulkanAccelerationStructure : public Rendering::Objects::AccelerationStructure
     {
         VulkanAccelerationStructure(const char* name);
@@ -13,7 +24,9 @@ namespace PK::Rendering::VulkanRHI::Objects
         void Dispose(const FenceRef& fence);
         
         void BeginWrite(Structs::QueueType queue, uint32_t instanceLimit) override final;
-        void AddInstance(Mesh* mesh, uint32_t submesh, uint32_t customIndex, const PK::Math::float4x4& matrix) override final;
+        bool AddInstance(Mesh* mesh, uint32_t submesh, uint32_t customIndex, const PK::Math::float4x4& matrix) override final;
+        void BeginUpdate(Structs::QueueType queue) override final;
+        void SetInstanceTransform(uint32_t index, const PK::Math::float4x4& matrix) override final;
         void EndWrite() override final;
 
         uint32_t GetInstanceCount() const override final { return m_instanceCount; }
@@ -46,23 +59,38 @@ namespace PK::Rendering::VulkanRHI::Objects
                 }
             };
 
+            struct CompactionBatch
+            {
+                VulkanQueryPool* queryPool;
+                FenceRef fence;
+                uint32_t firstSubStructure;
+            };
+
             VulkanRawBuffer* GetScratchBuffer(size_t size);
-            VulkanRawBuffer* GetInstanceBuffer(size_t size);
             VulkanRawAccelerationStructure* GetMeshStructure(Mesh* mesh, uint32_t submeshIndex);
+            void CompactSubStructures();
+            void UploadInstances();
 
             const VulkanDriver* m_driver = nullptr;
             std::string m_name = "AccelerationStructure";
 
             Objects::VulkanCommandBuffer* m_cmd = nullptr;
 
-            VulkanRawBuffer* m_instanceInputBuffer = nullptr;
+            PK::Utilities::Ref<Buffer> m_instanceInputBuffer;
             VulkanRawBuffer* m_scratchBuffer = nullptr;
             VulkanRawAccelerationStructure* m_structure = nullptr;
             PK::Utilities::PointerMap<MeshKey, VulkanRawAccelerationStructure, MeshKeyHash> m_subStructures;
+            std::vector<CompactionBatch> m_compactionBatches;
             VulkanBindHandle m_bindHandle{};
+
+            // Cpu side copy of the instance buffer.
+            std::vector<VkAccelerationStructureInstanceKHR> m_instances;
+            std::vector<uint32_t> m_modifiedInstances;
             uint32_t m_instanceCount = 0u;
             uint32_t m_instanceLimit = 0u;
+            uint32_t m_previousInstanceCount = 0u;
             uint32_t m_previousSubStructureCount = 0u;
-            VkAccelerationStructureInstanceKHR* m_writeBuffer = nullptr;
+            float m_refitAmount = 0.0f;
+            bool m_isInstanceSetModified = false;
     };
 }
\ No newline at end of file
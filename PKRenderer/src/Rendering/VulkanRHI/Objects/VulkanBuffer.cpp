@@ -35,9 +35,10 @@ namespace PK::Rendering::VulkanRHI::Objects
         if ((m_usage & BufferUsage::PersistentStage) == 0)
         {
             PK_THROW_ASSERT(m_mappedBuffer == nullptr, "Trying to begin a new mapping for a buffer that is already being mapped!");
-            m_mappedBuffer = m_driver->stagingBufferCache->GetBuffer(size, fence);
-            m_mapRange.region.srcOffset = 0ull;
-            return m_mappedBuffer->BeginMap(0ull);
+            auto stage = m_driver->stagingBufferCache->Allocate(size, PK_STAGING_ALIGNMENT, fence);
+            m_mappedBuffer = stage.buffer;
+            m_mapRange.region.srcOffset = stage.offset;
+            return stage.BeginMap();
         }
 
         // Local persistent stage
@@ -50,7 +51,6 @@ namespace PK::Rendering::VulkanRHI::Objects
         PK_THROW_ASSERT(m_mappedBuffer != nullptr, "Trying to end buffer map for an unmapped buffer!");
 
         m_mappedBuffer->EndMap(m_mapRange.region.srcOffset, m_mapRange.region.size);
-        m_mapRange.ringOffset = (m_mapRange.ringOffset + m_rawBuffer->capacity) % m_mappedBuffer->capacity;
 
         *src = m_mappedBuffer->buffer;
         *dst = m_rawBuffer->buffer;
@@ -60,6 +60,10 @@ namespace PK::Rendering::VulkanRHI::Objects
         {
             m_mappedBuffer = nullptr;
         }
+        else
+        {
+            m_mapRange.ringOffset = (m_mapRange.ringOffset + m_rawBuffer->capacity) % m_mappedBuffer->capacity;
+        }
     }
 
     const void* VulkanBuffer::BeginRead(size_t offset, size_t size)
@@ -145,7 +149,7 @@ namespace PK::Rendering::VulkanRHI::Objects
         if ((m_usage & BufferUsage::PersistentStage) != 0)
         {
             m_mapRange.ringOffset = 0ull;
-            m_mappedBuffer = new VulkanStagingBuffer(m_driver->device,
+            m_mappedBuffer = new VulkanRawBuffer(m_driver->device,
                 m_driver->allocator,
                 VulkanBufferCreateInfo(BufferUsage::DefaultStaging | BufferUsage::PersistentStage, size * PK_MAX_FRAMES_IN_FLIGHT),
                 (std::string(m_name) + std::string(".StagingBuffer")).c_str());
@@ -50,7 +50,8 @@ namespace PK::Rendering::VulkanRHI::Objects
             const VulkanDriver* m_driver = nullptr;
             std::string m_name = "Buffer";
             VulkanRawBuffer* m_rawBuffer = nullptr;
-            Services::VulkanStagingBuffer* m_mappedBuffer = nullptr;
+            // Owned by the buffer when persistently staged. Otherwise a range of the shared staging ring.
+            VulkanRawBuffer* m_mappedBuffer = nullptr;
             VulkanSparsePageTable* m_pageTable = nullptr;
             MapRange m_mapRange{};
             PK::Utilities::PointerMap<Structs::IndexRange, VulkanBindHandle, RangeHash> m_bindHandles;
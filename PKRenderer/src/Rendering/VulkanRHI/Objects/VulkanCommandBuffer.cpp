@@ -8,6 +8,7 @@
 #include "Rendering/VulkanRHI/Objects/VulkanBindArray.h"
 #include "Rendering/VulkanRHI/Utilities/VulkanExtensions.h"
 #include "Rendering/VulkanRHI/Utilities/VulkanUtilities.h"
+#include "Rendering/VulkanRHI/Services/VulkanCommandBufferPool.h"
 
 namespace PK::Rendering::VulkanRHI::Objects
 {
@@ -18,6 +19,11 @@ namespace PK::Rendering::VulkanRHI::Objects
 
     FenceRef VulkanCommandBuffer::GetFenceRef() const
     {
+        if (m_primary != nullptr)
+        {
+            return m_primary->GetFenceRef();
+        }
+
         return FenceRef(this, [](const void* ctx, uint64_t userdata, uint64_t timeout)
             {
                 auto cmd = reinterpret_cast<const VulkanCommandBuffer*>(ctx);
@@ -141,7 +147,7 @@ namespace PK::Rendering::VulkanRHI::Objects
     void VulkanCommandBuffer::DrawIndexedIndirect(const Buffer* indirectArguments, size_t offset, uint32_t drawCount, uint32_t stride)
     {
         auto vkbuffer = indirectArguments->GetNative<VulkanBuffer>()->GetRaw();
-        static Services::VulkanBarrierHandler::AccessRecord record{};
+        Services::VulkanBarrierHandler::AccessRecord record{};
         record.bufferRange.offset = (uint32_t)offset;
         record.bufferRange.size = drawCount * stride;
         record.stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
@@ -195,14 +201,23 @@ namespace PK::Rendering::VulkanRHI::Objects
 
     void VulkanCommandBuffer::Blit(Window* src, Buffer* dst)
     {
-        auto vksrc = src->GetNative<VulkanWindow>()->GetBindHandle();
+        Blit(src->GetNative<VulkanWindow>()->GetBindHandle(), dst);
+    }
+
+    void VulkanCommandBuffer::Blit(Texture* src, Buffer* dst)
+    {
+        Blit(src->GetNative<VulkanTexture>()->GetBindHandle(TextureBindMode::RenderTarget), dst);
+    }
+
+    void VulkanCommandBuffer::Blit(const VulkanBindHandle* vksrc, Buffer* dst)
+    {
         auto vkbuff = dst->GetNative<VulkanBuffer>();
 
         VkBufferImageCopy region{};
         region.imageSubresource.aspectMask = vksrc->image.range.aspectMask;
         region.imageSubresource.mipLevel = vksrc->image.range.baseMipLevel;
         region.imageSubresource.baseArrayLayer = vksrc->image.range.baseArrayLayer;
-        region.imageSubresource.layerCount = vksrc->image.range.layerCount;
+        region.imageSubresource.layerCount = 1u;
         region.imageExtent = vksrc->image.extent;
 
         m_renderState->RecordImage(vksrc, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
@@ -212,6 +227,26 @@ namespace PK::Rendering::VulkanRHI::Objects
         vkCmdCopyImageToBuffer(m_commandBuffer, vksrc->image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, vkbuff->GetRaw()->buffer, 1, &region);
     }
 
+    void VulkanCommandBuffer::Blit(Buffer* src, Texture* dst)
+    {
+        auto vkbuff = src->GetNative<VulkanBuffer>();
+        auto vkdst = dst->GetNative<VulkanTexture>()->GetBindHandle(TextureBindMode::RenderTarget);
+
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = vkdst->image.range.aspectMask;
+        region.imageSubresource.mipLevel = vkdst->image.range.baseMipLevel;
+        region.imageSubresource.baseArrayLayer = vkdst->image.range.baseArrayLayer;
+        region.imageSubresource.layerCount = 1u;
+        region.imageExtent = vkdst->image.extent;
+
+        m_renderState->RecordBuffer(vkbuff->GetBindHandle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        m_renderState->RecordImage(vkdst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        EndRenderPass();
+        ResolveBarriers();
+        vkCmdCopyBufferToImage(m_commandBuffer, vkbuff->GetRaw()->buffer, vkdst->image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
     void VulkanCommandBuffer::Blit(Texture* src, Texture* dst, const Structs::TextureViewRange& srcRange, const Structs::TextureViewRange& dstRange, FilterMode filter)
     {
         static VulkanBindHandle srcHandle;
@@ -293,6 +328,13 @@ namespace PK::Rendering::VulkanRHI::Objects
         vkCmdClearColorImage(m_commandBuffer, vktex->GetRaw()->image, handle->image.layout, &clearValue, 1, &subrange);
     }
 
+    void VulkanCommandBuffer::DiscardTexture(Texture* texture)
+    {
+        // Replaces the access records without a barrier. The transition out of the undefined layout synchronizes with all prior commands.
+        auto handle = texture->GetNative<VulkanTexture>()->GetBindHandle();
+        m_renderState->RecordImage(handle, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0u);
+    }
+
     void* VulkanCommandBuffer::BeginBufferWrite(Buffer* buffer, size_t offset, size_t size)
     {
         return buffer->GetNative<VulkanBuffer>()->BeginWrite(GetFenceRef(), offset, size);
@@ -308,7 +350,7 @@ namespace PK::Rendering::VulkanRHI::Objects
 
         vkCmdCopyBuffer(m_commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-        static Services::VulkanBarrierHandler::AccessRecord record{};
+        Services::VulkanBarrierHandler::AccessRecord record{};
         record.bufferRange.offset = (uint32_t)copyRegion.dstOffset;
         record.bufferRange.size = (uint32_t)copyRegion.size;
         record.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
@@ -324,7 +366,7 @@ namespace PK::Rendering::VulkanRHI::Objects
         auto vkTexture = texture->GetNative<VulkanTexture>();
         auto layout = vkTexture->GetImageLayout();
         auto range = VkImageSubresourceRange{ (uint32_t)vkTexture->GetAspectFlags(), 0, texture->GetLevels(), 0, texture->GetLayers() };
-        const auto stage = m_renderState->GetServices()->stagingBufferCache->GetBuffer(size, GetFenceRef());
+        const auto stage = m_renderState->GetServices()->stagingBufferCache->Allocate(size, Services::PK_STAGING_TEXTURE_ALIGNMENT, GetFenceRef());
         std::vector<VkBufferImageCopy> bufferCopyRegions;
         bufferCopyRegions.reserve(rangeCount);
 
@@ -343,13 +385,13 @@ namespace PK::Rendering::VulkanRHI::Objects
             bufferCopyRegion.imageOffset.x = range.offset.x;
             bufferCopyRegion.imageOffset.y = range.offset.y;
             bufferCopyRegion.imageOffset.z = range.offset.z;
-            bufferCopyRegion.bufferOffset = range.bufferOffset;
+            bufferCopyRegion.bufferOffset = stage.offset + range.bufferOffset;
             bufferCopyRegions.push_back(bufferCopyRegion);
         }
 
-        stage->SetData(data, size);
+        stage.SetData(data, size);
         TransitionImageLayout(vkTexture->GetRaw()->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
-        vkCmdCopyBufferToImage(m_commandBuffer, stage->buffer, vkTexture->GetRaw()->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)bufferCopyRegions.size(), bufferCopyRegions.data());
+        vkCmdCopyBufferToImage(m_commandBuffer, stage.buffer->buffer, vkTexture->GetRaw()->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)bufferCopyRegions.size(), bufferCopyRegions.data());
         TransitionImageLayout(vkTexture->GetRaw()->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout, range);
     }
 
@@ -362,7 +404,7 @@ namespace PK::Rendering::VulkanRHI::Objects
         auto image = vkTexture->GetRaw()->image;
         auto layout = vkTexture->GetImageLayout();
         auto range = VkImageSubresourceRange{ (uint32_t)vkTexture->GetAspectFlags(), level, 1, layer, 1 };
-        const auto* stage = m_renderState->GetServices()->stagingBufferCache->GetBuffer(size, GetFenceRef());
+        const auto stage = m_renderState->GetServices()->stagingBufferCache->Allocate(size, Services::PK_STAGING_TEXTURE_ALIGNMENT, GetFenceRef());
 
         VkBufferImageCopy copyRegion{};
         copyRegion.imageSubresource.aspectMask = vkTexture->GetAspectFlags();
@@ -373,10 +415,11 @@ namespace PK::Rendering::VulkanRHI::Objects
         copyRegion.imageExtent.width >>= level;
         copyRegion.imageExtent.height >>= level;
         copyRegion.imageExtent.depth >>= level;
+        copyRegion.bufferOffset = stage.offset;
 
-        stage->SetData(data, size);
+        stage.SetData(data, size);
         TransitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
-        vkCmdCopyBufferToImage(m_commandBuffer, stage->buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &copyRegion);
+        vkCmdCopyBufferToImage(m_commandBuffer, stage.buffer->buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &copyRegion);
         TransitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout, range);
     }
 
@@ -394,11 +437,62 @@ namespace PK::Rendering::VulkanRHI::Objects
         vkCmdEndDebugUtilsLabelEXT(m_commandBuffer);
     }
 
+    CommandBuffer* VulkanCommandBuffer::BeginSecondary(uint32_t threadIndex)
+    {
+        PK_THROW_ASSERT(m_level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && m_pool != nullptr, "Secondary command buffers can only be begun from a primary command buffer!");
+        return m_pool->BeginSecondary(this, threadIndex);
+    }
+
+    void VulkanCommandBuffer::ExecuteSecondary(CommandBuffer* const* secondaries, uint32_t count)
+    {
+        auto natives = PK_STACK_ALLOC(VkCommandBuffer, count);
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            auto secondary = secondaries[i]->GetNative<VulkanCommandBuffer>();
+            PK_THROW_ASSERT(secondary->m_primary == this, "Secondary command buffer was not begun from this command buffer!");
+            natives[i] = secondary->m_commandBuffer;
+            secondary->EndCommandBuffer();
+        }
+
+        if ((m_renderState->ValidateRenderPass() & PK_RENDER_STATE_DIRTY_RENDERTARGET) != 0)
+        {
+            EndRenderPass();
+            ResolveBarriers();
+            auto info = m_renderState->GetRenderPassInfo();
+            vkCmdBeginRenderPass(m_commandBuffer, &info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            m_isInActiveRenderPass = true;
+            m_isInSecondaryRenderPass = true;
+        }
+
+        PK_THROW_ASSERT(m_isInActiveRenderPass && m_isInSecondaryRenderPass, "Secondary command buffers must be executed in a render pass that was begun for them!");
+        vkCmdExecuteCommands(m_commandBuffer, count, natives);
+
+        // Bound state is undefined after executing secondary buffers. Dynamic state is restored immediately as it is not validated per draw.
+        m_renderState->InvalidateBindings();
+        SetDynamicState();
+    }
+
     void VulkanCommandBuffer::BuildAccelerationStructures(uint32_t infoCount, const VkAccelerationStructureBuildGeometryInfoKHR* pInfos, const VkAccelerationStructureBuildRangeInfoKHR* const* ppBuildRangeInfos)
     {
         vkCmdBuildAccelerationStructuresKHR(m_commandBuffer, infoCount, pInfos, ppBuildRangeInfos);
     }
 
+    void VulkanCommandBuffer::CopyAccelerationStructure(const VkCopyAccelerationStructureInfoKHR* pInfo)
+    {
+        vkCmdCopyAccelerationStructureKHR(m_commandBuffer, pInfo);
+    }
+
+    void VulkanCommandBuffer::WriteAccelerationStructuresProperties(uint32_t structureCount, const VkAccelerationStructureKHR* pStructures, VkQueryType queryType, VkQueryPool queryPool, uint32_t firstQuery)
+    {
+        vkCmdWriteAccelerationStructuresPropertiesKHR(m_commandBuffer, structureCount, pStructures, queryType, queryPool, firstQuery);
+    }
+
+    void VulkanCommandBuffer::ResetQueryPool(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        vkCmdResetQueryPool(m_commandBuffer, queryPool, firstQuery, queryCount);
+    }
+
     void VulkanCommandBuffer::TransitionImageLayout(VkImage image, VkImageLayout srcLayout, VkImageLayout dstLayout, const VkImageSubresourceRange& range)
     {
         if (srcLayout == dstLayout)
@@ -504,10 +598,13 @@ namespace PK::Rendering::VulkanRHI::Objects
         {
             EndRenderPass();
             auto info = m_renderState->GetRenderPassInfo();
-            vkCmdBeginRenderPass(m_commandBuffer, &info, m_level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? VK_SUBPASS_CONTENTS_INLINE : VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdBeginRenderPass(m_commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
             m_isInActiveRenderPass = true;
+            m_isInSecondaryRenderPass = false;
         }
 
+        PK_THROW_ASSERT(!m_isInSecondaryRenderPass || !m_isInActiveRenderPass, "Inline commands cannot be recorded into a render pass that executes secondary command buffers!");
+
         if ((flags & PK_RENDER_STATE_DIRTY_PIPELINE) != 0)
         {
             vkCmdBindPipeline(m_commandBuffer, m_renderState->GetPipelineBindPoint(), m_renderState->GetPipeline());
@@ -556,31 +653,76 @@ namespace PK::Rendering::VulkanRHI::Objects
         }
     }
 
+    void VulkanCommandBuffer::SetDynamicState()
+    {
+        uint32_t viewportCount = 0u;
+        uint32_t scissorCount = 0u;
+        auto viewports = m_renderState->GetViewports(&viewportCount);
+        auto scissors = m_renderState->GetScissors(&scissorCount);
+
+        if (viewportCount > 0u)
+        {
+            vkCmdSetViewport(m_commandBuffer, 0u, viewportCount, viewports);
+        }
+
+        if (scissorCount > 0u)
+        {
+            vkCmdSetScissor(m_commandBuffer, 0u, scissorCount, scissors);
+        }
+    }
+
     void VulkanCommandBuffer::EndRenderPass()
     {
         if (m_isInActiveRenderPass)
         {
+            PK_THROW_ASSERT(m_level == VK_COMMAND_BUFFER_LEVEL_PRIMARY, "Secondary command buffers cannot end the render pass they continue!");
             vkCmdEndRenderPass(m_commandBuffer);
             m_isInActiveRenderPass = false;
+            m_isInSecondaryRenderPass = false;
         }
     }
 
-    void VulkanCommandBuffer::BeginCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferLevel level, Objects::VulkanRenderState* renderState)
+    void VulkanCommandBuffer::BeginCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferLevel level, Objects::VulkanRenderState* renderState, const VulkanCommandBuffer* primary)
     {
         m_level = level;
         m_commandBuffer = commandBuffer;
         m_renderState = renderState;
+        m_primary = primary;
         m_renderState->Reset();
 
         VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (level == VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+        {
+            VK_ASSERT_RESULT(vkBeginCommandBuffer(m_commandBuffer, &beginInfo));
+            return;
+        }
+
+        // Secondary buffers continue the render pass of the primary buffer.
+        VkCommandBufferInheritanceInfo inheritanceInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+        inheritanceInfo.renderPass = m_renderState->InheritRenderTarget(primary->m_renderState);
+        inheritanceInfo.subpass = 0u;
+        inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+        beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
         VK_ASSERT_RESULT(vkBeginCommandBuffer(m_commandBuffer, &beginInfo));
+        m_isInActiveRenderPass = true;
+        m_isInSecondaryRenderPass = false;
+
+        // Dynamic state is not inherited.
+        SetDynamicState();
     }
 
     void VulkanCommandBuffer::EndCommandBuffer()
     {
-        // End possibly active render pass
-        EndRenderPass();
+        // End possibly active render pass. Secondary buffers only continue the render pass of their primary buffer.
+        if (m_level == VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+        {
+            EndRenderPass();
+        }
+
+        m_isInActiveRenderPass = false;
         VK_ASSERT_RESULT(vkEndCommandBuffer(m_commandBuffer));
         m_renderState = nullptr;
     }
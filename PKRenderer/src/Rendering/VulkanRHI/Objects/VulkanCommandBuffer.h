@@ -6,6 +6,11 @@
 #include "Rendering/VulkanRHI/Utilities/VulkanStructs.h"
 #include "Rendering/VulkanRHI/Objects/VulkanRenderState.h"
 
+namespace PK::Rendering::VulkanRHI::Services
+{
+    class VulkanCommandBufferPool;
+}
+
 namespace PK::Rendering::VulkanRHI::Objects
 {
     // Forgive me for this
@@ -21,11 +26,12 @@ namespace PK::Rendering::VulkanRHI::Objects
         inline bool IsActive() const { return m_commandBuffer != VK_NULL_HANDLE; }
         inline VkCommandBuffer& GetNative() { return m_commandBuffer; }
         inline const VkFence& GetFence() { return m_fence; }
-        inline void Initialize(VkFence fence, uint16_t queueFamily, VkPipelineStageFlags capabilities) 
+        inline void Initialize(VkFence fence, uint16_t queueFamily, VkPipelineStageFlags capabilities, Services::VulkanCommandBufferPool* pool) 
         {
             m_fence = fence;
             m_queueFamily = queueFamily;
             m_capabilityFlags = capabilities;
+            m_pool = pool;
         }
         inline void Release() { m_commandBuffer = VK_NULL_HANDLE; ++m_invocationIndex; }
 
@@ -57,11 +63,15 @@ namespace PK::Rendering::VulkanRHI::Objects
         
         void Blit(Texture* src, Core::Window* dst, FilterMode filter) override final;
         void Blit(Core::Window* src, Buffer* dst) override final;
+        void Blit(Texture* src, Buffer* dst) override final;
+        void Blit(Buffer* src, Texture* dst) override final;
         void Blit(Texture* src, Texture* dst, const Structs::TextureViewRange& srcRange, const Structs::TextureViewRange& dstRange, FilterMode filter) override final;
         void Blit(const VulkanBindHandle* src, const VulkanBindHandle* dst, uint32_t srcLevel, uint32_t dstLevel, uint32_t srcLayer, uint32_t dstLayer, FilterMode filter, bool flipVertical = false);
+        void Blit(const VulkanBindHandle* src, Buffer* dst);
 
         void Clear(Buffer* dst, size_t offset, size_t size, uint32_t value) override final;
         void Clear(Texture* dst, const TextureViewRange& range, const uint4& value) override final;
+        void DiscardTexture(Texture* texture) override final;
 
         void* BeginBufferWrite(Buffer* buffer, size_t offset, size_t size) override final;
         void EndBufferWrite(Buffer* buffer) override final;
@@ -72,8 +82,14 @@ namespace PK::Rendering::VulkanRHI::Objects
         void BeginDebugScope(const char* name, const Math::color& color) override final;
         void EndDebugScope() override final;
 
+        CommandBuffer* BeginSecondary(uint32_t threadIndex) override final;
+        void ExecuteSecondary(CommandBuffer* const* secondaries, uint32_t count) override final;
+
         // Vulkan specific interface
         void BuildAccelerationStructures(uint32_t infoCount, const VkAccelerationStructureBuildGeometryInfoKHR* pInfos, const VkAccelerationStructureBuildRangeInfoKHR* const* ppBuildRangeInfos);
+        void CopyAccelerationStructure(const VkCopyAccelerationStructureInfoKHR* pInfo);
+        void WriteAccelerationStructuresProperties(uint32_t structureCount, const VkAccelerationStructureKHR* pStructures, VkQueryType queryType, VkQueryPool queryPool, uint32_t firstQuery);
+        void ResetQueryPool(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount);
         void TransitionImageLayout(VkImage image, VkImageLayout srcLayout, VkImageLayout dstLayout, const VkImageSubresourceRange& range);
         void PipelineBarrier(const VulkanBarrierInfo& barrier);
         
@@ -83,18 +99,24 @@ namespace PK::Rendering::VulkanRHI::Objects
         bool ResolveBarriers();
         void ValidatePipeline();
         void EndRenderPass();
-        void BeginCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferLevel level, Objects::VulkanRenderState* renderState);
+        void BeginCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferLevel level, Objects::VulkanRenderState* renderState, const VulkanCommandBuffer* primary = nullptr);
         void EndCommandBuffer();
         
         private:
+            void SetDynamicState();
+
             VkFence m_fence = VK_NULL_HANDLE;
             VkPipelineStageFlags m_capabilityFlags = 0u;
             uint16_t m_queueFamily = 0u;
+            Services::VulkanCommandBufferPool* m_pool = nullptr;
+            // Secondary buffers are synchronized with the primary buffer that executes them.
+            const VulkanCommandBuffer* m_primary = nullptr;
 
             Objects::VulkanRenderState* m_renderState = nullptr;
             VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
             VkCommandBufferLevel m_level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
             uint64_t m_invocationIndex = 0ull;
             bool m_isInActiveRenderPass = false;
+            bool m_isInSecondaryRenderPass = false;
     };
 }
\ No newline at end of file
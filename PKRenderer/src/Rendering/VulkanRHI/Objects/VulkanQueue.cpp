@@ -2,6 +2,7 @@
 #include "VulkanQueue.h"
 #include "Rendering/VulkanRHI/Utilities/VulkanUtilities.h"
 #include "Core/Services/Log.h"
+#include "Core/Services/Profiler.h"
 #include "Math/FunctionsMisc.h"
 #include <vulkan/vk_enum_string_helper.h>
 
@@ -182,6 +183,8 @@ namespace PK::Rendering::VulkanRHI::Objects
 
     VkResult VulkanQueue::Submit(Objects::VulkanCommandBuffer* commandBuffer, VkSemaphore* outSignal)
     {
+        PK_PROFILE_FUNCTION();
+
         if (!commandBuffer)
         {
             return VK_SUCCESS;
@@ -28,6 +28,7 @@ namespace PK::Rendering::VulkanRHI::Objects
             constexpr uint32_t GetFamily() const { return m_family; }
             constexpr VkPipelineStageFlags GetCapabilityFlags() const { return m_capabilityFlags; }
             FenceRef GetFenceRef(int32_t timelineOffset = 0) const;
+            inline uint64_t GetTimelineCounter() const { return m_timeline.counter; }
 
             PK::Utilities::Scope<Services::VulkanCommandBufferPool> commandPool = nullptr;
             PK::Utilities::Scope<Services::VulkanBarrierHandler> barrierHandler = nullptr;
@@ -70,6 +71,7 @@ namespace PK::Rendering::VulkanRHI::Objects
             Rendering::Objects::CommandBuffer* Submit(Structs::QueueType type) override final;
             void Sync(Structs::QueueType from, Structs::QueueType to, int32_t submitOffset = 0) override final;
             inline Structs::FenceRef GetFenceRef(Structs::QueueType type, int32_t submitOffset = 0) override final { return GetQueue(type)->GetFenceRef(submitOffset); }
+            inline uint64_t GetSubmitCount(Structs::QueueType type) override final { return GetQueue(type)->GetTimelineCounter(); }
             void Prune();
 
         private:
@@ -15,6 +15,14 @@ namespace PK::Rendering::VulkanRHI::Objects
     using namespace Services;
     using namespace Core::Services;
 
+    // Render passes that execute secondary buffers use a conservative external dependency.
+    // Secondary buffers are begun before the previous access of the render targets is known & their render pass must only differ in layouts & load operations.
+    static void SetSecondaryRenderPassDependency(RenderPassKey* key)
+    {
+        key->stageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        key->accessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+
     VkRenderPassBeginInfo VulkanRenderState::GetRenderPassInfo() const
     {
         VkRenderPassBeginInfo renderPassInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
@@ -122,6 +130,8 @@ namespace PK::Rendering::VulkanRHI::Objects
         //memset(m_sbtAddresses, 0, sizeof(m_sbtAddresses));
 
         m_clearValueCount = 0u;
+        m_viewportCount = 0u;
+        m_scissorCount = 0u;
         m_indexType = VK_INDEX_TYPE_UINT16;
         m_pipelineKey.fixedFunctionState = FixedFunctionState();
         m_renderPass = nullptr;
@@ -140,6 +150,62 @@ namespace PK::Rendering::VulkanRHI::Objects
         m_pipelineKey.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     }
 
+    VkRenderPass VulkanRenderState::InheritRenderTarget(const VulkanRenderState* primary)
+    {
+        memcpy(m_frameBufferImages, primary->m_frameBufferImages, sizeof(m_frameBufferImages));
+        memcpy(m_frameBufferKey, primary->m_frameBufferKey, sizeof(FrameBufferKey));
+        memcpy(m_renderPassKey, primary->m_renderPassKey, sizeof(RenderPassKey));
+        memcpy(m_viewports, primary->m_viewports, sizeof(m_viewports));
+        memcpy(m_scissors, primary->m_scissors, sizeof(m_scissors));
+        m_viewportCount = primary->m_viewportCount;
+        m_scissorCount = primary->m_scissorCount;
+
+        // Targets are accessed by the primary state when it begins the render pass.
+        for (auto i = 0u; i < PK_MAX_RENDER_TARGETS && m_renderPassKey->colors[i].format != VK_FORMAT_UNDEFINED; ++i)
+        {
+            m_renderPassKey->colors[i].initialLayout = m_frameBufferImages[i]->image.layout;
+            m_renderPassKey->colors[i].finalLayout = m_frameBufferImages[i]->image.layout;
+        }
+
+        auto depth = m_frameBufferImages[PK_MAX_RENDER_TARGETS * 2];
+
+        if (m_renderPassKey->depth.format != VK_FORMAT_UNDEFINED && depth != nullptr)
+        {
+            m_renderPassKey->depth.initialLayout = depth->image.layout;
+            m_renderPassKey->depth.finalLayout = depth->image.layout;
+        }
+
+        SetSecondaryRenderPassDependency(m_renderPassKey);
+
+        m_renderPass = m_services.frameBufferCache->GetRenderPass(m_renderPassKey[0]);
+        m_frameBufferKey[0].renderPass = m_renderPass->renderPass;
+        memcpy(m_frameBufferKey + 1, m_frameBufferKey, sizeof(FrameBufferKey));
+        memcpy(m_renderPassKey + 1, m_renderPassKey, sizeof(RenderPassKey));
+
+        VulkanFrameBufferCache::GetCompatibilityKey(m_renderPassKey[0], &m_pipelineKey.renderPass);
+        m_pipelineKey.fixedFunctionState.colorTargetCount = 0u;
+
+        while (m_pipelineKey.fixedFunctionState.colorTargetCount < PK_MAX_RENDER_TARGETS &&
+               m_renderPassKey[0].colors[m_pipelineKey.fixedFunctionState.colorTargetCount].format != VK_FORMAT_UNDEFINED)
+        {
+            m_pipelineKey.fixedFunctionState.colorTargetCount++;
+        }
+
+        m_dirtyFlags |= PK_RENDER_STATE_DIRTY_PIPELINE;
+        return m_renderPass->renderPass;
+    }
+
+    void VulkanRenderState::InvalidateBindings()
+    {
+        memset(m_descriptorSetKeys, 0, sizeof(m_descriptorSetKeys));
+        m_dirtyFlags |= PK_RENDER_STATE_DIRTY_PIPELINE | PK_RENDER_STATE_DIRTY_VERTEXBUFFERS;
+
+        if (m_indexBuffer != nullptr)
+        {
+            m_dirtyFlags |= PK_RENDER_STATE_DIRTY_INDEXBUFFER;
+        }
+    }
+
     void VulkanRenderState::SetRenderTarget(const VulkanBindHandle* const* renderTargets, const VulkanBindHandle* const* resolves, uint32_t count)
     {
         m_dirtyFlags |= PK_RENDER_STATE_DIRTY_RENDERTARGET;
@@ -246,6 +312,7 @@ namespace PK::Rendering::VulkanRHI::Objects
             }
         }
 
+        m_viewportCount = count;
         return hasChanged;
     }
 
@@ -271,6 +338,7 @@ namespace PK::Rendering::VulkanRHI::Objects
             }
         }
 
+        m_scissorCount = count;
         return hasChanged;
     }
 
@@ -422,6 +490,11 @@ namespace PK::Rendering::VulkanRHI::Objects
             return;
         }
 
+        UpdateRenderPass(false);
+    }
+
+    void VulkanRenderState::UpdateRenderPass(bool executesSecondaries)
+    {
         if (memcmp(m_frameBufferKey, m_frameBufferKey + 1, sizeof(FrameBufferKey)) == 0 &&
             memcmp(m_renderPassKey, m_renderPassKey + 1, sizeof(RenderPassKey)) == 0)
         {
@@ -431,6 +504,11 @@ namespace PK::Rendering::VulkanRHI::Objects
 
         RecordRenderTargetAccess();
 
+        if (executesSecondaries)
+        {
+            SetSecondaryRenderPassDependency(m_renderPassKey);
+        }
+
         memcpy(m_frameBufferKey + 1, m_frameBufferKey, sizeof(FrameBufferKey));
         memcpy(m_renderPassKey + 1, m_renderPassKey, sizeof(RenderPassKey));
 
@@ -438,7 +516,7 @@ namespace PK::Rendering::VulkanRHI::Objects
         m_frameBufferKey[0].renderPass = m_renderPass->renderPass;
         m_frameBuffer = m_services.frameBufferCache->GetFrameBuffer(m_frameBufferKey[0]);
 
-        m_pipelineKey.renderPass = m_renderPass->renderPass;
+        VulkanFrameBufferCache::GetCompatibilityKey(m_renderPassKey[0], &m_pipelineKey.renderPass);
         m_dirtyFlags |= PK_RENDER_STATE_DIRTY_PIPELINE;
 
         for (auto i = 0u; i < PK_MAX_RENDER_TARGETS; ++i)
@@ -533,13 +611,16 @@ namespace PK::Rendering::VulkanRHI::Objects
                 }
 
                 auto* attribute = &m_pipelineKey.vertexAttributes[elementIdx];
+                // Fetch using the buffer format so that quantized attributes (i.e. half positions) are converted by the input assembler.
+                // The format is part of the pipeline key as the same shader can be bound with different vertex layouts.
+                auto format = EnumConvert::GetFormat(element.Type);
 
-                // Format equality isn't checked against so that meshes without certain attributes can still be bound.
-                if (attribute->binding != index || attribute->offset != element.Offset)
+                if (attribute->binding != index || attribute->offset != element.Offset || attribute->format != format)
                 {
                     m_dirtyFlags |= PK_RENDER_STATE_DIRTY_PIPELINE;
                     attribute->binding = index;
                     attribute->offset = element.Offset;
+                    attribute->format = format;
                 }
             }
         }
@@ -692,6 +773,19 @@ namespace PK::Rendering::VulkanRHI::Objects
     }
 
 
+    PKRenderStateDirtyFlags VulkanRenderState::ValidateRenderPass()
+    {
+        if ((m_dirtyFlags & PK_RENDER_STATE_DIRTY_RENDERTARGET) != 0)
+        {
+            UpdateRenderPass(true);
+        }
+
+        auto flags = (PKRenderStateDirtyFlags)(m_dirtyFlags & PK_RENDER_STATE_DIRTY_RENDERTARGET);
+        m_dirtyFlags &= ~PK_RENDER_STATE_DIRTY_RENDERTARGET;
+        return flags;
+    }
+
+
     void VulkanRenderState::RecordResourceAccess()
     {
         auto shader = m_pipelineKey.shader;
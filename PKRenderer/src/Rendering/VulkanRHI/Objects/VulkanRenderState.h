@@ -75,8 +75,14 @@ namespace PK::Rendering::VulkanRHI::Objects
             VulkanDescriptorSetBundle GetDescriptorSetBundle(const Structs::FenceRef& fence, uint32_t dirtyFlags);
             VkStridedDeviceAddressRegionKHR* GetShaderBindingTableAddresses();
             const VulkanBindHandle* GetIndexBuffer(VkIndexType* outIndexType) const;
+            inline const VkViewport* GetViewports(uint32_t* outCount) const { *outCount = m_viewportCount; return m_viewports; }
+            inline const VkRect2D* GetScissors(uint32_t* outCount) const { *outCount = m_scissorCount; return m_scissors; }
 
             void Reset();
+            // Assumes the render target of a primary state. Returns a render pass that is compatible with the one the primary state begins.
+            VkRenderPass InheritRenderTarget(const VulkanRenderState* primary);
+            // Forces bindings to be reapplied on the next validation.
+            void InvalidateBindings();
             void SetRenderTarget(const VulkanBindHandle* const* renderTargets, const VulkanBindHandle* const* resolves, uint32_t count);
             void ClearColor(const Math::color& color, uint32_t index);
             void ClearDepth(float depth, uint32_t stencil);
@@ -101,9 +107,12 @@ namespace PK::Rendering::VulkanRHI::Objects
             Services::VulkanBarrierHandler::AccessRecord ExchangeImage(const VulkanBindHandle* handle, VkPipelineStageFlags stage, VkAccessFlags access);
 
             PKRenderStateDirtyFlags ValidatePipeline(const Structs::FenceRef& fence);
+            // Validates the render pass for executing secondary buffers.
+            PKRenderStateDirtyFlags ValidateRenderPass();
 
         private:
             void ValidateRenderTarget();
+            void UpdateRenderPass(bool executesSecondaries);
             void ValidateVertexBuffers();
             void ValidateDescriptorSets(const Structs::FenceRef& fence);
 
@@ -125,6 +134,8 @@ namespace PK::Rendering::VulkanRHI::Objects
             
             VkViewport m_viewports[Structs::PK_MAX_VIEWPORTS]{};
             VkRect2D m_scissors[Structs::PK_MAX_VIEWPORTS]{};
+            uint32_t m_viewportCount = 0u;
+            uint32_t m_scissorCount = 0u;
             VkClearValue m_clearValues[Structs::PK_MAX_RENDER_TARGETS + 1]{};
             uint32_t m_clearValueCount = 0u;
             uint32_t m_dirtyFlags;
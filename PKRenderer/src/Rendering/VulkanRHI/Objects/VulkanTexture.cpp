@@ -17,6 +17,15 @@ namespace PK::Rendering::VulkanRHI::Objects
         Rebuild(descriptor);
     }
 
+    VulkanTexture::VulkanTexture(const TextureDescriptor& descriptor, const VulkanRawMemory* aliasMemory, size_t aliasOffset, const char* name) :
+        m_driver(GraphicsAPI::GetActiveDriver<VulkanDriver>()),
+        m_aliasMemory(aliasMemory),
+        m_aliasOffset(aliasOffset),
+        Texture(name)
+    {
+        Rebuild(descriptor);
+    }
+
     VulkanTexture::~VulkanTexture()
     {
         Dispose();
@@ -93,7 +102,16 @@ namespace PK::Rendering::VulkanRHI::Objects
         auto& families = m_driver->queues->GetSelectedFamilies();
 
         m_descriptor = descriptor;
-        m_rawImage = new VulkanRawImage(m_driver->device, m_driver->allocator, VulkanImageCreateInfo(descriptor, &families), m_name.c_str());
+        VulkanImageCreateInfo createInfo(descriptor, &families);
+
+        if (m_aliasMemory != nullptr)
+        {
+            m_rawImage = new VulkanRawImage(m_driver->device, m_driver->allocator, m_aliasMemory, m_aliasOffset, createInfo, m_name.c_str());
+        }
+        else
+        {
+            m_rawImage = new VulkanRawImage(m_driver->device, m_driver->allocator, createInfo, m_name.c_str());
+        }
 
         m_viewType = EnumConvert::GetViewType(descriptor.samplerType);
         m_swizzle = EnumConvert::GetSwizzle(m_rawImage->format);
@@ -10,6 +10,8 @@ namespace PK::Rendering::VulkanRHI::Objects
         public:
             VulkanTexture();
             VulkanTexture(const TextureDescriptor& descriptor, const char* name);
+            // Rebuilds place the image at the same offset of the alias memory.
+            VulkanTexture(const TextureDescriptor& descriptor, const VulkanRawMemory* aliasMemory, size_t aliasOffset, const char* name);
             ~VulkanTexture();
             
             void SetSampler(const Structs::SamplerDescriptor& sampler) override final;
@@ -83,6 +85,8 @@ namespace PK::Rendering::VulkanRHI::Objects
 
             const VulkanDriver* m_driver = nullptr;
             VulkanRawImage* m_rawImage = nullptr;
+            const VulkanRawMemory* m_aliasMemory = nullptr;
+            size_t m_aliasOffset = 0ull;
             std::map<ViewKey, PK::Utilities::Scope<ViewValue>> m_imageViews;
             VkComponentMapping m_swizzle{};
             Structs::TextureViewRange m_defaultViewRange{};
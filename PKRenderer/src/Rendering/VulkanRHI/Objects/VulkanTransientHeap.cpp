@@ -0,0 +1,76 @@
+#include "PrecompiledHeader.h"
+#include "VulkanTransientHeap.h"
+#include "Rendering/VulkanRHI/Objects/VulkanTexture.h"
+#include "Rendering/VulkanRHI/Utilities/VulkanUtilities.h"
+
+namespace PK::Rendering::VulkanRHI::Objects
+{
+    using namespace PK::Utilities;
+    using namespace PK::Rendering::Objects;
+
+    VulkanTransientHeap::VulkanTransientHeap(const char* name) :
+        m_driver(GraphicsAPI::GetActiveDriver<VulkanDriver>()),
+        m_name(name)
+    {
+    }
+
+    VulkanTransientHeap::~VulkanTransientHeap()
+    {
+        Dispose();
+    }
+
+    size_t VulkanTransientHeap::GetRequirements(const TextureDescriptor& descriptor, size_t* outAlignment)
+    {
+        VulkanImageCreateInfo createInfo(descriptor, &m_driver->queues->GetSelectedFamilies());
+        VkImage image = VK_NULL_HANDLE;
+        VK_ASSERT_RESULT_CTX(vkCreateImage(m_driver->device, &createInfo.image, nullptr, &image), "Failed to create an image!");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(m_driver->device, image, &requirements);
+        vkDestroyImage(m_driver->device, image, nullptr);
+
+        m_memoryTypeBits &= requirements.memoryTypeBits;
+        m_alignment = requirements.alignment > m_alignment ? requirements.alignment : m_alignment;
+        PK_THROW_ASSERT(m_memoryTypeBits != 0u, "No memory type supports all textures placed in heap: %s", m_name.c_str());
+
+        *outAlignment = (size_t)requirements.alignment;
+        return (size_t)requirements.size;
+    }
+
+    bool VulkanTransientHeap::Validate(size_t size)
+    {
+        if (m_rawMemory != nullptr && m_rawMemory->size >= size)
+        {
+            return false;
+        }
+
+        Dispose();
+
+        VkMemoryRequirements requirements{};
+        requirements.size = size;
+        requirements.alignment = m_alignment;
+        requirements.memoryTypeBits = m_memoryTypeBits;
+
+        VmaAllocationCreateInfo createInfo{};
+        createInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        createInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_CAN_ALIAS_BIT;
+
+        m_rawMemory = new VulkanRawMemory(m_driver->allocator, requirements, createInfo);
+        return true;
+    }
+
+    Ref<Texture> VulkanTransientHeap::CreateTexture(const TextureDescriptor& descriptor, size_t offset, const char* name)
+    {
+        PK_THROW_ASSERT(m_rawMemory != nullptr, "Cannot place a texture in an unallocated heap: %s", m_name.c_str());
+        return CreateRef<VulkanTexture>(descriptor, m_rawMemory, offset, name);
+    }
+
+    void VulkanTransientHeap::Dispose()
+    {
+        if (m_rawMemory != nullptr)
+        {
+            m_driver->disposer->Dispose(m_rawMemory, m_driver->GetQueues()->GetFenceRef(QueueType::Graphics));
+            m_rawMemory = nullptr;
+        }
+    }
+}
\ No newline at end of file
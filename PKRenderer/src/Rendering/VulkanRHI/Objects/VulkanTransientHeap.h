@@ -0,0 +1,29 @@
+#pragma once
+#include "Rendering/VulkanRHI/VulkanDriver.h"
+#include "Rendering/Objects/TransientHeap.h"
+
+namespace PK::Rendering::VulkanRHI::Objects
+{
+    class VulkanTransientHeap : public Rendering::Objects::TransientHeap
+    {
+        public:
+            VulkanTransientHeap(const char* name);
+            ~VulkanTransientHeap();
+
+            size_t GetRequirements(const Structs::TextureDescriptor& descriptor, size_t* outAlignment) override final;
+            bool Validate(size_t size) override final;
+            PK::Utilities::Ref<Rendering::Objects::Texture> CreateTexture(const Structs::TextureDescriptor& descriptor, size_t offset, const char* name) override final;
+            size_t GetSize() const override final { return m_rawMemory != nullptr ? m_rawMemory->size : 0ull; }
+
+            inline const VulkanRawMemory* GetRaw() const { return m_rawMemory; }
+
+        private:
+            void Dispose();
+
+            const VulkanDriver* m_driver = nullptr;
+            VulkanRawMemory* m_rawMemory = nullptr;
+            uint32_t m_memoryTypeBits = 0xFFFFFFFFu;
+            VkDeviceSize m_alignment = 1ull;
+            std::string m_name;
+    };
+}
\ No newline at end of file
@@ -235,6 +235,8 @@ namespace PK::Rendering::VulkanRHI::Services
 
     bool VulkanBarrierHandler::Resolve(VulkanBarrierInfo* outBarrierInfo)
     {
+        std::lock_guard<std::mutex> lock(m_lock);
+
         if (outBarrierInfo == nullptr || (m_bufferBarriers.GetCount() == 0u && m_imageBarriers.GetCount() == 0u))
         {
             return false;
@@ -5,6 +5,7 @@
 #include "Utilities/FixedPool.h"
 #include "Utilities/FixedList.h"
 #include "Utilities/PointerMap.h"
+#include <mutex>
 
 namespace PK::Rendering::VulkanRHI::Services
 {
@@ -74,6 +75,7 @@ namespace PK::Rendering::VulkanRHI::Services
             {
                 typedef TInfo<T>::BarrierType TBarrier;
                 TBarrier* barrier = nullptr;
+                std::lock_guard<std::mutex> lock(m_lock);
 
                 auto scope = record;
                 scope.next = nullptr;
@@ -165,6 +167,7 @@ namespace PK::Rendering::VulkanRHI::Services
             template<typename T>
             AccessRecord Retrieve(const T resource, const AccessRecord& record) const
             {
+                std::lock_guard<std::mutex> lock(m_lock);
                 auto index = m_resources.GetIndex(reinterpret_cast<uint64_t>(resource));
                 auto previous = record;
 
@@ -219,6 +222,8 @@ namespace PK::Rendering::VulkanRHI::Services
             }
 
             const uint32_t m_queueFamily = 0u;
+            // Secondary command buffers record accesses concurrently.
+            mutable std::mutex m_lock;
             PK::Utilities::PointerMap<uint64_t, AccessRecord> m_resources;
             PK::Utilities::FixedPool<AccessRecord, 1024> m_records;
             PK::Utilities::FixedList<VkBufferMemoryBarrier, 256> m_bufferBarriers;
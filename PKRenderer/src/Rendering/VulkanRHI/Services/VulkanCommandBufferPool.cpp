@@ -10,6 +10,9 @@ namespace PK::Rendering::VulkanRHI::Services
 
     VulkanCommandBufferPool::VulkanCommandBufferPool(VkDevice device, const VulkanServiceContext& services, uint32_t queueFamily, VkPipelineStageFlags capabilities) :
         m_device(device),
+        m_services(services),
+        m_queueFamily(queueFamily),
+        m_capabilities(capabilities),
         m_primaryRenderState(services)
     {
         VkCommandPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
@@ -22,7 +25,7 @@ namespace PK::Rendering::VulkanRHI::Services
             VkFenceCreateInfo fenceCreateInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
             VkFence fence = VK_NULL_HANDLE;
             VK_ASSERT_RESULT(vkCreateFence(device, &fenceCreateInfo, nullptr, &fence));
-            m_commandBuffers[i].Initialize(fence, queueFamily, capabilities);
+            m_commandBuffers[i].Initialize(fence, queueFamily, capabilities, this);
         }
     }
 
@@ -31,6 +34,11 @@ namespace PK::Rendering::VulkanRHI::Services
         Prune(true);
         vkDestroyCommandPool(m_device, m_pool, nullptr);
 
+        for (auto& secondaryPool : m_secondaryPools)
+        {
+            vkDestroyCommandPool(m_device, secondaryPool->pool, nullptr);
+        }
+
         for (auto& wrapper : m_commandBuffers)
         {
             vkDestroyFence(m_device, wrapper.GetFence(), nullptr);
@@ -75,6 +83,67 @@ namespace PK::Rendering::VulkanRHI::Services
         return cmd;
     }
 
+    VulkanCommandBuffer* VulkanCommandBufferPool::BeginSecondary(const VulkanCommandBuffer* primary, uint32_t threadIndex)
+    {
+        const int64_t primaryIndex = primary - &m_commandBuffers[0];
+        PK_THROW_ASSERT(primaryIndex >= 0 && primaryIndex < MAX_PRIMARY_COMMANDBUFFERS, "Primary command buffer is not owned by this pool!");
+
+        while (m_secondaryPools.size() <= threadIndex)
+        {
+            auto secondaryPool = CreateScope<SecondaryPool>();
+            VkCommandPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+            createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            createInfo.queueFamilyIndex = m_queueFamily;
+            VK_ASSERT_RESULT(vkCreateCommandPool(m_device, &createInfo, nullptr, &secondaryPool->pool));
+            m_secondaryPools.push_back(std::move(secondaryPool));
+        }
+
+        auto secondaryPool = m_secondaryPools.at(threadIndex).get();
+        SecondaryCommandBuffer* secondary = nullptr;
+
+        for (auto& buffer : secondaryPool->buffers)
+        {
+            if (buffer->primaryIndex == -1)
+            {
+                secondary = buffer.get();
+                break;
+            }
+        }
+
+        if (secondary == nullptr)
+        {
+            secondaryPool->buffers.push_back(CreateScope<SecondaryCommandBuffer>(m_services));
+            secondary = secondaryPool->buffers.back().get();
+
+            VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+            allocateInfo.commandPool = secondaryPool->pool;
+            allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocateInfo.commandBufferCount = 1u;
+            VK_ASSERT_RESULT(vkAllocateCommandBuffers(m_device, &allocateInfo, &secondary->native));
+            secondary->commandBuffer.Initialize(VK_NULL_HANDLE, m_queueFamily, m_capabilities, nullptr);
+        }
+
+        // Native buffers are kept allocated. Beginning a buffer implicitly resets it.
+        secondary->primaryIndex = (int32_t)primaryIndex;
+        secondary->commandBuffer.BeginCommandBuffer(secondary->native, VK_COMMAND_BUFFER_LEVEL_SECONDARY, &secondary->renderState, primary);
+        return &secondary->commandBuffer;
+    }
+
+    void VulkanCommandBufferPool::ReleaseSecondaries(int32_t primaryIndex)
+    {
+        for (auto& secondaryPool : m_secondaryPools)
+        {
+            for (auto& buffer : secondaryPool->buffers)
+            {
+                if (buffer->primaryIndex == primaryIndex)
+                {
+                    buffer->commandBuffer.Release();
+                    buffer->primaryIndex = -1;
+                }
+            }
+        }
+    }
+
     void VulkanCommandBufferPool::Prune(bool all)
     {
         VkFence fences[MAX_PRIMARY_COMMANDBUFFERS];
@@ -108,7 +177,9 @@ namespace PK::Rendering::VulkanRHI::Services
         {
             if (wrapper.IsActive() && vkWaitForFences(m_device, 1, &wrapper.GetFence(), VK_TRUE, 0) == VK_SUCCESS)
             {
-                m_nativeBuffers[(int64_t)(&wrapper - &m_commandBuffers[0])] = VK_NULL_HANDLE;
+                auto index = (int64_t)(&wrapper - &m_commandBuffers[0]);
+                ReleaseSecondaries((int32_t)index);
+                m_nativeBuffers[index] = VK_NULL_HANDLE;
                 vkFreeCommandBuffers(m_device, m_pool, 1, &wrapper.GetNative());
                 VK_ASSERT_RESULT(vkResetFences(m_device, 1, &wrapper.GetFence()));
                 wrapper.Release();
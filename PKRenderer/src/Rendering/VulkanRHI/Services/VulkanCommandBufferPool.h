@@ -17,16 +17,40 @@ namespace PK::Rendering::VulkanRHI::Services
     
             Objects::VulkanCommandBuffer* GetCurrent();
             Objects::VulkanCommandBuffer* EndCurrent();
+            Objects::VulkanCommandBuffer* BeginSecondary(const Objects::VulkanCommandBuffer* primary, uint32_t threadIndex);
             void Prune(bool all);
             void AllocateBuffers();
 
         private:
+            struct SecondaryCommandBuffer
+            {
+                SecondaryCommandBuffer(const Objects::VulkanServiceContext& services) : renderState(services) {}
+                Objects::VulkanRenderState renderState;
+                Objects::VulkanCommandBuffer commandBuffer;
+                VkCommandBuffer native = VK_NULL_HANDLE;
+                // Index of the primary buffer that executes this. Recycled once the primary buffer has completed.
+                int32_t primaryIndex = -1;
+            };
+
+            // Native pools cannot be accessed concurrently. Secondary buffers are allocated from a pool per recording thread.
+            struct SecondaryPool
+            {
+                VkCommandPool pool = VK_NULL_HANDLE;
+                std::vector<PK::Utilities::Scope<SecondaryCommandBuffer>> buffers;
+            };
+
+            void ReleaseSecondaries(int32_t primaryIndex);
+
             constexpr static const uint32_t MAX_PRIMARY_COMMANDBUFFERS = 24u;
             VkDevice m_device;
+            const Objects::VulkanServiceContext m_services;
+            const uint32_t m_queueFamily;
+            const VkPipelineStageFlags m_capabilities;
             VkCommandPool m_pool;
             VkCommandBuffer m_nativeBuffers[MAX_PRIMARY_COMMANDBUFFERS]{};
             Objects::VulkanRenderState m_primaryRenderState;
             Objects::VulkanCommandBuffer m_commandBuffers[MAX_PRIMARY_COMMANDBUFFERS]{};
             Objects::VulkanCommandBuffer* m_current = nullptr;
+            std::vector<PK::Utilities::Scope<SecondaryPool>> m_secondaryPools;
     };
 }
\ No newline at end of file
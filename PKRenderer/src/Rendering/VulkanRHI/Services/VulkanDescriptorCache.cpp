@@ -54,6 +54,7 @@ namespace PK::Rendering::VulkanRHI::Services
         const DescriptorSetKey& key,
         const FenceRef& fence)
     {
+        std::lock_guard<std::mutex> lock(m_lock);
         auto nextPruneTick = m_currentPruneTick + m_pruneDelay;
         VulkanDescriptorSet* value = nullptr;
 
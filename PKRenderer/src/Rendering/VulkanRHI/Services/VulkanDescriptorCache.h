@@ -4,6 +4,7 @@
 #include "Utilities/FixedPool.h"
 #include "Utilities/PointerMap.h"
 #include "Utilities/Ref.h"
+#include <mutex>
 
 namespace PK::Rendering::VulkanRHI::Services
 {
@@ -80,5 +81,7 @@ namespace PK::Rendering::VulkanRHI::Services
             std::vector<VkDescriptorImageInfo> m_writeImages;
             std::vector<VkDescriptorBufferInfo> m_writeBuffers;
             std::vector<VkWriteDescriptorSetAccelerationStructureKHR> m_writeAccerationStructures;
+            // Sets can be requested by secondary command buffers recording on multiple threads.
+            std::mutex m_lock;
     };
 }
\ No newline at end of file
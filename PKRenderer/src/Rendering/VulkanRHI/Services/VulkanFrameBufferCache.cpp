@@ -206,6 +206,30 @@ namespace PK::Rendering::VulkanRHI::Services
         return renderPass;
     }
 
+    void VulkanFrameBufferCache::GetCompatibilityKey(const RenderPassKey& key, RenderPassKey* outKey)
+    {
+        memcpy(outKey, &key, sizeof(RenderPassKey));
+
+        for (auto i = 0u; i < PK_MAX_RENDER_TARGETS; ++i)
+        {
+            if (outKey->colors[i].format != VK_FORMAT_UNDEFINED)
+            {
+                outKey->colors[i].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                outKey->colors[i].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                outKey->colors[i].loadop = LoadOp::Keep;
+                outKey->colors[i].storeop = StoreOp::Store;
+            }
+        }
+
+        if (outKey->depth.format != VK_FORMAT_UNDEFINED)
+        {
+            outKey->depth.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            outKey->depth.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            outKey->depth.loadop = LoadOp::Keep;
+            outKey->depth.storeop = StoreOp::Store;
+        }
+    }
+
     void VulkanFrameBufferCache::Prune()
     {
         m_currentPruneTick++;
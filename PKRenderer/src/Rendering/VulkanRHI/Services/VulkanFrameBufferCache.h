@@ -88,6 +88,10 @@ namespace PK::Rendering::VulkanRHI::Services
             const VulkanRenderPass* GetRenderPass(const RenderPassKey& key);
             void Prune();
 
+            // Strips the attachment layouts & load/store operations. Render passes that only differ in these are compatible.
+            // Pipelines are keyed by this so that they're shared between compatible passes & can be recreated from a serialized key.
+            static void GetCompatibilityKey(const RenderPassKey& key, RenderPassKey* outKey);
+
         private:
             const VkDevice m_device;
             std::unordered_map<FrameBufferKey, FrameBufferValue, FrameBufferKeyHash> m_framebuffers;
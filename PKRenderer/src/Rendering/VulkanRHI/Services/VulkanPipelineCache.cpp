@@ -2,16 +2,43 @@
 #include "VulkanPipelineCache.h"
 #include "Rendering/VulkanRHI/Utilities/VulkanEnumConversion.h"
 #include "Rendering/VulkanRHI/Utilities/VulkanUtilities.h"
+#include "Core/Services/Log.h"
+#include "Core/Services/StringHashID.h"
 #include "Utilities/FileIO.h"
+#include <chrono>
 
 namespace PK::Rendering::VulkanRHI::Services
 {
     using namespace PK::Utilities;
+    using namespace PK::Core::Services;
     using namespace Structs;
     using namespace Objects;
 
-    VulkanPipelineCache::VulkanPipelineCache(VkDevice device, const std::string& workingDirectory, const VulkanPhysicalDeviceProperties& physicalDeviceProperties, uint64_t pruneDelay) :
+    struct PipelineManifestHeader
+    {
+        uint32_t version;
+        uint32_t keySize;
+        uint32_t entryCount;
+    };
+
+    static uint64_t GetTimestampNanoseconds()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t GetManifestHash(const PipelineManifestEntry& entry)
+    {
+        auto seed = HashHelpers::FNV1AHash(entry.shaderPath.c_str(), entry.shaderPath.size()) + entry.variantIndex;
+        return HashHelpers::MurmurHash(reinterpret_cast<const void*>(&entry.key), sizeof(PipelineKey), seed);
+    }
+
+    VulkanPipelineCache::VulkanPipelineCache(VkDevice device, 
+                                             const std::string& workingDirectory, 
+                                             const VulkanPhysicalDeviceProperties& physicalDeviceProperties, 
+                                             VulkanFrameBufferCache* frameBufferCache, 
+                                             uint64_t pruneDelay) :
         m_device(device),
+        m_frameBufferCache(frameBufferCache),
         m_workingDirectory(workingDirectory),
         m_pruneDelay(pruneDelay),
         m_allowUnderEstimation(physicalDeviceProperties.conservativeRasterizationProperties.primitiveUnderestimation),
@@ -27,6 +54,7 @@ namespace PK::Rendering::VulkanRHI::Services
             cacheCreateInfo.pInitialData = cacheData;
             VK_ASSERT_RESULT_CTX(vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &m_pipelineCache), "Failed to create pipeline cache!");
             free(cacheData);
+            ReadManifest();
         }
     }
 
@@ -41,6 +69,7 @@ namespace PK::Rendering::VulkanRHI::Services
             FileIO::WriteBinary((m_workingDirectory + PIPELINE_CACHE_FILENAME).c_str(), cacheData, size);
             vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
             free(cacheData);
+            WriteManifest();
         }
 
         for (auto& kv : m_graphicsPipelines)
@@ -76,34 +105,95 @@ namespace PK::Rendering::VulkanRHI::Services
 
     const VulkanPipeline* VulkanPipelineCache::GetComputePipeline(const VersionHandle<VulkanShader>& shader)
     {
-        auto nextPruneTick = m_currentPruneTick + m_pruneDelay;
-        auto iterator = m_otherPipelines.find(shader);
+        PipelineValue* value = nullptr;
 
-        if (iterator != m_otherPipelines.end() && iterator->second.pipeline != nullptr)
         {
-            iterator->second.pruneTick = nextPruneTick;
-            return iterator->second.pipeline;
+            std::unique_lock<std::mutex> lock(m_lock);
+            value = &m_otherPipelines[shader];
+            auto pipeline = AcquirePipeline(value, lock);
+
+            if (pipeline != nullptr)
+            {
+                return pipeline;
+            }
         }
 
+        auto beginTimestamp = GetTimestampNanoseconds();
         VkComputePipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
         pipelineInfo.stage = shader->GetModule((int)ShaderStage::Compute)->stageInfo;
         pipelineInfo.layout = shader->GetPipelineLayout()->layout;
         auto pipeline = new VulkanPipeline(m_device, m_pipelineCache, pipelineInfo, shader->GetName());
-        m_otherPipelines[shader] = { pipeline, nextPruneTick };
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            RecordMiss(shader->GetName(), beginTimestamp);
+        }
+
+        PublishPipeline(value, pipeline);
         return pipeline;
     }
 
     const VulkanPipeline* VulkanPipelineCache::GetGraphicsPipeline(const PipelineKey& key)
     {
-        auto nextPruneTick = m_currentPruneTick + m_pruneDelay;
-        auto iterator = m_graphicsPipelines.find(key);
+        PipelineValue* value = nullptr;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            value = &m_graphicsPipelines[key];
+            auto pipeline = AcquirePipeline(value, lock);
+
+            if (pipeline != nullptr)
+            {
+                return pipeline;
+            }
+
+            // Render passes are otherwise only requested when beginning command buffers. Access from recording threads is serialized by the pipeline lock.
+            renderPass = m_frameBufferCache->GetRenderPass(key.renderPass)->renderPass;
+        }
+
+        auto beginTimestamp = GetTimestampNanoseconds();
+        auto pipeline = CreateGraphicsPipeline(key, renderPass);
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            RecordManifestEntry(key);
+            RecordMiss(key.shader->GetName(), beginTimestamp);
+        }
+
+        PublishPipeline(value, pipeline);
+        return pipeline;
+    }
+
+    VulkanPipeline* VulkanPipelineCache::AcquirePipeline(PipelineValue* value, std::unique_lock<std::mutex>& lock)
+    {
+        // Map values are never erased so the reservation stays valid while the lock is released.
+        m_published.wait(lock, [value]() { return !value->isPending; });
+
+        if (value->pipeline != nullptr)
+        {
+            value->pruneTick = m_currentPruneTick + m_pruneDelay;
+            return value->pipeline;
+        }
 
-        if (iterator != m_graphicsPipelines.end() && iterator->second.pipeline != nullptr)
+        value->isPending = true;
+        return nullptr;
+    }
+
+    void VulkanPipelineCache::PublishPipeline(PipelineValue* value, VulkanPipeline* pipeline)
+    {
         {
-            iterator->second.pruneTick = nextPruneTick;
-            return iterator->second.pipeline;
+            std::lock_guard<std::mutex> lock(m_lock);
+            value->pipeline = pipeline;
+            value->pruneTick = m_currentPruneTick + m_pruneDelay;
+            value->isPending = false;
         }
 
+        m_published.notify_all();
+    }
+
+    VulkanPipeline* VulkanPipelineCache::CreateGraphicsPipeline(const PipelineKey& key, VkRenderPass renderPass) const
+    {
         auto stageCount = 0u;
         VkPipelineShaderStageCreateInfo shaderStages[(int)ShaderStage::MaxCount];
 
@@ -227,27 +317,30 @@ namespace PK::Rendering::VulkanRHI::Services
         pipelineInfo.pColorBlendState = &colorBlending;
         pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = key.shader->GetPipelineLayout()->layout;
-        pipelineInfo.renderPass = key.renderPass;
+        pipelineInfo.renderPass = renderPass;
         pipelineInfo.subpass = 0;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineInfo.basePipelineIndex = -1;
 
-        auto pipeline = new VulkanPipeline(m_device, m_pipelineCache, pipelineInfo, key.shader->GetName());
-        m_graphicsPipelines[key] = { pipeline, nextPruneTick };
-        return pipeline;
+        return new VulkanPipeline(m_device, m_pipelineCache, pipelineInfo, key.shader->GetName());
     }
 
     const VulkanPipeline* VulkanPipelineCache::GetRayTracingPipeline(const PK::Utilities::VersionHandle<Objects::VulkanShader>& shader)
     {
-        auto nextPruneTick = m_currentPruneTick + m_pruneDelay;
-        auto iterator = m_otherPipelines.find(shader);
+        PipelineValue* value = nullptr;
 
-        if (iterator != m_otherPipelines.end() && iterator->second.pipeline != nullptr)
         {
-            iterator->second.pruneTick = nextPruneTick;
-            return iterator->second.pipeline;
+            std::unique_lock<std::mutex> lock(m_lock);
+            value = &m_otherPipelines[shader];
+            auto pipeline = AcquirePipeline(value, lock);
+
+            if (pipeline != nullptr)
+            {
+                return pipeline;
+            }
         }
 
+        auto beginTimestamp = GetTimestampNanoseconds();
         auto stageCount = 0u;
         VkPipelineShaderStageCreateInfo shaderStages[(int)ShaderStage::MaxCount]{};
         VkRayTracingShaderGroupCreateInfoKHR shaderGroups[(int)ShaderStage::MaxCount]{};
@@ -289,14 +382,271 @@ namespace PK::Rendering::VulkanRHI::Services
         pipelineInfo.layout = shader->GetPipelineLayout()->layout;
 
         auto pipeline = new VulkanPipeline(m_device, m_pipelineCache, pipelineInfo, shader->GetName());
-        m_otherPipelines[shader] = { pipeline, nextPruneTick };
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            RecordMiss(shader->GetName(), beginTimestamp);
+        }
+
+        PublishPipeline(value, pipeline);
         return pipeline;
     }
 
+    void VulkanPipelineCache::Precompile(JobSystem* jobSystem, const ShaderResolver& resolveShader)
+    {
+        auto beginTimestamp = GetTimestampNanoseconds();
+        std::vector<PipelineKey> keys;
+        std::vector<VkRenderPass> renderPasses;
+        std::vector<PipelineValue*> values;
+        std::vector<std::pair<std::string, uint32_t>> sources;
+        std::vector<const VulkanShader*> shaders;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            sources.reserve(m_manifest.size());
+
+            for (const auto& entry : m_manifest)
+            {
+                sources.emplace_back(entry.shaderPath, entry.variantIndex);
+            }
+        }
+
+        // Shaders may be loaded from disk. Resolve them without holding the lock.
+        // Other threads only append to the manifest so the resolved shaders remain aligned with its first entries.
+        shaders.reserve(sources.size());
+
+        for (const auto& source : sources)
+        {
+            shaders.push_back(resolveShader(source.first, source.second));
+        }
+
+        keys.reserve(shaders.size());
+        renderPasses.reserve(shaders.size());
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto iter = m_manifest.begin();
+
+            for (auto shader : shaders)
+            {
+                auto isValid = shader != nullptr && shader->GetType() == ShaderType::Graphics;
+                auto attributeCount = 0u;
+
+                // Vertex inputs are resolved against the shader when recording. Discard entries of shaders that have since changed.
+                if (isValid)
+                {
+                    for (const auto& element : shader->GetVertexLayout())
+                    {
+                        auto& attribute = iter->key.vertexAttributes[attributeCount++];
+                        isValid &= attribute.location == element.Location && attribute.format != VK_FORMAT_UNDEFINED;
+                    }
+
+                    isValid &= attributeCount >= PK_MAX_VERTEX_ATTRIBUTES || iter->key.vertexAttributes[attributeCount].format == VK_FORMAT_UNDEFINED;
+                }
+
+                if (!isValid)
+                {
+                    m_manifestHashes.erase(GetManifestHash(*iter));
+                    iter = m_manifest.erase(iter);
+                    continue;
+                }
+
+                auto& key = keys.emplace_back();
+                memcpy(&key, &iter->key, sizeof(PipelineKey));
+                key.shader = shader;
+                ++iter;
+
+                // Reserve the slot so that requests made while compiling wait for the precompiled pipeline.
+                auto value = &m_graphicsPipelines[key];
+
+                if (value->pipeline != nullptr || value->isPending)
+                {
+                    keys.pop_back();
+                    continue;
+                }
+
+                value->isPending = true;
+                values.push_back(value);
+                renderPasses.push_back(m_frameBufferCache->GetRenderPass(key.renderPass)->renderPass);
+            }
+        }
+
+        std::vector<VulkanPipeline*> pipelines(keys.size());
+        auto duration = 0ull;
+
+        jobSystem->ParallelFor((uint32_t)keys.size(), 1u, [this, &keys, &renderPasses, &pipelines](uint32_t begin, uint32_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                pipelines[i] = CreateGraphicsPipeline(keys[i], renderPasses[i]);
+            }
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto nextPruneTick = m_currentPruneTick + m_pruneDelay;
+
+            for (auto i = 0u; i < values.size(); ++i)
+            {
+                *values[i] = { pipelines[i], nextPruneTick, false };
+            }
+
+            duration = GetTimestampNanoseconds() - beginTimestamp;
+            m_precompiledCount += (uint32_t)keys.size();
+            m_precompileNanoseconds += duration;
+        }
+
+        m_published.notify_all();
+        PK_LOG_INFO("Precompiled %i pipelines from the manifest in %.2fms.", (uint32_t)keys.size(), duration / 1e6);
+    }
+
+    DriverPipelineInfo VulkanPipelineCache::GetInfo() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        DriverPipelineInfo info{};
+        info.pipelineCount = (uint32_t)(m_graphicsPipelines.size() + m_otherPipelines.size());
+        info.manifestCount = (uint32_t)m_manifest.size();
+        info.precompiledCount = m_precompiledCount;
+        info.missCount = m_missCount;
+        info.maxFrameMissCount = m_maxFrameMissCount;
+        info.missMilliseconds = m_missNanoseconds / 1e6;
+        info.maxMissMilliseconds = m_maxMissNanoseconds / 1e6;
+        info.precompileMilliseconds = m_precompileNanoseconds / 1e6;
+
+        for (auto i = 0u; i < PK_PIPELINE_MISS_HISTORY_SIZE; ++i)
+        {
+            auto index = (m_frameIndex + PK_PIPELINE_MISS_HISTORY_SIZE - 1u - i) % PK_PIPELINE_MISS_HISTORY_SIZE;
+            info.frameMissCounts[i] = m_frameMissCounts[index];
+            info.frameMissMilliseconds[i] = (float)(m_frameMissNanoseconds[index] / 1e6);
+        }
+
+        return info;
+    }
+
+    void VulkanPipelineCache::RecordMiss(const char* name, uint64_t beginTimestamp)
+    {
+        auto duration = GetTimestampNanoseconds() - beginTimestamp;
+        auto frameIndex = m_frameIndex % PK_PIPELINE_MISS_HISTORY_SIZE;
+        m_missCount++;
+        m_missNanoseconds += duration;
+        m_maxMissNanoseconds = duration > m_maxMissNanoseconds ? duration : m_maxMissNanoseconds;
+        m_frameMissCounts[frameIndex]++;
+        m_frameMissNanoseconds[frameIndex] += duration;
+        PK_LOG_VERBOSE("Pipeline cache miss: %s (%.2fms)", name, duration / 1e6);
+    }
+
+    void VulkanPipelineCache::RecordManifestEntry(const PipelineKey& key)
+    {
+        auto assetId = key.shader->GetAssetID();
+
+        if (m_workingDirectory.empty() || assetId == 0u)
+        {
+            return;
+        }
+
+        PipelineManifestEntry entry{};
+        entry.shaderPath = StringHashID::IDToString(assetId);
+        entry.variantIndex = key.shader->GetVariantIndex();
+        memcpy(&entry.key, &key, sizeof(PipelineKey));
+        memset(&entry.key.shader, 0, sizeof(entry.key.shader));
+
+        if (m_manifestHashes.insert(GetManifestHash(entry)).second)
+        {
+            m_manifest.push_back(entry);
+        }
+    }
+
+    void VulkanPipelineCache::ReadManifest()
+    {
+        void* data = nullptr;
+        size_t size = 0ull;
+
+        if (FileIO::ReadBinary((m_workingDirectory + PIPELINE_MANIFEST_FILENAME).c_str(), &data, &size) != 0)
+        {
+            return;
+        }
+
+        auto head = reinterpret_cast<const char*>(data);
+        auto end = head + size;
+        PipelineManifestHeader header{};
+
+        if (size >= sizeof(PipelineManifestHeader))
+        {
+            memcpy(&header, head, sizeof(PipelineManifestHeader));
+            head += sizeof(PipelineManifestHeader);
+        }
+
+        // Key layout changes invalidate the manifest as a whole.
+        if (header.version != PIPELINE_MANIFEST_VERSION || header.keySize != sizeof(PipelineKey))
+        {
+            PK_LOG_WARNING("Discarding an incompatible pipeline manifest.");
+            header.entryCount = 0u;
+        }
+
+        for (auto i = 0u; i < header.entryCount; ++i)
+        {
+            uint32_t variantIndex = 0u;
+            uint32_t pathLength = 0u;
+
+            if ((size_t)(end - head) < sizeof(uint32_t) * 2ull)
+            {
+                break;
+            }
+
+            memcpy(&variantIndex, head, sizeof(uint32_t));
+            memcpy(&pathLength, head + sizeof(uint32_t), sizeof(uint32_t));
+            head += sizeof(uint32_t) * 2ull;
+
+            if ((size_t)(end - head) < pathLength + sizeof(PipelineKey))
+            {
+                break;
+            }
+
+            PipelineManifestEntry entry{};
+            entry.shaderPath = std::string(head, pathLength);
+            entry.variantIndex = variantIndex;
+            memcpy(&entry.key, head + pathLength, sizeof(PipelineKey));
+            head += pathLength + sizeof(PipelineKey);
+
+            if (m_manifestHashes.insert(GetManifestHash(entry)).second)
+            {
+                m_manifest.push_back(entry);
+            }
+        }
+
+        free(data);
+    }
+
+    void VulkanPipelineCache::WriteManifest() const
+    {
+        std::vector<char> data;
+        PipelineManifestHeader header{ PIPELINE_MANIFEST_VERSION, (uint32_t)sizeof(PipelineKey), (uint32_t)m_manifest.size() };
+        data.insert(data.end(), reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header + 1));
+
+        for (auto& entry : m_manifest)
+        {
+            auto pathLength = (uint32_t)entry.shaderPath.size();
+            data.insert(data.end(), reinterpret_cast<const char*>(&entry.variantIndex), reinterpret_cast<const char*>(&entry.variantIndex + 1));
+            data.insert(data.end(), reinterpret_cast<const char*>(&pathLength), reinterpret_cast<const char*>(&pathLength + 1));
+            data.insert(data.end(), entry.shaderPath.begin(), entry.shaderPath.end());
+            data.insert(data.end(), reinterpret_cast<const char*>(&entry.key), reinterpret_cast<const char*>(&entry.key + 1));
+        }
+
+        FileIO::WriteBinary((m_workingDirectory + PIPELINE_MANIFEST_FILENAME).c_str(), data.data(), data.size());
+    }
+
     void VulkanPipelineCache::Prune()
     {
+        std::lock_guard<std::mutex> lock(m_lock);
         m_currentPruneTick++;
 
+        auto frameMissCount = m_frameMissCounts[m_frameIndex % PK_PIPELINE_MISS_HISTORY_SIZE];
+        m_maxFrameMissCount = frameMissCount > m_maxFrameMissCount ? frameMissCount : m_maxFrameMissCount;
+        m_frameIndex++;
+        m_frameMissCounts[m_frameIndex % PK_PIPELINE_MISS_HISTORY_SIZE] = 0u;
+        m_frameMissNanoseconds[m_frameIndex % PK_PIPELINE_MISS_HISTORY_SIZE] = 0ull;
+
         for (auto& kv : m_graphicsPipelines)
         {
             auto& key = kv.first;
@@ -2,7 +2,13 @@
 #include "Utilities/NoCopy.h"
 #include "Utilities/Ref.h"
 #include "Rendering/VulkanRHI/Objects/VulkanShader.h"
+#include "Rendering/VulkanRHI/Services/VulkanFrameBufferCache.h"
+#include "Rendering/GraphicsAPI.h"
+#include "Core/Services/JobSystem.h"
 #include "Utilities/HashHelpers.h"
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
 
 namespace PK::Rendering::VulkanRHI::Services
 {
@@ -12,7 +18,8 @@ namespace PK::Rendering::VulkanRHI::Services
         Structs::FixedFunctionState fixedFunctionState{};
         VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         VkBool32 primitiveRestart = VK_FALSE;
-        VkRenderPass renderPass = VK_NULL_HANDLE;
+        // Compatibility key of the target render pass. See VulkanFrameBufferCache::GetCompatibilityKey.
+        RenderPassKey renderPass{};
         VkVertexInputAttributeDescription vertexAttributes[Structs::PK_MAX_VERTEX_ATTRIBUTES]{};
         VkVertexInputBindingDescription vertexBuffers[Structs::PK_MAX_VERTEX_ATTRIBUTES]{};
 
@@ -31,38 +38,89 @@ namespace PK::Rendering::VulkanRHI::Services
         }
     };
 
+    // Graphics pipeline key that references its shader by asset path & variant index so that it remains valid across reloads & sessions.
+    struct PipelineManifestEntry
+    {
+        std::string shaderPath;
+        uint32_t variantIndex = 0u;
+        // Shader is unassigned.
+        PipelineKey key{};
+    };
+
     class VulkanPipelineCache : public PK::Utilities::NoCopy
     {
         private:
 
         public:
             constexpr const static char* PIPELINE_CACHE_FILENAME = "shadercache.cache";
+            constexpr const static char* PIPELINE_MANIFEST_FILENAME = "pipelinemanifest.cache";
+            constexpr const static uint32_t PIPELINE_MANIFEST_VERSION = 1u;
+
+            // Returns the graphics shader variant for a manifest entry or null if it no longer exists.
+            typedef std::function<const Objects::VulkanShader*(const std::string& shaderPath, uint32_t variantIndex)> ShaderResolver;
 
-            VulkanPipelineCache(VkDevice device, const std::string& workingDirectory, const VulkanPhysicalDeviceProperties& physicalDeviceProperties, uint64_t pruneDelay);
+            VulkanPipelineCache(VkDevice device, 
+                                const std::string& workingDirectory, 
+                                const VulkanPhysicalDeviceProperties& physicalDeviceProperties, 
+                                VulkanFrameBufferCache* frameBufferCache, 
+                                uint64_t pruneDelay);
             ~VulkanPipelineCache();
 
             struct PipelineValue
             {
                 VulkanPipeline* pipeline = nullptr;
                 uint64_t pruneTick = 0;
+                // Reserved by a thread that is creating the pipeline outside of the lock.
+                bool isPending = false;
             };
 
             const VulkanPipeline* GetPipeline(const PipelineKey& key);
             const VulkanPipeline* GetGraphicsPipeline(const PipelineKey& key);
             const VulkanPipeline* GetComputePipeline(const PK::Utilities::VersionHandle<Objects::VulkanShader>& shader);
             const VulkanPipeline* GetRayTracingPipeline(const PK::Utilities::VersionHandle<Objects::VulkanShader>& shader);
+
+            // Creates the graphics pipelines recorded into the manifest by previous sessions on the job system.
+            // Entries that can no longer be resolved are dropped from the manifest.
+            void Precompile(Core::Services::JobSystem* jobSystem, const ShaderResolver& resolveShader);
+            DriverPipelineInfo GetInfo() const;
             void Prune();
 
         private:
+            VulkanPipeline* CreateGraphicsPipeline(const PipelineKey& key, VkRenderPass renderPass) const;
+            VulkanPipeline* AcquirePipeline(PipelineValue* value, std::unique_lock<std::mutex>& lock);
+            void PublishPipeline(PipelineValue* value, VulkanPipeline* pipeline);
+            void RecordMiss(const char* name, uint64_t beginTimestamp);
+            void RecordManifestEntry(const PipelineKey& key);
+            void ReadManifest();
+            void WriteManifest() const;
+
             const VkDevice m_device;
             const bool m_allowUnderEstimation;
             const float m_maxOverEstimation;
 
             VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+            VulkanFrameBufferCache* m_frameBufferCache = nullptr;
             std::string m_workingDirectory;
+            std::vector<PipelineManifestEntry> m_manifest;
+            std::unordered_set<uint64_t> m_manifestHashes;
             std::unordered_map<PipelineKey, PipelineValue, PipelineKeyHash> m_graphicsPipelines;
             std::unordered_map<PK::Utilities::VersionHandle<Objects::VulkanShader>, PipelineValue, PK::Utilities::VersionHandle<Objects::VulkanShader>::Hash> m_otherPipelines;
             uint64_t m_currentPruneTick = 0;
             uint64_t m_pruneDelay = 0;
+
+            uint32_t m_precompiledCount = 0u;
+            uint32_t m_missCount = 0u;
+            uint32_t m_maxFrameMissCount = 0u;
+            uint64_t m_missNanoseconds = 0ull;
+            uint64_t m_maxMissNanoseconds = 0ull;
+            uint64_t m_precompileNanoseconds = 0ull;
+            uint32_t m_frameMissCounts[PK_PIPELINE_MISS_HISTORY_SIZE]{};
+            uint64_t m_frameMissNanoseconds[PK_PIPELINE_MISS_HISTORY_SIZE]{};
+            uint32_t m_frameIndex = 0u;
+
+            // Pipelines can be requested by secondary command buffers recording on multiple threads.
+            // They are created outside of the lock. Requests for a pipeline that is being created wait for it to be published.
+            mutable std::mutex m_lock;
+            std::condition_variable m_published;
     };
 }
\ No newline at end of file
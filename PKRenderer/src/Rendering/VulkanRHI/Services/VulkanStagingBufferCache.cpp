@@ -2,128 +2,174 @@
 #include "VulkanStagingBufferCache.h"
 #include "Utilities/VectorUtilities.h"
 #include "Core/Services/Log.h"
+#include "Math/FunctionsMisc.h"
 
 using namespace PK::Utilities;
 using namespace PK::Rendering::VulkanRHI::Services;
 using namespace PK::Rendering::Structs;
 
-template<>
-struct Vector::Comparer<VulkanStagingBuffer*>
+namespace PK::Rendering::VulkanRHI::Services
 {
-    int operator ()(VulkanStagingBuffer*& a, VulkanStagingBuffer*& b)
+    VulkanStagingBufferCache::VulkanStagingBufferCache(VkDevice device, VmaAllocator allocator, size_t frameSize) :
+        m_allocator(allocator),
+        m_device(device)
+    {
+        m_retiredRings.reserve(4);
+        m_dedicatedBuffers.reserve(32);
+        CreateRing(frameSize * PK_MAX_FRAMES_IN_FLIGHT);
+    }
+
+    VulkanStagingBufferCache::~VulkanStagingBufferCache()
     {
-        if (a->capacity < b->capacity)
+        delete m_ring.buffer;
+
+        for (auto& ring : m_retiredRings)
         {
-            return -1;
+            delete ring.buffer;
         }
 
-        if (a->capacity > b->capacity)
+        for (auto& dedicated : m_dedicatedBuffers)
         {
-            return 1;
+            delete dedicated.buffer;
         }
+    }
+
+    VulkanStagingRange VulkanStagingBufferCache::Allocate(size_t size, size_t alignment, const FenceRef& fence)
+    {
+        m_info.allocationCount++;
+        m_frameAllocationCount++;
+        m_frameBytes += size;
 
-        if (a->pruneTick < b->pruneTick)
+        if (size > PK_STAGING_DEDICATED_THRESHOLD)
         {
-            return -1;
+            VulkanBufferCreateInfo createInfo(BufferUsage::DefaultStaging | BufferUsage::PersistentStage, size);
+            auto buffer = new VulkanRawBuffer(m_device, m_allocator, createInfo, "StagingBuffer.Dedicated");
+            m_dedicatedBuffers.push_back({ buffer, fence });
+            m_info.dedicatedCount++;
+            m_info.dedicatedBytes += size;
+            return { buffer, 0ull, size };
         }
 
-        if (a->pruneTick > b->pruneTick)
+        Retire(&m_ring);
+
+        size_t offset = 0ull;
+
+        if (!TryAllocate(&m_ring, size, alignment, &offset, fence))
         {
-            return 1;
+            m_info.ringExhaustedCount++;
+            m_retiredRings.push_back(std::move(m_ring));
+            CreateRing(std::max<size_t>(m_retiredRings.back().buffer->capacity * 2ull, size * 2ull));
+            PK_THROW_ASSERT(TryAllocate(&m_ring, size, alignment, &offset, fence), "Failed to allocate a staging range from an empty ring!");
         }
 
-        return 0;
+        m_info.ringPeakUsedBytes = std::max<size_t>(m_info.ringPeakUsedBytes, m_ring.usedBytes);
+        return { m_ring.buffer, offset, size };
     }
-};
 
-template<>
-struct Vector::Bound<VulkanStagingBuffer*>
-{
-    size_t operator ()(VulkanStagingBuffer*& a)
+    void VulkanStagingBufferCache::Prune()
     {
-        return a->capacity;
-    }
-};
+        Retire(&m_ring);
 
-namespace PK::Rendering::VulkanRHI::Services
-{
-    VulkanStagingBufferCache::VulkanStagingBufferCache(VkDevice device, VmaAllocator allocator, uint64_t pruneDelay) :
-        m_allocator(allocator),
-        m_device(device),
-        m_pruneDelay(pruneDelay)
-    {
-        m_activeBuffers.reserve(32);
-        m_freeBuffers.reserve(32);
-    }
+        for (auto i = (int)m_retiredRings.size() - 1; i >= 0; --i)
+        {
+            auto& ring = m_retiredRings.at(i);
+            Retire(&ring);
 
+            if (ring.regions.empty())
+            {
+                delete ring.buffer;
+                Vector::UnorderedRemoveAt(m_retiredRings, i);
+            }
+        }
 
-    VulkanStagingBufferCache::~VulkanStagingBufferCache()
-    {
-        for (auto& buff : m_freeBuffers)
+        for (auto i = (int)m_dedicatedBuffers.size() - 1; i >= 0; --i)
         {
-            m_bufferPool.Delete(buff);
+            auto& dedicated = m_dedicatedBuffers.at(i);
+
+            if (dedicated.fence.IsComplete())
+            {
+                delete dedicated.buffer;
+                Vector::UnorderedRemoveAt(m_dedicatedBuffers, i);
+            }
         }
 
-        for (auto& buff : m_activeBuffers)
+        m_info.frameAllocationCount = m_frameAllocationCount;
+        m_info.frameBytes = m_frameBytes;
+        m_info.peakFrameBytes = std::max<size_t>(m_info.peakFrameBytes, m_frameBytes);
+        m_frameAllocationCount = 0u;
+        m_frameBytes = 0ull;
+    }
+
+    DriverStagingInfo VulkanStagingBufferCache::GetInfo() const
+    {
+        auto info = m_info;
+        info.ringCapacity = m_ring.buffer->capacity;
+        info.ringUsedBytes = m_ring.usedBytes;
+        info.dedicatedActiveCount = (uint32_t)m_dedicatedBuffers.size();
+
+        for (auto& ring : m_retiredRings)
         {
-            m_bufferPool.Delete(buff);
+            info.ringUsedBytes += ring.usedBytes;
         }
+
+        return info;
     }
 
-    VulkanStagingBuffer* VulkanStagingBufferCache::GetBuffer(size_t size, const FenceRef& fence)
+    void VulkanStagingBufferCache::CreateRing(size_t capacity)
     {
-        auto index = Vector::LowerBound(m_freeBuffers, (uint32_t)size);
-        auto nextPruneTick = m_currentPruneTick + 1;
-
-        VulkanStagingBuffer* stagingBuffer = nullptr;
+        VulkanBufferCreateInfo createInfo(BufferUsage::DefaultStaging | BufferUsage::PersistentStage, capacity);
+        m_ring = Ring();
+        m_ring.buffer = new VulkanRawBuffer(m_device, m_allocator, createInfo, "StagingBuffer.Ring");
+        m_info.ringGrowCount += m_info.ringCapacity > 0ull ? 1u : 0u;
+        m_info.ringCapacity = capacity;
+        PK_LOG_VERBOSE("Staging ring created with a capacity of %s", Math::Functions::BytesToString(capacity).c_str());
+    }
 
-        if (index != -1)
+    void VulkanStagingBufferCache::Retire(Ring* ring)
+    {
+        while (!ring->regions.empty() && ring->regions.front().fence.IsComplete())
         {
-            stagingBuffer = m_freeBuffers.at(index);
-            Vector::OrderedRemoveAt(m_freeBuffers, index);
-            m_activeBuffers.push_back(stagingBuffer);
+            ring->tail = ring->regions.front().end;
+            ring->usedBytes -= ring->regions.front().size;
+            ring->regions.pop_front();
         }
-        else
+
+        // Restart from the beginning to maximize the contiguous free range.
+        if (ring->regions.empty())
         {
-            VulkanBufferCreateInfo createInfo(BufferUsage::DefaultStaging, size);
-            stagingBuffer = m_bufferPool.New(m_device, m_allocator, createInfo, (std::string("StagingBuffer") + std::to_string(m_currentPruneTick)).c_str());
-            m_activeBuffers.push_back(stagingBuffer);
+            ring->head = 0ull;
+            ring->tail = 0ull;
+            ring->usedBytes = 0ull;
         }
-
-        stagingBuffer->pruneTick = nextPruneTick;
-        stagingBuffer->fence = fence;
-        return stagingBuffer;
     }
 
-    void VulkanStagingBufferCache::Prune()
+    bool VulkanStagingBufferCache::TryAllocate(Ring* ring, size_t size, size_t alignment, size_t* offset, const FenceRef& fence)
     {
-        ++m_currentPruneTick;
+        auto capacity = (size_t)ring->buffer->capacity;
+        auto isWrapped = ring->head < ring->tail || (ring->head == ring->tail && !ring->regions.empty());
+        auto begin = ((ring->head + alignment - 1ull) / alignment) * alignment;
 
-        for (auto i = (int)m_activeBuffers.size() - 1; i >= 0; --i)
+        if (!isWrapped && begin + size > capacity)
         {
-            auto stagingBuffer = m_activeBuffers.at(i);
-
-            // If staging buffer has been assigned an execution observer let's wait for that instead of prune tick.
-            if (stagingBuffer->fence.IsValid() ? stagingBuffer->fence.IsComplete() : stagingBuffer->pruneTick < m_currentPruneTick)
+            // Skip the remainder & continue from the beginning. The skipped range is retired with this allocation.
+            if (size > ring->tail)
             {
-                stagingBuffer->fence.Invalidate();
-                stagingBuffer->pruneTick = m_currentPruneTick + m_pruneDelay;
-                m_freeBuffers.push_back(stagingBuffer);
-                Vector::UnorderedRemoveAt(m_activeBuffers, i);
+                return false;
             }
-        }
 
-        for (auto i = (int)m_freeBuffers.size() - 1; i >= 0; --i)
+            begin = 0ull;
+        }
+        else if (isWrapped && begin + size > ring->tail)
         {
-            auto stagingBuffer = m_freeBuffers.at(i);
-
-            if (stagingBuffer->pruneTick < m_currentPruneTick)
-            {
-                m_bufferPool.Delete(stagingBuffer);
-                Vector::UnorderedRemoveAt(m_freeBuffers, i);
-            }
+            return false;
         }
 
-        Vector::QuickSort(m_freeBuffers);
+        auto end = begin + size;
+        auto regionSize = begin >= ring->head ? end - ring->head : (capacity - ring->head) + end;
+        ring->regions.push_back({ end, regionSize, fence });
+        ring->usedBytes += regionSize;
+        ring->head = end;
+        *offset = begin;
+        return true;
     }
 }
\ No newline at end of file
@@ -1,34 +1,83 @@
 #pragma once
 #include "Utilities/NoCopy.h"
 #include "Utilities/Ref.h"
-#include "Utilities/FixedPool.h"
+#include "Rendering/GraphicsAPI.h"
 #include "Rendering/VulkanRHI/Utilities/VulkanStructs.h"
+#include <deque>
 
 namespace PK::Rendering::VulkanRHI::Services
 {
-    struct VulkanStagingBuffer : public VulkanRawBuffer
+    // Initial ring capacity is this times the number of frames in flight.
+    constexpr static const size_t PK_STAGING_RING_FRAME_SIZE = 16ull << 20ull;
+    // Uploads larger than this get a dedicated buffer instead of a ring range.
+    constexpr static const size_t PK_STAGING_DEDICATED_THRESHOLD = 4ull << 20ull;
+    constexpr static const size_t PK_STAGING_ALIGNMENT = 256ull;
+    // Multiple of every texel & block size as well as the default alignment.
+    constexpr static const size_t PK_STAGING_TEXTURE_ALIGNMENT = 768ull;
+
+    struct VulkanStagingRange
     {
-        VulkanStagingBuffer(VkDevice device, VmaAllocator allocator, const VulkanBufferCreateInfo& createInfo, const char* name) : VulkanRawBuffer(device, allocator, createInfo, name) {}
-        mutable Rendering::Structs::FenceRef fence;
-        uint64_t pruneTick = 0ull;
+        VulkanRawBuffer* buffer = nullptr;
+        size_t offset = 0ull;
+        size_t size = 0ull;
+
+        inline void* BeginMap() const { return buffer->BeginMap(offset); }
+        inline void EndMap() const { buffer->EndMap(offset, size); }
+        inline void SetData(const void* data, size_t size) const { memcpy(BeginMap(), data, size); buffer->EndMap(offset, size); }
     };
 
+    /*
+     * Persistently mapped linear ring that sub allocates staging ranges.
+     * Ranges are retired in allocation order once the fence of the command buffer that consumes them has completed.
+     * A full ring is replaced by one of twice the size instead of waiting, as the oldest range may belong to a command buffer that has not been submitted yet.
+     * The previous ring is released once all of its ranges have retired.
+     */
     class VulkanStagingBufferCache : public PK::Utilities::NoCopy
     {
         public:
-            VulkanStagingBufferCache(VkDevice device, VmaAllocator allocator, uint64_t pruneDelay);
+            VulkanStagingBufferCache(VkDevice device, VmaAllocator allocator, size_t frameSize = PK_STAGING_RING_FRAME_SIZE);
             ~VulkanStagingBufferCache();
-            VulkanStagingBuffer* GetBuffer(size_t size, const Rendering::Structs::FenceRef& fence);
+
+            VulkanStagingRange Allocate(size_t size, size_t alignment, const Rendering::Structs::FenceRef& fence);
             void Prune();
 
+            DriverStagingInfo GetInfo() const;
+
         private:
+            struct Region
+            {
+                size_t end;
+                size_t size;
+                Rendering::Structs::FenceRef fence;
+            };
+
+            struct Ring
+            {
+                VulkanRawBuffer* buffer = nullptr;
+                size_t head = 0ull;
+                size_t tail = 0ull;
+                size_t usedBytes = 0ull;
+                std::deque<Region> regions;
+            };
+
+            struct DedicatedBuffer
+            {
+                VulkanRawBuffer* buffer;
+                Rendering::Structs::FenceRef fence;
+            };
+
+            void CreateRing(size_t capacity);
+            static void Retire(Ring* ring);
+            static bool TryAllocate(Ring* ring, size_t size, size_t alignment, size_t* offset, const Rendering::Structs::FenceRef& fence);
+
             const VmaAllocator m_allocator;
             const VkDevice m_device;
-            std::vector<VulkanStagingBuffer*> m_freeBuffers;
-            std::vector<VulkanStagingBuffer*> m_activeBuffers;
-            PK::Utilities::FixedPool<VulkanStagingBuffer, 1024> m_bufferPool;
+            Ring m_ring;
+            std::vector<Ring> m_retiredRings;
+            std::vector<DedicatedBuffer> m_dedicatedBuffers;
 
-            uint64_t m_currentPruneTick = 0ull;
-            uint64_t m_pruneDelay = 0ull;
+            DriverStagingInfo m_info{};
+            uint32_t m_frameAllocationCount = 0u;
+            size_t m_frameBytes = 0ull;
     };
 }
\ No newline at end of file
@@ -70,6 +70,12 @@ extern PFN_vkGetAccelerationStructureBuildSizesKHR pk_vkGetAccelerationStructure
 extern PFN_vkCmdBuildAccelerationStructuresKHR pk_vkCmdBuildAccelerationStructuresKHR;
 #define vkCmdBuildAccelerationStructuresKHR pk_vkCmdBuildAccelerationStructuresKHR
 
+extern PFN_vkCmdWriteAccelerationStructuresPropertiesKHR pk_vkCmdWriteAccelerationStructuresPropertiesKHR;
+#define vkCmdWriteAccelerationStructuresPropertiesKHR pk_vkCmdWriteAccelerationStructuresPropertiesKHR
+
+extern PFN_vkCmdCopyAccelerationStructureKHR pk_vkCmdCopyAccelerationStructureKHR;
+#define vkCmdCopyAccelerationStructureKHR pk_vkCmdCopyAccelerationStructureKHR
+
 namespace PK::Rendering::VulkanRHI::Utilities
 {
     void VulkanBindExtensionMethods(VkInstance instance);
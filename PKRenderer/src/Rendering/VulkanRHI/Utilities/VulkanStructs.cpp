@@ -281,8 +281,22 @@ namespace PK::Rendering::VulkanRHI
         EndMap(0ull, size);
     }
 
+    VulkanRawMemory::VulkanRawMemory(VmaAllocator allocator, const VkMemoryRequirements& requirements, const VmaAllocationCreateInfo& createInfo) :
+        allocator(allocator),
+        size(requirements.size)
+    {
+        VK_ASSERT_RESULT_CTX(vmaAllocateMemory(allocator, &requirements, &createInfo, &memory, nullptr), "Failed to allocate memory!");
+    }
+
+    VulkanRawMemory::~VulkanRawMemory()
+    {
+        vmaFreeMemory(allocator, memory);
+    }
+
     VulkanRawImage::VulkanRawImage(VkDevice device, VmaAllocator allocator, const VulkanImageCreateInfo& createInfo, const char* name) :
+        device(device),
         allocator(allocator),
+        isAliased(false),
         format(createInfo.image.format),
         type(createInfo.image.imageType),
         extent(createInfo.image.extent),
@@ -295,8 +309,37 @@ namespace PK::Rendering::VulkanRHI
         Utilities::VulkanSetObjectDebugName(device, VK_OBJECT_TYPE_IMAGE, (uint64_t)image, name);
     }
 
+    VulkanRawImage::VulkanRawImage(VkDevice device, VmaAllocator allocator, const VulkanRawMemory* aliasMemory, VkDeviceSize aliasOffset, const VulkanImageCreateInfo& createInfo, const char* name) :
+        device(device),
+        allocator(allocator),
+        isAliased(true),
+        memory(aliasMemory->memory),
+        format(createInfo.image.format),
+        type(createInfo.image.imageType),
+        extent(createInfo.image.extent),
+        levels(createInfo.image.mipLevels),
+        layers(createInfo.image.arrayLayers),
+        samples(createInfo.image.samples),
+        aspect(createInfo.aspect)
+    {
+        VK_ASSERT_RESULT_CTX(vkCreateImage(device, &createInfo.image, nullptr, &image), "Failed to create an image!");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, image, &requirements);
+        PK_THROW_ASSERT(aliasOffset + requirements.size <= aliasMemory->size, "Aliased image range exceeds the bounds of its memory!");
+
+        VK_ASSERT_RESULT_CTX(vmaBindImageMemory2(allocator, memory, aliasOffset, image, nullptr), "Failed to bind aliased image memory!");
+        Utilities::VulkanSetObjectDebugName(device, VK_OBJECT_TYPE_IMAGE, (uint64_t)image, name);
+    }
+
     VulkanRawImage::~VulkanRawImage()
     {
+        if (isAliased)
+        {
+            vkDestroyImage(device, image, nullptr);
+            return;
+        }
+
         vmaDestroyImage(allocator, image, memory);
     }
 
@@ -305,18 +348,38 @@ namespace PK::Rendering::VulkanRHI
         const VkAccelerationStructureGeometryKHR& geometryInfo,
         const VkAccelerationStructureBuildRangeInfoKHR& rangeInfo,
         const VkAccelerationStructureTypeKHR type,
+        const VkBuildAccelerationStructureFlagsKHR flags,
         const char* name) :
         device(device),
         geometryInfo(geometryInfo),
-        rangeInfo(rangeInfo)
+        rangeInfo(rangeInfo),
+        type(type),
+        flags(flags)
     {
-        auto buildSizeInfo = VulkanRHI::Utilities::VulkanGetAccelerationBuildSizesInfo(device, geometryInfo, type, rangeInfo.primitiveCount);
-
+        auto buildSizeInfo = VulkanRHI::Utilities::VulkanGetAccelerationBuildSizesInfo(device, geometryInfo, type, flags, rangeInfo.primitiveCount);
         scratchBufferSize = buildSizeInfo.buildScratchSize;
-        rawBuffer = new VulkanRawBuffer(device, allocator, VulkanBufferCreateInfo(BufferUsage::AccelerationStructure | BufferUsage::GPUOnly, buildSizeInfo.accelerationStructureSize), name);
+        updateScratchBufferSize = buildSizeInfo.updateScratchSize;
+        Create(allocator, buildSizeInfo.accelerationStructureSize, name);
+    }
+
+    VulkanRawAccelerationStructure::VulkanRawAccelerationStructure(VkDevice device, VmaAllocator allocator, const VulkanRawAccelerationStructure& source, VkDeviceSize size, const char* name) :
+        device(device),
+        scratchBufferSize(source.scratchBufferSize),
+        updateScratchBufferSize(source.updateScratchBufferSize),
+        geometryInfo(source.geometryInfo),
+        rangeInfo(source.rangeInfo),
+        type(source.type),
+        flags(source.flags)
+    {
+        Create(allocator, size, name);
+    }
+
+    void VulkanRawAccelerationStructure::Create(VmaAllocator allocator, VkDeviceSize size, const char* name)
+    {
+        rawBuffer = new VulkanRawBuffer(device, allocator, VulkanBufferCreateInfo(BufferUsage::AccelerationStructure | BufferUsage::GPUOnly, size), name);
 
         VkAccelerationStructureCreateInfoKHR createInfo{ VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR };
-        createInfo.size = buildSizeInfo.accelerationStructureSize;
+        createInfo.size = size;
         createInfo.type = type;
         createInfo.buffer = rawBuffer->buffer;
 
@@ -334,6 +397,23 @@ namespace PK::Rendering::VulkanRHI
         delete rawBuffer;
     }
 
+    VulkanQueryPool::VulkanQueryPool(VkDevice device, VkQueryType type, uint32_t count, const char* name) : 
+        device(device), 
+        type(type), 
+        count(count)
+    {
+        VkQueryPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+        createInfo.queryType = type;
+        createInfo.queryCount = count;
+        VK_ASSERT_RESULT_CTX(vkCreateQueryPool(device, &createInfo, nullptr, &pool), "Failed to create a query pool!");
+        Utilities::VulkanSetObjectDebugName(device, VK_OBJECT_TYPE_QUERY_POOL, (uint64_t)pool, name);
+    }
+
+    VulkanQueryPool::~VulkanQueryPool()
+    {
+        vkDestroyQueryPool(device, pool, nullptr);
+    }
+
     VulkanShaderModule::VulkanShaderModule(VkDevice device, VkShaderStageFlagBits stage, const uint32_t* spirv, size_t sprivSize, const char* name) : device(device)
     {
         VkShaderModuleCreateInfo createInfo{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
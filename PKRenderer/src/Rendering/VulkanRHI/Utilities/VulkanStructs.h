@@ -135,12 +135,26 @@ namespace PK::Rendering::VulkanRHI
         VmaAllocationInfo allocationInfo{};
     };
 
+    struct VulkanRawMemory : public Rendering::Services::IDisposable
+    {
+        VulkanRawMemory(VmaAllocator allocator, const VkMemoryRequirements& requirements, const VmaAllocationCreateInfo& createInfo);
+        ~VulkanRawMemory();
+
+        const VmaAllocator allocator;
+        const VkDeviceSize size;
+        VmaAllocation memory;
+    };
+
     struct VulkanRawImage : public Rendering::Services::IDisposable
     {
         VulkanRawImage(VkDevice device, VmaAllocator allocator, const VulkanImageCreateInfo& createInfo, const char* name);
+        // Binds the image to a range of memory that is owned & released elsewhere.
+        VulkanRawImage(VkDevice device, VmaAllocator allocator, const VulkanRawMemory* aliasMemory, VkDeviceSize aliasOffset, const VulkanImageCreateInfo& createInfo, const char* name);
         ~VulkanRawImage();
 
+        const VkDevice device;
         const VmaAllocator allocator;
+        const bool isAliased;
         VkImage image;
         VmaAllocation memory;
         VkImageAspectFlagBits aspect;
@@ -159,16 +173,36 @@ namespace PK::Rendering::VulkanRHI
             const VkAccelerationStructureGeometryKHR& geometryInfo,
             const VkAccelerationStructureBuildRangeInfoKHR& rangeInfo,
             const VkAccelerationStructureTypeKHR type,
+            const VkBuildAccelerationStructureFlagsKHR flags,
             const char* name);
+        // Creates an unbuilt structure of a given size with the build inputs of another. Used as a compacting copy destination.
+        VulkanRawAccelerationStructure(VkDevice device, VmaAllocator allocator, const VulkanRawAccelerationStructure& source, VkDeviceSize size, const char* name);
         ~VulkanRawAccelerationStructure();
 
         const VkDevice device;
         VulkanRawBuffer* rawBuffer;
         VkDeviceSize scratchBufferSize;
+        VkDeviceSize updateScratchBufferSize;
         VkDeviceAddress deviceAddress;
         VkAccelerationStructureKHR structure;
         VkAccelerationStructureGeometryKHR geometryInfo;
         VkAccelerationStructureBuildRangeInfoKHR rangeInfo;
+        VkAccelerationStructureTypeKHR type;
+        VkBuildAccelerationStructureFlagsKHR flags;
+
+        private:
+            void Create(VmaAllocator allocator, VkDeviceSize size, const char* name);
+    };
+
+    struct VulkanQueryPool : public Rendering::Services::IDisposable
+    {
+        VulkanQueryPool(VkDevice device, VkQueryType type, uint32_t count, const char* name);
+        ~VulkanQueryPool();
+
+        const VkDevice device;
+        VkQueryPool pool;
+        VkQueryType type;
+        uint32_t count;
     };
 
     struct VulkanShaderModule : public Rendering::Services::IDisposable
@@ -8,6 +8,7 @@
 #include "Rendering/VulkanRHI/Objects/VulkanTexture.h"
 #include "Rendering/VulkanRHI/Objects/VulkanAccelerationStructure.h"
 #include "Rendering/VulkanRHI/Objects/VulkanBindArray.h"
+#include "Rendering/VulkanRHI/Objects/VulkanShader.h"
 #include <gfx.h>
 
 namespace PK::Rendering::VulkanRHI
@@ -112,6 +113,7 @@ namespace PK::Rendering::VulkanRHI
         physicalDeviceRequirements.features.vk11.storageBuffer16BitAccess = VK_TRUE;
         physicalDeviceRequirements.features.vk11.uniformAndStorageBuffer16BitAccess = VK_TRUE;
         physicalDeviceRequirements.features.vk11.storagePushConstant16 = VK_TRUE;
+        physicalDeviceRequirements.features.vk11.shaderDrawParameters = VK_TRUE;
         physicalDeviceRequirements.features.vk12.shaderUniformBufferArrayNonUniformIndexing = VK_TRUE;
         physicalDeviceRequirements.features.vk12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
         physicalDeviceRequirements.features.vk12.runtimeDescriptorArray = VK_TRUE;
@@ -167,8 +169,8 @@ namespace PK::Rendering::VulkanRHI
 
 
         frameBufferCache = CreateScope<VulkanFrameBufferCache>(device, properties.garbagePruneDelay);
-        stagingBufferCache = CreateScope<VulkanStagingBufferCache>(device, allocator, properties.garbagePruneDelay);
-        pipelineCache = CreateScope<VulkanPipelineCache>(device, properties.workingDirectory, physicalDeviceProperties, properties.garbagePruneDelay);
+        stagingBufferCache = CreateScope<VulkanStagingBufferCache>(device, allocator);
+        pipelineCache = CreateScope<VulkanPipelineCache>(device, properties.workingDirectory, physicalDeviceProperties, frameBufferCache.get(), properties.garbagePruneDelay);
         samplerCache = CreateScope<VulkanSamplerCache>(device);
         layoutCache = CreateScope<VulkanLayoutCache>(device);
         disposer = CreateScope<Disposer>();
@@ -317,6 +319,20 @@ namespace PK::Rendering::VulkanRHI
         globalResources.Set<bool>(nameHashId, value);
     }
 
+    void VulkanDriver::PrecompilePipelines(Core::Services::AssetDatabase* assetDatabase, Core::Services::JobSystem* jobSystem)
+    {
+        pipelineCache->Precompile(jobSystem, [assetDatabase](const std::string& shaderPath, uint32_t variantIndex) -> const VulkanShader*
+        {
+            if (!std::filesystem::exists(shaderPath))
+            {
+                return nullptr;
+            }
+
+            auto shader = assetDatabase->Load<Rendering::Objects::Shader>(shaderPath);
+            return variantIndex < shader->GetVariantCount() ? shader->GetVariant(variantIndex)->GetNative<VulkanShader>() : nullptr;
+        });
+    }
+
     void VulkanDriver::GC()
     {
         stagingBufferCache->Prune();
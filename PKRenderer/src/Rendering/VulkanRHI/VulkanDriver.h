@@ -57,6 +57,8 @@ namespace PK::Rendering::VulkanRHI
         Rendering::Objects::QueueSet* GetQueues() const override final { return queues.get(); }
         std::string GetDriverHeader() const;
         DriverMemoryInfo GetMemoryInfo() const override final;
+        DriverPipelineInfo GetPipelineInfo() const override final { return pipelineCache->GetInfo(); }
+        DriverStagingInfo GetStagingInfo() const override final { return stagingBufferCache->GetInfo(); }
         size_t GetBufferOffsetAlignment(Structs::BufferUsage usage) const override final;
 
         void SetBuffer(uint32_t nameHashId, Objects::Buffer* buffer, const Structs::IndexRange& range) override final;
@@ -68,6 +70,7 @@ namespace PK::Rendering::VulkanRHI
         void SetConstant(uint32_t nameHashId, const void* data, uint32_t size) override final;
         void SetKeyword(uint32_t nameHashId, bool value) override final;
 
+        void PrecompilePipelines(Core::Services::AssetDatabase* assetDatabase, Core::Services::JobSystem* jobSystem) override final;
         void WaitForIdle() const override final { vkDeviceWaitIdle(device); }
         void GC() override final;
 
@@ -0,0 +1,298 @@
+#include "PrecompiledHeader.h"
+#include "Compression.h"
+
+namespace PK::Utilities::Compression
+{
+    constexpr static const uint32_t WINDOW_SIZE = 32768u;
+    constexpr static const uint32_t WINDOW_MASK = WINDOW_SIZE - 1u;
+    constexpr static const uint32_t HASH_BITS = 15u;
+    constexpr static const uint32_t HASH_SIZE = 1u << HASH_BITS;
+    constexpr static const uint32_t MAX_CHAIN = 16u;
+    constexpr static const uint32_t MIN_MATCH = 3u;
+    constexpr static const uint32_t MAX_MATCH = 258u;
+
+    constexpr static const uint16_t LENGTH_BASE[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+    constexpr static const uint8_t LENGTH_EXTRA[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+    constexpr static const uint16_t DISTANCE_BASE[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+    constexpr static const uint8_t DISTANCE_EXTRA[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+    struct DeflateTables
+    {
+        uint32_t crc[256];
+        // Bit reversed fixed huffman codes as deflate writes them starting from the most significant bit.
+        uint16_t literalCodes[288];
+        uint8_t literalLengths[288];
+        uint8_t distanceCodes[30];
+        uint8_t lengthSymbols[MAX_MATCH + 1u];
+        // Distances 1-256 are indexed directly, larger ones by (distance - 1) >> 7.
+        uint8_t distanceSymbols[512];
+
+        static uint32_t Reverse(uint32_t code, uint32_t length)
+        {
+            auto value = 0u;
+
+            for (auto i = 0u; i < length; ++i)
+            {
+                value = (value << 1u) | ((code >> i) & 1u);
+            }
+
+            return value;
+        }
+
+        DeflateTables()
+        {
+            for (auto i = 0u; i < 256u; ++i)
+            {
+                auto c = i;
+
+                for (auto k = 0u; k < 8u; ++k)
+                {
+                    c = (c & 1u) ? 0xEDB88320u ^ (c >> 1u) : c >> 1u;
+                }
+
+                crc[i] = c;
+            }
+
+            for (auto i = 0u; i < 288u; ++i)
+            {
+                uint32_t code, length;
+
+                if (i < 144u) { code = 0x30u + i; length = 8u; }
+                else if (i < 256u) { code = 0x190u + i - 144u; length = 9u; }
+                else if (i < 280u) { code = i - 256u; length = 7u; }
+                else { code = 0xC0u + i - 280u; length = 8u; }
+
+                literalCodes[i] = (uint16_t)Reverse(code, length);
+                literalLengths[i] = (uint8_t)length;
+            }
+
+            for (auto i = 0u; i < 30u; ++i)
+            {
+                distanceCodes[i] = (uint8_t)Reverse(i, 5u);
+            }
+
+            for (auto i = 0u; i < 29u; ++i)
+            {
+                auto end = i < 28u ? LENGTH_BASE[i + 1u] : MAX_MATCH + 1u;
+
+                for (auto length = (uint32_t)LENGTH_BASE[i]; length < end && length <= MAX_MATCH; ++length)
+                {
+                    lengthSymbols[length] = (uint8_t)i;
+                }
+            }
+
+            for (auto i = 0u; i < 30u; ++i)
+            {
+                auto first = (uint32_t)DISTANCE_BASE[i] - 1u;
+                auto last = first + (1u << DISTANCE_EXTRA[i]);
+
+                for (auto d = first; d < last; ++d)
+                {
+                    if (d < 256u)
+                    {
+                        distanceSymbols[d] = (uint8_t)i;
+                    }
+                    else
+                    {
+                        distanceSymbols[256u + (d >> 7u)] = (uint8_t)i;
+                    }
+                }
+            }
+        }
+
+        inline uint32_t GetDistanceSymbol(uint32_t distance) const
+        {
+            auto d = distance - 1u;
+            return d < 256u ? distanceSymbols[d] : distanceSymbols[256u + (d >> 7u)];
+        }
+    };
+
+    static const DeflateTables s_tables;
+
+    struct BitWriter
+    {
+        std::vector<uint8_t>* output;
+        uint64_t bits = 0ull;
+        uint32_t count = 0u;
+
+        BitWriter(std::vector<uint8_t>* output) : output(output) {}
+
+        inline void Write(uint32_t value, uint32_t length)
+        {
+            bits |= (uint64_t)value << count;
+            count += length;
+
+            while (count >= 8u)
+            {
+                output->push_back((uint8_t)bits);
+                bits >>= 8u;
+                count -= 8u;
+            }
+        }
+
+        inline void WriteLiteral(uint32_t symbol)
+        {
+            Write(s_tables.literalCodes[symbol], s_tables.literalLengths[symbol]);
+        }
+
+        inline void WriteMatch(uint32_t length, uint32_t distance)
+        {
+            auto lengthSymbol = s_tables.lengthSymbols[length];
+            WriteLiteral(257u + lengthSymbol);
+            Write(length - LENGTH_BASE[lengthSymbol], LENGTH_EXTRA[lengthSymbol]);
+
+            auto distanceSymbol = s_tables.GetDistanceSymbol(distance);
+            Write(s_tables.distanceCodes[distanceSymbol], 5u);
+            Write(distance - DISTANCE_BASE[distanceSymbol], DISTANCE_EXTRA[distanceSymbol]);
+        }
+
+        inline void Flush()
+        {
+            if (count > 0u)
+            {
+                output->push_back((uint8_t)bits);
+            }
+
+            bits = 0ull;
+            count = 0u;
+        }
+    };
+
+    static inline uint32_t Hash(const uint8_t* data)
+    {
+        return (((uint32_t)data[0] << 10u) ^ ((uint32_t)data[1] << 5u) ^ (uint32_t)data[2]) & (HASH_SIZE - 1u);
+    }
+
+    uint32_t CRC32(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        crc = ~crc;
+
+        for (auto i = 0ull; i < size; ++i)
+        {
+            crc = s_tables.crc[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8u);
+        }
+
+        return ~crc;
+    }
+
+    uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t size)
+    {
+        auto a = adler & 0xFFFFu;
+        auto b = adler >> 16u;
+
+        while (size > 0ull)
+        {
+            // Largest block for which b cannot overflow before the modulo.
+            auto blockSize = size < 5552ull ? size : 5552ull;
+            size -= blockSize;
+
+            for (auto i = 0ull; i < blockSize; ++i)
+            {
+                a += *data++;
+                b += a;
+            }
+
+            a %= 65521u;
+            b %= 65521u;
+        }
+
+        return (b << 16u) | a;
+    }
+
+    void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>* output)
+    {
+        output->reserve(output->size() + size / 2ull + 64ull);
+
+        // 32K window, deflate, no dictionary. Header check bits make the pair divisible by 31.
+        output->push_back(0x78u);
+        output->push_back(0x01u);
+
+        std::vector<int32_t> head(HASH_SIZE, -1);
+        std::vector<int32_t> prev(WINDOW_SIZE, -1);
+
+        BitWriter writer(output);
+        // Single final block using the fixed codes.
+        writer.Write(1u, 1u);
+        writer.Write(1u, 2u);
+
+        auto insert = [&](size_t position)
+        {
+            if (position + MIN_MATCH <= size)
+            {
+                auto h = Hash(data + position);
+                prev[position & WINDOW_MASK] = head[h];
+                head[h] = (int32_t)position;
+            }
+        };
+
+        size_t i = 0ull;
+
+        while (i < size)
+        {
+            auto bestLength = 0u;
+            auto bestDistance = 0u;
+
+            if (i + MIN_MATCH <= size)
+            {
+                auto maxLength = (uint32_t)std::min<size_t>(MAX_MATCH, size - i);
+                auto candidate = head[Hash(data + i)];
+                auto chain = MAX_CHAIN;
+
+                while (candidate >= 0 && i - (size_t)candidate <= WINDOW_SIZE && chain-- > 0u)
+                {
+                    auto match = data + candidate;
+
+                    if (match[bestLength] == data[i + bestLength])
+                    {
+                        auto length = 0u;
+
+                        while (length < maxLength && match[length] == data[i + length])
+                        {
+                            ++length;
+                        }
+
+                        if (length > bestLength)
+                        {
+                            bestLength = length;
+                            bestDistance = (uint32_t)(i - (size_t)candidate);
+
+                            if (length == maxLength)
+                            {
+                                break;
+                            }
+                        }
+                    }
+
+                    candidate = prev[candidate & WINDOW_MASK];
+                }
+            }
+
+            if (bestLength >= MIN_MATCH)
+            {
+                writer.WriteMatch(bestLength, bestDistance);
+
+                for (auto k = 0u; k < bestLength; ++k)
+                {
+                    insert(i + k);
+                }
+
+                i += bestLength;
+            }
+            else
+            {
+                writer.WriteLiteral(data[i]);
+                insert(i);
+                ++i;
+            }
+        }
+
+        writer.WriteLiteral(256u);
+        writer.Flush();
+
+        auto adler = Adler32(1u, data, size);
+        output->push_back((uint8_t)(adler >> 24u));
+        output->push_back((uint8_t)(adler >> 16u));
+        output->push_back((uint8_t)(adler >> 8u));
+        output->push_back((uint8_t)adler);
+    }
+}
\ No newline at end of file
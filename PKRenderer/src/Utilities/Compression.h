@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace PK::Utilities::Compression
+{
+    uint32_t CRC32(uint32_t crc, const uint8_t* data, size_t size);
+    uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t size);
+
+    // Appends a zlib stream of the data to the output.
+    // Uses greedy LZ77 matching with the fixed deflate huffman codes. Fast enough for runtime captures, not tuned for ratio.
+    void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>* output);
+}
\ No newline at end of file
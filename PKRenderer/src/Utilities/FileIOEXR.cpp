@@ -0,0 +1,162 @@
+#include "PrecompiledHeader.h"
+#include "FileIOEXR.h"
+#include "Compression.h"
+
+namespace PK::Utilities::FileIO
+{
+    constexpr static const uint32_t EXR_MAGIC = 20000630u;
+    constexpr static const uint32_t EXR_VERSION = 2u;
+    constexpr static const uint32_t EXR_PIXEL_TYPE_HALF = 1u;
+    constexpr static const uint8_t EXR_COMPRESSION_ZIP = 3u;
+    constexpr static const uint32_t EXR_ZIP_SCANLINES = 16u;
+    // Channels are stored in alphabetical order. Values are source offsets within an rgba pixel.
+    constexpr static const char* EXR_CHANNEL_NAMES[3] = { "B", "G", "R" };
+    constexpr static const uint32_t EXR_CHANNEL_OFFSETS[3] = { 2u, 1u, 0u };
+
+    template<typename T>
+    static void Append(std::vector<uint8_t>& stream, const T& value)
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(&value);
+        stream.insert(stream.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void AppendString(std::vector<uint8_t>& stream, const char* value)
+    {
+        stream.insert(stream.end(), value, value + strlen(value) + 1ull);
+    }
+
+    static void AppendAttribute(std::vector<uint8_t>& stream, const char* name, const char* type, const std::vector<uint8_t>& value)
+    {
+        AppendString(stream, name);
+        AppendString(stream, type);
+        Append(stream, (int32_t)value.size());
+        stream.insert(stream.end(), value.begin(), value.end());
+    }
+
+    // Zip compression splits even & odd bytes & stores the deltas between consecutive bytes before deflating them.
+    static void CompressZip(const std::vector<uint8_t>& raw, std::vector<uint8_t>& scratch, std::vector<uint8_t>* output)
+    {
+        auto size = raw.size();
+        scratch.resize(size);
+
+        auto t1 = scratch.data();
+        auto t2 = scratch.data() + (size + 1ull) / 2ull;
+
+        for (auto i = 0ull; i < size; ++i)
+        {
+            *((i & 1ull) ? t2++ : t1++) = raw[i];
+        }
+
+        auto previous = size > 0ull ? (int32_t)scratch[0] : 0;
+
+        for (auto i = 1ull; i < size; ++i)
+        {
+            auto current = (int32_t)scratch[i];
+            scratch[i] = (uint8_t)(current - previous + (128 + 256));
+            previous = current;
+        }
+
+        output->clear();
+        Compression::ZlibCompress(scratch.data(), size, output);
+    }
+
+    bool WriteEXR(const char* fileName, const uint16_t* pixels, uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> header;
+        Append(header, EXR_MAGIC);
+        Append(header, EXR_VERSION);
+
+        std::vector<uint8_t> value;
+
+        for (auto name : EXR_CHANNEL_NAMES)
+        {
+            AppendString(value, name);
+            Append(value, EXR_PIXEL_TYPE_HALF);
+            // pLinear & reserved
+            Append(value, 0u);
+            // x & y sampling
+            Append(value, 1);
+            Append(value, 1);
+        }
+
+        value.push_back(0u);
+        AppendAttribute(header, "channels", "chlist", value);
+
+        value = { EXR_COMPRESSION_ZIP };
+        AppendAttribute(header, "compression", "compression", value);
+
+        value.clear();
+        Append(value, 0);
+        Append(value, 0);
+        Append(value, (int32_t)width - 1);
+        Append(value, (int32_t)height - 1);
+        AppendAttribute(header, "dataWindow", "box2i", value);
+        AppendAttribute(header, "displayWindow", "box2i", value);
+
+        // Increasing y
+        value = { 0u };
+        AppendAttribute(header, "lineOrder", "lineOrder", value);
+
+        value.clear();
+        Append(value, 1.0f);
+        AppendAttribute(header, "pixelAspectRatio", "float", value);
+        AppendAttribute(header, "screenWindowWidth", "float", value);
+
+        value.clear();
+        Append(value, 0.0f);
+        Append(value, 0.0f);
+        AppendAttribute(header, "screenWindowCenter", "v2f", value);
+
+        header.push_back(0u);
+
+        auto chunkCount = (height + EXR_ZIP_SCANLINES - 1u) / EXR_ZIP_SCANLINES;
+        auto offset = (uint64_t)header.size() + sizeof(uint64_t) * chunkCount;
+        std::vector<uint64_t> offsets(chunkCount);
+        std::vector<uint8_t> chunks;
+        std::vector<uint8_t> raw;
+        std::vector<uint8_t> scratch;
+        std::vector<uint8_t> compressed;
+
+        for (auto chunk = 0u; chunk < chunkCount; ++chunk)
+        {
+            auto firstLine = chunk * EXR_ZIP_SCANLINES;
+            auto lastLine = std::min(firstLine + EXR_ZIP_SCANLINES, height);
+            raw.clear();
+
+            for (auto y = firstLine; y < lastLine; ++y)
+            {
+                auto row = pixels + (size_t)y * width * 4ull;
+
+                for (auto channel : EXR_CHANNEL_OFFSETS)
+                {
+                    for (auto x = 0u; x < width; ++x)
+                    {
+                        Append(raw, row[x * 4u + channel]);
+                    }
+                }
+            }
+
+            CompressZip(raw, scratch, &compressed);
+
+            // Readers treat blocks that did not shrink as uncompressed.
+            auto& data = compressed.size() < raw.size() ? compressed : raw;
+            offsets[chunk] = offset + chunks.size();
+            Append(chunks, (int32_t)firstLine);
+            Append(chunks, (int32_t)data.size());
+            chunks.insert(chunks.end(), data.begin(), data.end());
+        }
+
+        auto file = fopen(fileName, "wb");
+
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        fwrite(header.data(), 1, header.size(), file);
+        fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file);
+        fwrite(chunks.data(), 1, chunks.size(), file);
+        fclose(file);
+        return true;
+    }
+}
\ No newline at end of file
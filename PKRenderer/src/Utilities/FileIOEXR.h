@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+namespace PK::Utilities::FileIO
+{
+    // Writes the rgb channels of interleaved half float rgba pixels ordered from top to bottom as a zip compressed scanline image.
+    bool WriteEXR(const char* fileName, const uint16_t* pixels, uint32_t width, uint32_t height);
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "PrecompiledHeader.h"
+#include "FileIOPNG.h"
+#include "Compression.h"
+
+namespace PK::Utilities::FileIO
+{
+    constexpr static const uint8_t PNG_SIGNATURE[8] = { 0x89u, 'P', 'N', 'G', '\r', '\n', 0x1Au, '\n' };
+
+    static void WriteUint32BE(uint8_t* dst, uint32_t value)
+    {
+        dst[0] = (uint8_t)(value >> 24u);
+        dst[1] = (uint8_t)(value >> 16u);
+        dst[2] = (uint8_t)(value >> 8u);
+        dst[3] = (uint8_t)value;
+    }
+
+    static void WriteChunk(FILE* file, const char* type, const uint8_t* data, uint32_t size)
+    {
+        uint8_t header[8];
+        WriteUint32BE(header, size);
+        memcpy(header + 4, type, 4);
+
+        auto crc = Compression::CRC32(0u, header + 4, 4);
+        crc = Compression::CRC32(crc, data, size);
+
+        uint8_t footer[4];
+        WriteUint32BE(footer, crc);
+
+        fwrite(header, 1, sizeof(header), file);
+        fwrite(data, 1, size, file);
+        fwrite(footer, 1, sizeof(footer), file);
+    }
+
+    static inline uint8_t Paeth(int32_t a, int32_t b, int32_t c)
+    {
+        auto p = a + b - c;
+        auto pa = abs(p - a);
+        auto pb = abs(p - b);
+        auto pc = abs(p - c);
+        return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+    }
+
+    // Filters a row with each filter type & keeps the one with the smallest sum of absolute signed residuals.
+    static void FilterRow(const uint8_t* row, const uint8_t* above, uint32_t size, uint32_t bpp, uint8_t* candidates, uint8_t* dst)
+    {
+        uint64_t bestScore = ~0ull;
+        auto bestFilter = 0u;
+
+        for (auto filter = 0u; filter < 5u; ++filter)
+        {
+            auto out = candidates + (size_t)filter * size;
+            uint64_t score = 0ull;
+
+            for (auto i = 0u; i < size; ++i)
+            {
+                int32_t a = i >= bpp ? row[i - bpp] : 0;
+                int32_t b = above != nullptr ? above[i] : 0;
+                int32_t c = i >= bpp && above != nullptr ? above[i - bpp] : 0;
+                int32_t x = row[i];
+                uint8_t value = 0u;
+
+                switch (filter)
+                {
+                    case 0: value = (uint8_t)x; break;
+                    case 1: value = (uint8_t)(x - a); break;
+                    case 2: value = (uint8_t)(x - b); break;
+                    case 3: value = (uint8_t)(x - ((a + b) >> 1)); break;
+                    case 4: value = (uint8_t)(x - Paeth(a, b, c)); break;
+                }
+
+                out[i] = value;
+                score += (uint64_t)abs((int32_t)(int8_t)value);
+            }
+
+            if (score < bestScore)
+            {
+                bestScore = score;
+                bestFilter = filter;
+            }
+        }
+
+        dst[0] = (uint8_t)bestFilter;
+        memcpy(dst + 1, candidates + (size_t)bestFilter * size, size);
+    }
+
+    bool WritePNG(const char* fileName, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels)
+    {
+        if (channels != 3u && channels != 4u)
+        {
+            return false;
+        }
+
+        auto rowSize = width * channels;
+        std::vector<uint8_t> filtered(((size_t)rowSize + 1ull) * height);
+        std::vector<uint8_t> candidates((size_t)rowSize * 5ull);
+
+        for (auto y = 0u; y < height; ++y)
+        {
+            auto row = pixels + (size_t)y * rowSize;
+            auto above = y > 0u ? row - rowSize : nullptr;
+            FilterRow(row, above, rowSize, channels, candidates.data(), filtered.data() + (size_t)y * (rowSize + 1ull));
+        }
+
+        std::vector<uint8_t> compressed;
+        Compression::ZlibCompress(filtered.data(), filtered.size(), &compressed);
+
+        auto file = fopen(fileName, "wb");
+
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        uint8_t header[13];
+        WriteUint32BE(header + 0, width);
+        WriteUint32BE(header + 4, height);
+        header[8] = 8u;
+        header[9] = channels == 4u ? 6u : 2u;
+        header[10] = 0u;
+        header[11] = 0u;
+        header[12] = 0u;
+
+        fwrite(PNG_SIGNATURE, 1, sizeof(PNG_SIGNATURE), file);
+        WriteChunk(file, "IHDR", header, sizeof(header));
+
+        // Split into chunks so that chunk lengths stay well below the 2^31 limit.
+        constexpr auto maxChunkSize = 1u << 24u;
+
+        for (auto offset = 0ull; offset < compressed.size(); offset += maxChunkSize)
+        {
+            auto size = (uint32_t)std::min<size_t>(maxChunkSize, compressed.size() - offset);
+            WriteChunk(file, "IDAT", compressed.data() + offset, size);
+        }
+
+        WriteChunk(file, "IEND", nullptr, 0u);
+        fclose(file);
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+namespace PK::Utilities::FileIO
+{
+    // 8 bit RGB (3 channels) or RGBA (4 channels) rows ordered from top to bottom.
+    bool WritePNG(const char* fileName, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels);
+}
\ No newline at end of file
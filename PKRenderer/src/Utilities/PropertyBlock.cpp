@@ -1,8 +1,11 @@
 #include "PrecompiledHeader.h"
 #include "PropertyBlock.h"
+#include <atomic>
 
 namespace PK::Utilities
 {
+    static std::atomic<uint64_t> s_versionCounter = 0ull;
+
     PropertyBlock::PropertyBlock(uint64_t initialCapacity)
     {
         ValidateBufferSize(initialCapacity);
@@ -57,6 +60,7 @@ namespace PK::Utilities
         m_head = 0;
         m_properties.clear();
         memset(m_buffer, 0, m_capacity);
+        IncrementVersion();
     }
 
     bool PropertyBlock::TryWriteValue(const void* src, PropertyInfo& info, uint64_t writeSize)
@@ -68,6 +72,7 @@ namespace PK::Utilities
 
         auto dst = reinterpret_cast<char*>(m_buffer) + info.offset;
         memcpy(dst, src, writeSize);
+        IncrementVersion();
         return true;
     }
 
@@ -100,6 +105,11 @@ namespace PK::Utilities
         m_buffer = newBuffer;
     }
 
+    void PropertyBlock::IncrementVersion()
+    {
+        m_version = ++s_versionCounter;
+    }
+
     void PropertyBlock::SetForeign(void* buffer, uint64_t capacity)
     {
         m_buffer = buffer;
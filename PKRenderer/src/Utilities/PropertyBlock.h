@@ -89,6 +89,9 @@ namespace PK::Utilities
 			}
 
 			inline void FreezeLayout() { m_explicitLayout = true; }
+
+			// Unique across all blocks. Changes whenever values or layout are modified.
+			constexpr uint64_t GetVersion() const { return m_version; }
 		
 			template<typename T>
 			void Set(uint32_t hashId, const T* src, uint32_t count = 1u)
@@ -148,18 +151,21 @@ namespace PK::Utilities
 				ValidateBufferSize(m_head + wsize);
 				group[hashId] = { (uint32_t)m_head, wsize };
 				m_head += wsize;
+				IncrementVersion();
 			}
 	
 		protected:
 			bool TryWriteValue(const void* src, PropertyInfo& info, uint64_t writeSize);
 			void ValidateBufferSize(uint64_t size);
 			void SetForeign(void* buffer, uint64_t capacity);
+			void IncrementVersion();
 
 			bool m_foreignBuffer = false;
 			bool m_explicitLayout = false;
 			void* m_buffer = nullptr;
 			uint64_t m_capacity = 0ull;
 			uint64_t m_head = 0ll;
+			uint64_t m_version = 0ull;
 			std::unordered_map<std::type_index, std::unordered_map<uint32_t, PropertyInfo>> m_properties;
     };
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "PrecompiledHeader.h"
+#include "QuadtreeAllocator.h"
+
+namespace PK::Utilities
+{
+    QuadtreeAllocator::QuadtreeAllocator(uint32_t levelCount) : m_levelCount(levelCount)
+    {
+        // Nodes are stored per level in morton order so that the children of node n are 4n...4n+3 on the next level.
+        for (auto i = 0u; i < levelCount; ++i)
+        {
+            m_levelOffsets.push_back(m_nodesPerPage);
+            m_nodesPerPage += 1u << (2u * i);
+        }
+    }
+
+    bool QuadtreeAllocator::Allocate(uint32_t level, QuadtreeNode* node)
+    {
+        if (level >= m_levelCount)
+        {
+            throw std::invalid_argument("Out of bounds quadtree level!");
+        }
+
+        // Partially used pages are filled first to keep whole pages available for large regions.
+        for (auto pass = 0u; pass < 2u; ++pass)
+        {
+            auto state = pass == 0u ? NodeState::Split : NodeState::Free;
+
+            for (auto page = 0u; page < m_pageCount; ++page)
+            {
+                uint32_t index;
+
+                if (GetNode(page, 0u, 0u) == state && AllocateNode(page, 0u, 0u, level, &index))
+                {
+                    node->page = (uint16_t)page;
+                    node->level = (uint16_t)level;
+                    node->x = 0u;
+                    node->y = 0u;
+
+                    // Deinterleave morton bits.
+                    for (auto i = 0u; i < level; ++i)
+                    {
+                        node->x |= ((index >> (2u * i)) & 1u) << i;
+                        node->y |= ((index >> (2u * i + 1u)) & 1u) << i;
+                    }
+
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    bool QuadtreeAllocator::AllocatePages(uint32_t count, uint32_t* firstPage)
+    {
+        auto freeCount = 0u;
+
+        for (auto page = 0u; page < m_pageCount; ++page)
+        {
+            freeCount = GetNode(page, 0u, 0u) == NodeState::Free ? freeCount + 1u : 0u;
+
+            if (freeCount == count)
+            {
+                *firstPage = page + 1u - count;
+
+                for (auto i = *firstPage; i <= page; ++i)
+                {
+                    GetNode(i, 0u, 0u) = NodeState::Used;
+                }
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void QuadtreeAllocator::Free(const QuadtreeNode& node)
+    {
+        auto index = 0u;
+
+        for (auto i = 0u; i < node.level; ++i)
+        {
+            index |= ((node.x >> i) & 1u) << (2u * i);
+            index |= ((node.y >> i) & 1u) << (2u * i + 1u);
+        }
+
+        GetNode(node.page, node.level, index) = NodeState::Free;
+
+        // Merge with siblings. Children of a free node are always free.
+        for (auto level = node.level; level > 0u; --level)
+        {
+            auto first = index & ~3u;
+
+            for (auto i = 0u; i < 4u; ++i)
+            {
+                if (GetNode(node.page, level, first + i) != NodeState::Free)
+                {
+                    return;
+                }
+            }
+
+            index >>= 2u;
+            GetNode(node.page, level - 1u, index) = NodeState::Free;
+        }
+    }
+
+    void QuadtreeAllocator::FreePages(uint32_t firstPage, uint32_t count)
+    {
+        for (auto page = firstPage; page < firstPage + count; ++page)
+        {
+            GetNode(page, 0u, 0u) = NodeState::Free;
+        }
+    }
+
+    void QuadtreeAllocator::SetPageCount(uint32_t count)
+    {
+        if (count < m_pageCount)
+        {
+            throw std::runtime_error("Cannot remove quadtree allocator pages!");
+        }
+
+        m_pageCount = count;
+        m_nodes.resize((size_t)m_pageCount * m_nodesPerPage, NodeState::Free);
+    }
+
+    bool QuadtreeAllocator::AllocateNode(uint32_t page, uint32_t level, uint32_t index, uint32_t targetLevel, uint32_t* outIndex)
+    {
+        auto& state = GetNode(page, level, index);
+
+        if (state == NodeState::Used)
+        {
+            return false;
+        }
+
+        if (level == targetLevel)
+        {
+            if (state == NodeState::Free)
+            {
+                state = NodeState::Used;
+                *outIndex = index;
+                return true;
+            }
+
+            return false;
+        }
+
+        if (state == NodeState::Free)
+        {
+            // A freshly split node always has room for a smaller region.
+            state = NodeState::Split;
+            return AllocateNode(page, level + 1u, index * 4u, targetLevel, outIndex);
+        }
+
+        // Descend into split children first to avoid breaking up free ones.
+        for (auto pass = 0u; pass < 2u; ++pass)
+        {
+            auto childState = pass == 0u ? NodeState::Split : NodeState::Free;
+
+            for (auto i = 0u; i < 4u; ++i)
+            {
+                auto child = index * 4u + i;
+
+                if (GetNode(page, level + 1u, child) == childState && AllocateNode(page, level + 1u, child, targetLevel, outIndex))
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+}
\ No newline at end of file
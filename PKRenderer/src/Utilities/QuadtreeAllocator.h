@@ -0,0 +1,55 @@
+#pragma once
+#include "NoCopy.h"
+#include <vector>
+
+namespace PK::Utilities
+{
+    // Square region of a page. Coordinates are in units of the region size at its level.
+    struct QuadtreeNode
+    {
+        uint16_t page = 0u;
+        uint16_t level = 0u;
+        uint16_t x = 0u;
+        uint16_t y = 0u;
+    };
+
+    /*
+     * Buddy allocator of square regions over a growable set of equally sized pages.
+     * Each page is a quadtree where level n regions span 1/2^n of the page's width.
+     * Freed regions merge with their siblings so that larger regions become available again.
+     */
+    class QuadtreeAllocator : public NoCopy
+    {
+        public:
+            QuadtreeAllocator(uint32_t levelCount);
+
+            // Returns false when no page has a free region of the requested level.
+            bool Allocate(uint32_t level, QuadtreeNode* node);
+            // Allocates whole consecutive pages. Returns false when there is no such range.
+            bool AllocatePages(uint32_t count, uint32_t* firstPage);
+            void Free(const QuadtreeNode& node);
+            void FreePages(uint32_t firstPage, uint32_t count);
+            // Pages can only be added. Existing allocations are retained.
+            void SetPageCount(uint32_t count);
+
+            inline uint32_t GetPageCount() const { return m_pageCount; }
+            inline uint32_t GetLevelCount() const { return m_levelCount; }
+
+        private:
+            enum class NodeState : uint8_t
+            {
+                Free,
+                Split,
+                Used
+            };
+
+            inline NodeState& GetNode(uint32_t page, uint32_t level, uint32_t index) { return m_nodes.at(page * m_nodesPerPage + m_levelOffsets[level] + index); }
+            bool AllocateNode(uint32_t page, uint32_t level, uint32_t index, uint32_t targetLevel, uint32_t* outIndex);
+
+            std::vector<NodeState> m_nodes;
+            std::vector<uint32_t> m_levelOffsets;
+            uint32_t m_levelCount = 0u;
+            uint32_t m_nodesPerPage = 0u;
+            uint32_t m_pageCount = 0u;
+    };
+}
\ No newline at end of file
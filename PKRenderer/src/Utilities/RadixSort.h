@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+
+namespace PK::Utilities::RadixSort
+{
+    /*
+     * Stable LSD radix sort over 8 bit digits of T::key (uint64_t).
+     * Passes where every element shares the same digit are skipped.
+     * Ping pongs between values & scratch. Returns the buffer that holds the sorted result.
+     */
+    template<typename T>
+    T* Sort64(T* values, T* scratch, size_t count)
+    {
+        if (count < 2ull)
+        {
+            return values;
+        }
+
+        size_t histograms[8][256]{};
+
+        for (auto i = 0ull; i < count; ++i)
+        {
+            auto key = values[i].key;
+
+            for (auto digit = 0u; digit < 8u; ++digit)
+            {
+                histograms[digit][(key >> (digit * 8u)) & 0xFFu]++;
+            }
+        }
+
+        auto source = values;
+        auto destination = scratch;
+
+        for (auto digit = 0u; digit < 8u; ++digit)
+        {
+            auto shift = digit * 8u;
+            auto histogram = histograms[digit];
+
+            if (histogram[(source[0].key >> shift) & 0xFFu] == count)
+            {
+                continue;
+            }
+
+            size_t offsets[256];
+            auto sum = 0ull;
+
+            for (auto i = 0u; i < 256u; ++i)
+            {
+                offsets[i] = sum;
+                sum += histogram[i];
+            }
+
+            for (auto i = 0ull; i < count; ++i)
+            {
+                destination[offsets[(source[i].key >> shift) & 0xFFu]++] = source[i];
+            }
+
+            auto temp = source;
+            source = destination;
+            destination = temp;
+        }
+
+        return source;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include "NoCopy.h"
+#include <atomic>
+
+namespace PK::Utilities
+{
+    // Chase-Lev work stealing deque.
+    // Push & Pop may only be called by the owning thread. Steal can be called from any thread.
+    template<typename T, size_t capacity>
+    class WorkStealingQueue : NoCopy
+    {
+        static_assert((capacity & (capacity - 1)) == 0, "Capacity must be a power of two!");
+        constexpr static const int64_t Mask = (int64_t)capacity - 1;
+
+        public:
+            WorkStealingQueue()
+            {
+                for (auto i = 0u; i < capacity; ++i)
+                {
+                    m_items[i].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            bool Push(T* value)
+            {
+                auto bottom = m_bottom.load(std::memory_order_relaxed);
+                auto top = m_top.load(std::memory_order_acquire);
+
+                if (bottom - top >= (int64_t)capacity)
+                {
+                    return false;
+                }
+
+                m_items[bottom & Mask].store(value, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return true;
+            }
+
+            T* Pop()
+            {
+                auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+                m_bottom.store(bottom, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto top = m_top.load(std::memory_order_relaxed);
+
+                if (top > bottom)
+                {
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+
+                auto value = m_items[bottom & Mask].load(std::memory_order_relaxed);
+
+                if (top != bottom)
+                {
+                    return value;
+                }
+
+                // Last element. Race against stealers.
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    value = nullptr;
+                }
+
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return value;
+            }
+
+            T* Steal()
+            {
+                auto top = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto bottom = m_bottom.load(std::memory_order_acquire);
+
+                if (top >= bottom)
+                {
+                    return nullptr;
+                }
+
+                auto value = m_items[top & Mask].load(std::memory_order_relaxed);
+
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return nullptr;
+                }
+
+                return value;
+            }
+
+            inline size_t GetCount() const
+            {
+                auto count = m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_relaxed);
+                return count > 0 ? (size_t)count : 0ull;
+            }
+
+        private:
+            alignas(64) std::atomic<int64_t> m_top = 0;
+            alignas(64) std::atomic<int64_t> m_bottom = 0;
+            std::atomic<T*> m_items[capacity];
+    };
+}
\ No newline at end of file